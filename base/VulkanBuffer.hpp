@@ -14,6 +14,7 @@
 
 #include "vulkan/vulkan.h"
 #include "VulkanTools.h"
+#include "VulkanMemoryAllocator.hpp"
 
 namespace vks
 {	
@@ -25,7 +26,10 @@ namespace vks
 	{
 		VkDevice device;
 		VkBuffer buffer = VK_NULL_HANDLE;
+		/** @brief Device memory backing the buffer, may be shared with other resources if the buffer has been sub-allocated */
 		VkDeviceMemory memory = VK_NULL_HANDLE;
+		/** @brief Range of device memory assigned by the device's memory allocator (not valid for buffers with their own memory) */
+		vks::Allocation allocation;
 		VkDescriptorBufferInfo descriptor;
 		VkDeviceSize size = 0;
 		VkDeviceSize alignment = 0;
@@ -43,9 +47,20 @@ namespace vks
 		* @param offset (Optional) Byte offset from beginning
 		* 
 		* @return VkResult of the buffer mapping call
+		*
+		* @note Sub-allocated buffers are persistently mapped by the allocator, so this only returns a pointer into the mapped block
 		*/
 		VkResult map(VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0)
 		{
+			if (allocation.valid())
+			{
+				if (!allocation.mapped)
+				{
+					return VK_ERROR_MEMORY_MAP_FAILED;
+				}
+				mapped = static_cast<uint8_t*>(allocation.mapped) + offset;
+				return VK_SUCCESS;
+			}
 			return vkMapMemory(device, memory, offset, size, 0, &mapped);
 		}
 
@@ -58,7 +73,10 @@ namespace vks
 		{
 			if (mapped)
 			{
-				vkUnmapMemory(device, memory);
+				if (!allocation.valid())
+				{
+					vkUnmapMemory(device, memory);
+				}
 				mapped = nullptr;
 			}
 		}
@@ -72,7 +90,7 @@ namespace vks
 		*/
 		VkResult bind(VkDeviceSize offset = 0)
 		{
-			return vkBindBufferMemory(device, buffer, memory, offset);
+			return vkBindBufferMemory(device, buffer, memory, allocation.offset + offset);
 		}
 
 		/**
@@ -114,6 +132,10 @@ namespace vks
 		*/
 		VkResult flush(VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0)
 		{
+			if (allocation.valid())
+			{
+				return allocation.allocator->flush(allocation, size, offset);
+			}
 			VkMappedMemoryRange mappedRange = {};
 			mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
 			mappedRange.memory = memory;
@@ -134,6 +156,10 @@ namespace vks
 		*/
 		VkResult invalidate(VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0)
 		{
+			if (allocation.valid())
+			{
+				return allocation.allocator->invalidate(allocation, size, offset);
+			}
 			VkMappedMemoryRange mappedRange = {};
 			mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
 			mappedRange.memory = memory;
@@ -151,10 +177,17 @@ namespace vks
 			{
 				vkDestroyBuffer(device, buffer, nullptr);
 			}
-			if (memory)
+			if (allocation.valid())
+			{
+				allocation.allocator->free(allocation);
+			}
+			else if (memory)
 			{
 				vkFreeMemory(device, memory, nullptr);
 			}
+			buffer = VK_NULL_HANDLE;
+			memory = VK_NULL_HANDLE;
+			mapped = nullptr;
 		}
 
 	};
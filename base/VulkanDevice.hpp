@@ -16,6 +16,8 @@
 #include "vulkan/vulkan.h"
 #include "VulkanTools.h"
 #include "VulkanBuffer.hpp"
+#include "VulkanMemoryAllocator.hpp"
+#include "VulkanUploadManager.hpp"
 
 namespace vks
 {	
@@ -37,10 +39,17 @@ namespace vks
 		std::vector<VkQueueFamilyProperties> queueFamilyProperties;
 		/** @brief List of extensions supported by the device */
 		std::vector<std::string> supportedExtensions;
+		/** @brief List of extensions enabled for the logical device */
+		std::vector<std::string> enabledExtensions;
 
 		/** @brief Default command pool for the graphics queue family index */
 		VkCommandPool commandPool = VK_NULL_HANDLE;
 
+		/** @brief Sub-allocates device memory for buffers and images created through this device */
+		vks::MemoryAllocator memoryAllocator;
+		/** @brief Batches staging uploads and submits them to the transfer queue (if present) without blocking */
+		vks::UploadManager uploadManager;
+
 		/** @brief Set to true when the debug marker extension is detected */
 		bool enableDebugMarkers = false;
 
@@ -102,10 +111,12 @@ namespace vks
 		*/
 		~VulkanDevice()
 		{
+			uploadManager.destroy();
 			if (commandPool)
 			{
 				vkDestroyCommandPool(logicalDevice, commandPool, nullptr);
 			}
+			memoryAllocator.destroy();
 			if (logicalDevice)
 			{
 				vkDestroyDevice(logicalDevice, nullptr);
@@ -214,7 +225,7 @@ namespace vks
 		*
 		* @return VkResult of the device creation call
 		*/
-		VkResult createLogicalDevice(VkPhysicalDeviceFeatures enabledFeatures, std::vector<const char*> enabledExtensions, void* pNextChain, bool useSwapChain = true, VkQueueFlags requestedQueueTypes = VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)
+		VkResult createLogicalDevice(VkPhysicalDeviceFeatures enabledFeatures, std::vector<const char*> enabledExtensions, void* pNextChain, bool useSwapChain = true, VkQueueFlags requestedQueueTypes = VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT | VK_QUEUE_TRANSFER_BIT)
 		{			
 			// Desired queues need to be requested upon logical device creation
 			// Due to differing queue family configurations of Vulkan implementations this can be a bit tricky, especially if the application
@@ -326,8 +337,23 @@ namespace vks
 
 			if (result == VK_SUCCESS)
 			{
+				this->enabledExtensions.assign(deviceExtensions.begin(), deviceExtensions.end());
 				// Create a default command pool for graphics command buffers
 				commandPool = createCommandPool(queueFamilyIndices.graphics);
+				memoryAllocator.create(physicalDevice, logicalDevice);
+				// Uploads are made available to the graphics queue, devices without one use their compute or transfer queue instead
+				// All of these support transfers, so loaders can always use the upload manager
+				uint32_t uploadFamily = queueFamilyIndices.transfer;
+				if (requestedQueueTypes & VK_QUEUE_GRAPHICS_BIT)
+				{
+					uploadFamily = queueFamilyIndices.graphics;
+				}
+				else if (requestedQueueTypes & VK_QUEUE_COMPUTE_BIT)
+				{
+					uploadFamily = queueFamilyIndices.compute;
+				}
+				const uint32_t copyFamily = (requestedQueueTypes & VK_QUEUE_TRANSFER_BIT) ? queueFamilyIndices.transfer : uploadFamily;
+				uploadManager.create(physicalDevice, logicalDevice, &memoryAllocator, uploadFamily, copyFamily);
 			}
 
 			this->enabledFeatures = enabledFeatures;
@@ -342,47 +368,41 @@ namespace vks
 		* @param memoryPropertyFlags Memory properties for this buffer (i.e. device local, host visible, coherent)
 		* @param size Size of the buffer in byes
 		* @param buffer Pointer to the buffer handle acquired by the function
-		* @param memory Pointer to the memory handle acquired by the function
+		* @param allocation Pointer to the allocation acquired by the function, pass to memoryAllocator.free once the buffer is destroyed
 		* @param data Pointer to the data that should be copied to the buffer after creation (optional, if not set, no data is copied over)
 		*
 		* @return VK_SUCCESS if buffer handle and memory have been created and (optionally passed) data has been copied
+		*
+		* @note The memory is sub-allocated from the device's memory allocator, host visible allocations stay mapped at allocation->mapped
 		*/
-		VkResult createBuffer(VkBufferUsageFlags usageFlags, VkMemoryPropertyFlags memoryPropertyFlags, VkDeviceSize size, VkBuffer *buffer, VkDeviceMemory *memory, void *data = nullptr)
+		VkResult createBuffer(VkBufferUsageFlags usageFlags, VkMemoryPropertyFlags memoryPropertyFlags, VkDeviceSize size, VkBuffer *buffer, vks::Allocation *allocation, void *data = nullptr)
 		{
 			// Create the buffer handle
 			VkBufferCreateInfo bufferCreateInfo = vks::initializers::bufferCreateInfo(usageFlags, size);
 			bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 			VK_CHECK_RESULT(vkCreateBuffer(logicalDevice, &bufferCreateInfo, nullptr, buffer));
 
-			// Create the memory backing up the buffer handle
+			// Sub-allocate the memory backing up the buffer handle from the device's memory allocator
 			VkMemoryRequirements memReqs;
-			VkMemoryAllocateInfo memAlloc = vks::initializers::memoryAllocateInfo();
 			vkGetBufferMemoryRequirements(logicalDevice, *buffer, &memReqs);
-			memAlloc.allocationSize = memReqs.size;
 			// Find a memory type index that fits the properties of the buffer
-			memAlloc.memoryTypeIndex = getMemoryType(memReqs.memoryTypeBits, memoryPropertyFlags);
-			VK_CHECK_RESULT(vkAllocateMemory(logicalDevice, &memAlloc, nullptr, memory));
-			
-			// If a pointer to the buffer data has been passed, map the buffer and copy over the data
+			uint32_t memoryTypeIndex = getMemoryType(memReqs.memoryTypeBits, memoryPropertyFlags);
+			VK_CHECK_RESULT(memoryAllocator.allocate(memReqs, memoryTypeIndex, vks::ResourceType::Linear, allocation));
+
+			// If a pointer to the buffer data has been passed, copy it over to the persistently mapped allocation
 			if (data != nullptr)
 			{
-				void *mapped;
-				VK_CHECK_RESULT(vkMapMemory(logicalDevice, *memory, 0, size, 0, &mapped));
-				memcpy(mapped, data, size);
-				// If host coherency hasn't been requested, do a manual flush to make writes visible
-				if ((memoryPropertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) == 0)
+				if (!allocation->mapped)
 				{
-					VkMappedMemoryRange mappedRange = vks::initializers::mappedMemoryRange();
-					mappedRange.memory = *memory;
-					mappedRange.offset = 0;
-					mappedRange.size = size;
-					vkFlushMappedMemoryRanges(logicalDevice, 1, &mappedRange);
+					return VK_ERROR_MEMORY_MAP_FAILED;
 				}
-				vkUnmapMemory(logicalDevice, *memory);
+				memcpy(allocation->mapped, data, size);
+				// If host coherency hasn't been requested, do a manual flush to make writes visible
+				VK_CHECK_RESULT(memoryAllocator.flush(*allocation, size));
 			}
 
 			// Attach the memory to the buffer object
-			VK_CHECK_RESULT(vkBindBufferMemory(logicalDevice, *buffer, *memory, 0));
+			VK_CHECK_RESULT(vkBindBufferMemory(logicalDevice, *buffer, allocation->memory, allocation->offset));
 
 			return VK_SUCCESS;
 		}
@@ -406,14 +426,13 @@ namespace vks
 			VkBufferCreateInfo bufferCreateInfo = vks::initializers::bufferCreateInfo(usageFlags, size);
 			VK_CHECK_RESULT(vkCreateBuffer(logicalDevice, &bufferCreateInfo, nullptr, &buffer->buffer));
 
-			// Create the memory backing up the buffer handle
+			// Sub-allocate the memory backing up the buffer handle from the device's memory allocator
 			VkMemoryRequirements memReqs;
-			VkMemoryAllocateInfo memAlloc = vks::initializers::memoryAllocateInfo();
 			vkGetBufferMemoryRequirements(logicalDevice, buffer->buffer, &memReqs);
-			memAlloc.allocationSize = memReqs.size;
 			// Find a memory type index that fits the properties of the buffer
-			memAlloc.memoryTypeIndex = getMemoryType(memReqs.memoryTypeBits, memoryPropertyFlags);
-			VK_CHECK_RESULT(vkAllocateMemory(logicalDevice, &memAlloc, nullptr, &buffer->memory));
+			uint32_t memoryTypeIndex = getMemoryType(memReqs.memoryTypeBits, memoryPropertyFlags);
+			VK_CHECK_RESULT(memoryAllocator.allocate(memReqs, memoryTypeIndex, vks::ResourceType::Linear, &buffer->allocation));
+			buffer->memory = buffer->allocation.memory;
 
 			buffer->alignment = memReqs.alignment;
 			buffer->size = size;
@@ -438,6 +457,26 @@ namespace vks
 			return buffer->bind();
 		}
 
+		/**
+		* Sub-allocate memory for an image from the device's memory allocator and bind it to the image
+		*
+		* @param image Image to allocate and bind memory for
+		* @param memoryPropertyFlags Memory properties for the image memory (usually device local)
+		* @param allocation Pointer to the allocation that receives the memory range, pass to memoryAllocator.free once the image is destroyed
+		* @param tiling (Optional) Tiling of the image, used to keep linear and optimal resources apart as required by bufferImageGranularity
+		*
+		* @return VK_SUCCESS if the memory has been allocated and bound
+		*/
+		VkResult allocateImageMemory(VkImage image, VkMemoryPropertyFlags memoryPropertyFlags, vks::Allocation *allocation, VkImageTiling tiling = VK_IMAGE_TILING_OPTIMAL)
+		{
+			VkMemoryRequirements memReqs;
+			vkGetImageMemoryRequirements(logicalDevice, image, &memReqs);
+			uint32_t memoryTypeIndex = getMemoryType(memReqs.memoryTypeBits, memoryPropertyFlags);
+			vks::ResourceType resourceType = (tiling == VK_IMAGE_TILING_OPTIMAL) ? vks::ResourceType::Optimal : vks::ResourceType::Linear;
+			VK_CHECK_RESULT(memoryAllocator.allocate(memReqs, memoryTypeIndex, resourceType, allocation));
+			return vkBindImageMemory(logicalDevice, image, allocation->memory, allocation->offset);
+		}
+
 		/**
 		* Copy buffer data from src to dst using VkCmdCopyBuffer
 		* 
@@ -572,6 +611,18 @@ namespace vks
 			return (std::find(supportedExtensions.begin(), supportedExtensions.end(), extension) != supportedExtensions.end());
 		}
 
+		/**
+		* Check if an extension has been enabled for the logical device
+		*
+		* @param extension Name of the extension to check
+		*
+		* @return True if the extension has been passed to (or added by) createLogicalDevice
+		*/
+		bool extensionEnabled(std::string extension)
+		{
+			return (std::find(enabledExtensions.begin(), enabledExtensions.end(), extension) != enabledExtensions.end());
+		}
+
 		/**
 		* Select the best-fit depth format for this device from a list of possible depth (and stencil) formats
 		*
@@ -0,0 +1,275 @@
+/*
+* Vulkan GPU profiler
+*
+* Measures the GPU time of named and nested scopes of a frame's command buffers with timestamp queries
+*
+* Copyright (C) by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license (MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <mutex>
+#include <iostream>
+#include <assert.h>
+#include <stdint.h>
+
+#include "vulkan/vulkan.h"
+#include "VulkanTools.h"
+#include "VulkanDebug.h"
+#include "VulkanDevice.hpp"
+
+namespace vks
+{
+	/**
+	* @brief Timestamp based GPU profiler with one query pool per frame in flight
+	*
+	* Scopes are written into the command buffers recorded for the current frame, and the timestamps of a frame are read back once its fence
+	* has been waited on for the next use of the frame's slot, so reading the results never stalls the CPU. The results are therefore
+	* as many frames old as there are frames in flight.
+	* Each scope is also a debug marker region, so the scopes show up with the same names in graphics debuggers.
+	*
+	* @note Scopes must only be written into command buffers that are recorded for and submitted with the current frame, not into prebuilt ones
+	* @note If the queue family does not support timestamps, scopes only insert the debug marker regions
+	*/
+	class GpuProfiler
+	{
+	public:
+		/** @brief Returned by beginScope if no timestamps are written for the scope */
+		static const uint32_t INVALID_SCOPE = ~0u;
+
+		/** @brief GPU time of a scope of the last resolved frame */
+		struct ScopeResult {
+			std::string name;
+			/** @brief Names of the scope and its parents joined by "/", e.g. "frame/scene/objects" */
+			std::string path;
+			/** @brief Nesting level, 0 for scopes without a parent */
+			uint32_t depth = 0;
+			/** @brief Time between the start and the end of the scope in ms */
+			double time = 0.0;
+		};
+
+		/** @brief Scope results of the last resolved frame, parents are always listed before their children */
+		std::vector<ScopeResult> results;
+		/** @brief Number of scopes that did not get timestamps as the frame's query pool was full, summed over all frames */
+		uint64_t droppedScopes = 0;
+
+		/**
+		* @brief Writes the start and end timestamps of a scope for its lifetime
+		*
+		* Nested scopes are created from their parent, which must outlive them:
+		*     vks::GpuProfiler::Scope scene(profiler, commandBuffer, "scene");
+		*     vks::GpuProfiler::Scope objects(scene, "objects");
+		*/
+		class Scope
+		{
+			GpuProfiler *profiler;
+			VkCommandBuffer commandBuffer;
+			uint32_t index;
+		public:
+			Scope(GpuProfiler &profiler, VkCommandBuffer commandBuffer, const char *name, uint32_t parent = INVALID_SCOPE)
+				: profiler(&profiler), commandBuffer(commandBuffer)
+			{
+				index = profiler.beginScope(commandBuffer, name, parent);
+			}
+			/** @brief Nested scope in the same command buffer as its parent */
+			Scope(Scope &parent, const char *name) : Scope(*parent.profiler, parent.commandBuffer, name, parent.index) {}
+			/** @brief Nested scope in another command buffer executed within the parent, e.g. a secondary command buffer */
+			Scope(Scope &parent, VkCommandBuffer commandBuffer, const char *name) : Scope(*parent.profiler, commandBuffer, name, parent.index) {}
+			Scope(const Scope&) = delete;
+			Scope &operator=(const Scope&) = delete;
+			~Scope()
+			{
+				profiler->endScope(commandBuffer, index);
+			}
+			/** @brief Index of the scope, for use as the parent of scopes created elsewhere (e.g. on recording threads) */
+			uint32_t id() const { return index; }
+		};
+
+	private:
+		struct ScopeInfo {
+			std::string name;
+			uint32_t parent;
+			uint32_t depth;
+		};
+		struct FrameSlot {
+			VkQueryPool queryPool = VK_NULL_HANDLE;
+			/** @brief Scopes written with the last recording of this slot, each one uses the queries 2 * index and 2 * index + 1 */
+			std::vector<ScopeInfo> scopes;
+			/** @brief Set if the slot's query pool has been reset for the frame (beginFrame) */
+			bool recording = false;
+		};
+
+		vks::VulkanDevice *device = nullptr;
+		std::vector<FrameSlot> slots;
+		uint32_t currentSlot = 0;
+		uint32_t maxScopes = 0;
+		uint64_t timestampMask = 0;
+		float timestampPeriod = 0.0f;
+		/** @brief Guards the scope allocation, as secondary command buffers may be recorded on several threads */
+		std::mutex mutex;
+		std::vector<uint64_t> queryResults;
+
+	public:
+		GpuProfiler() = default;
+		GpuProfiler(const GpuProfiler&) = delete;
+		GpuProfiler &operator=(const GpuProfiler&) = delete;
+		~GpuProfiler()
+		{
+			destroy();
+		}
+
+		/**
+		* @brief Creates the query pools
+		*
+		* @param device Device the command buffers are recorded for
+		* @param queueFamilyIndex Queue family the command buffers are submitted to
+		* @param frameCount Number of frames in flight, one query pool is used per frame
+		* @param maxScopes Maximum number of scopes per frame, additional scopes are dropped
+		*/
+		void prepare(vks::VulkanDevice *device, uint32_t queueFamilyIndex, uint32_t frameCount, uint32_t maxScopes = 64)
+		{
+			assert(frameCount > 0);
+			this->device = device;
+			this->maxScopes = maxScopes;
+			slots.resize(frameCount);
+			const uint32_t validBits = device->queueFamilyProperties[queueFamilyIndex].timestampValidBits;
+			timestampPeriod = device->properties.limits.timestampPeriod;
+			if ((validBits == 0) || (timestampPeriod == 0.0f)) {
+				std::cout << "GPU timestamps are not supported by the queue, the GPU profiler is disabled" << std::endl;
+				return;
+			}
+			timestampMask = (validBits >= 64) ? ~0ull : ((1ull << validBits) - 1);
+			VkQueryPoolCreateInfo queryPoolCI{};
+			queryPoolCI.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+			queryPoolCI.queryType = VK_QUERY_TYPE_TIMESTAMP;
+			queryPoolCI.queryCount = maxScopes * 2;
+			for (auto& slot : slots) {
+				VK_CHECK_RESULT(vkCreateQueryPool(device->logicalDevice, &queryPoolCI, nullptr, &slot.queryPool));
+			}
+			// A value and an availability word per query
+			queryResults.resize(maxScopes * 2 * 2);
+		}
+
+		void destroy()
+		{
+			if (!device) {
+				return;
+			}
+			for (auto& slot : slots) {
+				if (slot.queryPool != VK_NULL_HANDLE) {
+					vkDestroyQueryPool(device->logicalDevice, slot.queryPool, nullptr);
+				}
+			}
+			slots.clear();
+			results.clear();
+			device = nullptr;
+		}
+
+		/** @brief True if scopes are measured, false if timestamps aren't supported or the profiler hasn't been prepared */
+		bool supported() const
+		{
+			return timestampMask != 0;
+		}
+
+		/**
+		* @brief Reads the timestamps written by the last frame that used the given slot into results
+		* @note Call after the frame's fence has been waited on, queries that are not available yet are skipped instead of waited for
+		*/
+		void resolveFrame(uint32_t frameIndex)
+		{
+			if (!supported()) {
+				return;
+			}
+			FrameSlot &slot = slots[frameIndex % slots.size()];
+			if (!slot.recording) {
+				return;
+			}
+			slot.recording = false;
+			results.clear();
+			if (slot.scopes.empty()) {
+				return;
+			}
+			const uint32_t queryCount = static_cast<uint32_t>(slot.scopes.size()) * 2;
+			// Returns VK_NOT_READY if any query isn't available, the availability words tell which ones are
+			VkResult result = vkGetQueryPoolResults(device->logicalDevice, slot.queryPool, 0, queryCount, queryCount * 2 * sizeof(uint64_t), queryResults.data(), 2 * sizeof(uint64_t), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+			if ((result != VK_SUCCESS) && (result != VK_NOT_READY)) {
+				VK_CHECK_RESULT(result);
+			}
+			std::vector<std::string> paths(slot.scopes.size());
+			for (size_t i = 0; i < slot.scopes.size(); i++) {
+				const ScopeInfo &scope = slot.scopes[i];
+				paths[i] = (scope.parent == INVALID_SCOPE) ? scope.name : paths[scope.parent] + "/" + scope.name;
+				const uint64_t *begin = &queryResults[i * 4];
+				const uint64_t *end = &queryResults[i * 4 + 2];
+				if ((begin[1] == 0) || (end[1] == 0)) {
+					continue;
+				}
+				ScopeResult scopeResult;
+				scopeResult.name = scope.name;
+				scopeResult.path = paths[i];
+				scopeResult.depth = scope.depth;
+				scopeResult.time = (double)((end[0] - begin[0]) & timestampMask) * (double)timestampPeriod / 1000000.0;
+				results.push_back(scopeResult);
+			}
+		}
+
+		/**
+		* @brief Starts writing scopes for the given frame in flight and resets its query pool
+		* @note Must be recorded outside of a render pass, before any scope of the frame, into a command buffer submitted before all others of the frame
+		*/
+		void beginFrame(VkCommandBuffer commandBuffer, uint32_t frameIndex)
+		{
+			if (!supported()) {
+				return;
+			}
+			currentSlot = frameIndex % slots.size();
+			FrameSlot &slot = slots[currentSlot];
+			slot.scopes.clear();
+			slot.recording = true;
+			vkCmdResetQueryPool(commandBuffer, slot.queryPool, 0, maxScopes * 2);
+		}
+
+		/**
+		* @brief Writes the start timestamp of a scope and begins a debug marker region with the same name
+		* @param parent Scope the new one is nested in, INVALID_SCOPE for a top level scope
+		* @return Index of the scope to pass to endScope, INVALID_SCOPE if no timestamp was written
+		*/
+		uint32_t beginScope(VkCommandBuffer commandBuffer, const char *name, uint32_t parent = INVALID_SCOPE)
+		{
+			vks::debugmarker::beginRegion(commandBuffer, name, glm::vec4(0.0f, 0.5f, 1.0f, 1.0f));
+			if (!supported() || !slots[currentSlot].recording) {
+				return INVALID_SCOPE;
+			}
+			FrameSlot &slot = slots[currentSlot];
+			uint32_t index;
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				if (slot.scopes.size() >= maxScopes) {
+					droppedScopes++;
+					return INVALID_SCOPE;
+				}
+				index = static_cast<uint32_t>(slot.scopes.size());
+				ScopeInfo scope;
+				scope.name = name;
+				scope.parent = parent;
+				scope.depth = (parent == INVALID_SCOPE) ? 0 : slot.scopes[parent].depth + 1;
+				slot.scopes.push_back(scope);
+			}
+			vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, slot.queryPool, index * 2);
+			return index;
+		}
+
+		/** @brief Writes the end timestamp of a scope once all previous commands have completed and ends its debug marker region */
+		void endScope(VkCommandBuffer commandBuffer, uint32_t scope)
+		{
+			if (scope != INVALID_SCOPE) {
+				vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, slots[currentSlot].queryPool, scope * 2 + 1);
+			}
+			vks::debugmarker::endRegion(commandBuffer);
+		}
+	};
+}
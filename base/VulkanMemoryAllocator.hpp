@@ -0,0 +1,791 @@
+/*
+* Vulkan device memory allocator
+*
+* Sub-allocates buffers and images from larger device memory blocks to keep the number of vkAllocateMemory calls low
+*
+* Copyright (C) by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license (MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#pragma once
+
+#include <vector>
+#include <mutex>
+#include <memory>
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include <assert.h>
+#include <stdint.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#include "vulkan/vulkan.h"
+#include "VulkanTools.h"
+
+namespace vks
+{
+	class MemoryAllocator;
+	struct MemoryBlock;
+
+	/**
+	* @brief Resource types that may be placed inside a memory block
+	* @note Linear (buffers, linear images) and optimal (tiled images) resources are kept in separate blocks, so neighbouring resources never violate bufferImageGranularity
+	*/
+	enum class ResourceType { Linear, Optimal };
+
+	/** @brief Sub-allocation strategies used to manage the ranges inside a memory block */
+	enum class AllocationStrategy {
+		/** @brief Two-level segregated fit, O(1) allocation and free with immediate coalescing (general purpose) */
+		TLSF,
+		/** @brief Bump allocator, block is reset once all of its allocations have been freed (transient data like staging buffers) */
+		Linear
+	};
+
+	/** @brief Describes a range of device memory handed out by the memory allocator */
+	struct Allocation
+	{
+		/** @brief Device memory object backing the allocation (shared with other allocations of the same block) */
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		/** @brief Byte offset of the allocation inside the device memory object */
+		VkDeviceSize offset = 0;
+		/** @brief Size of the allocation in bytes */
+		VkDeviceSize size = 0;
+		/** @brief Host pointer to the start of the allocation, only set for host visible memory (blocks are persistently mapped) */
+		void* mapped = nullptr;
+		uint32_t memoryTypeIndex = 0;
+		/** @brief Allocator that owns this allocation, nullptr if the allocation is not valid */
+		MemoryAllocator* allocator = nullptr;
+		/** @brief Block the allocation has been taken from, nullptr for dedicated allocations */
+		MemoryBlock* block = nullptr;
+		/** @brief Handle of the range inside the block's metadata */
+		uint32_t handle = 0;
+
+		bool valid() const { return allocator != nullptr; }
+	};
+
+	namespace memory
+	{
+		inline VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment)
+		{
+			return (alignment > 1) ? ((value + alignment - 1) / alignment) * alignment : value;
+		}
+
+		inline VkDeviceSize alignDown(VkDeviceSize value, VkDeviceSize alignment)
+		{
+			return (alignment > 1) ? (value / alignment) * alignment : value;
+		}
+
+		/** @brief Index of the most significant set bit (value must not be zero) */
+		inline uint32_t bitScanReverse(uint64_t value)
+		{
+			assert(value != 0);
+#if defined(_MSC_VER)
+			unsigned long index;
+			_BitScanReverse64(&index, value);
+			return static_cast<uint32_t>(index);
+#else
+			return 63 - static_cast<uint32_t>(__builtin_clzll(value));
+#endif
+		}
+
+		/** @brief Index of the least significant set bit (value must not be zero) */
+		inline uint32_t bitScanForward(uint64_t value)
+		{
+			assert(value != 0);
+#if defined(_MSC_VER)
+			unsigned long index;
+			_BitScanForward64(&index, value);
+			return static_cast<uint32_t>(index);
+#else
+			return static_cast<uint32_t>(__builtin_ctzll(value));
+#endif
+		}
+	}
+
+	/** @brief Interface for the bookkeeping of the free and used ranges inside a single memory block */
+	class BlockMetadata
+	{
+	public:
+		static const uint32_t INVALID_HANDLE = UINT32_MAX;
+
+		virtual ~BlockMetadata() {}
+		/** @brief Returns a handle to the allocated range (or INVALID_HANDLE if the block can't fit the request) and stores its offset */
+		virtual uint32_t allocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize *offset) = 0;
+		virtual void free(uint32_t handle) = 0;
+		virtual VkDeviceSize usedSize() const = 0;
+		virtual VkDeviceSize largestFreeRange() const = 0;
+		virtual uint32_t allocationCount() const = 0;
+	};
+
+	/**
+	* @brief Two-level segregated fit (TLSF) metadata
+	* @note Free ranges are kept in size segregated lists addressed by two bitmaps, neighbouring free ranges are merged on free
+	*/
+	class TLSFBlockMetadata : public BlockMetadata
+	{
+	private:
+		// Number of second level lists per first level (power of two) size class
+		static const uint32_t SL_LOG2 = 5;
+		static const uint32_t SL_COUNT = 1 << SL_LOG2;
+		static const uint32_t FL_COUNT = 64 - SL_LOG2 + 1;
+
+		struct Range {
+			VkDeviceSize offset;
+			VkDeviceSize size;
+			uint32_t prevPhysical;
+			uint32_t nextPhysical;
+			uint32_t prevFree;
+			uint32_t nextFree;
+			bool free;
+		};
+
+		std::vector<Range> ranges;
+		std::vector<uint32_t> unusedRanges;
+		uint64_t flBitmap = 0;
+		uint32_t slBitmap[FL_COUNT] = {};
+		uint32_t freeLists[FL_COUNT][SL_COUNT];
+		VkDeviceSize capacity;
+		VkDeviceSize used = 0;
+		uint32_t count = 0;
+
+		static void mapping(VkDeviceSize size, uint32_t &fl, uint32_t &sl)
+		{
+			if (size < SL_COUNT) {
+				fl = 0;
+				sl = static_cast<uint32_t>(size);
+			} else {
+				const uint32_t msb = memory::bitScanReverse(size);
+				sl = static_cast<uint32_t>(size >> (msb - SL_LOG2)) - SL_COUNT;
+				fl = msb - SL_LOG2 + 1;
+			}
+		}
+
+		// Rounds the size up to the next list boundary, so every range in the selected list is large enough
+		static void mappingSearch(VkDeviceSize size, uint32_t &fl, uint32_t &sl)
+		{
+			if (size >= SL_COUNT) {
+				size += (VkDeviceSize(1) << (memory::bitScanReverse(size) - SL_LOG2)) - 1;
+			}
+			mapping(size, fl, sl);
+		}
+
+		uint32_t newRange()
+		{
+			if (!unusedRanges.empty()) {
+				uint32_t index = unusedRanges.back();
+				unusedRanges.pop_back();
+				return index;
+			}
+			ranges.push_back(Range{});
+			return static_cast<uint32_t>(ranges.size() - 1);
+		}
+
+		void insertFree(uint32_t index)
+		{
+			Range &range = ranges[index];
+			uint32_t fl, sl;
+			mapping(range.size, fl, sl);
+			range.free = true;
+			range.prevFree = INVALID_HANDLE;
+			range.nextFree = freeLists[fl][sl];
+			if (range.nextFree != INVALID_HANDLE) {
+				ranges[range.nextFree].prevFree = index;
+			}
+			freeLists[fl][sl] = index;
+			flBitmap |= (uint64_t(1) << fl);
+			slBitmap[fl] |= (1u << sl);
+		}
+
+		void removeFree(uint32_t index)
+		{
+			Range &range = ranges[index];
+			uint32_t fl, sl;
+			mapping(range.size, fl, sl);
+			if (range.prevFree != INVALID_HANDLE) {
+				ranges[range.prevFree].nextFree = range.nextFree;
+			} else {
+				freeLists[fl][sl] = range.nextFree;
+				if (freeLists[fl][sl] == INVALID_HANDLE) {
+					slBitmap[fl] &= ~(1u << sl);
+					if (slBitmap[fl] == 0) {
+						flBitmap &= ~(uint64_t(1) << fl);
+					}
+				}
+			}
+			if (range.nextFree != INVALID_HANDLE) {
+				ranges[range.nextFree].prevFree = range.prevFree;
+			}
+			range.free = false;
+		}
+
+		uint32_t findFree(uint32_t fl, uint32_t sl) const
+		{
+			if (fl >= FL_COUNT) {
+				return INVALID_HANDLE;
+			}
+			uint32_t slMap = (sl < SL_COUNT) ? (slBitmap[fl] & (~0u << sl)) : 0;
+			if (slMap == 0) {
+				const uint64_t flMap = (fl + 1 < 64) ? (flBitmap & (~uint64_t(0) << (fl + 1))) : 0;
+				if (flMap == 0) {
+					return INVALID_HANDLE;
+				}
+				fl = memory::bitScanForward(flMap);
+				slMap = slBitmap[fl];
+			}
+			sl = memory::bitScanForward(slMap);
+			return freeLists[fl][sl];
+		}
+
+		// Splits off the tail of a range beyond the given size and returns it to the free lists
+		void splitTail(uint32_t index, VkDeviceSize size)
+		{
+			const VkDeviceSize remainder = ranges[index].size - size;
+			if (remainder == 0) {
+				return;
+			}
+			uint32_t tail = newRange();
+			Range &range = ranges[index];
+			ranges[tail].offset = range.offset + size;
+			ranges[tail].size = remainder;
+			ranges[tail].prevPhysical = index;
+			ranges[tail].nextPhysical = range.nextPhysical;
+			if (range.nextPhysical != INVALID_HANDLE) {
+				ranges[range.nextPhysical].prevPhysical = tail;
+			}
+			range.nextPhysical = tail;
+			range.size = size;
+			insertFree(tail);
+		}
+
+		// Splits off the head of a range up to the given offset and returns it to the free lists
+		void splitHead(uint32_t index, VkDeviceSize alignedOffset)
+		{
+			const VkDeviceSize padding = alignedOffset - ranges[index].offset;
+			if (padding == 0) {
+				return;
+			}
+			uint32_t head = newRange();
+			Range &range = ranges[index];
+			ranges[head].offset = range.offset;
+			ranges[head].size = padding;
+			ranges[head].prevPhysical = range.prevPhysical;
+			ranges[head].nextPhysical = index;
+			if (range.prevPhysical != INVALID_HANDLE) {
+				ranges[range.prevPhysical].nextPhysical = head;
+			}
+			range.prevPhysical = head;
+			range.offset = alignedOffset;
+			range.size -= padding;
+			insertFree(head);
+		}
+
+	public:
+		TLSFBlockMetadata(VkDeviceSize capacity) : capacity(capacity)
+		{
+			for (uint32_t fl = 0; fl < FL_COUNT; fl++) {
+				for (uint32_t sl = 0; sl < SL_COUNT; sl++) {
+					freeLists[fl][sl] = INVALID_HANDLE;
+				}
+			}
+			uint32_t index = newRange();
+			ranges[index].offset = 0;
+			ranges[index].size = capacity;
+			ranges[index].prevPhysical = INVALID_HANDLE;
+			ranges[index].nextPhysical = INVALID_HANDLE;
+			insertFree(index);
+		}
+
+		uint32_t allocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize *offset) override
+		{
+			assert(size > 0);
+			uint32_t fl, sl;
+			// Try the size class of the request first, the candidate may already satisfy the alignment
+			mappingSearch(size, fl, sl);
+			uint32_t index = findFree(fl, sl);
+			if ((index != INVALID_HANDLE) && (memory::alignUp(ranges[index].offset, alignment) + size > ranges[index].offset + ranges[index].size)) {
+				// Fall back to a size class that is guaranteed to fit the request including worst case alignment padding
+				mappingSearch(size + alignment - 1, fl, sl);
+				index = findFree(fl, sl);
+			}
+			if (index == INVALID_HANDLE) {
+				return INVALID_HANDLE;
+			}
+			removeFree(index);
+			splitHead(index, memory::alignUp(ranges[index].offset, alignment));
+			splitTail(index, size);
+			used += ranges[index].size;
+			count++;
+			*offset = ranges[index].offset;
+			return index;
+		}
+
+		void free(uint32_t handle) override
+		{
+			assert(handle < ranges.size() && !ranges[handle].free);
+			used -= ranges[handle].size;
+			count--;
+			// Merge with the previous and next ranges in memory if they are free
+			uint32_t prev = ranges[handle].prevPhysical;
+			if ((prev != INVALID_HANDLE) && ranges[prev].free) {
+				removeFree(prev);
+				ranges[prev].size += ranges[handle].size;
+				ranges[prev].nextPhysical = ranges[handle].nextPhysical;
+				if (ranges[handle].nextPhysical != INVALID_HANDLE) {
+					ranges[ranges[handle].nextPhysical].prevPhysical = prev;
+				}
+				unusedRanges.push_back(handle);
+				handle = prev;
+			}
+			uint32_t next = ranges[handle].nextPhysical;
+			if ((next != INVALID_HANDLE) && ranges[next].free) {
+				removeFree(next);
+				ranges[handle].size += ranges[next].size;
+				ranges[handle].nextPhysical = ranges[next].nextPhysical;
+				if (ranges[next].nextPhysical != INVALID_HANDLE) {
+					ranges[ranges[next].nextPhysical].prevPhysical = handle;
+				}
+				unusedRanges.push_back(next);
+			}
+			insertFree(handle);
+		}
+
+		VkDeviceSize usedSize() const override
+		{
+			return used;
+		}
+
+		VkDeviceSize largestFreeRange() const override
+		{
+			if (flBitmap == 0) {
+				return 0;
+			}
+			const uint32_t fl = memory::bitScanReverse(flBitmap);
+			const uint32_t sl = memory::bitScanReverse(slBitmap[fl]);
+			VkDeviceSize largest = 0;
+			for (uint32_t index = freeLists[fl][sl]; index != INVALID_HANDLE; index = ranges[index].nextFree) {
+				largest = std::max(largest, ranges[index].size);
+			}
+			return largest;
+		}
+
+		uint32_t allocationCount() const override
+		{
+			return count;
+		}
+	};
+
+	/** @brief Linear (bump pointer) metadata, the block is rewound once it's empty */
+	class LinearBlockMetadata : public BlockMetadata
+	{
+	private:
+		VkDeviceSize capacity;
+		VkDeviceSize head = 0;
+		VkDeviceSize used = 0;
+		uint32_t count = 0;
+		std::vector<VkDeviceSize> sizes;
+	public:
+		LinearBlockMetadata(VkDeviceSize capacity) : capacity(capacity) {}
+
+		uint32_t allocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize *offset) override
+		{
+			const VkDeviceSize alignedOffset = memory::alignUp(head, alignment);
+			if (alignedOffset + size > capacity) {
+				return INVALID_HANDLE;
+			}
+			// Handles only need to identify the size of the allocation for statistics
+			sizes.push_back(size);
+			*offset = alignedOffset;
+			head = alignedOffset + size;
+			used += size;
+			count++;
+			return static_cast<uint32_t>(sizes.size() - 1);
+		}
+
+		void free(uint32_t handle) override
+		{
+			assert((handle < sizes.size()) && (count > 0));
+			used -= sizes[handle];
+			count--;
+			if (count == 0) {
+				head = 0;
+				sizes.clear();
+			}
+		}
+
+		VkDeviceSize usedSize() const override
+		{
+			return used;
+		}
+
+		VkDeviceSize largestFreeRange() const override
+		{
+			return capacity - head;
+		}
+
+		uint32_t allocationCount() const override
+		{
+			return count;
+		}
+	};
+
+	/** @brief A single device memory allocation that is split up into smaller ranges */
+	struct MemoryBlock
+	{
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		VkDeviceSize size = 0;
+		uint32_t memoryTypeIndex = 0;
+		/** @brief Host visible blocks are mapped once for their whole lifetime */
+		void* mapped = nullptr;
+		std::unique_ptr<BlockMetadata> metadata;
+	};
+
+	/**
+	* @brief Device memory allocator owned by the VulkanDevice
+	* @note Allocations are grouped into pools per memory type and resource type, each pool owns a list of memory blocks
+	*/
+	class MemoryAllocator
+	{
+	public:
+		/** @brief Allocation statistics of the allocator */
+		struct Statistics {
+			/** @brief Number of currently live device memory objects (blocks and dedicated allocations) */
+			uint32_t deviceMemoryCount = 0;
+			/** @brief Number of vkAllocateMemory calls since creation */
+			uint32_t deviceMemoryAllocations = 0;
+			/** @brief Number of currently live sub-allocations */
+			uint32_t allocationCount = 0;
+			/** @brief Number of sub-allocations since creation */
+			uint64_t totalAllocations = 0;
+			/** @brief Bytes currently reserved from the device in blocks and dedicated allocations */
+			VkDeviceSize reservedBytes = 0;
+			/** @brief Bytes currently used by live allocations */
+			VkDeviceSize usedBytes = 0;
+			VkDeviceSize peakReservedBytes = 0;
+			VkDeviceSize peakUsedBytes = 0;
+			/** @brief External fragmentation of the free memory in all blocks (0 = one contiguous free range, 1 = completely fragmented) */
+			float fragmentation = 0.0f;
+		};
+
+		/** @brief Preferred size for new memory blocks (capped at 1/8th of the heap size) */
+		VkDeviceSize preferredBlockSize = 64 * 1024 * 1024;
+		/** @brief Strategy used for newly created blocks */
+		AllocationStrategy strategy = AllocationStrategy::TLSF;
+
+	private:
+		VkDevice device = VK_NULL_HANDLE;
+		VkPhysicalDeviceMemoryProperties memoryProperties{};
+		VkDeviceSize nonCoherentAtomSize = 1;
+		// One pool per memory type index and resource type
+		std::vector<std::vector<MemoryBlock*>> pools;
+		std::mutex mutex;
+		Statistics stats;
+
+		std::vector<MemoryBlock*> &pool(uint32_t memoryTypeIndex, ResourceType resourceType)
+		{
+			return pools[memoryTypeIndex * 2 + (resourceType == ResourceType::Optimal ? 1 : 0)];
+		}
+
+		bool isHostVisible(uint32_t memoryTypeIndex) const
+		{
+			return (memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) != 0;
+		}
+
+		bool isHostCoherent(uint32_t memoryTypeIndex) const
+		{
+			return (memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
+		}
+
+		VkDeviceSize blockSize(uint32_t memoryTypeIndex) const
+		{
+			const VkDeviceSize heapSize = memoryProperties.memoryHeaps[memoryProperties.memoryTypes[memoryTypeIndex].heapIndex].size;
+			return std::min(preferredBlockSize, std::max(heapSize / 8, VkDeviceSize(1024 * 1024)));
+		}
+
+		VkResult allocateDeviceMemory(VkDeviceSize size, uint32_t memoryTypeIndex, VkDeviceMemory *memory, void **mapped)
+		{
+			VkMemoryAllocateInfo memAlloc = vks::initializers::memoryAllocateInfo();
+			memAlloc.allocationSize = size;
+			memAlloc.memoryTypeIndex = memoryTypeIndex;
+			VkResult result = vkAllocateMemory(device, &memAlloc, nullptr, memory);
+			if (result != VK_SUCCESS) {
+				return result;
+			}
+			*mapped = nullptr;
+			if (isHostVisible(memoryTypeIndex)) {
+				result = vkMapMemory(device, *memory, 0, VK_WHOLE_SIZE, 0, mapped);
+				if (result != VK_SUCCESS) {
+					vkFreeMemory(device, *memory, nullptr);
+					return result;
+				}
+			}
+			stats.deviceMemoryCount++;
+			stats.deviceMemoryAllocations++;
+			stats.reservedBytes += size;
+			stats.peakReservedBytes = std::max(stats.peakReservedBytes, stats.reservedBytes);
+			return VK_SUCCESS;
+		}
+
+		void freeDeviceMemory(VkDeviceMemory memory, VkDeviceSize size)
+		{
+			// Freeing implicitly unmaps the memory
+			vkFreeMemory(device, memory, nullptr);
+			stats.deviceMemoryCount--;
+			stats.reservedBytes -= size;
+		}
+
+		void destroyBlock(MemoryBlock *block)
+		{
+			freeDeviceMemory(block->memory, block->size);
+			delete block;
+		}
+
+	public:
+		MemoryAllocator() {}
+
+		~MemoryAllocator()
+		{
+			destroy();
+		}
+
+		/**
+		* Prepare the allocator for use with the given device
+		*
+		* @param physicalDevice Physical device used to query memory properties and limits
+		* @param device Logical device to allocate memory from
+		*/
+		void create(VkPhysicalDevice physicalDevice, VkDevice device)
+		{
+			this->device = device;
+			vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+			VkPhysicalDeviceProperties properties;
+			vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+			nonCoherentAtomSize = std::max(properties.limits.nonCoherentAtomSize, VkDeviceSize(1));
+			pools.resize(memoryProperties.memoryTypeCount * 2);
+		}
+
+		/** @brief Free all memory blocks, all allocations must have been freed before */
+		void destroy()
+		{
+			for (auto &pool : pools) {
+				for (auto block : pool) {
+					if (block->metadata->allocationCount() > 0) {
+						std::cerr << "Memory block of type " << block->memoryTypeIndex << " still has " << block->metadata->allocationCount() << " live allocations on destruction" << std::endl;
+					}
+					destroyBlock(block);
+				}
+				pool.clear();
+			}
+			pools.clear();
+		}
+
+		/**
+		* Allocate a range of device memory
+		*
+		* @param memReqs Memory requirements of the resource (from vkGet*MemoryRequirements)
+		* @param memoryTypeIndex Memory type to allocate from
+		* @param resourceType Linear for buffers and linear images, optimal for tiled images
+		* @param allocation Pointer to the allocation that is filled by the function
+		*
+		* @return VK_SUCCESS or the error of the failed device memory allocation
+		*/
+		VkResult allocate(const VkMemoryRequirements &memReqs, uint32_t memoryTypeIndex, ResourceType resourceType, Allocation *allocation)
+		{
+			assert(device != VK_NULL_HANDLE);
+			std::lock_guard<std::mutex> lock(mutex);
+
+			VkDeviceSize alignment = std::max(memReqs.alignment, VkDeviceSize(1));
+			VkDeviceSize size = memReqs.size;
+			// Ranges of non-coherent memory are aligned to the atom size so they can be flushed without touching their neighbours
+			if (isHostVisible(memoryTypeIndex) && !isHostCoherent(memoryTypeIndex)) {
+				alignment = std::max(alignment, nonCoherentAtomSize);
+				size = memory::alignUp(size, nonCoherentAtomSize);
+			}
+
+			*allocation = Allocation{};
+			allocation->allocator = this;
+			allocation->memoryTypeIndex = memoryTypeIndex;
+			allocation->size = size;
+
+			const VkDeviceSize defaultBlockSize = blockSize(memoryTypeIndex);
+
+			// Large resources get their own device memory object
+			if (size > defaultBlockSize / 2) {
+				VkResult result = allocateDeviceMemory(size, memoryTypeIndex, &allocation->memory, &allocation->mapped);
+				if (result != VK_SUCCESS) {
+					*allocation = Allocation{};
+					return result;
+				}
+			} else {
+				std::vector<MemoryBlock*> &blocks = pool(memoryTypeIndex, resourceType);
+				MemoryBlock *target = nullptr;
+				uint32_t handle = BlockMetadata::INVALID_HANDLE;
+				VkDeviceSize offset = 0;
+				for (auto block : blocks) {
+					handle = block->metadata->allocate(size, alignment, &offset);
+					if (handle != BlockMetadata::INVALID_HANDLE) {
+						target = block;
+						break;
+					}
+				}
+				if (!target) {
+					// Create a new block, smaller blocks are tried if the device runs out of memory
+					MemoryBlock *block = new MemoryBlock();
+					block->memoryTypeIndex = memoryTypeIndex;
+					block->size = defaultBlockSize;
+					VkResult result = VK_ERROR_OUT_OF_DEVICE_MEMORY;
+					while (block->size >= size) {
+						result = allocateDeviceMemory(block->size, memoryTypeIndex, &block->memory, &block->mapped);
+						if (result == VK_SUCCESS) {
+							break;
+						}
+						block->size /= 2;
+					}
+					if (result != VK_SUCCESS) {
+						delete block;
+						*allocation = Allocation{};
+						return result;
+					}
+					if (strategy == AllocationStrategy::Linear) {
+						block->metadata.reset(new LinearBlockMetadata(block->size));
+					} else {
+						block->metadata.reset(new TLSFBlockMetadata(block->size));
+					}
+					blocks.push_back(block);
+					handle = block->metadata->allocate(size, alignment, &offset);
+					assert(handle != BlockMetadata::INVALID_HANDLE);
+					target = block;
+				}
+				allocation->memory = target->memory;
+				allocation->offset = offset;
+				allocation->block = target;
+				allocation->handle = handle;
+				if (target->mapped) {
+					allocation->mapped = static_cast<uint8_t*>(target->mapped) + offset;
+				}
+			}
+
+			stats.allocationCount++;
+			stats.totalAllocations++;
+			stats.usedBytes += allocation->size;
+			stats.peakUsedBytes = std::max(stats.peakUsedBytes, stats.usedBytes);
+			return VK_SUCCESS;
+		}
+
+		/**
+		* Return an allocation to the allocator
+		*
+		* @note Empty blocks are released, except for the last block of a pool to avoid allocation thrashing
+		*/
+		void free(Allocation &allocation)
+		{
+			if (!allocation.valid()) {
+				return;
+			}
+			assert(allocation.allocator == this);
+			std::lock_guard<std::mutex> lock(mutex);
+			stats.allocationCount--;
+			stats.usedBytes -= allocation.size;
+			if (allocation.block) {
+				MemoryBlock *block = allocation.block;
+				block->metadata->free(allocation.handle);
+				if (block->metadata->allocationCount() == 0) {
+					for (auto &blocks : pools) {
+						auto it = std::find(blocks.begin(), blocks.end(), block);
+						if (it != blocks.end()) {
+							if (blocks.size() > 1) {
+								blocks.erase(it);
+								destroyBlock(block);
+							}
+							break;
+						}
+					}
+				}
+			} else {
+				freeDeviceMemory(allocation.memory, allocation.size);
+			}
+			allocation = Allocation{};
+		}
+
+		/**
+		* Flush a range of an allocation to make host writes visible to the device
+		*
+		* @param allocation Allocation to flush
+		* @param size Size of the range to flush, VK_WHOLE_SIZE flushes up to the end of the allocation
+		* @param offset Byte offset relative to the start of the allocation
+		*
+		* @note Does nothing for host coherent memory
+		*/
+		VkResult flush(const Allocation &allocation, VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0)
+		{
+			if (isHostCoherent(allocation.memoryTypeIndex)) {
+				return VK_SUCCESS;
+			}
+			VkMappedMemoryRange mappedRange = mappedRangeFor(allocation, size, offset);
+			return vkFlushMappedMemoryRanges(device, 1, &mappedRange);
+		}
+
+		/**
+		* Invalidate a range of an allocation to make device writes visible to the host
+		*
+		* @note Does nothing for host coherent memory
+		*/
+		VkResult invalidate(const Allocation &allocation, VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0)
+		{
+			if (isHostCoherent(allocation.memoryTypeIndex)) {
+				return VK_SUCCESS;
+			}
+			VkMappedMemoryRange mappedRange = mappedRangeFor(allocation, size, offset);
+			return vkInvalidateMappedMemoryRanges(device, 1, &mappedRange);
+		}
+
+		/** @brief Returns a mapped memory range covering the given range of the allocation, aligned to nonCoherentAtomSize */
+		VkMappedMemoryRange mappedRangeFor(const Allocation &allocation, VkDeviceSize size, VkDeviceSize offset) const
+		{
+			if (size == VK_WHOLE_SIZE) {
+				size = allocation.size - offset;
+			}
+			const VkDeviceSize memorySize = allocation.block ? allocation.block->size : allocation.size;
+			const VkDeviceSize start = memory::alignDown(allocation.offset + offset, nonCoherentAtomSize);
+			const VkDeviceSize end = memory::alignUp(allocation.offset + offset + size, nonCoherentAtomSize);
+			VkMappedMemoryRange mappedRange = vks::initializers::mappedMemoryRange();
+			mappedRange.memory = allocation.memory;
+			mappedRange.offset = start;
+			mappedRange.size = (end >= memorySize) ? VK_WHOLE_SIZE : end - start;
+			return mappedRange;
+		}
+
+		/** @brief Returns the current allocation statistics */
+		Statistics getStatistics()
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			Statistics result = stats;
+			VkDeviceSize freeBytes = 0;
+			VkDeviceSize largestFree = 0;
+			for (auto &blocks : pools) {
+				for (auto block : blocks) {
+					freeBytes += block->size - block->metadata->usedSize();
+					largestFree = std::max(largestFree, block->metadata->largestFreeRange());
+				}
+			}
+			result.fragmentation = (freeBytes > 0) ? 1.0f - (float)largestFree / (float)freeBytes : 0.0f;
+			return result;
+		}
+
+		/** @brief Print the current allocation statistics to stdout */
+		void printStatistics()
+		{
+			const Statistics s = getStatistics();
+			const double mb = 1024.0 * 1024.0;
+			std::cout << std::fixed << std::setprecision(2);
+			std::cout << "Device memory allocator" << std::endl;
+			std::cout << "  device memory objects : " << s.deviceMemoryCount << " (" << s.deviceMemoryAllocations << " vkAllocateMemory calls)" << std::endl;
+			std::cout << "  allocations           : " << s.allocationCount << " (" << s.totalAllocations << " total)" << std::endl;
+			std::cout << "  reserved              : " << (s.reservedBytes / mb) << " MB (peak " << (s.peakReservedBytes / mb) << " MB)" << std::endl;
+			std::cout << "  used                  : " << (s.usedBytes / mb) << " MB (peak " << (s.peakUsedBytes / mb) << " MB)" << std::endl;
+			std::cout << "  fragmentation         : " << (s.fragmentation * 100.0f) << " %" << std::endl;
+		}
+	};
+}
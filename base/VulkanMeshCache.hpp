@@ -0,0 +1,586 @@
+/*
+* Binary mesh cache
+*
+* Stores preprocessed model data (final vertex and index buffers, hierarchy, materials, animations) in a versioned
+* binary file (.vkmesh) in the cache directory, so models don't have to be parsed and converted on every start
+*
+* Copyright (C) by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license (MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <cstring>
+#include <cstdio>
+#include <stdint.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace vks
+{
+	namespace meshcache
+	{
+		/** @brief Identifies files written by this implementation */
+		const uint32_t FILE_MAGIC = 0x534d4b56; // "VKMS"
+		/** @brief Increase if the layout of the container or of any of the stored sections changes */
+		const uint32_t FILE_VERSION = 2;
+		/** @brief Sections are aligned to this so vertex and index data can be read straight from the mapped file */
+		const uint64_t SECTION_ALIGNMENT = 16;
+
+		/** @brief Loader that wrote the cache file */
+		enum ContentType : uint32_t {
+			CONTENT_GLTF = 1,
+			CONTENT_ASSIMP = 2
+		};
+
+		/** @brief Header at the start of each cache file */
+		struct FileHeader
+		{
+			uint32_t magic;
+			uint32_t version;
+			uint32_t headerSize;
+			uint32_t contentType;
+			/** @brief Hash of all loading parameters that affect the stored data (flags, vertex layout, scale) */
+			uint64_t parameterHash;
+			/** @brief Total size of the file, used to detect truncated files */
+			uint64_t fileSize;
+			uint32_t sectionCount;
+			uint32_t reserved;
+		};
+
+		/** @brief Entry of the section table that follows the file header */
+		struct SectionHeader
+		{
+			uint32_t type;
+			uint32_t reserved;
+			uint64_t offset;
+			uint64_t size;
+		};
+
+		/** @brief Section storing the files the cache has been generated from, written by every loader */
+		const uint32_t SECTION_DEPENDENCIES = 0;
+
+		/** @brief 64 bit FNV-1a hash */
+		inline uint64_t hash(const void *data, size_t size, uint64_t seed = 0xcbf29ce484222325ull)
+		{
+			const uint8_t *bytes = static_cast<const uint8_t*>(data);
+			uint64_t hash = seed;
+			for (size_t i = 0; i < size; i++) {
+				hash ^= bytes[i];
+				hash *= 0x100000001b3ull;
+			}
+			return hash;
+		}
+
+		/**
+		* Hash the contents of a file
+		*
+		* @note Mixes in eight bytes per step, which is fast enough to validate large binary buffers on every start
+		*
+		* @return False if the file can't be read
+		*/
+		inline bool hashFile(const std::string &filename, uint64_t *fileHash, uint64_t *fileSize)
+		{
+			std::ifstream is(filename, std::ios::binary | std::ios::in);
+			if (!is.is_open()) {
+				return false;
+			}
+			uint64_t hash = 0xcbf29ce484222325ull;
+			uint64_t size = 0;
+			std::vector<char> chunk(1 << 20);
+			while (is) {
+				is.read(chunk.data(), chunk.size());
+				const size_t count = static_cast<size_t>(is.gcount());
+				size_t i = 0;
+				for (; i + 8 <= count; i += 8) {
+					uint64_t word;
+					memcpy(&word, &chunk[i], sizeof(word));
+					hash = (hash ^ word) * 0x100000001b3ull;
+					hash ^= hash >> 29;
+				}
+				hash = meshcache::hash(&chunk[i], count - i, hash);
+				size += count;
+			}
+			*fileHash = hash;
+			*fileSize = size;
+			return true;
+		}
+
+		/**
+		* Get the size and the modification time of a file without reading it
+		*
+		* @return False if the file doesn't exist
+		*/
+		inline bool getFileStatus(const std::string &filename, uint64_t *fileSize, uint64_t *modified)
+		{
+#if defined(_WIN32)
+			WIN32_FILE_ATTRIBUTE_DATA attributes;
+			if (!GetFileAttributesExA(filename.c_str(), GetFileExInfoStandard, &attributes)) {
+				return false;
+			}
+			*fileSize = (uint64_t(attributes.nFileSizeHigh) << 32) | attributes.nFileSizeLow;
+			*modified = (uint64_t(attributes.ftLastWriteTime.dwHighDateTime) << 32) | attributes.ftLastWriteTime.dwLowDateTime;
+#else
+			struct stat st;
+			if (stat(filename.c_str(), &st) != 0) {
+				return false;
+			}
+			*fileSize = static_cast<uint64_t>(st.st_size);
+#if defined(__APPLE__)
+			*modified = uint64_t(st.st_mtimespec.tv_sec) * 1000000000ull + uint64_t(st.st_mtimespec.tv_nsec);
+#else
+			*modified = uint64_t(st.st_mtim.tv_sec) * 1000000000ull + uint64_t(st.st_mtim.tv_nsec);
+#endif
+#endif
+			return true;
+		}
+
+		/** @brief Returns the directory part of a path including the trailing separator */
+		inline std::string getDirectory(const std::string &filename)
+		{
+			const size_t pos = filename.find_last_of("/\\");
+			return (pos == std::string::npos) ? std::string() : filename.substr(0, pos + 1);
+		}
+
+		/**
+		* Directory the cache files are written to, including the trailing separator
+		*
+		* @note Empty by default, which places the caches in the working directory like the examples' pipeline caches (set by the example base)
+		*/
+		inline std::string &cacheDirectory()
+		{
+			static std::string directory;
+			return directory;
+		}
+
+		/**
+		* Returns the name of the cache file for a source file
+		*
+		* @note The file lives in the cache directory, the hash of the source path keeps models with the same name in different directories apart
+		*/
+		inline std::string getFileName(const std::string &filename)
+		{
+			const size_t pos = filename.find_last_of("/\\");
+			const std::string name = (pos == std::string::npos) ? filename : filename.substr(pos + 1);
+			char pathHash[17];
+			snprintf(pathHash, sizeof(pathHash), "%016llx", static_cast<unsigned long long>(hash(filename.data(), filename.size())));
+			return cacheDirectory() + name + "." + pathHash + ".vkmesh";
+		}
+
+		/** @brief Appends plain data to a section */
+		class Writer
+		{
+		public:
+			std::vector<uint8_t> data;
+
+			void write(const void *src, size_t size)
+			{
+				const uint8_t *bytes = static_cast<const uint8_t*>(src);
+				data.insert(data.end(), bytes, bytes + size);
+			}
+
+			template<typename T>
+			void write(const T &value)
+			{
+				write(&value, sizeof(T));
+			}
+
+			void writeString(const std::string &value)
+			{
+				write(static_cast<uint32_t>(value.size()));
+				write(value.data(), value.size());
+			}
+
+			/** @brief Pads the section so the next write starts at a multiple of the given alignment */
+			void align(size_t alignment)
+			{
+				data.resize((data.size() + alignment - 1) / alignment * alignment, 0);
+			}
+
+			/** @brief Arrays are stored aligned, so they can be used directly from the mapped file */
+			template<typename T>
+			void writeVector(const std::vector<T> &values)
+			{
+				write(static_cast<uint64_t>(values.size()));
+				align(SECTION_ALIGNMENT);
+				write(values.data(), values.size() * sizeof(T));
+			}
+		};
+
+		/** @brief Bounds checked reads from a section, any read past the end marks the reader as failed and returns zeroed data */
+		class Reader
+		{
+		private:
+			const uint8_t *data = nullptr;
+			uint64_t size = 0;
+			uint64_t position = 0;
+		public:
+			bool failed = false;
+
+			Reader() {}
+			Reader(const void *data, uint64_t size) : data(static_cast<const uint8_t*>(data)), size(size) {}
+
+			/** @brief Returns a pointer to the next size bytes and skips them, nullptr if not enough data is left */
+			const void *skip(uint64_t count)
+			{
+				if (failed || (count > size - position)) {
+					failed = true;
+					return nullptr;
+				}
+				const void *ptr = data + position;
+				position += count;
+				return ptr;
+			}
+
+			void read(void *dst, size_t count)
+			{
+				const void *src = skip(count);
+				if (src) {
+					memcpy(dst, src, count);
+				} else {
+					memset(dst, 0, count);
+				}
+			}
+
+			template<typename T>
+			T read()
+			{
+				T value;
+				read(&value, sizeof(T));
+				return value;
+			}
+
+			void align(uint64_t alignment)
+			{
+				skip((position + alignment - 1) / alignment * alignment - position);
+			}
+
+			std::string readString()
+			{
+				const uint32_t length = read<uint32_t>();
+				const char *chars = static_cast<const char*>(skip(length));
+				return chars ? std::string(chars, length) : std::string();
+			}
+
+			template<typename T>
+			std::vector<T> readVector()
+			{
+				const uint64_t count = read<uint64_t>();
+				align(SECTION_ALIGNMENT);
+				if (failed || (count > (size - position) / sizeof(T))) {
+					failed = true;
+					return std::vector<T>();
+				}
+				std::vector<T> values(static_cast<size_t>(count));
+				read(values.data(), values.size() * sizeof(T));
+				return values;
+			}
+
+			/** @brief Returns a pointer to an array stored with writeVector without copying it */
+			template<typename T>
+			const T *mapVector(uint64_t *count)
+			{
+				*count = read<uint64_t>();
+				align(SECTION_ALIGNMENT);
+				if (failed || (*count > (size - position) / sizeof(T))) {
+					failed = true;
+					*count = 0;
+					return nullptr;
+				}
+				return static_cast<const T*>(skip(*count * sizeof(T)));
+			}
+		};
+
+		/** @brief Read-only memory mapping of a complete file */
+		class MappedFile
+		{
+		private:
+#if defined(_WIN32)
+			HANDLE file = INVALID_HANDLE_VALUE;
+			HANDLE mapping = NULL;
+#else
+			int fd = -1;
+#endif
+		public:
+			const uint8_t *data = nullptr;
+			uint64_t size = 0;
+
+			MappedFile() {}
+			MappedFile(const MappedFile&) = delete;
+			MappedFile &operator=(const MappedFile&) = delete;
+			~MappedFile()
+			{
+				close();
+			}
+
+			bool open(const std::string &filename)
+			{
+				close();
+#if defined(_WIN32)
+				file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+				if (file == INVALID_HANDLE_VALUE) {
+					return false;
+				}
+				LARGE_INTEGER fileSize;
+				if (!GetFileSizeEx(file, &fileSize) || (fileSize.QuadPart == 0)) {
+					close();
+					return false;
+				}
+				size = static_cast<uint64_t>(fileSize.QuadPart);
+				mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+				data = mapping ? static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0)) : nullptr;
+#else
+				fd = ::open(filename.c_str(), O_RDONLY);
+				if (fd < 0) {
+					return false;
+				}
+				struct stat st;
+				if ((fstat(fd, &st) != 0) || (st.st_size == 0)) {
+					close();
+					return false;
+				}
+				size = static_cast<uint64_t>(st.st_size);
+				void *ptr = mmap(nullptr, static_cast<size_t>(size), PROT_READ, MAP_PRIVATE, fd, 0);
+				data = (ptr != MAP_FAILED) ? static_cast<const uint8_t*>(ptr) : nullptr;
+#endif
+				if (!data) {
+					close();
+					return false;
+				}
+				return true;
+			}
+
+			void close()
+			{
+#if defined(_WIN32)
+				if (data) {
+					UnmapViewOfFile(data);
+				}
+				if (mapping) {
+					CloseHandle(mapping);
+				}
+				if (file != INVALID_HANDLE_VALUE) {
+					CloseHandle(file);
+				}
+				mapping = NULL;
+				file = INVALID_HANDLE_VALUE;
+#else
+				if (data) {
+					munmap(const_cast<uint8_t*>(data), static_cast<size_t>(size));
+				}
+				if (fd >= 0) {
+					::close(fd);
+				}
+				fd = -1;
+#endif
+				data = nullptr;
+				size = 0;
+			}
+		};
+
+		/**
+		* Collects the sections of a cache file and writes them to disk
+		*
+		* @note Source files are hashed when they are added, so the cache describes the state of the sources it has been generated from
+		*/
+		class CacheWriter
+		{
+		private:
+			std::vector<std::pair<uint32_t, std::vector<uint8_t>>> sections;
+			Writer dependencies;
+			uint32_t dependencyCount = 0;
+			bool dependenciesValid = true;
+		public:
+			/**
+			* Add a file the cached data depends on
+			*
+			* @param directory Directory the path is relative to
+			* @param path Path of the file, stored as passed so the cache stays valid if the model directory is moved
+			*/
+			void addDependency(const std::string &directory, const std::string &path)
+			{
+				uint64_t fileHash, fileSize, modified;
+				if (!getFileStatus(directory + path, &fileSize, &modified) || !hashFile(directory + path, &fileHash, &fileSize)) {
+					dependenciesValid = false;
+					return;
+				}
+				dependencies.writeString(path);
+				dependencies.write(fileHash);
+				dependencies.write(fileSize);
+				dependencies.write(modified);
+				dependencyCount++;
+			}
+
+			/** @brief Add a section, the section type is defined by the loader */
+			void addSection(uint32_t type, Writer &writer)
+			{
+				sections.push_back(std::make_pair(type, std::move(writer.data)));
+			}
+
+			/**
+			* Write the cache file
+			*
+			* @note The data is written to a temporary file first which then replaces the target, so concurrent runs never see a partially written cache
+			*
+			* @return True if the file has been written
+			*/
+			bool save(const std::string &filename, ContentType contentType, uint64_t parameterHash)
+			{
+				if (!dependenciesValid) {
+					return false;
+				}
+				Writer dependencySection;
+				dependencySection.write(dependencyCount);
+				dependencySection.write(dependencies.data.data(), dependencies.data.size());
+				sections.insert(sections.begin(), std::make_pair(SECTION_DEPENDENCIES, std::move(dependencySection.data)));
+
+				FileHeader header{};
+				header.magic = FILE_MAGIC;
+				header.version = FILE_VERSION;
+				header.headerSize = sizeof(FileHeader);
+				header.contentType = contentType;
+				header.parameterHash = parameterHash;
+				header.sectionCount = static_cast<uint32_t>(sections.size());
+
+				std::vector<SectionHeader> table(sections.size());
+				uint64_t offset = sizeof(FileHeader) + table.size() * sizeof(SectionHeader);
+				for (size_t i = 0; i < sections.size(); i++) {
+					offset = (offset + SECTION_ALIGNMENT - 1) & ~(SECTION_ALIGNMENT - 1);
+					table[i].type = sections[i].first;
+					table[i].reserved = 0;
+					table[i].offset = offset;
+					table[i].size = sections[i].second.size();
+					offset += table[i].size;
+				}
+				header.fileSize = offset;
+
+#if defined(_WIN32)
+				const std::string tempFilename = filename + ".tmp" + std::to_string(GetCurrentProcessId());
+#else
+				const std::string tempFilename = filename + ".tmp" + std::to_string(getpid());
+#endif
+				{
+					std::ofstream os(tempFilename, std::ios::binary | std::ios::out | std::ios::trunc);
+					if (!os.is_open()) {
+						return false;
+					}
+					os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+					os.write(reinterpret_cast<const char*>(table.data()), table.size() * sizeof(SectionHeader));
+					uint64_t position = sizeof(FileHeader) + table.size() * sizeof(SectionHeader);
+					const char padding[SECTION_ALIGNMENT] = {};
+					for (size_t i = 0; i < sections.size(); i++) {
+						os.write(padding, static_cast<std::streamsize>(table[i].offset - position));
+						os.write(reinterpret_cast<const char*>(sections[i].second.data()), sections[i].second.size());
+						position = table[i].offset + table[i].size;
+					}
+					os.close();
+					if (os.fail()) {
+						std::remove(tempFilename.c_str());
+						return false;
+					}
+				}
+#if defined(_WIN32)
+				const bool renamed = MoveFileExA(tempFilename.c_str(), filename.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+				const bool renamed = std::rename(tempFilename.c_str(), filename.c_str()) == 0;
+#endif
+				if (!renamed) {
+					std::remove(tempFilename.c_str());
+				}
+				return renamed;
+			}
+		};
+
+		/**
+		* Maps a cache file and validates it against the current sources and loading parameters
+		*/
+		class CacheReader
+		{
+		private:
+			MappedFile file;
+			const SectionHeader *table = nullptr;
+			uint32_t sectionCount = 0;
+		public:
+			/**
+			* Open a cache file
+			*
+			* @param filename Cache file to open
+			* @param directory Directory the dependencies stored in the cache are relative to
+			* @param contentType Expected loader of the cached data
+			* @param parameterHash Hash of the current loading parameters
+			*
+			* @return True if the cache exists, is intact and all of the files it was generated from are unchanged
+			*
+			* @note Dependencies with the stored size and modification time are not read, only files that have been touched are hashed
+			*/
+			bool open(const std::string &filename, const std::string &directory, ContentType contentType, uint64_t parameterHash)
+			{
+				if (!file.open(filename) || (file.size < sizeof(FileHeader))) {
+					return false;
+				}
+				FileHeader header;
+				memcpy(&header, file.data, sizeof(header));
+				if ((header.magic != FILE_MAGIC) || (header.version != FILE_VERSION) || (header.headerSize != sizeof(FileHeader)) || (header.contentType != contentType)) {
+					return false;
+				}
+				if ((header.parameterHash != parameterHash) || (header.fileSize != file.size)) {
+					return false;
+				}
+				if (header.sectionCount > (file.size - sizeof(FileHeader)) / sizeof(SectionHeader)) {
+					return false;
+				}
+				table = reinterpret_cast<const SectionHeader*>(file.data + sizeof(FileHeader));
+				sectionCount = header.sectionCount;
+				for (uint32_t i = 0; i < sectionCount; i++) {
+					if ((table[i].offset > file.size) || (table[i].size > file.size - table[i].offset)) {
+						return false;
+					}
+				}
+
+				Reader dependencies = section(SECTION_DEPENDENCIES);
+				const uint32_t dependencyCount = dependencies.read<uint32_t>();
+				for (uint32_t i = 0; i < dependencyCount; i++) {
+					const std::string path = dependencies.readString();
+					const uint64_t storedHash = dependencies.read<uint64_t>();
+					const uint64_t storedSize = dependencies.read<uint64_t>();
+					const uint64_t storedModified = dependencies.read<uint64_t>();
+					uint64_t fileHash, fileSize, modified;
+					if (dependencies.failed || !getFileStatus(directory + path, &fileSize, &modified) || (fileSize != storedSize)) {
+						return false;
+					}
+					if (modified == storedModified) {
+						continue;
+					}
+					if (!hashFile(directory + path, &fileHash, &fileSize) || (fileHash != storedHash) || (fileSize != storedSize)) {
+						return false;
+					}
+				}
+				return !dependencies.failed && (dependencyCount > 0);
+			}
+
+			/** @brief Returns a reader for the first section of the given type, the reader is marked as failed if there is no such section */
+			Reader section(uint32_t type) const
+			{
+				for (uint32_t i = 0; i < sectionCount; i++) {
+					if (table[i].type == type) {
+						return Reader(file.data + table[i].offset, table[i].size);
+					}
+				}
+				Reader reader;
+				reader.failed = true;
+				return reader;
+			}
+		};
+	}
+}
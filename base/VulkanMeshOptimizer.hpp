@@ -0,0 +1,423 @@
+/*
+* Mesh optimization for the vertex pipeline
+*
+* Reorders the triangles of indexed triangle lists for the post-transform vertex cache (Tipsify, see "Fast Triangle Reordering for Vertex Locality and
+* Reduced Overdraw" by Sander, Nehab and Barczak), reorders clusters of those triangles so outward facing parts are drawn first to reduce overdraw
+* and reorders vertices in the order they are first referenced, so vertex fetches access memory sequentially
+*
+* Copyright (C) by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license (MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <math.h>
+#include <stdint.h>
+#include <stddef.h>
+
+namespace vks
+{
+	namespace meshoptimizer
+	{
+		/** @brief Size of the FIFO post-transform cache assumed for optimizing and simulated for the statistics */
+		const uint32_t DEFAULT_CACHE_SIZE = 16;
+
+		/** @brief Clusters are split where the cache miss ratio of the cluster so far is within this factor of the whole mesh's ratio */
+		const float DEFAULT_OVERDRAW_THRESHOLD = 1.05f;
+
+		/** @brief Result of simulating a FIFO post-transform vertex cache */
+		struct VertexCacheStatistics
+		{
+			uint64_t triangles = 0;
+			/** @brief Number of distinct vertices referenced by the indices */
+			uint64_t vertices = 0;
+			/** @brief Number of vertex shader invocations (cache misses) */
+			uint64_t transforms = 0;
+
+			/** @brief Average cache miss ratio, transformed vertices per triangle (about 0.5 is optimal for regular meshes, 3 is the worst case) */
+			double acmr() const
+			{
+				return triangles > 0 ? (double)transforms / (double)triangles : 0.0;
+			}
+
+			/** @brief Average transform to vertex ratio, transformed vertices per referenced vertex (1 is optimal) */
+			double atvr() const
+			{
+				return vertices > 0 ? (double)transforms / (double)vertices : 0.0;
+			}
+
+			void add(const VertexCacheStatistics &other)
+			{
+				triangles += other.triangles;
+				vertices += other.vertices;
+				transforms += other.transforms;
+			}
+		};
+
+		/** @brief Statistics of a mesh before and after optimizing it */
+		struct Statistics
+		{
+			VertexCacheStatistics before;
+			VertexCacheStatistics after;
+			/** @brief Number of triangle clusters reordered for overdraw */
+			uint64_t clusters = 0;
+
+			void add(const Statistics &other)
+			{
+				before.add(other.before);
+				after.add(other.after);
+				clusters += other.clusters;
+			}
+		};
+
+		/**
+		* Simulate a FIFO post-transform cache of the given size for an indexed triangle list
+		*
+		* @param indices Triangle list indices, all smaller than vertexCount
+		* @param indexCount Number of indices (a multiple of three)
+		* @param vertexCount Number of vertices referenced by the indices
+		* @param cacheSize Number of entries of the simulated cache
+		*/
+		inline VertexCacheStatistics analyzeVertexCache(const uint32_t *indices, size_t indexCount, uint32_t vertexCount, uint32_t cacheSize = DEFAULT_CACHE_SIZE)
+		{
+			VertexCacheStatistics stats;
+			stats.triangles = indexCount / 3;
+			// A vertex is in the cache if fewer than cacheSize other vertices have been transformed since it was transformed
+			std::vector<uint32_t> timestamps(vertexCount, 0);
+			std::vector<bool> referenced(vertexCount, false);
+			uint32_t time = cacheSize + 1;
+			for (size_t i = 0; i < stats.triangles * 3; i++) {
+				const uint32_t v = indices[i];
+				if (time - timestamps[v] > cacheSize) {
+					timestamps[v] = time++;
+					stats.transforms++;
+				}
+				if (!referenced[v]) {
+					referenced[v] = true;
+					stats.vertices++;
+				}
+			}
+			return stats;
+		}
+
+		/**
+		* Reorder triangles for the post-transform vertex cache with Tipsify
+		*
+		* Triangles are emitted by fanning around vertices, the next fanning vertex is the one of the last triangles that will still be in the cache
+		* after its remaining triangles have been emitted. If there is none, a vertex of a recently emitted triangle or the next unprocessed vertex is used.
+		*
+		* @param indices Triangle list indices, reordered in place, the winding of the triangles is kept
+		* @param indexCount Number of indices (a multiple of three)
+		* @param vertexCount Number of vertices referenced by the indices
+		* @param cacheSize Size of the cache the order is optimized for
+		* @param clusters If not null, receives the first triangle of every run that starts with a cold cache (always starts with triangle 0)
+		*/
+		inline void optimizeVertexCache(uint32_t *indices, size_t indexCount, uint32_t vertexCount, uint32_t cacheSize = DEFAULT_CACHE_SIZE, std::vector<uint32_t> *clusters = nullptr)
+		{
+			const uint32_t triangleCount = static_cast<uint32_t>(indexCount / 3);
+			if (clusters) {
+				clusters->clear();
+			}
+			if (triangleCount == 0) {
+				return;
+			}
+			// Triangles adjacent to each vertex, stored consecutively starting at adjacencyOffsets[v]
+			std::vector<uint32_t> liveTriangles(vertexCount, 0);
+			for (uint32_t i = 0; i < triangleCount * 3; i++) {
+				liveTriangles[indices[i]]++;
+			}
+			std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+			for (uint32_t v = 0; v < vertexCount; v++) {
+				adjacencyOffsets[v + 1] = adjacencyOffsets[v] + liveTriangles[v];
+			}
+			std::vector<uint32_t> adjacency(triangleCount * 3);
+			{
+				std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+				for (uint32_t i = 0; i < triangleCount * 3; i++) {
+					adjacency[fill[indices[i]]++] = i / 3;
+				}
+			}
+
+			std::vector<uint32_t> timestamps(vertexCount, 0);
+			std::vector<bool> emitted(triangleCount, false);
+			std::vector<uint32_t> deadEnds;
+			std::vector<uint32_t> candidates;
+			std::vector<uint32_t> result;
+			result.reserve(triangleCount * 3);
+			uint32_t time = cacheSize + 1;
+			uint32_t cursor = 0;
+
+			auto inCache = [&](uint32_t v) {
+				return time - timestamps[v] <= cacheSize;
+			};
+			// Vertex with remaining triangles from the dead end stack or the input order, -1 if all triangles have been emitted
+			auto skipDeadEnd = [&]() -> int64_t {
+				while (!deadEnds.empty()) {
+					const uint32_t v = deadEnds.back();
+					deadEnds.pop_back();
+					if (liveTriangles[v] > 0) {
+						return v;
+					}
+				}
+				while (cursor < vertexCount) {
+					if (liveTriangles[cursor] > 0) {
+						return cursor++;
+					}
+					cursor++;
+				}
+				return -1;
+			};
+
+			int64_t fanning = skipDeadEnd();
+			while (fanning >= 0) {
+				const uint32_t f = static_cast<uint32_t>(fanning);
+				if (clusters && !inCache(f)) {
+					clusters->push_back(static_cast<uint32_t>(result.size() / 3));
+				}
+				candidates.clear();
+				for (uint32_t a = adjacencyOffsets[f]; a < adjacencyOffsets[f + 1]; a++) {
+					const uint32_t t = adjacency[a];
+					if (emitted[t]) {
+						continue;
+					}
+					emitted[t] = true;
+					for (uint32_t k = 0; k < 3; k++) {
+						const uint32_t v = indices[t * 3 + k];
+						result.push_back(v);
+						deadEnds.push_back(v);
+						candidates.push_back(v);
+						liveTriangles[v]--;
+						if (!inCache(v)) {
+							timestamps[v] = time++;
+						}
+					}
+				}
+				// Prefer the candidate that entered the cache earliest among those whose remaining triangles still fit into the cache
+				int64_t next = -1;
+				int64_t bestPriority = -1;
+				for (uint32_t v : candidates) {
+					if (liveTriangles[v] == 0) {
+						continue;
+					}
+					int64_t priority = 0;
+					if (time - timestamps[v] + 2 * liveTriangles[v] <= cacheSize) {
+						priority = time - timestamps[v];
+					}
+					if (priority > bestPriority) {
+						bestPriority = priority;
+						next = v;
+					}
+				}
+				fanning = (next >= 0) ? next : skipDeadEnd();
+			}
+			if (clusters && (clusters->empty() || (*clusters)[0] != 0)) {
+				clusters->insert(clusters->begin(), 0);
+			}
+			memcpy(indices, result.data(), result.size() * sizeof(uint32_t));
+		}
+
+		/**
+		* Reorder the clusters of a cache optimized triangle list so that clusters facing away from the center of the mesh are drawn first
+		*
+		* Such clusters are more likely to occlude the rest of the mesh, so more fragments are rejected by the depth test. Clusters are split further
+		* where the cache miss ratio since the start of the cluster is within threshold times the ratio of the whole mesh, trading a few cache misses for
+		* smaller clusters that can be sorted more effectively.
+		*
+		* @param indices Triangle list indices in vertex cache order (see optimizeVertexCache), reordered in place
+		* @param indexCount Number of indices (a multiple of three)
+		* @param positions Vertex positions (three floats at the start of each vertex)
+		* @param vertexStride Distance between the positions of consecutive vertices in bytes
+		* @param vertexCount Number of vertices referenced by the indices
+		* @param clusters Clusters starting with a cold cache as returned by optimizeVertexCache
+		* @param threshold Maximum increase of the cache miss ratio caused by splitting clusters (1.0 only uses the given clusters)
+		* @param cacheSize Size of the cache the order is optimized for
+		*
+		* @return Number of clusters
+		*/
+		inline uint32_t optimizeOverdraw(uint32_t *indices, size_t indexCount, const float *positions, size_t vertexStride, uint32_t vertexCount, const std::vector<uint32_t> &clusters, float threshold = DEFAULT_OVERDRAW_THRESHOLD, uint32_t cacheSize = DEFAULT_CACHE_SIZE)
+		{
+			const uint32_t triangleCount = static_cast<uint32_t>(indexCount / 3);
+			if (triangleCount == 0) {
+				return 0;
+			}
+			const uint8_t *positionData = reinterpret_cast<const uint8_t*>(positions);
+			auto position = [&](uint32_t v, uint32_t axis) {
+				return reinterpret_cast<const float*>(positionData + v * vertexStride)[axis];
+			};
+
+			// Split the cold start clusters where their miss ratio so far is already close to the one of the mesh
+			const double meshAcmr = analyzeVertexCache(indices, indexCount, vertexCount, cacheSize).acmr();
+			std::vector<uint32_t> splits;
+			{
+				std::vector<uint32_t> timestamps(vertexCount, 0);
+				uint32_t time = cacheSize + 1;
+				for (size_t c = 0; c < clusters.size(); c++) {
+					const uint32_t end = (c + 1 < clusters.size()) ? clusters[c + 1] : triangleCount;
+					uint32_t start = clusters[c];
+					splits.push_back(start);
+					// Clusters start with a cold cache
+					time += cacheSize + 1;
+					uint32_t misses = 0;
+					for (uint32_t t = start; t < end; t++) {
+						for (uint32_t k = 0; k < 3; k++) {
+							const uint32_t v = indices[t * 3 + k];
+							if (time - timestamps[v] > cacheSize) {
+								timestamps[v] = time++;
+								misses++;
+							}
+						}
+						const uint32_t triangles = t + 1 - start;
+						if ((t + 1 < end) && ((double)misses <= threshold * meshAcmr * triangles)) {
+							start = t + 1;
+							splits.push_back(start);
+							time += cacheSize + 1;
+							misses = 0;
+						}
+					}
+				}
+			}
+
+			// Sort clusters by how much their area weighted normal points away from the mesh's centroid
+			struct Cluster {
+				uint32_t first;
+				uint32_t count;
+				float sortKey;
+			};
+			std::vector<Cluster> sorted(splits.size());
+			float meshCentroid[3] = { 0.0f, 0.0f, 0.0f };
+			float meshArea = 0.0f;
+			std::vector<float> clusterData(splits.size() * 7, 0.0f);
+			for (size_t c = 0; c < splits.size(); c++) {
+				const uint32_t end = (c + 1 < splits.size()) ? splits[c + 1] : triangleCount;
+				float *data = &clusterData[c * 7];
+				for (uint32_t t = splits[c]; t < end; t++) {
+					float p[3][3];
+					for (uint32_t k = 0; k < 3; k++) {
+						for (uint32_t axis = 0; axis < 3; axis++) {
+							p[k][axis] = position(indices[t * 3 + k], axis);
+						}
+					}
+					const float e0[3] = { p[1][0] - p[0][0], p[1][1] - p[0][1], p[1][2] - p[0][2] };
+					const float e1[3] = { p[2][0] - p[0][0], p[2][1] - p[0][1], p[2][2] - p[0][2] };
+					// Twice the area weighted normal
+					const float n[3] = { e0[1] * e1[2] - e0[2] * e1[1], e0[2] * e1[0] - e0[0] * e1[2], e0[0] * e1[1] - e0[1] * e1[0] };
+					const float area = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+					for (uint32_t axis = 0; axis < 3; axis++) {
+						const float center = (p[0][axis] + p[1][axis] + p[2][axis]) / 3.0f;
+						data[axis] += center * area;
+						data[3 + axis] += n[axis];
+					}
+					data[6] += area;
+				}
+				for (uint32_t axis = 0; axis < 3; axis++) {
+					meshCentroid[axis] += data[axis];
+				}
+				meshArea += data[6];
+				sorted[c].first = splits[c];
+				sorted[c].count = end - splits[c];
+			}
+			if (meshArea > 0.0f) {
+				for (uint32_t axis = 0; axis < 3; axis++) {
+					meshCentroid[axis] /= meshArea;
+				}
+			}
+			for (size_t c = 0; c < sorted.size(); c++) {
+				const float *data = &clusterData[c * 7];
+				float key = 0.0f;
+				const float normalLength = sqrtf(data[3] * data[3] + data[4] * data[4] + data[5] * data[5]);
+				if ((data[6] > 0.0f) && (normalLength > 0.0f)) {
+					for (uint32_t axis = 0; axis < 3; axis++) {
+						key += (data[axis] / data[6] - meshCentroid[axis]) * data[3 + axis] / normalLength;
+					}
+				}
+				sorted[c].sortKey = key;
+			}
+			std::stable_sort(sorted.begin(), sorted.end(), [](const Cluster &a, const Cluster &b) { return a.sortKey > b.sortKey; });
+
+			std::vector<uint32_t> result;
+			result.reserve(triangleCount * 3);
+			for (const Cluster &cluster : sorted) {
+				result.insert(result.end(), indices + cluster.first * 3, indices + (cluster.first + cluster.count) * 3);
+			}
+			memcpy(indices, result.data(), result.size() * sizeof(uint32_t));
+			return static_cast<uint32_t>(sorted.size());
+		}
+
+		/**
+		* Build a remap table that orders vertices by their first reference in the indices, unreferenced vertices are moved to the end
+		*
+		* @param remap Receives the new position of each vertex
+		*
+		* @return Number of referenced vertices
+		*/
+		inline uint32_t buildVertexFetchRemap(std::vector<uint32_t> &remap, const uint32_t *indices, size_t indexCount, uint32_t vertexCount)
+		{
+			const uint32_t unassigned = ~0u;
+			remap.assign(vertexCount, unassigned);
+			uint32_t next = 0;
+			for (size_t i = 0; i < indexCount; i++) {
+				if (remap[indices[i]] == unassigned) {
+					remap[indices[i]] = next++;
+				}
+			}
+			const uint32_t referenced = next;
+			for (uint32_t v = 0; v < vertexCount; v++) {
+				if (remap[v] == unassigned) {
+					remap[v] = next++;
+				}
+			}
+			return referenced;
+		}
+
+		/** @brief Move vertices of vertexSize bytes to the positions given by a remap table */
+		inline void remapVertexBuffer(void *vertices, size_t vertexSize, uint32_t vertexCount, const std::vector<uint32_t> &remap)
+		{
+			const uint8_t *source = static_cast<const uint8_t*>(vertices);
+			std::vector<uint8_t> result(vertexSize * vertexCount);
+			for (uint32_t v = 0; v < vertexCount; v++) {
+				memcpy(&result[remap[v] * vertexSize], source + v * vertexSize, vertexSize);
+			}
+			memcpy(vertices, result.data(), result.size());
+		}
+
+		/** @brief Replace all indices by their new positions from a remap table */
+		inline void remapIndexBuffer(uint32_t *indices, size_t indexCount, const std::vector<uint32_t> &remap)
+		{
+			for (size_t i = 0; i < indexCount; i++) {
+				indices[i] = remap[indices[i]];
+			}
+		}
+
+		/**
+		* Run all optimizations on a mesh: vertex cache order, overdraw order and vertex fetch order
+		*
+		* @param indices Triangle list indices relative to the first vertex of the mesh, reordered and remapped in place
+		* @param indexCount Number of indices (a multiple of three)
+		* @param vertices Vertex data, reordered in place
+		* @param vertexSize Size of a vertex in bytes
+		* @param vertexCount Number of vertices
+		* @param positionOffset Offset of the vertex position (three floats) inside a vertex in bytes
+		*
+		* @return Vertex cache statistics before and after optimizing
+		*/
+		inline Statistics optimizeMesh(uint32_t *indices, size_t indexCount, void *vertices, size_t vertexSize, uint32_t vertexCount, size_t positionOffset)
+		{
+			Statistics stats;
+			stats.before = analyzeVertexCache(indices, indexCount, vertexCount);
+			std::vector<uint32_t> clusters;
+			optimizeVertexCache(indices, indexCount, vertexCount, DEFAULT_CACHE_SIZE, &clusters);
+			const float *positions = reinterpret_cast<const float*>(static_cast<const uint8_t*>(vertices) + positionOffset);
+			stats.clusters = optimizeOverdraw(indices, indexCount, positions, vertexSize, vertexCount, clusters);
+			std::vector<uint32_t> remap;
+			buildVertexFetchRemap(remap, indices, indexCount, vertexCount);
+			remapVertexBuffer(vertices, vertexSize, vertexCount, remap);
+			remapIndexBuffer(indices, indexCount, remap);
+			stats.after = analyzeVertexCache(indices, indexCount, vertexCount);
+			return stats;
+		}
+	}
+}
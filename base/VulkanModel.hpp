@@ -11,6 +11,7 @@
 #include <stdlib.h>
 #include <string>
 #include <fstream>
+#include <iomanip>
 #include <vector>
 
 #include "vulkan/vulkan.h"
@@ -26,6 +27,8 @@
 
 #include "VulkanDevice.hpp"
 #include "VulkanBuffer.hpp"
+#include "VulkanMeshCache.hpp"
+#include "VulkanMeshOptimizer.hpp"
 
 #if defined(__ANDROID__)
 #include <android/asset_manager.h>
@@ -56,28 +59,45 @@ namespace vks
 			this->components = std::move(components);
 		}
 
+		static uint32_t componentSize(Component component)
+		{
+			switch (component)
+			{
+			case VERTEX_COMPONENT_UV:
+				return 2 * sizeof(float);
+			case VERTEX_COMPONENT_DUMMY_FLOAT:
+				return sizeof(float);
+			case VERTEX_COMPONENT_DUMMY_VEC4:
+				return 4 * sizeof(float);
+			default:
+				// All components except the ones listed above are made up of 3 floats
+				return 3 * sizeof(float);
+			}
+		}
+
 		uint32_t stride()
 		{
 			uint32_t res = 0;
 			for (auto& component : components)
 			{
-				switch (component)
+				res += componentSize(component);
+			}
+			return res;
+		}
+
+		/** @brief Byte offset of the first occurence of a component within a vertex, -1 if the layout does not contain it */
+		int32_t offset(Component component)
+		{
+			uint32_t res = 0;
+			for (auto& c : components)
+			{
+				if (c == component)
 				{
-				case VERTEX_COMPONENT_UV:
-					res += 2 * sizeof(float);
-					break;
-				case VERTEX_COMPONENT_DUMMY_FLOAT:
-					res += sizeof(float);
-					break;
-				case VERTEX_COMPONENT_DUMMY_VEC4:
-					res += 4 * sizeof(float);
-					break;
-				default:
-					// All components except the ones listed above are made up of 3 floats
-					res += 3 * sizeof(float);
+					return static_cast<int32_t>(res);
 				}
+				res += componentSize(c);
 			}
-			return res;
+			return -1;
 		}
 	};
 
@@ -131,16 +151,174 @@ namespace vks
 			glm::vec3 size;
 		} dim;
 
+		/** @brief Store the converted vertex and index data in a binary cache file (.vkmesh) in vks::meshcache::cacheDirectory() and load from it if the source and loading parameters are unchanged */
+		bool enableMeshCache = true;
+
+		/** @brief Reorder the triangles and vertices of every part for the vertex cache, overdraw and vertex fetch at load time (see vks::meshoptimizer) */
+		bool optimizeMeshes = false;
+		/** @brief Vertex cache statistics of all parts before and after the optimization (only if optimizeMeshes is set, stored in the mesh cache) */
+		vks::meshoptimizer::Statistics meshOptimization;
+
+		/** @brief Sections of the mesh cache file */
+		enum MeshCacheSection : uint32_t {
+			MESH_CACHE_SECTION_PARTS = 1,
+			MESH_CACHE_SECTION_VERTICES = 2,
+			MESH_CACHE_SECTION_INDICES = 3,
+			MESH_CACHE_SECTION_OPTIMIZATION = 4
+		};
+
 		/** @brief Release all Vulkan resources of this model */
 		void destroy()
 		{		
 			assert(device);
-			vkDestroyBuffer(device, vertices.buffer, nullptr);
-			vkFreeMemory(device, vertices.memory, nullptr);
+			vertices.destroy();
 			if (indices.buffer != VK_NULL_HANDLE)
 			{
-				vkDestroyBuffer(device, indices.buffer, nullptr);
-				vkFreeMemory(device, indices.memory, nullptr);
+				indices.destroy();
+			}
+		}
+
+		/** @brief Hash of all parameters that change the data stored in the mesh cache */
+		static uint64_t meshCacheParameterHash(const vks::VertexLayout &layout, const glm::vec3 &scale, const glm::vec2 &uvscale, const glm::vec3 &center, bool optimizeMeshes)
+		{
+			uint64_t hash = vks::meshcache::hash(layout.components.data(), layout.components.size() * sizeof(Component));
+			const int flags = defaultFlags;
+			hash = vks::meshcache::hash(&flags, sizeof(flags), hash);
+			hash = vks::meshcache::hash(&scale, sizeof(scale), hash);
+			hash = vks::meshcache::hash(&uvscale, sizeof(uvscale), hash);
+			hash = vks::meshcache::hash(&center, sizeof(center), hash);
+			// Only mixed in if set, so caches of unoptimized models stay valid
+			if (optimizeMeshes) {
+				const uint32_t optimization = vks::meshoptimizer::DEFAULT_CACHE_SIZE;
+				hash = vks::meshcache::hash(&optimization, sizeof(optimization), hash);
+			}
+			return hash;
+		}
+
+		/** @brief Create the device local vertex and index buffers and queue the upload of their data */
+		void createBuffers(vks::VulkanDevice *device, const void *vertexData, VkDeviceSize vertexDataSize, const void *indexData, VkDeviceSize indexDataSize, VkBufferUsageFlags usageFlags)
+		{
+			// Vertex buffer
+			VK_CHECK_RESULT(device->createBuffer(
+				VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | usageFlags,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+				&vertices,
+				vertexDataSize));
+
+			// Index buffer
+			VK_CHECK_RESULT(device->createBuffer(
+				VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | usageFlags,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+				&indices,
+				indexDataSize));
+
+			device->uploadManager.uploadBuffer(vertices.buffer, vertexData, vertexDataSize);
+			device->uploadManager.uploadBuffer(indices.buffer, indexData, indexDataSize);
+			device->uploadManager.submit();
+		}
+
+		/**
+		* Load the model from a validated mesh cache
+		*
+		* @return False if the cache is inconsistent
+		*/
+		bool loadMeshCache(const vks::meshcache::CacheReader &cache, vks::VulkanDevice *device, VkBufferUsageFlags usageFlags)
+		{
+			vks::meshcache::Reader partSection = cache.section(MESH_CACHE_SECTION_PARTS);
+			vks::meshcache::Reader vertexSection = cache.section(MESH_CACHE_SECTION_VERTICES);
+			vks::meshcache::Reader indexSection = cache.section(MESH_CACHE_SECTION_INDICES);
+			std::vector<ModelPart> cachedParts = partSection.readVector<ModelPart>();
+			Dimension cachedDim;
+			cachedDim.min = partSection.read<glm::vec3>();
+			cachedDim.max = partSection.read<glm::vec3>();
+			cachedDim.size = partSection.read<glm::vec3>();
+			const uint32_t cachedVertexCount = partSection.read<uint32_t>();
+			uint64_t floatCount, cachedIndexCount;
+			const float *vertexData = vertexSection.mapVector<float>(&floatCount);
+			const uint32_t *indexData = indexSection.mapVector<uint32_t>(&cachedIndexCount);
+			if (partSection.failed || vertexSection.failed || indexSection.failed || (floatCount == 0) || (cachedIndexCount == 0)) {
+				return false;
+			}
+			parts = std::move(cachedParts);
+			dim = cachedDim;
+			vertexCount = cachedVertexCount;
+			indexCount = static_cast<uint32_t>(cachedIndexCount);
+			createBuffers(device, vertexData, floatCount * sizeof(float), indexData, cachedIndexCount * sizeof(uint32_t), usageFlags);
+			// The cached buffers are already optimized, only the statistics of the optimization are read back
+			if (optimizeMeshes) {
+				vks::meshcache::Reader optimizationSection = cache.section(MESH_CACHE_SECTION_OPTIMIZATION);
+				const vks::meshoptimizer::Statistics stats = optimizationSection.read<vks::meshoptimizer::Statistics>();
+				if (!optimizationSection.failed) {
+					meshOptimization = stats;
+				}
+			}
+			return true;
+		}
+
+		/** @brief Write the converted model to the mesh cache */
+		void writeMeshCache(const std::string &filename, const std::vector<float> &vertexBuffer, const std::vector<uint32_t> &indexBuffer, uint64_t parameterHash)
+		{
+			const std::string directory = vks::meshcache::getDirectory(filename);
+			vks::meshcache::CacheWriter cacheWriter;
+			cacheWriter.addDependency(directory, filename.substr(directory.size()));
+			vks::meshcache::Writer partSection, vertexSection, indexSection;
+			partSection.writeVector(parts);
+			partSection.write(dim.min);
+			partSection.write(dim.max);
+			partSection.write(dim.size);
+			partSection.write(vertexCount);
+			vertexSection.writeVector(vertexBuffer);
+			indexSection.writeVector(indexBuffer);
+			cacheWriter.addSection(MESH_CACHE_SECTION_PARTS, partSection);
+			cacheWriter.addSection(MESH_CACHE_SECTION_VERTICES, vertexSection);
+			cacheWriter.addSection(MESH_CACHE_SECTION_INDICES, indexSection);
+			if (optimizeMeshes) {
+				vks::meshcache::Writer optimizationSection;
+				optimizationSection.write(meshOptimization);
+				cacheWriter.addSection(MESH_CACHE_SECTION_OPTIMIZATION, optimizationSection);
+			}
+			if (!cacheWriter.save(vks::meshcache::getFileName(filename), vks::meshcache::CONTENT_ASSIMP, parameterHash)) {
+				std::cerr << "Could not write mesh cache for \"" << filename << "\"" << std::endl;
+			}
+		}
+
+		/** @brief Reorder the triangles and vertices of all parts for the vertex cache, overdraw and vertex fetch */
+		void optimizeParts(vks::VertexLayout &layout, std::vector<float> &vertexBuffer, std::vector<uint32_t> &indexBuffer)
+		{
+			meshOptimization = vks::meshoptimizer::Statistics();
+			const int32_t positionOffset = layout.offset(VERTEX_COMPONENT_POSITION);
+			if (positionOffset < 0)
+			{
+				return;
+			}
+			const uint32_t stride = layout.stride();
+			for (auto& part : parts)
+			{
+				if (part.indexCount < 3)
+				{
+					continue;
+				}
+				// Indices of a part are offset by its index base, the optimizer works on the part's local range
+				uint32_t *partIndices = indexBuffer.data() + part.indexBase;
+				for (uint32_t i = 0; i < part.indexCount; i++)
+				{
+					partIndices[i] -= part.indexBase;
+				}
+				float *partVertices = vertexBuffer.data() + part.vertexBase * (stride / sizeof(float));
+				meshOptimization.add(vks::meshoptimizer::optimizeMesh(partIndices, part.indexCount, partVertices, stride, part.vertexCount, positionOffset));
+				for (uint32_t i = 0; i < part.indexCount; i++)
+				{
+					partIndices[i] += part.indexBase;
+				}
+			}
+		}
+
+		void printOptimizationStatistics(const std::string &filename)
+		{
+			if (optimizeMeshes)
+			{
+				std::cout << std::fixed << std::setprecision(3) << "Optimized \"" << filename << "\": vertex cache ACMR " << meshOptimization.before.acmr() << " -> " << meshOptimization.after.acmr() << ", ATVR " << meshOptimization.before.atvr() << " -> " << meshOptimization.after.atvr() << ", " << meshOptimization.clusters << " overdraw clusters" << std::endl;
+				std::cout.unsetf(std::ios::floatfield);
 			}
 		}
 
@@ -151,12 +329,40 @@ namespace vks
 		* @param filename File to load (must be a model format supported by ASSIMP)
 		* @param layout Vertex layout components (position, normals, tangents, etc.)
 		* @param createInfo MeshCreateInfo structure for load time settings like scale, center, etc.
-		* @param copyQueue Queue used for the memory staging copy commands (must support transfer)
+		* @param copyQueue Unused, the vertex and index data is uploaded by the device's upload manager
 		*/
 		bool loadFromFile(const std::string& filename, vks::VertexLayout layout, vks::ModelCreateInfo *createInfo, vks::VulkanDevice *device, VkQueue copyQueue)
 		{
 			this->device = device->logicalDevice;
 
+			glm::vec3 scale(1.0f);
+			glm::vec2 uvscale(1.0f);
+			glm::vec3 center(0.0f);
+			if (createInfo)
+			{
+				scale = createInfo->scale;
+				uvscale = createInfo->uvscale;
+				center = createInfo->center;
+			}
+
+#if defined(__ANDROID__)
+			// Meshes are read from the apk on Android, which has no place for the cache next to the source
+			const bool useMeshCache = false;
+#else
+			const bool useMeshCache = enableMeshCache;
+#endif
+			const uint64_t meshCacheParameters = meshCacheParameterHash(layout, scale, uvscale, center, optimizeMeshes);
+			if (useMeshCache)
+			{
+				// The converted data is uploaded straight from the mapped cache file, so neither ASSIMP's post processing nor the vertex conversion have to run
+				vks::meshcache::CacheReader meshCache;
+				if (meshCache.open(vks::meshcache::getFileName(filename), vks::meshcache::getDirectory(filename), vks::meshcache::CONTENT_ASSIMP, meshCacheParameters) && loadMeshCache(meshCache, device, createInfo->memoryPropertyFlags))
+				{
+					printOptimizationStatistics(filename);
+					return true;
+				}
+			}
+
 			Assimp::Importer Importer;
 			const aiScene* pScene;
 
@@ -195,16 +401,6 @@ namespace vks
 				parts.clear();
 				parts.resize(pScene->mNumMeshes);
 
-				glm::vec3 scale(1.0f);
-				glm::vec2 uvscale(1.0f);
-				glm::vec3 center(0.0f);
-				if (createInfo)
-				{
-					scale = createInfo->scale;
-					uvscale = createInfo->uvscale;
-					center = createInfo->center;
-				}
-
 				std::vector<float> vertexBuffer;
 				std::vector<uint32_t> indexBuffer;
 
@@ -308,62 +504,21 @@ namespace vks
 				}
 
 
+				if (optimizeMeshes)
+				{
+					optimizeParts(layout, vertexBuffer, indexBuffer);
+					printOptimizationStatistics(filename);
+				}
+
 				uint32_t vBufferSize = static_cast<uint32_t>(vertexBuffer.size()) * sizeof(float);
 				uint32_t iBufferSize = static_cast<uint32_t>(indexBuffer.size()) * sizeof(uint32_t);
 
-				// Use staging buffer to move vertex and index buffer to device local memory
-				// Create staging buffers
-				vks::Buffer vertexStaging, indexStaging;
-
-				// Vertex buffer
-				VK_CHECK_RESULT(device->createBuffer(
-					VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-					VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-					&vertexStaging,
-					vBufferSize,
-					vertexBuffer.data()));
-
-				// Index buffer
-				VK_CHECK_RESULT(device->createBuffer(
-					VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-					VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-					&indexStaging,
-					iBufferSize,
-					indexBuffer.data()));
-
-				// Create device local target buffers
-				// Vertex buffer
-				VK_CHECK_RESULT(device->createBuffer(
-					VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | createInfo->memoryPropertyFlags,
-					VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-					&vertices,
-					vBufferSize));
-
-				// Index buffer
-				VK_CHECK_RESULT(device->createBuffer(
-					VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | createInfo->memoryPropertyFlags,
-					VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-					&indices,
-					iBufferSize));
-
-				// Copy from staging buffers
-				VkCommandBuffer copyCmd = device->createCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
-
-				VkBufferCopy copyRegion{};
-
-				copyRegion.size = vBufferSize;
-				vkCmdCopyBuffer(copyCmd, vertexStaging.buffer, vertices.buffer, 1, &copyRegion);
-
-				copyRegion.size = iBufferSize;
-				vkCmdCopyBuffer(copyCmd, indexStaging.buffer, indices.buffer, 1, &copyRegion);
-
-				device->flushCommandBuffer(copyCmd, copyQueue);
-
-				// Destroy staging resources
-				vkDestroyBuffer(device->logicalDevice, vertexStaging.buffer, nullptr);
-				vkFreeMemory(device->logicalDevice, vertexStaging.memory, nullptr);
-				vkDestroyBuffer(device->logicalDevice, indexStaging.buffer, nullptr);
-				vkFreeMemory(device->logicalDevice, indexStaging.memory, nullptr);
+				createBuffers(device, vertexBuffer.data(), vBufferSize, indexBuffer.data(), iBufferSize, createInfo->memoryPropertyFlags);
+
+				if (useMeshCache)
+				{
+					writeMeshCache(filename, vertexBuffer, indexBuffer, meshCacheParameters);
+				}
 
 				return true;
 			}
@@ -384,7 +539,7 @@ namespace vks
 		* @param filename File to load (must be a model format supported by ASSIMP)
 		* @param layout Vertex layout components (position, normals, tangents, etc.)
 		* @param scale Load time scene scale
-		* @param copyQueue Queue used for the memory staging copy commands (must support transfer)
+		* @param copyQueue Unused, the vertex and index data is uploaded by the device's upload manager
 		*/
 		bool loadFromFile(const std::string& filename, vks::VertexLayout layout, float scale, vks::VulkanDevice *device, VkQueue copyQueue)
 		{
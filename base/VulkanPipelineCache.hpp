@@ -0,0 +1,218 @@
+/*
+* Vulkan pipeline cache persistence
+*
+* Stores the contents of a pipeline cache on disk so pipelines don't have to be recompiled on every start
+*
+* Copyright (C) by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license (MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cstring>
+#include <cstdio>
+#include <stdint.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "vulkan/vulkan.h"
+#include "VulkanTools.h"
+
+namespace vks
+{
+	namespace pipelinecache
+	{
+		/** @brief Identifies files written by this implementation */
+		const uint32_t FILE_MAGIC = 0x434c5056; // "VPLC"
+		/** @brief Increase if the layout of the file header changes */
+		const uint32_t FILE_VERSION = 1;
+
+		/**
+		* @brief Header preceding the driver's pipeline cache data on disk
+		* @note The cache data is only passed to the driver if the device, driver and checksum match
+		*/
+		struct FileHeader
+		{
+			uint32_t magic;
+			uint32_t version;
+			uint32_t headerSize;
+			uint32_t vendorID;
+			uint32_t deviceID;
+			uint32_t driverVersion;
+			uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+			uint64_t dataSize;
+			uint64_t checksum;
+		};
+
+		/** @brief 64 bit FNV-1a hash used to detect truncated or corrupted cache files */
+		inline uint64_t checksum(const uint8_t *data, size_t size)
+		{
+			uint64_t hash = 0xcbf29ce484222325ull;
+			for (size_t i = 0; i < size; i++) {
+				hash ^= data[i];
+				hash *= 0x100000001b3ull;
+			}
+			return hash;
+		}
+
+		/** @brief Returns the file name used to store the pipeline cache of an example on the given device */
+		inline std::string getFileName(const std::string &directory, const std::string &name, const VkPhysicalDeviceProperties &properties)
+		{
+			std::stringstream ss;
+			ss << directory << name << "_" << std::hex << std::setfill('0') << std::setw(4) << properties.vendorID << "_" << std::setw(4) << properties.deviceID << ".pipelinecache";
+			return ss.str();
+		}
+
+		/**
+		* Validate the cache data stored in a file against the properties of the current device
+		*
+		* @param header File header read from disk
+		* @param data Pipeline cache data following the header
+		* @param properties Properties of the physical device the cache is to be used with
+		*
+		* @return True if the data was written for the same device and driver and is intact
+		*/
+		inline bool validate(const FileHeader &header, const std::vector<uint8_t> &data, const VkPhysicalDeviceProperties &properties)
+		{
+			if ((header.magic != FILE_MAGIC) || (header.version != FILE_VERSION) || (header.headerSize != sizeof(FileHeader))) {
+				return false;
+			}
+			if ((header.vendorID != properties.vendorID) || (header.deviceID != properties.deviceID) || (header.driverVersion != properties.driverVersion)) {
+				return false;
+			}
+			if (memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) != 0) {
+				return false;
+			}
+			if ((header.dataSize != data.size()) || (header.checksum != checksum(data.data(), data.size()))) {
+				return false;
+			}
+			// The driver's own header (VkPipelineCacheHeaderVersionOne) must match the device too
+			const uint32_t driverHeaderSize = 16 + VK_UUID_SIZE;
+			if (data.size() < driverHeaderSize) {
+				return false;
+			}
+			uint32_t driverHeader[4];
+			memcpy(driverHeader, data.data(), sizeof(driverHeader));
+			if ((driverHeader[0] < driverHeaderSize) || (driverHeader[1] != VK_PIPELINE_CACHE_HEADER_VERSION_ONE) || (driverHeader[2] != properties.vendorID) || (driverHeader[3] != properties.deviceID)) {
+				return false;
+			}
+			return memcmp(data.data() + 16, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+		}
+
+		/**
+		* Create a pipeline cache, initialized with the data stored on disk if it's valid for the current device
+		*
+		* @param device Logical device to create the pipeline cache on
+		* @param properties Properties of the physical device
+		* @param filename File to load the cache data from
+		* @param pipelineCache Pointer to the pipeline cache handle acquired by the function
+		*
+		* @return True if valid cache data has been loaded from disk (warm start)
+		*/
+		inline bool create(VkDevice device, const VkPhysicalDeviceProperties &properties, const std::string &filename, VkPipelineCache *pipelineCache)
+		{
+			std::vector<uint8_t> data;
+			std::ifstream is(filename, std::ios::binary | std::ios::in);
+			if (is.is_open()) {
+				FileHeader header{};
+				if (is.read(reinterpret_cast<char*>(&header), sizeof(header)) && (header.dataSize < (uint64_t(1) << 32))) {
+					data.resize(static_cast<size_t>(header.dataSize));
+					if (!is.read(reinterpret_cast<char*>(data.data()), data.size()) || !validate(header, data, properties)) {
+						std::cerr << "Ignoring invalid or outdated pipeline cache \"" << filename << "\"" << std::endl;
+						data.clear();
+					}
+				}
+				is.close();
+			}
+
+			VkPipelineCacheCreateInfo pipelineCacheCreateInfo = {};
+			pipelineCacheCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+			pipelineCacheCreateInfo.initialDataSize = data.size();
+			pipelineCacheCreateInfo.pInitialData = data.empty() ? nullptr : data.data();
+			VkResult result = vkCreatePipelineCache(device, &pipelineCacheCreateInfo, nullptr, pipelineCache);
+			if ((result != VK_SUCCESS) && !data.empty()) {
+				// Fall back to an empty cache if the driver rejects the data
+				pipelineCacheCreateInfo.initialDataSize = 0;
+				pipelineCacheCreateInfo.pInitialData = nullptr;
+				data.clear();
+				result = vkCreatePipelineCache(device, &pipelineCacheCreateInfo, nullptr, pipelineCache);
+			}
+			VK_CHECK_RESULT(result);
+			return !data.empty();
+		}
+
+		/**
+		* Write the contents of a pipeline cache to disk
+		*
+		* @param device Logical device the pipeline cache has been created on
+		* @param properties Properties of the physical device
+		* @param pipelineCache Pipeline cache to store
+		* @param filename File to write the cache data to
+		*
+		* @note The data is written to a temporary file first which then replaces the target, so concurrent runs never see a partially written cache
+		*
+		* @return True if the cache has been written
+		*/
+		inline bool save(VkDevice device, const VkPhysicalDeviceProperties &properties, VkPipelineCache pipelineCache, const std::string &filename)
+		{
+			size_t dataSize = 0;
+			if ((vkGetPipelineCacheData(device, pipelineCache, &dataSize, nullptr) != VK_SUCCESS) || (dataSize == 0)) {
+				return false;
+			}
+			std::vector<uint8_t> data(dataSize);
+			if (vkGetPipelineCacheData(device, pipelineCache, &dataSize, data.data()) != VK_SUCCESS) {
+				return false;
+			}
+			data.resize(dataSize);
+
+			FileHeader header{};
+			header.magic = FILE_MAGIC;
+			header.version = FILE_VERSION;
+			header.headerSize = sizeof(FileHeader);
+			header.vendorID = properties.vendorID;
+			header.deviceID = properties.deviceID;
+			header.driverVersion = properties.driverVersion;
+			memcpy(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE);
+			header.dataSize = data.size();
+			header.checksum = checksum(data.data(), data.size());
+
+#if defined(_WIN32)
+			const std::string tempFilename = filename + ".tmp" + std::to_string(GetCurrentProcessId());
+#else
+			const std::string tempFilename = filename + ".tmp" + std::to_string(getpid());
+#endif
+			{
+				std::ofstream os(tempFilename, std::ios::binary | std::ios::out | std::ios::trunc);
+				if (!os.is_open()) {
+					return false;
+				}
+				os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+				os.write(reinterpret_cast<const char*>(data.data()), data.size());
+				os.close();
+				if (os.fail()) {
+					std::remove(tempFilename.c_str());
+					return false;
+				}
+			}
+#if defined(_WIN32)
+			const bool renamed = MoveFileExA(tempFilename.c_str(), filename.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+			const bool renamed = std::rename(tempFilename.c_str(), filename.c_str()) == 0;
+#endif
+			if (!renamed) {
+				std::remove(tempFilename.c_str());
+			}
+			return renamed;
+		}
+	}
+}
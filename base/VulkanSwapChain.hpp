@@ -15,6 +15,8 @@
 #include <assert.h>
 #include <stdio.h>
 #include <vector>
+#include <fstream>
+#include <iostream>
 
 #include <vulkan/vulkan.h>
 #include "VulkanTools.h"
@@ -65,6 +67,202 @@ private:
 	PFN_vkGetSwapchainImagesKHR fpGetSwapchainImagesKHR;
 	PFN_vkAcquireNextImageKHR fpAcquireNextImageKHR;
 	PFN_vkQueuePresentKHR fpQueuePresentKHR;
+	/** @brief Resources of the offscreen image ring that replaces the swapchain in headless mode */
+	struct {
+		VkQueue queue = VK_NULL_HANDLE;
+		std::vector<VkDeviceMemory> memory;
+		uint32_t currentImage = 0;
+		uint32_t width = 0;
+		uint32_t height = 0;
+		// Host visible buffer, command buffer and fence used for copying presented images back for frame dumps
+		VkCommandPool commandPool = VK_NULL_HANDLE;
+		VkCommandBuffer copyCmd = VK_NULL_HANDLE;
+		VkFence copyFence = VK_NULL_HANDLE;
+		VkBuffer dumpBuffer = VK_NULL_HANDLE;
+		VkDeviceMemory dumpMemory = VK_NULL_HANDLE;
+		void* dumpMapped = nullptr;
+		uint32_t dumpedFrames = 0;
+	} offscreen;
+
+	uint32_t getMemoryTypeIndex(uint32_t typeBits, VkMemoryPropertyFlags properties)
+	{
+		VkPhysicalDeviceMemoryProperties memoryProperties;
+		vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+		for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++) {
+			if ((typeBits & (1 << i)) && ((memoryProperties.memoryTypes[i].propertyFlags & properties) == properties)) {
+				return i;
+			}
+		}
+		vks::tools::exitFatal("Could not find a matching memory type for the headless swapchain", -1);
+		return 0;
+	}
+
+	void destroyHeadlessImages()
+	{
+		for (uint32_t i = 0; i < static_cast<uint32_t>(buffers.size()); i++) {
+			vkDestroyImageView(device, buffers[i].view, nullptr);
+			vkDestroyImage(device, buffers[i].image, nullptr);
+			vkFreeMemory(device, offscreen.memory[i], nullptr);
+		}
+		buffers.clear();
+		images.clear();
+		offscreen.memory.clear();
+		if (offscreen.dumpBuffer != VK_NULL_HANDLE) {
+			vkUnmapMemory(device, offscreen.dumpMemory);
+			vkDestroyBuffer(device, offscreen.dumpBuffer, nullptr);
+			vkFreeMemory(device, offscreen.dumpMemory, nullptr);
+			offscreen.dumpBuffer = VK_NULL_HANDLE;
+			offscreen.dumpMapped = nullptr;
+		}
+	}
+
+	/** @brief Creates the offscreen images that take the place of the swapchain images in headless mode */
+	void createHeadless(uint32_t width, uint32_t height)
+	{
+		destroyHeadlessImages();
+		offscreen.width = width;
+		offscreen.height = height;
+		offscreen.currentImage = imageCount - 1;
+		images.resize(imageCount);
+		buffers.resize(imageCount);
+		offscreen.memory.resize(imageCount);
+		for (uint32_t i = 0; i < imageCount; i++)
+		{
+			VkImageCreateInfo imageCI{};
+			imageCI.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+			imageCI.imageType = VK_IMAGE_TYPE_2D;
+			imageCI.format = colorFormat;
+			imageCI.extent = { width, height, 1 };
+			imageCI.mipLevels = 1;
+			imageCI.arrayLayers = 1;
+			imageCI.samples = VK_SAMPLE_COUNT_1_BIT;
+			imageCI.tiling = VK_IMAGE_TILING_OPTIMAL;
+			// Same usage as a swapchain that supports transfers, some examples copy into or out of the swapchain images
+			imageCI.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+			imageCI.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			VK_CHECK_RESULT(vkCreateImage(device, &imageCI, nullptr, &images[i]));
+
+			VkMemoryRequirements memReqs;
+			vkGetImageMemoryRequirements(device, images[i], &memReqs);
+			VkMemoryAllocateInfo memAlloc{};
+			memAlloc.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+			memAlloc.allocationSize = memReqs.size;
+			memAlloc.memoryTypeIndex = getMemoryTypeIndex(memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+			VK_CHECK_RESULT(vkAllocateMemory(device, &memAlloc, nullptr, &offscreen.memory[i]));
+			VK_CHECK_RESULT(vkBindImageMemory(device, images[i], offscreen.memory[i], 0));
+
+			VkImageViewCreateInfo colorAttachmentView{};
+			colorAttachmentView.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+			colorAttachmentView.viewType = VK_IMAGE_VIEW_TYPE_2D;
+			colorAttachmentView.format = colorFormat;
+			colorAttachmentView.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+			colorAttachmentView.image = images[i];
+			buffers[i].image = images[i];
+			VK_CHECK_RESULT(vkCreateImageView(device, &colorAttachmentView, nullptr, &buffers[i].view));
+		}
+
+		if (!dumpPath.empty())
+		{
+			VkBufferCreateInfo bufferCI{};
+			bufferCI.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+			bufferCI.size = (VkDeviceSize)width * height * 4;
+			bufferCI.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+			VK_CHECK_RESULT(vkCreateBuffer(device, &bufferCI, nullptr, &offscreen.dumpBuffer));
+			VkMemoryRequirements memReqs;
+			vkGetBufferMemoryRequirements(device, offscreen.dumpBuffer, &memReqs);
+			VkMemoryAllocateInfo memAlloc{};
+			memAlloc.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+			memAlloc.allocationSize = memReqs.size;
+			memAlloc.memoryTypeIndex = getMemoryTypeIndex(memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+			VK_CHECK_RESULT(vkAllocateMemory(device, &memAlloc, nullptr, &offscreen.dumpMemory));
+			VK_CHECK_RESULT(vkBindBufferMemory(device, offscreen.dumpBuffer, offscreen.dumpMemory, 0));
+			VK_CHECK_RESULT(vkMapMemory(device, offscreen.dumpMemory, 0, VK_WHOLE_SIZE, 0, &offscreen.dumpMapped));
+		}
+	}
+
+	/** @brief Copies the given image to the host and writes it to the dump directory as a binary ppm file */
+	VkResult dumpHeadlessImage(uint32_t imageIndex, VkSemaphore waitSemaphore)
+	{
+		VkCommandBufferBeginInfo cmdBufInfo{};
+		cmdBufInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		cmdBufInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		VK_CHECK_RESULT(vkBeginCommandBuffer(offscreen.copyCmd, &cmdBufInfo));
+
+		VkImageMemoryBarrier imageBarrier{};
+		imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		imageBarrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+		imageBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+		imageBarrier.oldLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+		imageBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		imageBarrier.image = images[imageIndex];
+		imageBarrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+		vkCmdPipelineBarrier(offscreen.copyCmd, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &imageBarrier);
+
+		VkBufferImageCopy copyRegion{};
+		copyRegion.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+		copyRegion.imageExtent = { offscreen.width, offscreen.height, 1 };
+		vkCmdCopyImageToBuffer(offscreen.copyCmd, images[imageIndex], VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, offscreen.dumpBuffer, 1, &copyRegion);
+
+		// Return the image to the layout it was "presented" in, so the next frame finds it as it left it
+		imageBarrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+		imageBarrier.dstAccessMask = 0;
+		imageBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		imageBarrier.newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+		vkCmdPipelineBarrier(offscreen.copyCmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, 1, &imageBarrier);
+
+		VkBufferMemoryBarrier bufferBarrier{};
+		bufferBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		bufferBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		bufferBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+		bufferBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		bufferBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		bufferBarrier.buffer = offscreen.dumpBuffer;
+		bufferBarrier.size = VK_WHOLE_SIZE;
+		vkCmdPipelineBarrier(offscreen.copyCmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr, 1, &bufferBarrier, 0, nullptr);
+		VK_CHECK_RESULT(vkEndCommandBuffer(offscreen.copyCmd));
+
+		const VkPipelineStageFlags waitStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+		VkSubmitInfo submitInfo{};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &offscreen.copyCmd;
+		if (waitSemaphore != VK_NULL_HANDLE) {
+			submitInfo.waitSemaphoreCount = 1;
+			submitInfo.pWaitSemaphores = &waitSemaphore;
+			submitInfo.pWaitDstStageMask = &waitStageMask;
+		}
+		VK_CHECK_RESULT(vkResetFences(device, 1, &offscreen.copyFence));
+		VkResult result = vkQueueSubmit(offscreen.queue, 1, &submitInfo, offscreen.copyFence);
+		if (result != VK_SUCCESS) {
+			return result;
+		}
+		VK_CHECK_RESULT(vkWaitForFences(device, 1, &offscreen.copyFence, VK_TRUE, UINT64_MAX));
+
+		char fileName[32];
+		snprintf(fileName, sizeof(fileName), "frame%06u.ppm", offscreen.dumpedFrames++);
+		std::ofstream file(dumpPath + "/" + fileName, std::ios::out | std::ios::binary);
+		if (!file.is_open()) {
+			std::cerr << "Could not write frame dump to \"" << dumpPath << "/" << fileName << "\"" << std::endl;
+			return VK_SUCCESS;
+		}
+		file << "P6\n" << offscreen.width << "\n" << offscreen.height << "\n" << 255 << "\n";
+		// The image ring uses BGRA if supported, ppm stores RGB
+		const bool colorSwizzle = (colorFormat == VK_FORMAT_B8G8R8A8_UNORM);
+		const uint8_t* pixel = (const uint8_t*)offscreen.dumpMapped;
+		std::vector<uint8_t> row(offscreen.width * 3);
+		for (uint32_t y = 0; y < offscreen.height; y++) {
+			for (uint32_t x = 0; x < offscreen.width; x++) {
+				row[x * 3 + 0] = colorSwizzle ? pixel[2] : pixel[0];
+				row[x * 3 + 1] = pixel[1];
+				row[x * 3 + 2] = colorSwizzle ? pixel[0] : pixel[2];
+				pixel += 4;
+			}
+			file.write((const char*)row.data(), row.size());
+		}
+		return VK_SUCCESS;
+	}
 public:
 	VkFormat colorFormat;
 	VkColorSpaceKHR colorSpace;
@@ -75,6 +273,12 @@ public:
 	std::vector<SwapChainBuffer> buffers;
 	/** @brief Queue family index of the detected graphics and presenting device queue */
 	uint32_t queueNodeIndex = UINT32_MAX;
+	/** @brief Replace the swapchain with a ring of offscreen images, no surface or windowing system is required (must be set before connecting) */
+	bool headless = false;
+	/** @brief Number of images in the headless image ring */
+	static const uint32_t HEADLESS_IMAGE_COUNT = 3;
+	/** @brief Directory that all presented images are written to as ppm files in headless mode (empty disables frame dumps) */
+	std::string dumpPath;
 
 	/** @brief Creates the platform specific surface abstraction of the native platform window used for presentation */	
 #if defined(VK_USE_PLATFORM_WIN32_KHR)
@@ -247,6 +451,44 @@ public:
 
 	}
 
+	/**
+	* Set up the headless image ring used instead of a surface
+	*
+	* @param queue Queue used to signal and wait on the acquire and present semaphores
+	* @param queueFamilyIndex Family of the graphics queue the images are rendered on
+	*/
+	void initHeadless(VkQueue queue, uint32_t queueFamilyIndex)
+	{
+		offscreen.queue = queue;
+		queueNodeIndex = queueFamilyIndex;
+		imageCount = HEADLESS_IMAGE_COUNT;
+
+		// Use the same format most surfaces report, so examples see the same color format as with a window
+		colorFormat = VK_FORMAT_B8G8R8A8_UNORM;
+		colorSpace = VK_COLOR_SPACE_SRGB_NONLINEAR_KHR;
+		VkFormatProperties formatProperties;
+		vkGetPhysicalDeviceFormatProperties(physicalDevice, colorFormat, &formatProperties);
+		if (!(formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT)) {
+			// VK_FORMAT_R8G8B8A8_UNORM color attachments are mandatory
+			colorFormat = VK_FORMAT_R8G8B8A8_UNORM;
+		}
+
+		VkCommandPoolCreateInfo cmdPoolInfo{};
+		cmdPoolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		cmdPoolInfo.queueFamilyIndex = queueFamilyIndex;
+		cmdPoolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+		VK_CHECK_RESULT(vkCreateCommandPool(device, &cmdPoolInfo, nullptr, &offscreen.commandPool));
+		VkCommandBufferAllocateInfo cmdBufAllocateInfo{};
+		cmdBufAllocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		cmdBufAllocateInfo.commandPool = offscreen.commandPool;
+		cmdBufAllocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		cmdBufAllocateInfo.commandBufferCount = 1;
+		VK_CHECK_RESULT(vkAllocateCommandBuffers(device, &cmdBufAllocateInfo, &offscreen.copyCmd));
+		VkFenceCreateInfo fenceCI{};
+		fenceCI.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+		VK_CHECK_RESULT(vkCreateFence(device, &fenceCI, nullptr, &offscreen.copyFence));
+	}
+
 	/**
 	* Set instance, physical and logical device to use for the swapchain and get all required function pointers
 	* 
@@ -260,6 +502,10 @@ public:
 		this->instance = instance;
 		this->physicalDevice = physicalDevice;
 		this->device = device;
+		// Headless mode does not use any WSI functions, the instance and device may not even have the extensions enabled
+		if (headless) {
+			return;
+		}
 		GET_INSTANCE_PROC_ADDR(instance, GetPhysicalDeviceSurfaceSupportKHR);
 		GET_INSTANCE_PROC_ADDR(instance, GetPhysicalDeviceSurfaceCapabilitiesKHR);
 		GET_INSTANCE_PROC_ADDR(instance, GetPhysicalDeviceSurfaceFormatsKHR);
@@ -280,6 +526,11 @@ public:
 	*/
 	void create(uint32_t *width, uint32_t *height, bool vsync = false)
 	{
+		if (headless) {
+			createHeadless(*width, *height);
+			return;
+		}
+
 		VkSwapchainKHR oldSwapchain = swapChain;
 
 		// Get physical device surface properties and formats
@@ -463,6 +714,20 @@ public:
 	{
 		// By setting timeout to UINT64_MAX we will always wait until the next image has been acquired or an actual error is thrown
 		// With that we don't have to handle VK_NOT_READY
+		if (headless) {
+			// Images are handed out round robin
+			// The semaphore is signaled by an empty submission, which (like a FIFO presentation engine) orders it after all work submitted so far
+			offscreen.currentImage = (offscreen.currentImage + 1) % imageCount;
+			*imageIndex = offscreen.currentImage;
+			if (presentCompleteSemaphore == VK_NULL_HANDLE) {
+				return VK_SUCCESS;
+			}
+			VkSubmitInfo submitInfo{};
+			submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+			submitInfo.signalSemaphoreCount = 1;
+			submitInfo.pSignalSemaphores = &presentCompleteSemaphore;
+			return vkQueueSubmit(offscreen.queue, 1, &submitInfo, VK_NULL_HANDLE);
+		}
 		return fpAcquireNextImageKHR(device, swapChain, UINT64_MAX, presentCompleteSemaphore, (VkFence)nullptr, imageIndex);
 	}
 
@@ -477,6 +742,22 @@ public:
 	*/
 	VkResult queuePresent(VkQueue queue, uint32_t imageIndex, VkSemaphore waitSemaphore = VK_NULL_HANDLE)
 	{
+		if (headless) {
+			if (offscreen.dumpMapped) {
+				return dumpHeadlessImage(imageIndex, waitSemaphore);
+			}
+			if (waitSemaphore == VK_NULL_HANDLE) {
+				return VK_SUCCESS;
+			}
+			// Nothing is presented, but the semaphore still needs to be waited on (unsignaled) before it can be signaled again
+			const VkPipelineStageFlags waitStageMask = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+			VkSubmitInfo submitInfo{};
+			submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+			submitInfo.waitSemaphoreCount = 1;
+			submitInfo.pWaitSemaphores = &waitSemaphore;
+			submitInfo.pWaitDstStageMask = &waitStageMask;
+			return vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE);
+		}
 		VkPresentInfoKHR presentInfo = {};
 		presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
 		presentInfo.pNext = NULL;
@@ -498,6 +779,16 @@ public:
 	*/
 	void cleanup()
 	{
+		if (headless)
+		{
+			destroyHeadlessImages();
+			if (offscreen.commandPool != VK_NULL_HANDLE) {
+				vkDestroyFence(device, offscreen.copyFence, nullptr);
+				vkDestroyCommandPool(device, offscreen.commandPool, nullptr);
+				offscreen.commandPool = VK_NULL_HANDLE;
+			}
+			return;
+		}
 		if (swapChain != VK_NULL_HANDLE)
 		{
 			for (uint32_t i = 0; i < imageCount; i++)
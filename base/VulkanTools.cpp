@@ -115,6 +115,57 @@ namespace vks
 			return false;
 		}
 
+		uint32_t formatTexelBlockSize(VkFormat format)
+		{
+			switch (format)
+			{
+			case VK_FORMAT_R4G4_UNORM_PACK8:
+			case VK_FORMAT_S8_UINT:
+				return 1;
+			case VK_FORMAT_D16_UNORM:
+				return 2;
+			case VK_FORMAT_X8_D24_UNORM_PACK32:
+			case VK_FORMAT_D32_SFLOAT:
+			case VK_FORMAT_D24_UNORM_S8_UINT:
+			case VK_FORMAT_B10G11R11_UFLOAT_PACK32:
+			case VK_FORMAT_E5B9G9R9_UFLOAT_PACK32:
+				return 4;
+			// The depth and stencil aspects are copied separately, this is the size of the combined texel
+			case VK_FORMAT_D16_UNORM_S8_UINT:
+				return 3;
+			case VK_FORMAT_D32_SFLOAT_S8_UINT:
+				return 5;
+			default:
+				break;
+			}
+			if (format >= VK_FORMAT_R8_UNORM && format <= VK_FORMAT_R8_SRGB)
+				return 1;
+			if ((format >= VK_FORMAT_R4G4B4A4_UNORM_PACK16 && format <= VK_FORMAT_A1R5G5B5_UNORM_PACK16) || (format >= VK_FORMAT_R8G8_UNORM && format <= VK_FORMAT_R8G8_SRGB) || (format >= VK_FORMAT_R16_UNORM && format <= VK_FORMAT_R16_SFLOAT))
+				return 2;
+			if (format >= VK_FORMAT_R8G8B8_UNORM && format <= VK_FORMAT_B8G8R8_SRGB)
+				return 3;
+			if ((format >= VK_FORMAT_R8G8B8A8_UNORM && format <= VK_FORMAT_A2B10G10R10_SINT_PACK32) || (format >= VK_FORMAT_R16G16_UNORM && format <= VK_FORMAT_R16G16_SFLOAT) || (format >= VK_FORMAT_R32_UINT && format <= VK_FORMAT_R32_SFLOAT))
+				return 4;
+			if (format >= VK_FORMAT_R16G16B16_UNORM && format <= VK_FORMAT_R16G16B16_SFLOAT)
+				return 6;
+			if ((format >= VK_FORMAT_R16G16B16A16_UNORM && format <= VK_FORMAT_R16G16B16A16_SFLOAT) || (format >= VK_FORMAT_R32G32_UINT && format <= VK_FORMAT_R32G32_SFLOAT) || (format >= VK_FORMAT_R64_UINT && format <= VK_FORMAT_R64_SFLOAT))
+				return 8;
+			if (format >= VK_FORMAT_R32G32B32_UINT && format <= VK_FORMAT_R32G32B32_SFLOAT)
+				return 12;
+			if ((format >= VK_FORMAT_R32G32B32A32_UINT && format <= VK_FORMAT_R32G32B32A32_SFLOAT) || (format >= VK_FORMAT_R64G64_UINT && format <= VK_FORMAT_R64G64_SFLOAT))
+				return 16;
+			if (format >= VK_FORMAT_R64G64B64_UINT && format <= VK_FORMAT_R64G64B64_SFLOAT)
+				return 24;
+			if (format >= VK_FORMAT_R64G64B64A64_UINT && format <= VK_FORMAT_R64G64B64A64_SFLOAT)
+				return 32;
+			// Block compressed formats
+			if ((format >= VK_FORMAT_BC1_RGB_UNORM_BLOCK && format <= VK_FORMAT_BC1_RGBA_SRGB_BLOCK) || (format >= VK_FORMAT_BC4_UNORM_BLOCK && format <= VK_FORMAT_BC4_SNORM_BLOCK) || (format >= VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK && format <= VK_FORMAT_ETC2_R8G8B8A1_SRGB_BLOCK) || (format >= VK_FORMAT_EAC_R11_UNORM_BLOCK && format <= VK_FORMAT_EAC_R11_SNORM_BLOCK))
+				return 8;
+			if ((format >= VK_FORMAT_BC2_UNORM_BLOCK && format <= VK_FORMAT_BC3_SRGB_BLOCK) || (format >= VK_FORMAT_BC5_UNORM_BLOCK && format <= VK_FORMAT_BC7_SRGB_BLOCK) || (format >= VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK && format <= VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK) || (format >= VK_FORMAT_EAC_R11G11_UNORM_BLOCK && format <= VK_FORMAT_EAC_R11G11_SNORM_BLOCK) || (format >= VK_FORMAT_ASTC_4x4_UNORM_BLOCK && format <= VK_FORMAT_ASTC_12x12_SRGB_BLOCK))
+				return 16;
+			return 0;
+		}
+
 		// Create an image memory barrier for changing the layout of
 		// an image and put it into an active command buffer
 		// See chapter 11.4 "Image Layout" for details
@@ -81,6 +81,9 @@ namespace vks
 		// Returns if a given format support LINEAR filtering
 		VkBool32 formatIsFilterable(VkPhysicalDevice physicalDevice, VkFormat format, VkImageTiling tiling);
 
+		// Returns the size in bytes of a texel (or of a block of texels for compressed formats) of a core format, 0 for unknown formats
+		uint32_t formatTexelBlockSize(VkFormat format);
+
 		// Put an image memory barrier for setting an image layout on the sub resource into the given command buffer
 		void setImageLayout(
 			VkCommandBuffer cmdbuffer,
@@ -94,13 +94,7 @@ namespace vks
 		imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 		imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
 		VK_CHECK_RESULT(vkCreateImage(device->logicalDevice, &imageInfo, nullptr, &fontImage));
-		VkMemoryRequirements memReqs;
-		vkGetImageMemoryRequirements(device->logicalDevice, fontImage, &memReqs);
-		VkMemoryAllocateInfo memAllocInfo = vks::initializers::memoryAllocateInfo();
-		memAllocInfo.allocationSize = memReqs.size;
-		memAllocInfo.memoryTypeIndex = device->getMemoryType(memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-		VK_CHECK_RESULT(vkAllocateMemory(device->logicalDevice, &memAllocInfo, nullptr, &fontMemory));
-		VK_CHECK_RESULT(vkBindImageMemory(device->logicalDevice, fontImage, fontMemory, 0));
+		VK_CHECK_RESULT(device->allocateImageMemory(fontImage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &fontAllocation));
 
 		// Image view
 		VkImageViewCreateInfo viewInfo = vks::initializers::imageViewCreateInfo();
@@ -112,33 +106,7 @@ namespace vks
 		viewInfo.subresourceRange.layerCount = 1;
 		VK_CHECK_RESULT(vkCreateImageView(device->logicalDevice, &viewInfo, nullptr, &fontView));
 
-		// Staging buffers for font data upload
-		vks::Buffer stagingBuffer;
-
-		VK_CHECK_RESULT(device->createBuffer(
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-			&stagingBuffer,
-			uploadSize));
-
-		stagingBuffer.map();
-		memcpy(stagingBuffer.mapped, fontData, uploadSize);
-		stagingBuffer.unmap();
-
-		// Copy buffer data to font image
-		VkCommandBuffer copyCmd = device->createCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
-
-		// Prepare for transfer
-		vks::tools::setImageLayout(
-			copyCmd,
-			fontImage,
-			VK_IMAGE_ASPECT_COLOR_BIT,
-			VK_IMAGE_LAYOUT_UNDEFINED,
-			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-			VK_PIPELINE_STAGE_HOST_BIT,
-			VK_PIPELINE_STAGE_TRANSFER_BIT);
-
-		// Copy
+		// Upload the font data, the image is transitioned to shader read once the copy has finished
 		VkBufferImageCopy bufferCopyRegion = {};
 		bufferCopyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
 		bufferCopyRegion.imageSubresource.layerCount = 1;
@@ -146,28 +114,13 @@ namespace vks
 		bufferCopyRegion.imageExtent.height = texHeight;
 		bufferCopyRegion.imageExtent.depth = 1;
 
-		vkCmdCopyBufferToImage(
-			copyCmd,
-			stagingBuffer.buffer,
-			fontImage,
-			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-			1,
-			&bufferCopyRegion
-		);
-
-		// Prepare for shader read
-		vks::tools::setImageLayout(
-			copyCmd,
-			fontImage,
-			VK_IMAGE_ASPECT_COLOR_BIT,
-			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-			VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-			VK_PIPELINE_STAGE_TRANSFER_BIT,
-			VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
-
-		device->flushCommandBuffer(copyCmd, queue, true);
+		VkImageSubresourceRange subresourceRange = {};
+		subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		subresourceRange.levelCount = 1;
+		subresourceRange.layerCount = 1;
 
-		stagingBuffer.destroy();
+		device->uploadManager.uploadImage(fontImage, VK_FORMAT_R8G8B8A8_UNORM, fontData, uploadSize, { bufferCopyRegion }, subresourceRange, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+		device->uploadManager.submit();
 
 		// Font texture Sampler
 		VkSamplerCreateInfo samplerInfo = vks::initializers::samplerCreateInfo();
@@ -290,59 +243,93 @@ namespace vks
 	}
 
 	/** Update vertex and index buffer containing the imGui elements when required */
-	bool UIOverlay::update()
+	/**
+	* Upload the current ImGui draw data into the given frame's slice of the vertex and index buffers
+	*
+	* @param frameIndex Frame in flight the data is written for, the GPU must no longer read this frame's slice
+	*
+	* @return True if the command buffers containing the overlay's draw commands need to be rebuilt
+	*/
+	bool UIOverlay::update(uint32_t frameIndex)
 	{
 		ImDrawData* imDrawData = ImGui::GetDrawData();
 		bool updateCmdBuffers = false;
 
 		if (!imDrawData) { return false; };
 
-		// Note: Alignment is done inside buffer creation
-		VkDeviceSize vertexBufferSize = imDrawData->TotalVtxCount * sizeof(ImDrawVert);
-		VkDeviceSize indexBufferSize = imDrawData->TotalIdxCount * sizeof(ImDrawIdx);
-
-		// Update buffers only if vertex or index count has been changed compared to current buffer size
-		if ((vertexBufferSize == 0) || (indexBufferSize == 0)) {
+		if ((imDrawData->TotalVtxCount == 0) || (imDrawData->TotalIdxCount == 0)) {
 			return false;
 		}
 
-		// Vertex buffer
-		if ((vertexBuffer.buffer == VK_NULL_HANDLE) || (vertexCount != imDrawData->TotalVtxCount)) {
-			vertexBuffer.unmap();
-			vertexBuffer.destroy();
-			VK_CHECK_RESULT(device->createBuffer(VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, &vertexBuffer, vertexBufferSize));
-			vertexCount = imDrawData->TotalVtxCount;
-			vertexBuffer.unmap();
-			vertexBuffer.map();
-			updateCmdBuffers = true;
-		}
-
-		// Index buffer
-		VkDeviceSize indexSize = imDrawData->TotalIdxCount * sizeof(ImDrawIdx);
-		if ((indexBuffer.buffer == VK_NULL_HANDLE) || (indexCount < imDrawData->TotalIdxCount)) {
-			indexBuffer.unmap();
-			indexBuffer.destroy();
-			VK_CHECK_RESULT(device->createBuffer(VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, &indexBuffer, indexBufferSize));
-			indexCount = imDrawData->TotalIdxCount;
-			indexBuffer.map();
+		// The buffers only grow (geometrically), so small changes of the overlay's contents never cause an allocation
+		const bool growVertices = (vertexBuffer.buffer == VK_NULL_HANDLE) || (imDrawData->TotalVtxCount > vertexCapacity);
+		const bool growIndices = (indexBuffer.buffer == VK_NULL_HANDLE) || (imDrawData->TotalIdxCount > indexCapacity);
+		if (growVertices || growIndices) {
+			// Earlier frames may still read from the buffers that are replaced
+			if (vertexBuffer.buffer != VK_NULL_HANDLE) {
+				VK_CHECK_RESULT(vkQueueWaitIdle(queue));
+			}
+			auto grow = [](int32_t capacity, int32_t required) {
+				capacity = std::max(capacity, 1024);
+				while (capacity < required) {
+					capacity *= 2;
+				}
+				return capacity;
+			};
+			// Host coherent memory is always available for host visible buffers and doesn't need flushing
+			if (growVertices) {
+				vertexBuffer.destroy();
+				vertexCapacity = grow(vertexCapacity, imDrawData->TotalVtxCount);
+				VK_CHECK_RESULT(device->createBuffer(VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &vertexBuffer, (VkDeviceSize)vertexCapacity * sizeof(ImDrawVert) * frameCount));
+				VK_CHECK_RESULT(vertexBuffer.map());
+				statistics.reallocations++;
+			}
+			if (growIndices) {
+				indexBuffer.destroy();
+				indexCapacity = grow(indexCapacity, imDrawData->TotalIdxCount);
+				VK_CHECK_RESULT(device->createBuffer(VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &indexBuffer, (VkDeviceSize)indexCapacity * sizeof(ImDrawIdx) * frameCount));
+				VK_CHECK_RESULT(indexBuffer.map());
+				statistics.reallocations++;
+			}
 			updateCmdBuffers = true;
 		}
 
 		// Upload data
-		ImDrawVert* vtxDst = (ImDrawVert*)vertexBuffer.mapped;
-		ImDrawIdx* idxDst = (ImDrawIdx*)indexBuffer.mapped;
-
+		currentSlice = frameIndex % frameCount;
+		ImDrawVert* vtxDst = (ImDrawVert*)vertexBuffer.mapped + (size_t)currentSlice * vertexCapacity;
+		ImDrawIdx* idxDst = (ImDrawIdx*)indexBuffer.mapped + (size_t)currentSlice * indexCapacity;
+
+		// Prebuilt command buffers contain the draw commands and the slice's offsets, so they only have to be rebuilt if those change
+		// Moving vertices around (e.g. dragging a slider) keeps the layout and just uploads new data
+		uint64_t layoutHash = 14695981039346656037ull;
+		auto hash = [&layoutHash](uint64_t value) {
+			layoutHash = (layoutHash ^ value) * 1099511628211ull;
+		};
+		hash(currentSlice);
 		for (int n = 0; n < imDrawData->CmdListsCount; n++) {
 			const ImDrawList* cmd_list = imDrawData->CmdLists[n];
 			memcpy(vtxDst, cmd_list->VtxBuffer.Data, cmd_list->VtxBuffer.Size * sizeof(ImDrawVert));
 			memcpy(idxDst, cmd_list->IdxBuffer.Data, cmd_list->IdxBuffer.Size * sizeof(ImDrawIdx));
 			vtxDst += cmd_list->VtxBuffer.Size;
 			idxDst += cmd_list->IdxBuffer.Size;
+			hash(cmd_list->VtxBuffer.Size);
+			for (int32_t j = 0; j < cmd_list->CmdBuffer.Size; j++) {
+				const ImDrawCmd* pcmd = &cmd_list->CmdBuffer[j];
+				hash(pcmd->ElemCount);
+				hash((uint64_t)(int64_t)pcmd->ClipRect.x << 32 | (uint32_t)(int32_t)pcmd->ClipRect.y);
+				hash((uint64_t)(int64_t)pcmd->ClipRect.z << 32 | (uint32_t)(int32_t)pcmd->ClipRect.w);
+			}
 		}
+		statistics.uploadBytes = static_cast<uint32_t>(imDrawData->TotalVtxCount * sizeof(ImDrawVert) + imDrawData->TotalIdxCount * sizeof(ImDrawIdx));
+		statistics.totalUploadBytes += statistics.uploadBytes;
 
-		// Flush to make writes visible to GPU
-		vertexBuffer.flush();
-		indexBuffer.flush();
+		if (layoutHash != drawLayoutHash) {
+			drawLayoutHash = layoutHash;
+			updateCmdBuffers = true;
+		}
+		if (updateCmdBuffers) {
+			statistics.rebuilds++;
+		}
 
 		return updateCmdBuffers;
 	}
@@ -353,7 +340,7 @@ namespace vks
 		int32_t vertexOffset = 0;
 		int32_t indexOffset = 0;
 
-		if ((!imDrawData) || (imDrawData->CmdListsCount == 0)) {
+		if ((!imDrawData) || (imDrawData->CmdListsCount == 0) || (vertexBuffer.buffer == VK_NULL_HANDLE)) {
 			return;
 		}
 
@@ -366,9 +353,10 @@ namespace vks
 		pushConstBlock.translate = glm::vec2(-1.0f);
 		vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(PushConstBlock), &pushConstBlock);
 
-		VkDeviceSize offsets[1] = { 0 };
+		// Bind the slice written by the last update
+		VkDeviceSize offsets[1] = { (VkDeviceSize)currentSlice * vertexCapacity * sizeof(ImDrawVert) };
 		vkCmdBindVertexBuffers(commandBuffer, 0, 1, &vertexBuffer.buffer, offsets);
-		vkCmdBindIndexBuffer(commandBuffer, indexBuffer.buffer, 0, VK_INDEX_TYPE_UINT16);
+		vkCmdBindIndexBuffer(commandBuffer, indexBuffer.buffer, (VkDeviceSize)currentSlice * indexCapacity * sizeof(ImDrawIdx), VK_INDEX_TYPE_UINT16);
 
 		for (int32_t i = 0; i < imDrawData->CmdListsCount; i++)
 		{
@@ -402,7 +390,7 @@ namespace vks
 		indexBuffer.destroy();
 		vkDestroyImageView(device->logicalDevice, fontView, nullptr);
 		vkDestroyImage(device->logicalDevice, fontImage, nullptr);
-		vkFreeMemory(device->logicalDevice, fontMemory, nullptr);
+		device->memoryAllocator.free(fontAllocation);
 		vkDestroySampler(device->logicalDevice, sampler, nullptr);
 		vkDestroyDescriptorSetLayout(device->logicalDevice, descriptorSetLayout, nullptr);
 		vkDestroyDescriptorPool(device->logicalDevice, descriptorPool, nullptr);
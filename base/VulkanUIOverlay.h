@@ -39,10 +39,30 @@ namespace vks
 		VkSampleCountFlagBits rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
 		uint32_t subpass = 0;
 
+		/** @brief Persistently mapped vertex and index buffers, split into one slice per frame in flight */
 		vks::Buffer vertexBuffer;
 		vks::Buffer indexBuffer;
-		int32_t vertexCount = 0;
-		int32_t indexCount = 0;
+		/** @brief Number of vertices and indices that fit into one slice, grown geometrically */
+		int32_t vertexCapacity = 0;
+		int32_t indexCapacity = 0;
+		/** @brief Number of slices, must be set before the first update (one per frame in flight) */
+		uint32_t frameCount = 1;
+		/** @brief Slice written by the last update and bound by draw */
+		uint32_t currentSlice = 0;
+		/** @brief Hash of the draw commands the command buffers were last built with (see update) */
+		uint64_t drawLayoutHash = 0;
+
+		/** @brief Counters for the buffer updates */
+		struct Statistics {
+			/** @brief Bytes uploaded by the last update */
+			uint32_t uploadBytes = 0;
+			/** @brief Bytes uploaded by all updates */
+			uint64_t totalUploadBytes = 0;
+			/** @brief Number of times the vertex or index buffer had to be (re)allocated */
+			uint32_t reallocations = 0;
+			/** @brief Number of updates that required the command buffers to be rebuilt */
+			uint32_t rebuilds = 0;
+		} statistics;
 
 		std::vector<VkPipelineShaderStageCreateInfo> shaders;
 
@@ -52,7 +72,7 @@ namespace vks
 		VkPipelineLayout pipelineLayout;
 		VkPipeline pipeline;
 
-		VkDeviceMemory fontMemory = VK_NULL_HANDLE;
+		vks::Allocation fontAllocation;
 		VkImage fontImage = VK_NULL_HANDLE;
 		VkImageView fontView = VK_NULL_HANDLE;
 		VkSampler sampler;
@@ -64,6 +84,8 @@ namespace vks
 
 		bool visible = true;
 		bool updated = false;
+		/** @brief Set by the example to rebuild the overlay with the next frame instead of the next refresh, e.g. after changing a value it displays */
+		bool invalidated = false;
 		float scale = 1.0f;
 
 		UIOverlay();
@@ -72,7 +94,7 @@ namespace vks
 		void preparePipeline(const VkPipelineCache pipelineCache, const VkRenderPass renderPass);
 		void prepareResources();
 
-		bool update();
+		bool update(uint32_t frameIndex = 0);
 		void draw(const VkCommandBuffer commandBuffer);
 		void resize(uint32_t width, uint32_t height);
 
@@ -0,0 +1,601 @@
+/*
+* Vulkan upload manager
+*
+* Batches buffer and image uploads through a persistently mapped staging ring and submits them without stalling the host
+*
+* Copyright (C) by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license (MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <functional>
+#include <algorithm>
+#include <stdexcept>
+#include <cstring>
+#include <assert.h>
+#include <stdint.h>
+
+#include "vulkan/vulkan.h"
+#include "VulkanTools.h"
+#include "VulkanMemoryAllocator.hpp"
+
+namespace vks
+{
+	/**
+	* @brief Identifies a batch of uploads
+	* @note Tickets increase monotonically and batches complete in ticket order, so waiting for a ticket also waits for all earlier ones (like a timeline semaphore value)
+	*/
+	typedef uint64_t UploadTicket;
+
+	/**
+	* @brief Records staging copies into batches that are submitted with a single vkQueueSubmit
+	* @note Copies are executed on the dedicated transfer queue if the device has one, ownership of the destination resources is then released to the graphics queue family
+	* @note Submissions are made to queue 0 of the graphics and transfer queue families, so they must not happen concurrently with other submissions to these queues
+	*/
+	class UploadManager
+	{
+	public:
+		/** @brief Upload statistics */
+		struct Statistics {
+			/** @brief Number of submitted batches */
+			uint64_t submits = 0;
+			/** @brief Number of buffer and image uploads */
+			uint64_t uploads = 0;
+			/** @brief Number of bytes copied through staging memory */
+			uint64_t bytes = 0;
+			/** @brief Number of times an upload had to wait for the GPU to free up staging ring space */
+			uint64_t stalls = 0;
+		};
+
+		/** @brief Size of the staging ring buffer, uploads larger than this use a temporary staging buffer */
+		VkDeviceSize stagingSize = 32 * 1024 * 1024;
+
+	private:
+		struct StagingRange {
+			VkBuffer buffer = VK_NULL_HANDLE;
+			VkDeviceSize offset = 0;
+			uint8_t *mapped = nullptr;
+			// Only valid for uploads that didn't fit into the staging ring
+			Allocation temporaryAllocation;
+		};
+
+		struct Batch {
+			UploadTicket ticket = 0;
+			VkCommandBuffer transferCommandBuffer = VK_NULL_HANDLE;
+			VkCommandBuffer graphicsCommandBuffer = VK_NULL_HANDLE;
+			VkFence fence = VK_NULL_HANDLE;
+			VkSemaphore semaphore = VK_NULL_HANDLE;
+			// Position of the ring head at submission, ring space up to here is free once the batch has completed
+			VkDeviceSize ringHead = 0;
+			std::vector<VkBufferMemoryBarrier> bufferBarriers;
+			std::vector<VkImageMemoryBarrier> imageBarriers;
+			std::vector<std::function<void(VkCommandBuffer)>> graphicsCommands;
+			std::vector<std::pair<VkBuffer, Allocation>> temporaryBuffers;
+		};
+
+		VkDevice device = VK_NULL_HANDLE;
+		MemoryAllocator *allocator = nullptr;
+		VkPhysicalDeviceMemoryProperties memoryProperties{};
+		VkDeviceSize optimalBufferCopyOffsetAlignment = 1;
+		// False if the queue family uploads are made available to (graphicsFamily) only supports compute or transfers
+		bool graphicsSupported = false;
+		uint32_t graphicsFamily = 0;
+		uint32_t transferFamily = 0;
+		VkQueue graphicsQueue = VK_NULL_HANDLE;
+		VkQueue transferQueue = VK_NULL_HANDLE;
+		VkCommandPool graphicsPool = VK_NULL_HANDLE;
+		VkCommandPool transferPool = VK_NULL_HANDLE;
+
+		struct {
+			VkBuffer buffer = VK_NULL_HANDLE;
+			Allocation allocation;
+			uint8_t *mapped = nullptr;
+			VkDeviceSize head = 0;
+			VkDeviceSize tail = 0;
+			// Set if ring space has been handed out for the batch that is currently being recorded
+			bool pendingUse = false;
+		} ring;
+
+		Batch *pending = nullptr;
+		std::deque<Batch*> inFlight;
+		std::vector<Batch*> freeBatches;
+		UploadTicket nextTicket = 1;
+		UploadTicket completedTicket = 0;
+		Statistics stats;
+		std::mutex mutex;
+
+		// Uploads can't be recorded before create, e.g. if the device was created without a queue the manager could use
+		void checkCreated() const
+		{
+			if (device == VK_NULL_HANDLE) {
+				throw std::runtime_error("The upload manager has not been created for this device");
+			}
+		}
+
+		static VkDeviceSize greatestCommonDivisor(VkDeviceSize a, VkDeviceSize b)
+		{
+			while (b != 0) {
+				const VkDeviceSize remainder = a % b;
+				a = b;
+				b = remainder;
+			}
+			return a;
+		}
+
+		bool ringEmpty() const
+		{
+			return inFlight.empty() && !ring.pendingUse;
+		}
+
+		uint32_t getStagingMemoryType(uint32_t typeBits) const
+		{
+			const VkMemoryPropertyFlags properties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+			for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++) {
+				if ((typeBits & (1 << i)) && ((memoryProperties.memoryTypes[i].propertyFlags & properties) == properties)) {
+					return i;
+				}
+			}
+			throw std::runtime_error("Could not find a host visible and coherent memory type for staging");
+		}
+
+		void createStagingBuffer(VkDeviceSize size, VkBuffer *buffer, Allocation *allocation)
+		{
+			VkBufferCreateInfo bufferCreateInfo = vks::initializers::bufferCreateInfo(VK_BUFFER_USAGE_TRANSFER_SRC_BIT, size);
+			VK_CHECK_RESULT(vkCreateBuffer(device, &bufferCreateInfo, nullptr, buffer));
+			VkMemoryRequirements memReqs;
+			vkGetBufferMemoryRequirements(device, *buffer, &memReqs);
+			VK_CHECK_RESULT(allocator->allocate(memReqs, getStagingMemoryType(memReqs.memoryTypeBits), ResourceType::Linear, allocation));
+			VK_CHECK_RESULT(vkBindBufferMemory(device, *buffer, allocation->memory, allocation->offset));
+		}
+
+		bool ringAllocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize *offset)
+		{
+			if (ringEmpty()) {
+				ring.head = ring.tail = 0;
+			}
+			const VkDeviceSize start = memory::alignUp(ring.head, alignment);
+			if (ring.head >= ring.tail) {
+				// Free space at the end of the ring and (after wrapping around) in front of the tail
+				if (start + size <= stagingSize) {
+					*offset = start;
+				} else if (size < ring.tail) {
+					*offset = 0;
+				} else {
+					return false;
+				}
+			} else {
+				// Free space between head and tail, the head must never catch up with the tail
+				if (start + size < ring.tail) {
+					*offset = start;
+				} else {
+					return false;
+				}
+			}
+			ring.head = *offset + size;
+			ring.pendingUse = true;
+			return true;
+		}
+
+		// Returns staging memory for an upload, waits for in-flight batches if the ring is full
+		StagingRange stage(VkDeviceSize size, VkDeviceSize alignment)
+		{
+			StagingRange range;
+			if (size <= stagingSize) {
+				if (ring.buffer == VK_NULL_HANDLE) {
+					createStagingBuffer(stagingSize, &ring.buffer, &ring.allocation);
+					ring.mapped = static_cast<uint8_t*>(ring.allocation.mapped);
+				}
+				VkDeviceSize offset;
+				bool allocated = ringAllocate(size, alignment, &offset);
+				if (!allocated && pending) {
+					submitLocked();
+				}
+				while (!allocated && !inFlight.empty()) {
+					stats.stalls++;
+					waitOldest();
+					allocated = ringAllocate(size, alignment, &offset);
+				}
+				if (allocated) {
+					range.buffer = ring.buffer;
+					range.offset = offset;
+					range.mapped = ring.mapped + offset;
+					return range;
+				}
+			}
+			// Too large for the ring, use a temporary staging buffer that is released once the batch has completed
+			createStagingBuffer(size, &range.buffer, &range.temporaryAllocation);
+			range.mapped = static_cast<uint8_t*>(range.temporaryAllocation.mapped);
+			return range;
+		}
+
+		// Returns the batch that is currently being recorded
+		Batch *getPending(const StagingRange *range = nullptr)
+		{
+			if (!pending) {
+				if (!freeBatches.empty()) {
+					pending = freeBatches.back();
+					freeBatches.pop_back();
+					VK_CHECK_RESULT(vkResetCommandBuffer(pending->transferCommandBuffer, 0));
+					if (pending->graphicsCommandBuffer) {
+						VK_CHECK_RESULT(vkResetCommandBuffer(pending->graphicsCommandBuffer, 0));
+					}
+					VK_CHECK_RESULT(vkResetFences(device, 1, &pending->fence));
+				} else {
+					pending = new Batch();
+					VkCommandBufferAllocateInfo cmdBufAllocateInfo = vks::initializers::commandBufferAllocateInfo(transferPool, VK_COMMAND_BUFFER_LEVEL_PRIMARY, 1);
+					VK_CHECK_RESULT(vkAllocateCommandBuffers(device, &cmdBufAllocateInfo, &pending->transferCommandBuffer));
+					if (separateTransferQueue()) {
+						cmdBufAllocateInfo.commandPool = graphicsPool;
+						VK_CHECK_RESULT(vkAllocateCommandBuffers(device, &cmdBufAllocateInfo, &pending->graphicsCommandBuffer));
+						VkSemaphoreCreateInfo semaphoreCreateInfo = vks::initializers::semaphoreCreateInfo();
+						VK_CHECK_RESULT(vkCreateSemaphore(device, &semaphoreCreateInfo, nullptr, &pending->semaphore));
+					}
+					VkFenceCreateInfo fenceCreateInfo = vks::initializers::fenceCreateInfo(VK_FLAGS_NONE);
+					VK_CHECK_RESULT(vkCreateFence(device, &fenceCreateInfo, nullptr, &pending->fence));
+				}
+				pending->ticket = nextTicket++;
+				VkCommandBufferBeginInfo cmdBufInfo = vks::initializers::commandBufferBeginInfo();
+				cmdBufInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+				VK_CHECK_RESULT(vkBeginCommandBuffer(pending->transferCommandBuffer, &cmdBufInfo));
+			}
+			if (range && range->temporaryAllocation.valid()) {
+				pending->temporaryBuffers.push_back(std::make_pair(range->buffer, range->temporaryAllocation));
+			}
+			return pending;
+		}
+
+		UploadTicket submitLocked()
+		{
+			if (!pending) {
+				return nextTicket - 1;
+			}
+			Batch *batch = pending;
+			pending = nullptr;
+			batch->ringHead = ring.head;
+			ring.pendingUse = false;
+
+			const bool separate = separateTransferQueue();
+			// With a dedicated transfer queue the barriers acquire ownership on the graphics queue, otherwise they complete the transfer on the same queue
+			VkCommandBuffer barrierCommandBuffer = separate ? batch->graphicsCommandBuffer : batch->transferCommandBuffer;
+			if (separate) {
+				VK_CHECK_RESULT(vkEndCommandBuffer(batch->transferCommandBuffer));
+				VkCommandBufferBeginInfo cmdBufInfo = vks::initializers::commandBufferBeginInfo();
+				cmdBufInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+				VK_CHECK_RESULT(vkBeginCommandBuffer(batch->graphicsCommandBuffer, &cmdBufInfo));
+			}
+			if (!batch->bufferBarriers.empty() || !batch->imageBarriers.empty()) {
+				vkCmdPipelineBarrier(
+					barrierCommandBuffer,
+					separate ? VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT : VK_PIPELINE_STAGE_TRANSFER_BIT,
+					VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+					0,
+					0, nullptr,
+					static_cast<uint32_t>(batch->bufferBarriers.size()), batch->bufferBarriers.data(),
+					static_cast<uint32_t>(batch->imageBarriers.size()), batch->imageBarriers.data());
+			}
+			for (auto &func : batch->graphicsCommands) {
+				func(barrierCommandBuffer);
+			}
+			VK_CHECK_RESULT(vkEndCommandBuffer(barrierCommandBuffer));
+
+			VkSubmitInfo submitInfo = vks::initializers::submitInfo();
+			submitInfo.commandBufferCount = 1;
+			if (separate) {
+				submitInfo.pCommandBuffers = &batch->transferCommandBuffer;
+				submitInfo.signalSemaphoreCount = 1;
+				submitInfo.pSignalSemaphores = &batch->semaphore;
+				VK_CHECK_RESULT(vkQueueSubmit(transferQueue, 1, &submitInfo, VK_NULL_HANDLE));
+				const VkPipelineStageFlags waitStageMask = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+				submitInfo = vks::initializers::submitInfo();
+				submitInfo.commandBufferCount = 1;
+				submitInfo.pCommandBuffers = &batch->graphicsCommandBuffer;
+				submitInfo.waitSemaphoreCount = 1;
+				submitInfo.pWaitSemaphores = &batch->semaphore;
+				submitInfo.pWaitDstStageMask = &waitStageMask;
+				VK_CHECK_RESULT(vkQueueSubmit(graphicsQueue, 1, &submitInfo, batch->fence));
+			} else {
+				submitInfo.pCommandBuffers = &batch->transferCommandBuffer;
+				VK_CHECK_RESULT(vkQueueSubmit(transferQueue, 1, &submitInfo, batch->fence));
+			}
+			inFlight.push_back(batch);
+			stats.submits++;
+			return batch->ticket;
+		}
+
+		void retireBatch(Batch *batch)
+		{
+			completedTicket = batch->ticket;
+			ring.tail = batch->ringHead;
+			for (auto &temporary : batch->temporaryBuffers) {
+				vkDestroyBuffer(device, temporary.first, nullptr);
+				allocator->free(temporary.second);
+			}
+			batch->temporaryBuffers.clear();
+			batch->bufferBarriers.clear();
+			batch->imageBarriers.clear();
+			batch->graphicsCommands.clear();
+			freeBatches.push_back(batch);
+		}
+
+		void waitOldest()
+		{
+			Batch *batch = inFlight.front();
+			VK_CHECK_RESULT(vkWaitForFences(device, 1, &batch->fence, VK_TRUE, DEFAULT_FENCE_TIMEOUT));
+			inFlight.pop_front();
+			retireBatch(batch);
+		}
+
+		// Retire all batches that have finished executing without blocking
+		void poll()
+		{
+			while (!inFlight.empty() && (vkGetFenceStatus(device, inFlight.front()->fence) == VK_SUCCESS)) {
+				Batch *batch = inFlight.front();
+				inFlight.pop_front();
+				retireBatch(batch);
+			}
+		}
+
+		void destroyBatch(Batch *batch)
+		{
+			for (auto &temporary : batch->temporaryBuffers) {
+				vkDestroyBuffer(device, temporary.first, nullptr);
+				allocator->free(temporary.second);
+			}
+			vkDestroyFence(device, batch->fence, nullptr);
+			if (batch->semaphore) {
+				vkDestroySemaphore(device, batch->semaphore, nullptr);
+			}
+			delete batch;
+		}
+
+	public:
+		/**
+		* Prepare the upload manager for use
+		*
+		* @param physicalDevice Physical device used to look up staging memory types
+		* @param device Logical device
+		* @param allocator Memory allocator used for staging memory
+		* @param graphicsFamily Queue family index of the graphics queue that uploaded resources are used on (or of the compute or transfer queue for devices without one)
+		* @param transferFamily Queue family index used for the copies (may be the same as the graphics queue family)
+		*/
+		void create(VkPhysicalDevice physicalDevice, VkDevice device, MemoryAllocator *allocator, uint32_t graphicsFamily, uint32_t transferFamily)
+		{
+			this->device = device;
+			this->allocator = allocator;
+			this->graphicsFamily = graphicsFamily;
+			this->transferFamily = transferFamily;
+			vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+			VkPhysicalDeviceProperties properties;
+			vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+			optimalBufferCopyOffsetAlignment = std::max(properties.limits.optimalBufferCopyOffsetAlignment, VkDeviceSize(1));
+			uint32_t queueFamilyCount;
+			vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+			std::vector<VkQueueFamilyProperties> queueFamilyProperties(queueFamilyCount);
+			vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueFamilyProperties.data());
+			graphicsSupported = (queueFamilyProperties[graphicsFamily].queueFlags & VK_QUEUE_GRAPHICS_BIT) != 0;
+			vkGetDeviceQueue(device, graphicsFamily, 0, &graphicsQueue);
+			vkGetDeviceQueue(device, transferFamily, 0, &transferQueue);
+			VkCommandPoolCreateInfo cmdPoolInfo = vks::initializers::commandPoolCreateInfo();
+			cmdPoolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT | VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+			cmdPoolInfo.queueFamilyIndex = transferFamily;
+			VK_CHECK_RESULT(vkCreateCommandPool(device, &cmdPoolInfo, nullptr, &transferPool));
+			if (separateTransferQueue()) {
+				cmdPoolInfo.queueFamilyIndex = graphicsFamily;
+				VK_CHECK_RESULT(vkCreateCommandPool(device, &cmdPoolInfo, nullptr, &graphicsPool));
+			}
+		}
+
+		/** @brief Wait for all uploads to finish and release all resources */
+		void destroy()
+		{
+			if (device == VK_NULL_HANDLE) {
+				return;
+			}
+			waitIdle();
+			for (auto batch : freeBatches) {
+				destroyBatch(batch);
+			}
+			freeBatches.clear();
+			if (ring.buffer) {
+				vkDestroyBuffer(device, ring.buffer, nullptr);
+				allocator->free(ring.allocation);
+				ring.buffer = VK_NULL_HANDLE;
+			}
+			vkDestroyCommandPool(device, transferPool, nullptr);
+			if (graphicsPool) {
+				vkDestroyCommandPool(device, graphicsPool, nullptr);
+			}
+			device = VK_NULL_HANDLE;
+		}
+
+		/** @brief True if copies are executed on a dedicated transfer queue family */
+		bool separateTransferQueue() const
+		{
+			return transferFamily != graphicsFamily;
+		}
+
+		/**
+		* Queue an upload of data to a buffer
+		*
+		* @param buffer Destination buffer (must have been created with VK_BUFFER_USAGE_TRANSFER_DST_BIT)
+		* @param data Pointer to the data to upload, copied to staging memory before the function returns
+		* @param size Size of the data in bytes
+		* @param dstOffset (Optional) Byte offset into the destination buffer
+		*
+		* @return Ticket of the batch containing the upload
+		*/
+		UploadTicket uploadBuffer(VkBuffer buffer, const void *data, VkDeviceSize size, VkDeviceSize dstOffset = 0)
+		{
+			checkCreated();
+			std::lock_guard<std::mutex> lock(mutex);
+			StagingRange range = stage(size, 4);
+			memcpy(range.mapped, data, static_cast<size_t>(size));
+			Batch *batch = getPending(&range);
+
+			VkBufferCopy copyRegion = {};
+			copyRegion.srcOffset = range.offset;
+			copyRegion.dstOffset = dstOffset;
+			copyRegion.size = size;
+			vkCmdCopyBuffer(batch->transferCommandBuffer, range.buffer, buffer, 1, &copyRegion);
+
+			VkBufferMemoryBarrier barrier = vks::initializers::bufferMemoryBarrier();
+			barrier.buffer = buffer;
+			barrier.offset = dstOffset;
+			barrier.size = size;
+			barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			if (separateTransferQueue()) {
+				// Release ownership to the graphics queue family, the matching acquire is recorded at submission
+				barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+				barrier.dstAccessMask = 0;
+				barrier.srcQueueFamilyIndex = transferFamily;
+				barrier.dstQueueFamilyIndex = graphicsFamily;
+				vkCmdPipelineBarrier(batch->transferCommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+				barrier.srcAccessMask = 0;
+			} else {
+				barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			}
+			barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+			batch->bufferBarriers.push_back(barrier);
+
+			stats.uploads++;
+			stats.bytes += size;
+			return batch->ticket;
+		}
+
+		/**
+		* Queue an upload of data to an image
+		*
+		* @param image Destination image (must have been created with VK_IMAGE_USAGE_TRANSFER_DST_BIT)
+		* @param format Format of the image, the staged data is aligned to its texel block size
+		* @param data Pointer to the data to upload, copied to staging memory before the function returns
+		* @param size Size of the data in bytes
+		* @param regions Copy regions, buffer offsets are relative to data
+		* @param subresourceRange Subresources of the image that are transitioned
+		* @param finalLayout Layout the subresources are transitioned to once the copies have finished
+		*
+		* @return Ticket of the batch containing the upload
+		*/
+		UploadTicket uploadImage(VkImage image, VkFormat format, const void *data, VkDeviceSize size, std::vector<VkBufferImageCopy> regions, VkImageSubresourceRange subresourceRange, VkImageLayout finalLayout)
+		{
+			checkCreated();
+			// Buffer offsets of image copies must be a multiple of the texel block size (which isn't a power of two for e.g. 3 byte formats) and of 4
+			const VkDeviceSize texelBlockSize = std::max(vks::tools::formatTexelBlockSize(format), 1u);
+			VkDeviceSize alignment = (texelBlockSize % 4 == 0) ? texelBlockSize : ((texelBlockSize % 2 == 0) ? texelBlockSize * 2 : texelBlockSize * 4);
+			if (alignment % optimalBufferCopyOffsetAlignment != 0) {
+				alignment = alignment * (optimalBufferCopyOffsetAlignment / greatestCommonDivisor(alignment, optimalBufferCopyOffsetAlignment));
+			}
+			std::lock_guard<std::mutex> lock(mutex);
+			StagingRange range = stage(size, alignment);
+			memcpy(range.mapped, data, static_cast<size_t>(size));
+			Batch *batch = getPending(&range);
+
+			VkImageMemoryBarrier barrier = vks::initializers::imageMemoryBarrier();
+			barrier.image = image;
+			barrier.subresourceRange = subresourceRange;
+			barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			barrier.srcAccessMask = 0;
+			barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			vkCmdPipelineBarrier(batch->transferCommandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+			for (auto &region : regions) {
+				region.bufferOffset += range.offset;
+			}
+			vkCmdCopyBufferToImage(batch->transferCommandBuffer, range.buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(regions.size()), regions.data());
+
+			barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			barrier.newLayout = finalLayout;
+			if (separateTransferQueue()) {
+				// Release ownership to the graphics queue family, the layout transition is executed by the release and the matching acquire
+				barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+				barrier.dstAccessMask = 0;
+				barrier.srcQueueFamilyIndex = transferFamily;
+				barrier.dstQueueFamilyIndex = graphicsFamily;
+				vkCmdPipelineBarrier(batch->transferCommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+				barrier.srcAccessMask = 0;
+			}
+			barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+			batch->imageBarriers.push_back(barrier);
+
+			stats.uploads++;
+			stats.bytes += size;
+			return batch->ticket;
+		}
+
+		/**
+		* Record commands that need to be executed on the graphics queue once the uploads of the current batch are available (e.g. mip map generation with blits)
+		*
+		* @param func Function recording the commands, called at submission
+		*
+		* @return Ticket of the batch the commands are part of
+		*/
+		UploadTicket recordGraphicsCommands(std::function<void(VkCommandBuffer)> func)
+		{
+			checkCreated();
+			if (!graphicsSupported) {
+				throw std::runtime_error("Graphics commands can't be added to uploads on a device without a graphics queue");
+			}
+			std::lock_guard<std::mutex> lock(mutex);
+			Batch *batch = getPending();
+			batch->graphicsCommands.push_back(func);
+			return batch->ticket;
+		}
+
+		/**
+		* Submit the batch that is currently being recorded without waiting for it to finish
+		*
+		* @note Work that is submitted to the graphics queue afterwards will see the uploaded data
+		*
+		* @return Ticket of the submitted batch
+		*/
+		UploadTicket submit()
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			poll();
+			return submitLocked();
+		}
+
+		/** @brief Returns true if all uploads up to and including the given ticket have finished */
+		bool isComplete(UploadTicket ticket)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			poll();
+			return ticket <= completedTicket;
+		}
+
+		/** @brief Wait on the host for all uploads up to and including the given ticket, submits the current batch if required */
+		void wait(UploadTicket ticket)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (pending && (ticket >= pending->ticket)) {
+				submitLocked();
+			}
+			while ((completedTicket < ticket) && !inFlight.empty()) {
+				waitOldest();
+			}
+		}
+
+		/** @brief Submit pending uploads and wait for all of them to finish */
+		void waitIdle()
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			submitLocked();
+			while (!inFlight.empty()) {
+				waitOldest();
+			}
+		}
+
+		/** @brief Returns the current upload statistics */
+		Statistics getStatistics()
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			return stats;
+		}
+	};
+}
@@ -12,15 +12,26 @@
 #include <string>
 #include <fstream>
 #include <vector>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
 
 #include "vulkan/vulkan.h"
 #include "VulkanDevice.hpp"
+#include "jobsystem.hpp"
+#include "benchmark.hpp"
+#include "simd.hpp"
+#include "frustum.hpp"
+#include "VulkanMeshCache.hpp"
+#include "VulkanMeshOptimizer.hpp"
 
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include <glm/gtc/packing.hpp>
 
 #define TINYGLTF_IMPLEMENTATION
 #define STB_IMAGE_IMPLEMENTATION
@@ -35,6 +46,42 @@ namespace vkglTF
 {
 	struct Node;
 
+	/*
+		Image loading callback for tinyglTF that only stores the encoded image data
+		Decoding is deferred until the file has been parsed, so images can be decoded in parallel
+	*/
+	inline bool loadImageDataDeferred(tinygltf::Image *image, const int imageIndex, std::string *error, std::string *warning, int reqWidth, int reqHeight, const unsigned char *bytes, int size, void *userData)
+	{
+		image->image.assign(bytes, bytes + size);
+		image->as_is = true;
+		return true;
+	}
+
+	/*
+		Decode an image stored by loadImageDataDeferred to 8 bit RGBA
+		Returns false if the data can't be decoded, the image is left unchanged in that case
+	*/
+	inline bool decodeImage(tinygltf::Image &image)
+	{
+		if (!image.as_is) {
+			return true;
+		}
+		int width, height, components;
+		unsigned char *data = stbi_load_from_memory(image.image.data(), static_cast<int>(image.image.size()), &width, &height, &components, 4);
+		if (!data) {
+			return false;
+		}
+		image.width = width;
+		image.height = height;
+		image.component = 4;
+		image.bits = 8;
+		image.pixel_type = TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE;
+		image.image.assign(data, data + static_cast<size_t>(width) * height * 4);
+		image.as_is = false;
+		stbi_image_free(data);
+		return true;
+	}
+
 	/*
 		glTF texture loading class
 	*/
@@ -43,6 +90,7 @@ namespace vkglTF
 		VkImage image;
 		VkImageLayout imageLayout;
 		VkDeviceMemory deviceMemory;
+		vks::Allocation allocation;
 		VkImageView view;
 		uint32_t width, height;
 		uint32_t mipLevels;
@@ -61,7 +109,7 @@ namespace vkglTF
 		{
 			vkDestroyImageView(device->logicalDevice, view, nullptr);
 			vkDestroyImage(device->logicalDevice, image, nullptr);
-			vkFreeMemory(device->logicalDevice, deviceMemory, nullptr);
+			device->memoryAllocator.free(allocation);
 			vkDestroySampler(device->logicalDevice, sampler, nullptr);
 		}
 
@@ -109,30 +157,6 @@ namespace vkglTF
 			assert(formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_BLIT_SRC_BIT);
 			assert(formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_BLIT_DST_BIT);
 
-			VkMemoryAllocateInfo memAllocInfo{};
-			memAllocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-			VkMemoryRequirements memReqs{};
-
-			VkBuffer stagingBuffer;
-			VkDeviceMemory stagingMemory;
-
-			VkBufferCreateInfo bufferCreateInfo{};
-			bufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-			bufferCreateInfo.size = bufferSize;
-			bufferCreateInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-			bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-			VK_CHECK_RESULT(vkCreateBuffer(device->logicalDevice, &bufferCreateInfo, nullptr, &stagingBuffer));
-			vkGetBufferMemoryRequirements(device->logicalDevice, stagingBuffer, &memReqs);
-			memAllocInfo.allocationSize = memReqs.size;
-			memAllocInfo.memoryTypeIndex = device->getMemoryType(memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-			VK_CHECK_RESULT(vkAllocateMemory(device->logicalDevice, &memAllocInfo, nullptr, &stagingMemory));
-			VK_CHECK_RESULT(vkBindBufferMemory(device->logicalDevice, stagingBuffer, stagingMemory, 0));
-
-			uint8_t *data;
-			VK_CHECK_RESULT(vkMapMemory(device->logicalDevice, stagingMemory, 0, memReqs.size, 0, (void **)&data));
-			memcpy(data, buffer, bufferSize);
-			vkUnmapMemory(device->logicalDevice, stagingMemory);
-
 			VkImageCreateInfo imageCreateInfo{};
 			imageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
 			imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
@@ -147,31 +171,14 @@ namespace vkglTF
 			imageCreateInfo.extent = { width, height, 1 };
 			imageCreateInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
 			VK_CHECK_RESULT(vkCreateImage(device->logicalDevice, &imageCreateInfo, nullptr, &image));
-			vkGetImageMemoryRequirements(device->logicalDevice, image, &memReqs);
-			memAllocInfo.allocationSize = memReqs.size;
-			memAllocInfo.memoryTypeIndex = device->getMemoryType(memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-			VK_CHECK_RESULT(vkAllocateMemory(device->logicalDevice, &memAllocInfo, nullptr, &deviceMemory));
-			VK_CHECK_RESULT(vkBindImageMemory(device->logicalDevice, image, deviceMemory, 0));
-
-			VkCommandBuffer copyCmd = device->createCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
+			VK_CHECK_RESULT(device->allocateImageMemory(image, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &allocation));
+			deviceMemory = allocation.memory;
 
 			VkImageSubresourceRange subresourceRange = {};
 			subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
 			subresourceRange.levelCount = 1;
 			subresourceRange.layerCount = 1;
 
-			{
-				VkImageMemoryBarrier imageMemoryBarrier{};
-				imageMemoryBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-				imageMemoryBarrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-				imageMemoryBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-				imageMemoryBarrier.srcAccessMask = 0;
-				imageMemoryBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-				imageMemoryBarrier.image = image;
-				imageMemoryBarrier.subresourceRange = subresourceRange;
-				vkCmdPipelineBarrier(copyCmd, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, 0, nullptr, 1, &imageMemoryBarrier);
-			}
-
 			VkBufferImageCopy bufferCopyRegion = {};
 			bufferCopyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
 			bufferCopyRegion.imageSubresource.mipLevel = 0;
@@ -181,93 +188,86 @@ namespace vkglTF
 			bufferCopyRegion.imageExtent.height = height;
 			bufferCopyRegion.imageExtent.depth = 1;
 
-			vkCmdCopyBufferToImage(copyCmd, stagingBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &bufferCopyRegion);
-
-			{
-				VkImageMemoryBarrier imageMemoryBarrier{};
-				imageMemoryBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-				imageMemoryBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-				imageMemoryBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-				imageMemoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-				imageMemoryBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-				imageMemoryBarrier.image = image;
-				imageMemoryBarrier.subresourceRange = subresourceRange;
-				vkCmdPipelineBarrier(copyCmd, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, 0, nullptr, 1, &imageMemoryBarrier);
+			// Stage the first mip level, it ends up in transfer source layout for the blits
+			device->uploadManager.uploadImage(image, format, buffer, bufferSize, { bufferCopyRegion }, subresourceRange, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+			if (deleteBuffer) {
+				delete[] buffer;
 			}
 
-			device->flushCommandBuffer(copyCmd, copyQueue, true);
-
-			vkFreeMemory(device->logicalDevice, stagingMemory, nullptr);
-			vkDestroyBuffer(device->logicalDevice, stagingBuffer, nullptr);
+			subresourceRange.levelCount = mipLevels;
+			imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
 
 			// Generate the mip chain (glTF uses jpg and png, so we need to create this manually)
-			VkCommandBuffer blitCmd = device->createCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
-			for (uint32_t i = 1; i < mipLevels; i++) {
-				VkImageBlit imageBlit{};
-
-				imageBlit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-				imageBlit.srcSubresource.layerCount = 1;
-				imageBlit.srcSubresource.mipLevel = i - 1;
-				imageBlit.srcOffsets[1].x = int32_t(width >> (i - 1));
-				imageBlit.srcOffsets[1].y = int32_t(height >> (i - 1));
-				imageBlit.srcOffsets[1].z = 1;
-
-				imageBlit.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-				imageBlit.dstSubresource.layerCount = 1;
-				imageBlit.dstSubresource.mipLevel = i;
-				imageBlit.dstOffsets[1].x = int32_t(width >> i);
-				imageBlit.dstOffsets[1].y = int32_t(height >> i);
-				imageBlit.dstOffsets[1].z = 1;
-
-				VkImageSubresourceRange mipSubRange = {};
-				mipSubRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-				mipSubRange.baseMipLevel = i;
-				mipSubRange.levelCount = 1;
-				mipSubRange.layerCount = 1;
+			// Blits need a graphics queue, so they are recorded by the upload manager once the copy has been made available to the graphics queue
+			// The texture is copied into the model's texture list after loading, so only copies of the required members are captured
+			const VkImage mipImage = image;
+			const uint32_t mipWidth = width;
+			const uint32_t mipHeight = height;
+			const uint32_t mipCount = mipLevels;
+			const VkImageSubresourceRange mipChainRange = subresourceRange;
+			device->uploadManager.recordGraphicsCommands([=](VkCommandBuffer blitCmd) {
+				for (uint32_t i = 1; i < mipCount; i++) {
+					VkImageBlit imageBlit{};
+
+					imageBlit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+					imageBlit.srcSubresource.layerCount = 1;
+					imageBlit.srcSubresource.mipLevel = i - 1;
+					imageBlit.srcOffsets[1].x = int32_t(mipWidth >> (i - 1));
+					imageBlit.srcOffsets[1].y = int32_t(mipHeight >> (i - 1));
+					imageBlit.srcOffsets[1].z = 1;
+
+					imageBlit.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+					imageBlit.dstSubresource.layerCount = 1;
+					imageBlit.dstSubresource.mipLevel = i;
+					imageBlit.dstOffsets[1].x = int32_t(mipWidth >> i);
+					imageBlit.dstOffsets[1].y = int32_t(mipHeight >> i);
+					imageBlit.dstOffsets[1].z = 1;
+
+					VkImageSubresourceRange mipSubRange = {};
+					mipSubRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+					mipSubRange.baseMipLevel = i;
+					mipSubRange.levelCount = 1;
+					mipSubRange.layerCount = 1;
 
-				{
-					VkImageMemoryBarrier imageMemoryBarrier{};
-					imageMemoryBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-					imageMemoryBarrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-					imageMemoryBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-					imageMemoryBarrier.srcAccessMask = 0;
-					imageMemoryBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-					imageMemoryBarrier.image = image;
-					imageMemoryBarrier.subresourceRange = mipSubRange;
-					vkCmdPipelineBarrier(blitCmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &imageMemoryBarrier);
-				}
+					{
+						VkImageMemoryBarrier imageMemoryBarrier{};
+						imageMemoryBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+						imageMemoryBarrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+						imageMemoryBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+						imageMemoryBarrier.srcAccessMask = 0;
+						imageMemoryBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+						imageMemoryBarrier.image = mipImage;
+						imageMemoryBarrier.subresourceRange = mipSubRange;
+						vkCmdPipelineBarrier(blitCmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &imageMemoryBarrier);
+					}
 
-				vkCmdBlitImage(blitCmd, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &imageBlit, VK_FILTER_LINEAR);
+					vkCmdBlitImage(blitCmd, mipImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, mipImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &imageBlit, VK_FILTER_LINEAR);
+
+					{
+						VkImageMemoryBarrier imageMemoryBarrier{};
+						imageMemoryBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+						imageMemoryBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+						imageMemoryBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+						imageMemoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+						imageMemoryBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+						imageMemoryBarrier.image = mipImage;
+						imageMemoryBarrier.subresourceRange = mipSubRange;
+						vkCmdPipelineBarrier(blitCmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &imageMemoryBarrier);
+					}
+				}
 
 				{
 					VkImageMemoryBarrier imageMemoryBarrier{};
 					imageMemoryBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-					imageMemoryBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-					imageMemoryBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+					imageMemoryBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+					imageMemoryBarrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
 					imageMemoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
 					imageMemoryBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-					imageMemoryBarrier.image = image;
-					imageMemoryBarrier.subresourceRange = mipSubRange;
-					vkCmdPipelineBarrier(blitCmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &imageMemoryBarrier);
+					imageMemoryBarrier.image = mipImage;
+					imageMemoryBarrier.subresourceRange = mipChainRange;
+					vkCmdPipelineBarrier(blitCmd, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, 0, nullptr, 1, &imageMemoryBarrier);
 				}
-			}
-
-			subresourceRange.levelCount = mipLevels;
-			imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-
-			{
-				VkImageMemoryBarrier imageMemoryBarrier{};
-				imageMemoryBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-				imageMemoryBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-				imageMemoryBarrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-				imageMemoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-				imageMemoryBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-				imageMemoryBarrier.image = image;
-				imageMemoryBarrier.subresourceRange = subresourceRange;
-				vkCmdPipelineBarrier(blitCmd, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, 0, nullptr, 1, &imageMemoryBarrier);
-			}
-
-			device->flushCommandBuffer(blitCmd, copyQueue, true);
+			});
 
 			VkSamplerCreateInfo samplerInfo{};
 			samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
@@ -326,6 +326,51 @@ namespace vkglTF
 		VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
 	};
 
+	/*
+		Axis aligned bounding box, empty until expanded
+	*/
+	struct BoundingBox {
+		glm::vec3 min = glm::vec3(FLT_MAX);
+		glm::vec3 max = glm::vec3(-FLT_MAX);
+
+		BoundingBox() {};
+		BoundingBox(glm::vec3 min, glm::vec3 max) : min(min), max(max) {};
+
+		bool valid() const {
+			return (min.x <= max.x) && (min.y <= max.y) && (min.z <= max.z);
+		}
+
+		void expand(const BoundingBox &box) {
+			min = glm::min(min, box.min);
+			max = glm::max(max, box.max);
+		}
+
+		/** @brief Center and radius of the box's bounding sphere */
+		glm::vec3 center() const {
+			return (min + max) * 0.5f;
+		}
+
+		float radius() const {
+			return glm::distance(min, max) * 0.5f;
+		}
+
+		/** @brief Smallest axis aligned box containing all eight corners of this box transformed by an affine matrix */
+		BoundingBox transform(const glm::mat4 &matrix) const {
+			if (!valid()) {
+				return BoundingBox();
+			}
+			const glm::vec3 localCenter = center();
+			const glm::vec3 localExtent = (max - min) * 0.5f;
+			const glm::vec3 worldCenter = glm::vec3(matrix * glm::vec4(localCenter, 1.0f));
+			// Extent along each world axis is the sum of the absolute projections of the box's half axes (Arvo)
+			glm::vec3 worldExtent;
+			for (uint32_t i = 0; i < 3; i++) {
+				worldExtent[i] = fabsf(matrix[0][i]) * localExtent.x + fabsf(matrix[1][i]) * localExtent.y + fabsf(matrix[2][i]) * localExtent.z;
+			}
+			return BoundingBox(worldCenter - worldExtent, worldCenter + worldExtent);
+		}
+	};
+
 	/*
 		glTF primitive
 	*/
@@ -352,9 +397,22 @@ namespace vkglTF
 			dimensions.radius = glm::distance(min, max) / 2.0f;
 		}
 
+		/** @brief World space bounds, maintained by Model::updateTransforms (see Model::updateNodeBounds) */
+		BoundingBox bounds;
+		/** @brief Result of the last Model::cull */
+		bool visible = true;
+
 		Primitive(uint32_t firstIndex, uint32_t indexCount, Material &material) : firstIndex(firstIndex), indexCount(indexCount), material(material) {};
 	};
 
+	/*
+		Links a loaded primitive to its glTF source for extracting the vertex and index data
+	*/
+	struct PrimitiveLoadInfo {
+		const tinygltf::Primitive *source;
+		Primitive *primitive;
+	};
+
 	/*
 		glTF mesh
 	*/
@@ -363,38 +421,47 @@ namespace vkglTF
 
 		std::vector<Primitive*> primitives;
 		std::string name;
+		/** @brief Index of the mesh's range in the model's joint palette (only valid for skinned meshes) */
+		uint32_t jointRange = 0;
+		/** @brief Index of the mesh's matrix and of the draw of its first primitive in the flattened draw list (only valid if the model has been loaded with Model::indirectDraw) */
+		uint32_t matrixIndex = 0;
+		uint32_t firstDraw = 0;
 
-		struct UniformBuffer {
-			VkBuffer buffer;
-			VkDeviceMemory memory;
-			VkDescriptorBufferInfo descriptor;
+		struct UniformBuffer : public vks::Buffer {
 			VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
-			void *mapped;
 		} uniformBuffer;
 
+		/** 
+		* Per mesh uniform data (std140)
+		*
+		* @note The joint matrices of skinned meshes are stored in the model's joint palette (see Model::JointPalette) at jointOffset
+		*/
 		struct UniformBlock {
 			glm::mat4 matrix;
-			glm::mat4 jointMatrix[64]{};
-			float jointcount{ 0 };
+			uint32_t jointOffset{ 0 };
+			uint32_t jointCount{ 0 };
+			uint32_t padding[2]{ 0, 0 };
+			/** @brief Positions stored as Unorm16 (see VertexFormat) are dequantized with pos = positionOffset.xyz + positionScale.xyz * inPos.xyz, identity for all other formats */
+			glm::vec4 positionScale = glm::vec4(1.0f);
+			glm::vec4 positionOffset = glm::vec4(0.0f);
 		} uniformBlock;
 
 		Mesh(vks::VulkanDevice *device, glm::mat4 matrix) {
 			this->device = device;
 			this->uniformBlock.matrix = matrix;
+			// Uniform buffers of all meshes are sub-allocated from the same persistently mapped memory block
 			VK_CHECK_RESULT(device->createBuffer(
 				VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
 				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+				&uniformBuffer,
 				sizeof(uniformBlock),
-				&uniformBuffer.buffer,
-				&uniformBuffer.memory,
 				&uniformBlock));
-			VK_CHECK_RESULT(vkMapMemory(device->logicalDevice, uniformBuffer.memory, 0, sizeof(uniformBlock), 0, &uniformBuffer.mapped));
-			uniformBuffer.descriptor = { uniformBuffer.buffer, 0, sizeof(uniformBlock) };
+			VK_CHECK_RESULT(uniformBuffer.map());
+			uniformBuffer.setupDescriptor(sizeof(uniformBlock));
 		};
 
 		~Mesh() {
-			vkDestroyBuffer(device->logicalDevice, uniformBuffer.buffer, nullptr);
-			vkFreeMemory(device->logicalDevice, uniformBuffer.memory, nullptr);
+			uniformBuffer.destroy();
 		}
 
 	};
@@ -425,43 +492,84 @@ namespace vkglTF
 		glm::vec3 scale{ 1.0f };
 		glm::quat rotation{};
 
+		/** @brief Transforms cached by Model::updateTransforms, valid while neither the node nor one of its ancestors is dirty */
+		glm::mat4 cachedLocalMatrix{ 1.0f };
+		glm::mat4 cachedWorldMatrix{ 1.0f };
+		/** @brief Set if translation, rotation, scale or matrix have been changed since the last transform update (see setDirty) */
+		bool dirty = true;
+		/** @brief Set if the world matrix has been recalculated by the last transform update */
+		bool worldChanged = true;
+		/** @brief Position of the node in Model::sortedNodes */
+		uint32_t sortedIndex = 0;
+		/** @brief World space bounds of the node's mesh and of the meshes of the node and all its descendants, maintained by Model::updateTransforms */
+		BoundingBox bounds;
+		BoundingBox subtreeBounds;
+
+		/** @brief Needs to be called after changing translation, rotation, scale or matrix, so the cached matrices of the node and its subtree are updated */
+		void setDirty() {
+			dirty = true;
+		}
+
 		glm::mat4 localMatrix() {
 			return glm::translate(glm::mat4(1.0f), translation) * glm::mat4(rotation) * glm::scale(glm::mat4(1.0f), scale) * matrix;
 		}
 
+		/** @brief Returns the world matrix of the node, from the cache unless the node or one of its ancestors has been changed since the last transform update */
 		glm::mat4 getMatrix() {
-			glm::mat4 m = localMatrix();
-			vkglTF::Node *p = parent;
-			while (p) {
-				m = p->localMatrix() * m;
-				p = p->parent;
+			for (vkglTF::Node *p = this; p; p = p->parent) {
+				if (p->dirty) {
+					glm::mat4 m = localMatrix();
+					vkglTF::Node *q = parent;
+					while (q) {
+						m = q->localMatrix() * m;
+						q = q->parent;
+					}
+					return m;
+				}
 			}
-			return m;
+			return cachedWorldMatrix;
 		}
 
-		void update() {
-			if (mesh) {
-				glm::mat4 m = getMatrix();
-				if (skin) {
-					mesh->uniformBlock.matrix = m;
-					// Update join matrices
-					glm::mat4 inverseTransform = glm::inverse(m);
-					for (size_t i = 0; i < skin->joints.size(); i++) {
-						vkglTF::Node *jointNode = skin->joints[i];
-						glm::mat4 jointMat = jointNode->getMatrix() * skin->inverseBindMatrices[i];
-						jointMat = inverseTransform * jointMat;
-						mesh->uniformBlock.jointMatrix[i] = jointMat;
-					}
-					mesh->uniformBlock.jointcount = (float)skin->joints.size();
-					memcpy(mesh->uniformBuffer.mapped, &mesh->uniformBlock, sizeof(mesh->uniformBlock));
-				} else {
-					memcpy(mesh->uniformBuffer.mapped, &m, sizeof(glm::mat4));
+		/**
+		* Write the node's world matrix to the mesh's uniform buffer and the joint matrices of its skin to the palette
+		*
+		* @param jointMatrices Host copy of the model's joint palette (see Model::JointPalette)
+		*
+		* @note Expects the cached matrices to be up to date (see Model::updateTransforms), children are not updated
+		*/
+		void update(glm::mat4 *jointMatrices) {
+			if (!mesh) {
+				return;
+			}
+			const glm::mat4 &m = cachedWorldMatrix;
+			mesh->uniformBlock.matrix = m;
+			memcpy(mesh->uniformBuffer.mapped, &m, sizeof(glm::mat4));
+			if (skin && (mesh->uniformBlock.jointCount > 0)) {
+				// Update joint matrices
+				glm::mat4 inverseTransform = glm::inverse(m);
+				for (uint32_t i = 0; i < mesh->uniformBlock.jointCount; i++) {
+					vkglTF::Node *jointNode = skin->joints[i];
+					jointMatrices[mesh->uniformBlock.jointOffset + i] = inverseTransform * jointNode->cachedWorldMatrix * skin->inverseBindMatrices[i];
 				}
 			}
+		}
 
-			for (auto& child : children) {
-				child->update();
+		/** @brief True if the mesh's uniform buffer needs to be updated after the last transform update */
+		bool meshChanged() const {
+			if (!mesh) {
+				return false;
+			}
+			if (worldChanged) {
+				return true;
+			}
+			if (skin) {
+				for (const vkglTF::Node *joint : skin->joints) {
+					if (joint->worldChanged) {
+						return true;
+					}
+				}
 			}
+			return false;
 		}
 
 		~Node() {
@@ -482,6 +590,8 @@ namespace vkglTF
 		PathType path;
 		Node *node;
 		uint32_t samplerIndex;
+		/** @brief Keyframe interval found by the last evaluation, where the next lookup starts */
+		uint32_t keyCursor = 0;
 	};
 
 	/*
@@ -491,7 +601,310 @@ namespace vkglTF
 		enum InterpolationType { LINEAR, STEP, CUBICSPLINE };
 		InterpolationType interpolation;
 		std::vector<float> inputs;
+		/** @brief Output values, cubic spline samplers store in-tangent, value and out-tangent for every keyframe */
 		std::vector<glm::vec4> outputsVec4;
+
+		/** @brief True if there are enough outputs for all keyframes */
+		bool valid() const {
+			return !inputs.empty() && (outputsVec4.size() >= inputs.size() * (interpolation == CUBICSPLINE ? 3 : 1));
+		}
+
+		/**
+		* Find the keyframe interval [inputs[i], inputs[i + 1]] that contains the given time
+		*
+		* @param time Time to look up, clamped to the first and last keyframe
+		* @param cursor Interval found by the previous lookup, the search gallops forward from there (amortized O(1) for continuous playback) and falls back to a binary search when going backwards, updated to the result
+		*
+		* @return Index of the first keyframe of the interval
+		*/
+		uint32_t findKey(float time, uint32_t &cursor) const {
+			const uint32_t lastInterval = static_cast<uint32_t>(inputs.size()) - 2;
+			if (time <= inputs.front()) {
+				cursor = 0;
+			} else if (time >= inputs.back()) {
+				cursor = lastInterval;
+			} else if ((cursor <= lastInterval) && (inputs[cursor] <= time) && (time < inputs[cursor + 1])) {
+				// Same interval as the last lookup
+			} else if ((cursor <= lastInterval) && (inputs[cursor] <= time)) {
+				// Playback moved forward, gallop from the cursor so advancing by a few keyframes stays cheap
+				uint32_t first = cursor + 1;
+				uint32_t step = 1;
+				while ((first + step <= lastInterval) && (inputs[first + step] <= time)) {
+					first += step;
+					step *= 2;
+				}
+				const uint32_t last = std::min(first + step, lastInterval + 1);
+				cursor = static_cast<uint32_t>(std::upper_bound(inputs.begin() + first, inputs.begin() + last, time) - inputs.begin()) - 1;
+			} else {
+				cursor = static_cast<uint32_t>(std::upper_bound(inputs.begin(), inputs.end(), time) - inputs.begin()) - 1;
+			}
+			return cursor;
+		}
+
+		/**
+		* Evaluate the sampler at the given time
+		*
+		* @param time Time to evaluate, clamped to the first and last keyframe
+		* @param cursor Keyframe cursor of the channel (see findKey)
+		* @param rotation True if the outputs are rotation quaternions (x, y, z, w), which are interpolated spherically and normalized
+		*/
+		glm::vec4 evaluate(float time, uint32_t &cursor, bool rotation) const {
+			if (inputs.size() == 1) {
+				return outputsVec4[interpolation == CUBICSPLINE ? 1 : 0];
+			}
+			const uint32_t i = findKey(time, cursor);
+			const float t0 = inputs[i];
+			const float t1 = inputs[i + 1];
+			const float dt = t1 - t0;
+			const float u = (dt > 0.0f) ? std::min(std::max((time - t0) / dt, 0.0f), 1.0f) : 0.0f;
+			switch (interpolation) {
+			case STEP:
+				return outputsVec4[(time >= t1) ? i + 1 : i];
+			case CUBICSPLINE: {
+				// Hermite spline between the values of both keyframes using the out-tangent of the first and the in-tangent of the second keyframe (scaled by the interval length)
+				const float u2 = u * u;
+				const float u3 = u2 * u;
+				const glm::vec4 &p0 = outputsVec4[i * 3 + 1];
+				const glm::vec4 m0 = outputsVec4[i * 3 + 2] * dt;
+				const glm::vec4 &p1 = outputsVec4[(i + 1) * 3 + 1];
+				const glm::vec4 m1 = outputsVec4[(i + 1) * 3] * dt;
+				glm::vec4 value = p0 * (2.0f * u3 - 3.0f * u2 + 1.0f) + m0 * (u3 - 2.0f * u2 + u) + p1 * (-2.0f * u3 + 3.0f * u2) + m1 * (u3 - u2);
+				if (rotation) {
+					value = glm::normalize(value);
+				}
+				return value;
+			}
+			default: {
+				if (!rotation) {
+					return glm::mix(outputsVec4[i], outputsVec4[i + 1], u);
+				}
+				const glm::vec4 &a = outputsVec4[i];
+				const glm::vec4 &b = outputsVec4[i + 1];
+				const glm::quat q = glm::normalize(glm::slerp(glm::quat(a.w, a.x, a.y, a.z), glm::quat(b.w, b.x, b.y, b.z), u));
+				return glm::vec4(q.x, q.y, q.z, q.w);
+			}
+			}
+		}
+
+		/**
+		* Keyframe values surrounding the given time and the interpolation factor between them, for evaluating many channels in a batch (see AnimationBatch)
+		*
+		* @note Step and cubic spline samplers are evaluated completely and return the result in both values
+		*/
+		void interval(float time, uint32_t &cursor, bool rotation, glm::vec4 &a, glm::vec4 &b, float &u) const {
+			if ((interpolation != LINEAR) || (inputs.size() == 1)) {
+				a = b = evaluate(time, cursor, rotation);
+				u = 0.0f;
+				return;
+			}
+			const uint32_t i = findKey(time, cursor);
+			const float dt = inputs[i + 1] - inputs[i];
+			u = (dt > 0.0f) ? std::min(std::max((time - inputs[i]) / dt, 0.0f), 1.0f) : 0.0f;
+			a = outputsVec4[i];
+			b = outputsVec4[i + 1];
+		}
+	};
+
+	/*
+		Structure-of-arrays streams for evaluating all channels of an animation in a batch
+		Channels are grouped by their target path, and the keyframe values surrounding the current time are gathered per component so that four (SSE) or eight (AVX2) channels are interpolated at once
+	*/
+	struct AnimationBatch {
+		/** @brief Streams are padded to a multiple of the widest vector */
+		static const uint32_t LANES = 8;
+
+		struct Stream {
+			/** @brief Channel indices (in Animation::channels) evaluated in this stream */
+			std::vector<uint32_t> channels;
+			std::vector<float> a[4];
+			std::vector<float> b[4];
+			std::vector<float> u;
+			std::vector<float> result[4];
+			/** @brief Number of channels rounded up to a multiple of LANES */
+			uint32_t paddedCount = 0;
+
+			void resize(uint32_t count, bool rotation) {
+				paddedCount = (count + LANES - 1) / LANES * LANES;
+				for (uint32_t c = 0; c < 4; c++) {
+					// Padding lanes hold identity quaternions so the rotation kernels don't normalize zero vectors
+					const float pad = (rotation && c == 3) ? 1.0f : 0.0f;
+					a[c].assign(paddedCount, pad);
+					b[c].assign(paddedCount, pad);
+					result[c].assign(paddedCount, 0.0f);
+				}
+				u.assign(paddedCount, 0.0f);
+			}
+		};
+		/** @brief One stream per AnimationChannel::PathType */
+		Stream streams[3];
+		bool initialized = false;
+
+		/** @brief Linear interpolation of the first components of all channels in a stream */
+		static void lerpScalar(Stream &stream, uint32_t components) {
+			for (uint32_t c = 0; c < components; c++) {
+				const float *a = stream.a[c].data();
+				const float *b = stream.b[c].data();
+				float *r = stream.result[c].data();
+				for (uint32_t i = 0; i < stream.paddedCount; i++) {
+					r[i] = a[i] + (b[i] - a[i]) * stream.u[i];
+				}
+			}
+		}
+
+		/**
+		* Rotation interpolation of all channels in a stream
+		*
+		* @param nlerp Interpolate linearly and normalize, otherwise the interpolation factor is corrected to approximate slerp (maximum error of about 1e-3 radians for unrelated quaternions, much lower for neighbouring keyframes)
+		*
+		* @note The correction is a cubic polynomial in the factor with coefficients depending on the cosine of the angle between both quaternions (see "Approximating slerp" by Arseny Kapoulkine)
+		*/
+		static void rotationScalar(Stream &stream, bool nlerp) {
+			for (uint32_t i = 0; i < stream.paddedCount; i++) {
+				float d = stream.a[0][i] * stream.b[0][i] + stream.a[1][i] * stream.b[1][i] + stream.a[2][i] * stream.b[2][i] + stream.a[3][i] * stream.b[3][i];
+				// Interpolate along the shortest arc
+				const float sign = (d < 0.0f) ? -1.0f : 1.0f;
+				d *= sign;
+				float t = stream.u[i];
+				if (!nlerp) {
+					const float ca = 1.0904f + d * (-3.2452f + d * (3.55645f - d * 1.43519f));
+					const float cb = 0.848013f + d * (-1.06021f + d * 0.215638f);
+					const float th = t - 0.5f;
+					const float k = ca * th * th + cb;
+					t = t + t * th * (t - 1.0f) * k;
+				}
+				float q[4];
+				float len = 0.0f;
+				for (uint32_t c = 0; c < 4; c++) {
+					q[c] = stream.a[c][i] + (stream.b[c][i] * sign - stream.a[c][i]) * t;
+					len += q[c] * q[c];
+				}
+				len = std::sqrt(len);
+				for (uint32_t c = 0; c < 4; c++) {
+					stream.result[c][i] = q[c] / len;
+				}
+			}
+		}
+
+#if defined(VKS_SIMD_X86)
+		VKS_SIMD_TARGET_SSE2 static void lerpSSE(Stream &stream, uint32_t components) {
+			for (uint32_t c = 0; c < components; c++) {
+				for (uint32_t i = 0; i < stream.paddedCount; i += 4) {
+					const __m128 a = _mm_loadu_ps(&stream.a[c][i]);
+					const __m128 b = _mm_loadu_ps(&stream.b[c][i]);
+					const __m128 u = _mm_loadu_ps(&stream.u[i]);
+					_mm_storeu_ps(&stream.result[c][i], _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), u)));
+				}
+			}
+		}
+
+		VKS_SIMD_TARGET_SSE2 static void rotationSSE(Stream &stream, bool nlerp) {
+			const __m128 signMask = _mm_set1_ps(-0.0f);
+			const __m128 half = _mm_set1_ps(0.5f);
+			const __m128 one = _mm_set1_ps(1.0f);
+			for (uint32_t i = 0; i < stream.paddedCount; i += 4) {
+				__m128 a[4], b[4];
+				for (uint32_t c = 0; c < 4; c++) {
+					a[c] = _mm_loadu_ps(&stream.a[c][i]);
+					b[c] = _mm_loadu_ps(&stream.b[c][i]);
+				}
+				__m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a[0], b[0]), _mm_mul_ps(a[1], b[1])), _mm_add_ps(_mm_mul_ps(a[2], b[2]), _mm_mul_ps(a[3], b[3])));
+				// Flip b into the hemisphere of a by transferring the sign bit of the dot product
+				const __m128 sign = _mm_and_ps(d, signMask);
+				d = _mm_xor_ps(d, sign);
+				__m128 t = _mm_loadu_ps(&stream.u[i]);
+				if (!nlerp) {
+					const __m128 ca = _mm_add_ps(_mm_set1_ps(1.0904f), _mm_mul_ps(d, _mm_add_ps(_mm_set1_ps(-3.2452f), _mm_mul_ps(d, _mm_sub_ps(_mm_set1_ps(3.55645f), _mm_mul_ps(d, _mm_set1_ps(1.43519f)))))));
+					const __m128 cb = _mm_add_ps(_mm_set1_ps(0.848013f), _mm_mul_ps(d, _mm_add_ps(_mm_set1_ps(-1.06021f), _mm_mul_ps(d, _mm_set1_ps(0.215638f)))));
+					const __m128 th = _mm_sub_ps(t, half);
+					const __m128 k = _mm_add_ps(_mm_mul_ps(ca, _mm_mul_ps(th, th)), cb);
+					t = _mm_add_ps(t, _mm_mul_ps(_mm_mul_ps(t, th), _mm_mul_ps(_mm_sub_ps(t, one), k)));
+				}
+				__m128 q[4];
+				__m128 len = _mm_setzero_ps();
+				for (uint32_t c = 0; c < 4; c++) {
+					q[c] = _mm_add_ps(a[c], _mm_mul_ps(_mm_sub_ps(_mm_xor_ps(b[c], sign), a[c]), t));
+					len = _mm_add_ps(len, _mm_mul_ps(q[c], q[c]));
+				}
+				len = _mm_sqrt_ps(len);
+				for (uint32_t c = 0; c < 4; c++) {
+					_mm_storeu_ps(&stream.result[c][i], _mm_div_ps(q[c], len));
+				}
+			}
+		}
+
+		VKS_SIMD_TARGET_AVX2 static void lerpAVX2(Stream &stream, uint32_t components) {
+			for (uint32_t c = 0; c < components; c++) {
+				for (uint32_t i = 0; i < stream.paddedCount; i += 8) {
+					const __m256 a = _mm256_loadu_ps(&stream.a[c][i]);
+					const __m256 b = _mm256_loadu_ps(&stream.b[c][i]);
+					const __m256 u = _mm256_loadu_ps(&stream.u[i]);
+					_mm256_storeu_ps(&stream.result[c][i], _mm256_add_ps(a, _mm256_mul_ps(_mm256_sub_ps(b, a), u)));
+				}
+			}
+		}
+
+		VKS_SIMD_TARGET_AVX2 static void rotationAVX2(Stream &stream, bool nlerp) {
+			const __m256 signMask = _mm256_set1_ps(-0.0f);
+			const __m256 half = _mm256_set1_ps(0.5f);
+			const __m256 one = _mm256_set1_ps(1.0f);
+			for (uint32_t i = 0; i < stream.paddedCount; i += 8) {
+				__m256 a[4], b[4];
+				for (uint32_t c = 0; c < 4; c++) {
+					a[c] = _mm256_loadu_ps(&stream.a[c][i]);
+					b[c] = _mm256_loadu_ps(&stream.b[c][i]);
+				}
+				__m256 d = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(a[0], b[0]), _mm256_mul_ps(a[1], b[1])), _mm256_add_ps(_mm256_mul_ps(a[2], b[2]), _mm256_mul_ps(a[3], b[3])));
+				const __m256 sign = _mm256_and_ps(d, signMask);
+				d = _mm256_xor_ps(d, sign);
+				__m256 t = _mm256_loadu_ps(&stream.u[i]);
+				if (!nlerp) {
+					const __m256 ca = _mm256_add_ps(_mm256_set1_ps(1.0904f), _mm256_mul_ps(d, _mm256_add_ps(_mm256_set1_ps(-3.2452f), _mm256_mul_ps(d, _mm256_sub_ps(_mm256_set1_ps(3.55645f), _mm256_mul_ps(d, _mm256_set1_ps(1.43519f)))))));
+					const __m256 cb = _mm256_add_ps(_mm256_set1_ps(0.848013f), _mm256_mul_ps(d, _mm256_add_ps(_mm256_set1_ps(-1.06021f), _mm256_mul_ps(d, _mm256_set1_ps(0.215638f)))));
+					const __m256 th = _mm256_sub_ps(t, half);
+					const __m256 k = _mm256_add_ps(_mm256_mul_ps(ca, _mm256_mul_ps(th, th)), cb);
+					t = _mm256_add_ps(t, _mm256_mul_ps(_mm256_mul_ps(t, th), _mm256_mul_ps(_mm256_sub_ps(t, one), k)));
+				}
+				__m256 q[4];
+				__m256 len = _mm256_setzero_ps();
+				for (uint32_t c = 0; c < 4; c++) {
+					q[c] = _mm256_add_ps(a[c], _mm256_mul_ps(_mm256_sub_ps(_mm256_xor_ps(b[c], sign), a[c]), t));
+					len = _mm256_add_ps(len, _mm256_mul_ps(q[c], q[c]));
+				}
+				len = _mm256_sqrt_ps(len);
+				for (uint32_t c = 0; c < 4; c++) {
+					_mm256_storeu_ps(&stream.result[c][i], _mm256_div_ps(q[c], len));
+				}
+			}
+		}
+#endif
+
+		/** @brief Interpolate all channels of a stream with the given instruction set */
+		static void interpolate(Stream &stream, bool rotation, bool nlerp, vks::simd::Path path) {
+			// Translations and scales only use the first three components
+#if defined(VKS_SIMD_X86)
+			if (path == vks::simd::Path::AVX2) {
+				if (rotation) {
+					rotationAVX2(stream, nlerp);
+				} else {
+					lerpAVX2(stream, 3);
+				}
+				return;
+			}
+			if (path == vks::simd::Path::SSE) {
+				if (rotation) {
+					rotationSSE(stream, nlerp);
+				} else {
+					lerpSSE(stream, 3);
+				}
+				return;
+			}
+#endif
+			if (rotation) {
+				rotationScalar(stream, nlerp);
+			} else {
+				lerpScalar(stream, 3);
+			}
+		}
 	};
 
 	/*
@@ -503,6 +916,17 @@ namespace vkglTF
 		std::vector<AnimationChannel> channels;
 		float start = std::numeric_limits<float>::max();
 		float end = std::numeric_limits<float>::min();
+		/** @brief Scratch streams for the batched evaluation, set up on first use */
+		AnimationBatch batch;
+	};
+
+	/*
+		Animation with playback time and weight for blending multiple animations (see Model::updateAnimations)
+	*/
+	struct AnimationState {
+		uint32_t index;
+		float time;
+		float weight = 1.0f;
 	};
 
 	/*
@@ -549,245 +973,836 @@ namespace vkglTF
 		}
 	};
 
-	enum FileLoadingFlags {
-		None = 0x00000000,
-		PreTransformVertices = 0x00000001,
-		PreMultiplyVertexColors = 0x00000002,
-		FlipY = 0x00000004
+	/*
+		Encodings of the vertex components in the device vertex buffer (see VertexFormat)
+	*/
+	enum class VertexEncoding {
+		/** @brief 32 bit floats, same as Vertex */
+		Float,
+		/** @brief 16 bit floats (UV, Joint0), exact for joint indices up to 2048 */
+		Half,
+		/** @brief Normalized 16 bit unsigned integers (Position, UV, Weight0), positions are mapped to the bounds of their mesh and have to be dequantized in the shader (see Mesh::UniformBlock) */
+		Unorm16,
+		/** @brief Normalized 8 bit unsigned integers (Color, Weight0) */
+		Unorm8,
+		/** @brief Normalized 8 bit signed integers (Normal) */
+		Snorm8,
+		/** @brief Octahedral mapping to two normalized 16 bit signed integers (Normal), has to be decoded in the shader */
+		Octahedral,
+		/** @brief 8 bit unsigned integers (Joint0), has to be read as an uvec4 in the shader */
+		Uint8
 	};
 
 	/*
-		glTF model loading and rendering class
+		Layout of the device vertex buffer
+		The model always keeps the full Vertex on the host (skinning, culling, mesh cache), the vertices are only packed into this format on upload
+		An empty format stores the full Vertex, so the attribute descriptions of the format can be used in both cases
 	*/
-	struct Model {
-
-		vks::VulkanDevice *device;
-		VkDescriptorPool descriptorPool;
-		VkDescriptorSetLayout descriptorSetLayout;
-
-		struct Vertices {
-			VkBuffer buffer;
-			VkDeviceMemory memory;
-		} vertices;
-		struct Indices {
-			int count;
-			VkBuffer buffer;
-			VkDeviceMemory memory;
-		} indices;
+	struct VertexFormat {
+		struct Attribute {
+			VertexComponent component;
+			VertexEncoding encoding;
+		};
+		/** @brief Components stored in the vertex buffer in this order */
+		std::vector<Attribute> attributes;
 
-		std::vector<Node*> nodes;
-		std::vector<Node*> linearNodes;
+		VertexFormat() {};
+		VertexFormat(std::vector<Attribute> attributes) : attributes(std::move(attributes)) {};
 
-		std::vector<Skin*> skins;
+		/**
+		* Compact format for the given components
+		*
+		* @param components Components required by the shaders, everything else is dropped from the vertex buffer
+		* @param shaderDecoding Use the encodings that need to be decoded in the shader (quantized positions, octahedral normals, integer joints) instead of the ones read transparently by the vertex input
+		*/
+		static VertexFormat compact(const std::vector<VertexComponent> &components, bool shaderDecoding) {
+			VertexFormat format;
+			for (VertexComponent component : components) {
+				VertexEncoding encoding = VertexEncoding::Float;
+				switch (component) {
+					case VertexComponent::Position:
+						encoding = shaderDecoding ? VertexEncoding::Unorm16 : VertexEncoding::Float;
+						break;
+					case VertexComponent::Normal:
+						encoding = shaderDecoding ? VertexEncoding::Octahedral : VertexEncoding::Snorm8;
+						break;
+					case VertexComponent::UV:
+						encoding = VertexEncoding::Half;
+						break;
+					case VertexComponent::Color:
+						encoding = VertexEncoding::Unorm8;
+						break;
+					case VertexComponent::Joint0:
+						encoding = shaderDecoding ? VertexEncoding::Uint8 : VertexEncoding::Half;
+						break;
+					case VertexComponent::Weight0:
+						encoding = VertexEncoding::Unorm8;
+						break;
+				}
+				format.attributes.push_back({ component, encoding });
+			}
+			return format;
+		}
 
-		std::vector<Texture> textures;
-		std::vector<Material> materials;
-		std::vector<Animation> animations;
+		bool packed() const {
+			return !attributes.empty();
+		}
 
-		struct Dimensions {
-			glm::vec3 min = glm::vec3(FLT_MAX);
-			glm::vec3 max = glm::vec3(-FLT_MAX);
-			glm::vec3 size;
-			glm::vec3 center;
-			float radius;
-		} dimensions;
+		/** @brief Vulkan format of an encoded component, VK_FORMAT_UNDEFINED if the encoding is not supported for the component */
+		static VkFormat attributeFormat(VertexComponent component, VertexEncoding encoding) {
+			const uint32_t componentCount = (component == VertexComponent::UV) ? 2 : ((component == VertexComponent::Position) || (component == VertexComponent::Normal)) ? 3 : 4;
+			switch (encoding) {
+				case VertexEncoding::Float:
+					return (componentCount == 2) ? VK_FORMAT_R32G32_SFLOAT : (componentCount == 3) ? VK_FORMAT_R32G32B32_SFLOAT : VK_FORMAT_R32G32B32A32_SFLOAT;
+				case VertexEncoding::Half:
+					return (component == VertexComponent::UV) ? VK_FORMAT_R16G16_SFLOAT : (component == VertexComponent::Joint0) ? VK_FORMAT_R16G16B16A16_SFLOAT : VK_FORMAT_UNDEFINED;
+				case VertexEncoding::Unorm16:
+					// Three component 16 bit formats are not required for vertex buffers, positions are padded to four
+					return (component == VertexComponent::UV) ? VK_FORMAT_R16G16_UNORM : ((component == VertexComponent::Position) || (component == VertexComponent::Weight0)) ? VK_FORMAT_R16G16B16A16_UNORM : VK_FORMAT_UNDEFINED;
+				case VertexEncoding::Unorm8:
+					return ((component == VertexComponent::Color) || (component == VertexComponent::Weight0)) ? VK_FORMAT_R8G8B8A8_UNORM : VK_FORMAT_UNDEFINED;
+				case VertexEncoding::Snorm8:
+					return (component == VertexComponent::Normal) ? VK_FORMAT_R8G8B8A8_SNORM : VK_FORMAT_UNDEFINED;
+				case VertexEncoding::Octahedral:
+					return (component == VertexComponent::Normal) ? VK_FORMAT_R16G16_SNORM : VK_FORMAT_UNDEFINED;
+				case VertexEncoding::Uint8:
+					return (component == VertexComponent::Joint0) ? VK_FORMAT_R8G8B8A8_UINT : VK_FORMAT_UNDEFINED;
+				default:
+					return VK_FORMAT_UNDEFINED;
+			}
+		}
 
-		bool metallicRoughnessWorkflow = true;
+		/** @brief Size of an encoded component in bytes, all sizes are multiples of four to keep the attributes aligned */
+		static uint32_t attributeSize(VertexComponent component, VertexEncoding encoding) {
+			switch (attributeFormat(component, encoding)) {
+				case VK_FORMAT_R32G32B32A32_SFLOAT:
+					return 16;
+				case VK_FORMAT_R32G32B32_SFLOAT:
+					return 12;
+				case VK_FORMAT_R32G32_SFLOAT:
+				case VK_FORMAT_R16G16B16A16_SFLOAT:
+				case VK_FORMAT_R16G16B16A16_UNORM:
+					return 8;
+				case VK_FORMAT_UNDEFINED:
+					return 0;
+				default:
+					return 4;
+			}
+		}
 
-		Model() {};
+		uint32_t stride() const {
+			if (!packed()) {
+				return sizeof(Vertex);
+			}
+			uint32_t res = 0;
+			for (const Attribute &attribute : attributes) {
+				res += attributeSize(attribute.component, attribute.encoding);
+			}
+			return res;
+		}
 
-		~Model() 
-		{
-			vkDestroyBuffer(device->logicalDevice, vertices.buffer, nullptr);
-			vkFreeMemory(device->logicalDevice, vertices.memory, nullptr);
-			vkDestroyBuffer(device->logicalDevice, indices.buffer, nullptr);
-			vkFreeMemory(device->logicalDevice, indices.memory, nullptr);
-			for (auto texture : textures) {
-				texture.destroy();
+		/** @brief Returns the index of the component in the attributes, -1 if the format does not store it */
+		int32_t find(VertexComponent component) const {
+			for (size_t i = 0; i < attributes.size(); i++) {
+				if (attributes[i].component == component) {
+					return static_cast<int32_t>(i);
+				}
 			}
-			for (auto node : nodes) {
-				delete node;
+			return -1;
+		}
+
+		/** @brief True if positions have to be dequantized with the mesh's positionScale and positionOffset */
+		bool quantizedPositions() const {
+			const int32_t index = find(VertexComponent::Position);
+			return (index >= 0) && (attributes[index].encoding == VertexEncoding::Unorm16);
+		}
+
+		/** @brief Returns false if an encoding is not supported for its component */
+		bool valid() const {
+			for (const Attribute &attribute : attributes) {
+				if (attributeFormat(attribute.component, attribute.encoding) == VK_FORMAT_UNDEFINED) {
+					return false;
+				}
 			}
-			vkDestroyDescriptorSetLayout(device->logicalDevice, descriptorSetLayout, nullptr);
-			vkDestroyDescriptorPool(device->logicalDevice, descriptorPool, nullptr);
+			return true;
 		}
 
-		void loadNode(vkglTF::Node *parent, const tinygltf::Node &node, uint32_t nodeIndex, const tinygltf::Model &model, std::vector<uint32_t>& indexBuffer, std::vector<Vertex>& vertexBuffer, float globalscale)
-		{
-			vkglTF::Node *newNode = new Node{};
-			newNode->index = nodeIndex;
-			newNode->parent = parent;
-			newNode->name = node.name;
-			newNode->skinIndex = node.skin;
-			newNode->matrix = glm::mat4(1.0f);
+		VkVertexInputBindingDescription inputBindingDescription(uint32_t binding) const {
+			return VkVertexInputBindingDescription({ binding, stride(), VK_VERTEX_INPUT_RATE_VERTEX });
+		}
 
-			// Generate local node matrix
-			glm::vec3 translation = glm::vec3(0.0f);
-			if (node.translation.size() == 3) {
-				translation = glm::make_vec3(node.translation.data());
-				newNode->translation = translation;
+		/** @brief Attribute description of a component, components not stored in the format are read from the start of the vertex */
+		VkVertexInputAttributeDescription inputAttributeDescription(uint32_t binding, uint32_t location, VertexComponent component) const {
+			if (!packed()) {
+				return Vertex::inputAttributeDescription(binding, location, component);
 			}
-			glm::mat4 rotation = glm::mat4(1.0f);
-			if (node.rotation.size() == 4) {
-				glm::quat q = glm::make_quat(node.rotation.data());
-				newNode->rotation = glm::mat4(q);
+			uint32_t offset = 0;
+			for (const Attribute &attribute : attributes) {
+				if (attribute.component == component) {
+					return VkVertexInputAttributeDescription({ location, binding, attributeFormat(attribute.component, attribute.encoding), offset });
+				}
+				offset += attributeSize(attribute.component, attribute.encoding);
 			}
-			glm::vec3 scale = glm::vec3(1.0f);
-			if (node.scale.size() == 3) {
-				scale = glm::make_vec3(node.scale.data());
-				newNode->scale = scale;
+			return VkVertexInputAttributeDescription({ location, binding, attributeFormat(attributes[0].component, attributes[0].encoding), 0 });
+		}
+
+		std::vector<VkVertexInputAttributeDescription> inputAttributeDescriptions(uint32_t binding, const std::vector<VertexComponent> components) const {
+			std::vector<VkVertexInputAttributeDescription> result;
+			uint32_t location = 0;
+			for (VertexComponent component : components) {
+				result.push_back(inputAttributeDescription(binding, location, component));
+				location++;
 			}
-			if (node.matrix.size() == 16) {
-				newNode->matrix = glm::make_mat4x4(node.matrix.data());
-				if (globalscale != 1.0f) {
-					//newNode->matrix = glm::scale(newNode->matrix, glm::vec3(globalscale));
-				}
-			};
+			return result;
+		}
 
-			// Node with children
-			if (node.children.size() > 0) {
-				for (auto i = 0; i < node.children.size(); i++) {
-					loadNode(newNode, model.nodes[node.children[i]], node.children[i], model, indexBuffer, vertexBuffer, globalscale);
-				}
+		/** @brief Octahedral mapping of a unit vector to [-1, 1]^2 */
+		static glm::vec2 octahedralEncode(const glm::vec3 &n) {
+			const float sum = std::fabs(n.x) + std::fabs(n.y) + std::fabs(n.z);
+			if (sum == 0.0f) {
+				return glm::vec2(0.0f);
+			}
+			glm::vec2 p(n.x / sum, n.y / sum);
+			if (n.z < 0.0f) {
+				// Fold the lower hemisphere over the diagonals
+				const glm::vec2 folded((1.0f - std::fabs(p.y)) * (p.x >= 0.0f ? 1.0f : -1.0f), (1.0f - std::fabs(p.x)) * (p.y >= 0.0f ? 1.0f : -1.0f));
+				p = folded;
 			}
+			return p;
+		}
 
-			// Node contains mesh data
-			if (node.mesh > -1) {
-				const tinygltf::Mesh mesh = model.meshes[node.mesh];
-				Mesh *newMesh = new Mesh(device, newNode->matrix);
-				newMesh->name = mesh.name;
-				for (size_t j = 0; j < mesh.primitives.size(); j++) {
-					const tinygltf::Primitive &primitive = mesh.primitives[j];
-					if (primitive.indices < 0) {
-						continue;
-					}
-					uint32_t indexStart = static_cast<uint32_t>(indexBuffer.size());
-					uint32_t vertexStart = static_cast<uint32_t>(vertexBuffer.size());
-					uint32_t indexCount = 0;
-					uint32_t vertexCount = 0;
-					glm::vec3 posMin{};
-					glm::vec3 posMax{};
-					bool hasSkin = false;
-					// Vertices
-					{
-						const float *bufferPos = nullptr;
-						const float *bufferNormals = nullptr;
-						const float *bufferTexCoords = nullptr;
-						const float* bufferColors = nullptr;
-						uint32_t numColorComponents;
-						const uint16_t *bufferJoints = nullptr;
-						const float *bufferWeights = nullptr;
-
-						// Position attribute is required
-						assert(primitive.attributes.find("POSITION") != primitive.attributes.end());
-
-						const tinygltf::Accessor &posAccessor = model.accessors[primitive.attributes.find("POSITION")->second];
-						const tinygltf::BufferView &posView = model.bufferViews[posAccessor.bufferView];
-						bufferPos = reinterpret_cast<const float *>(&(model.buffers[posView.buffer].data[posAccessor.byteOffset + posView.byteOffset]));
-						posMin = glm::vec3(posAccessor.minValues[0], posAccessor.minValues[1], posAccessor.minValues[2]);
-						posMax = glm::vec3(posAccessor.maxValues[0], posAccessor.maxValues[1], posAccessor.maxValues[2]);
-
-						if (primitive.attributes.find("NORMAL") != primitive.attributes.end()) {
-							const tinygltf::Accessor &normAccessor = model.accessors[primitive.attributes.find("NORMAL")->second];
-							const tinygltf::BufferView &normView = model.bufferViews[normAccessor.bufferView];
-							bufferNormals = reinterpret_cast<const float *>(&(model.buffers[normView.buffer].data[normAccessor.byteOffset + normView.byteOffset]));
-						}
+		/** @brief Same decoding as in the shaders */
+		static glm::vec3 octahedralDecode(const glm::vec2 &p) {
+			glm::vec3 n(p.x, p.y, 1.0f - std::fabs(p.x) - std::fabs(p.y));
+			const float t = std::max(-n.z, 0.0f);
+			n.x += (n.x >= 0.0f) ? -t : t;
+			n.y += (n.y >= 0.0f) ? -t : t;
+			return glm::normalize(n);
+		}
 
-						if (primitive.attributes.find("TEXCOORD_0") != primitive.attributes.end()) {
-							const tinygltf::Accessor &uvAccessor = model.accessors[primitive.attributes.find("TEXCOORD_0")->second];
-							const tinygltf::BufferView &uvView = model.bufferViews[uvAccessor.bufferView];
-							bufferTexCoords = reinterpret_cast<const float *>(&(model.buffers[uvView.buffer].data[uvAccessor.byteOffset + uvView.byteOffset]));
+		/**
+		* Encode a single vertex
+		*
+		* @param vertex Source vertex
+		* @param target Start of the encoded vertex, stride() bytes are written
+		* @param positionScale Extent of the mesh's positions, only used for quantized positions
+		* @param positionOffset Minimum of the mesh's positions, only used for quantized positions
+		*/
+		void pack(const Vertex &vertex, uint8_t *target, const glm::vec3 &positionScale, const glm::vec3 &positionOffset) const {
+			for (const Attribute &attribute : attributes) {
+				const float *source = nullptr;
+				uint32_t count = 4;
+				switch (attribute.component) {
+					case VertexComponent::Position:
+						source = &vertex.pos.x;
+						count = 3;
+						break;
+					case VertexComponent::Normal:
+						source = &vertex.normal.x;
+						count = 3;
+						break;
+					case VertexComponent::UV:
+						source = &vertex.uv.x;
+						count = 2;
+						break;
+					case VertexComponent::Color:
+						source = &vertex.color.x;
+						break;
+					case VertexComponent::Joint0:
+						source = &vertex.joint0.x;
+						break;
+					case VertexComponent::Weight0:
+						source = &vertex.weight0.x;
+						break;
+				}
+				const uint32_t size = attributeSize(attribute.component, attribute.encoding);
+				switch (attribute.encoding) {
+					case VertexEncoding::Float:
+						memcpy(target, source, count * sizeof(float));
+						break;
+					case VertexEncoding::Half: {
+						uint16_t *dst = reinterpret_cast<uint16_t*>(target);
+						for (uint32_t i = 0; i < count; i++) {
+							dst[i] = glm::packHalf1x16(source[i]);
 						}
-						if (primitive.attributes.find("COLOR_0") != primitive.attributes.end()) {
-							const tinygltf::Accessor& colorAccessor = model.accessors[primitive.attributes.find("COLOR_0")->second];
-							const tinygltf::BufferView& colorView = model.bufferViews[colorAccessor.bufferView];
-							// Color buffer are either of type vec3 or vec4
-							numColorComponents = colorAccessor.type == TINYGLTF_PARAMETER_TYPE_FLOAT_VEC3 ? 3 : 4;
-							bufferColors = reinterpret_cast<const float*>(&(model.buffers[colorView.buffer].data[colorAccessor.byteOffset + colorView.byteOffset]));
+						break;
+					}
+					case VertexEncoding::Unorm16: {
+						uint16_t *dst = reinterpret_cast<uint16_t*>(target);
+						for (uint32_t i = 0; i < count; i++) {
+							dst[i] = (attribute.component == VertexComponent::Position) ? glm::packUnorm1x16((source[i] - positionOffset[i]) / positionScale[i]) : glm::packUnorm1x16(source[i]);
 						}
-
-						// Skinning
-						// Joints
-						if (primitive.attributes.find("JOINTS_0") != primitive.attributes.end()) {
-							const tinygltf::Accessor &jointAccessor = model.accessors[primitive.attributes.find("JOINTS_0")->second];
-							const tinygltf::BufferView &jointView = model.bufferViews[jointAccessor.bufferView];
-							bufferJoints = reinterpret_cast<const uint16_t *>(&(model.buffers[jointView.buffer].data[jointAccessor.byteOffset + jointView.byteOffset]));
+						if (count == 3) {
+							dst[3] = 0xffff;
 						}
-
-						if (primitive.attributes.find("WEIGHTS_0") != primitive.attributes.end()) {
-							const tinygltf::Accessor &uvAccessor = model.accessors[primitive.attributes.find("WEIGHTS_0")->second];
-							const tinygltf::BufferView &uvView = model.bufferViews[uvAccessor.bufferView];
-							bufferWeights = reinterpret_cast<const float *>(&(model.buffers[uvView.buffer].data[uvAccessor.byteOffset + uvView.byteOffset]));
+						break;
+					}
+					case VertexEncoding::Unorm8: {
+						for (uint32_t i = 0; i < count; i++) {
+							target[i] = glm::packUnorm1x8(source[i]);
 						}
-
-						hasSkin = (bufferJoints && bufferWeights);
-
-						vertexCount = static_cast<uint32_t>(posAccessor.count);
-
-						for (size_t v = 0; v < posAccessor.count; v++) {
-							Vertex vert{};
-							vert.pos = glm::vec4(glm::make_vec3(&bufferPos[v * 3]), 1.0f);
-							vert.normal = glm::normalize(glm::vec3(bufferNormals ? glm::make_vec3(&bufferNormals[v * 3]) : glm::vec3(0.0f)));
-							vert.uv = bufferTexCoords ? glm::make_vec2(&bufferTexCoords[v * 2]) : glm::vec3(0.0f);
-							if (bufferColors) {
-								switch (numColorComponents) {
-									case 3: 
-										vert.color = glm::vec4(glm::make_vec3(&bufferColors[v * 3]), 1.0f);
-									case 4:
-										vert.color = glm::make_vec4(&bufferColors[v * 4]);
-								}
+						if (attribute.component == VertexComponent::Weight0) {
+							// Rounding may change the sum of the weights, the difference is added to the largest one
+							uint32_t sum = 0;
+							uint32_t largest = 0;
+							for (uint32_t i = 0; i < 4; i++) {
+								sum += target[i];
+								largest = (target[i] > target[largest]) ? i : largest;
 							}
-							else {
-								vert.color = glm::vec4(1.0f);
+							if ((sum > 0) && (sum != 255)) {
+								target[largest] = static_cast<uint8_t>(static_cast<int32_t>(target[largest]) + 255 - static_cast<int32_t>(sum));
 							}
-							vert.joint0 = hasSkin ? glm::vec4(glm::make_vec4(&bufferJoints[v * 4])) : glm::vec4(0.0f);
-							vert.weight0 = hasSkin ? glm::make_vec4(&bufferWeights[v * 4]) : glm::vec4(0.0f);
-							vertexBuffer.push_back(vert);
 						}
+						break;
 					}
-					// Indices
-					{
-						const tinygltf::Accessor &accessor = model.accessors[primitive.indices];
-						const tinygltf::BufferView &bufferView = model.bufferViews[accessor.bufferView];
-						const tinygltf::Buffer &buffer = model.buffers[bufferView.buffer];
-
-						indexCount = static_cast<uint32_t>(accessor.count);
-
-						switch (accessor.componentType) {
-						case TINYGLTF_PARAMETER_TYPE_UNSIGNED_INT: {
-							uint32_t *buf = new uint32_t[accessor.count];
-							memcpy(buf, &buffer.data[accessor.byteOffset + bufferView.byteOffset], accessor.count * sizeof(uint32_t));
-							for (size_t index = 0; index < accessor.count; index++) {
-								indexBuffer.push_back(buf[index] + vertexStart);
-							}
-							break;
-						}
-						case TINYGLTF_PARAMETER_TYPE_UNSIGNED_SHORT: {
-							uint16_t *buf = new uint16_t[accessor.count];
-							memcpy(buf, &buffer.data[accessor.byteOffset + bufferView.byteOffset], accessor.count * sizeof(uint16_t));
-							for (size_t index = 0; index < accessor.count; index++) {
-								indexBuffer.push_back(buf[index] + vertexStart);
-							}
-							break;
-						}
-						case TINYGLTF_PARAMETER_TYPE_UNSIGNED_BYTE: {
-							uint8_t *buf = new uint8_t[accessor.count];
-							memcpy(buf, &buffer.data[accessor.byteOffset + bufferView.byteOffset], accessor.count * sizeof(uint8_t));
-							for (size_t index = 0; index < accessor.count; index++) {
-								indexBuffer.push_back(buf[index] + vertexStart);
-							}
-							break;
+					case VertexEncoding::Snorm8: {
+						for (uint32_t i = 0; i < count; i++) {
+							target[i] = glm::packSnorm1x8(source[i]);
 						}
-						default:
-							std::cerr << "Index component type " << accessor.componentType << " not supported!" << std::endl;
-							return;
+						target[3] = 0;
+						break;
+					}
+					case VertexEncoding::Octahedral: {
+						const glm::vec2 p = octahedralEncode(vertex.normal);
+						uint16_t *dst = reinterpret_cast<uint16_t*>(target);
+						dst[0] = glm::packSnorm1x16(p.x);
+						dst[1] = glm::packSnorm1x16(p.y);
+						break;
+					}
+					case VertexEncoding::Uint8: {
+						for (uint32_t i = 0; i < count; i++) {
+							target[i] = static_cast<uint8_t>(std::min(std::max(source[i], 0.0f), 255.0f));
 						}
+						break;
+					}
+				}
+				target += size;
+			}
+		}
+	};
+
+	enum FileLoadingFlags {
+		None = 0x00000000,
+		PreTransformVertices = 0x00000001,
+		PreMultiplyVertexColors = 0x00000002,
+		FlipY = 0x00000004,
+		/** @brief Print the loading time of each phase to stdout (loading times are always reported to a running benchmark) */
+		LogLoadingTimes = 0x00000008
+	};
+
+	/*
+		Host side vertex skinning for devices where skinning in the vertex shader is not an option (see Model::cpuSkinning)
+
+		Uses the same formula as the skinning shaders, with the normal transformed by the inverse transpose of the skin matrix:
+		  skinMat = weight.x * joints[joint.x] + weight.y * joints[joint.y] + weight.z * joints[joint.z] + weight.w * joints[joint.w]
+		  pos = (skinMat * vec4(pos, 1.0)).xyz
+		  normal = normalize(transpose(inverse(mat3(skinMat))) * normal)
+	*/
+	struct VertexSkinning {
+		/** @brief Vertices of a skinned primitive and the joint palette range of its mesh */
+		struct Range {
+			uint32_t firstVertex;
+			uint32_t vertexCount;
+			uint32_t jointOffset;
+			uint32_t jointRange;
+		};
+
+		/**
+		* Skin a single vertex with a blended matrix
+		*
+		* @note The inverse transpose of the upper 3x3 is its cofactor matrix divided by the determinant, only the sign of the determinant survives the normalization
+		*/
+		static void transformScalar(const float *m, const Vertex &source, Vertex &target) {
+			for (uint32_t c = 0; c < 3; c++) {
+				target.pos[c] = m[c] * source.pos.x + m[4 + c] * source.pos.y + m[8 + c] * source.pos.z + m[12 + c];
+			}
+			const float *a = &m[0];
+			const float *b = &m[4];
+			const float *d = &m[8];
+			const float cofactor[3][3] = {
+				{ b[1] * d[2] - b[2] * d[1], b[2] * d[0] - b[0] * d[2], b[0] * d[1] - b[1] * d[0] },
+				{ d[1] * a[2] - d[2] * a[1], d[2] * a[0] - d[0] * a[2], d[0] * a[1] - d[1] * a[0] },
+				{ a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0] },
+			};
+			const float det = a[0] * cofactor[0][0] + a[1] * cofactor[0][1] + a[2] * cofactor[0][2];
+			float n[3];
+			for (uint32_t c = 0; c < 3; c++) {
+				n[c] = cofactor[0][c] * source.normal.x + cofactor[1][c] * source.normal.y + cofactor[2][c] * source.normal.z;
+				if (det < 0.0f) {
+					n[c] = -n[c];
+				}
+			}
+			const float lengthSq = n[0] * n[0] + n[1] * n[1] + n[2] * n[2];
+			// Degenerate skin matrices (e.g. all weights zero) leave a zero normal instead of NaNs
+			const float length = (lengthSq > 0.0f) ? std::sqrt(lengthSq) : 1.0f;
+			for (uint32_t c = 0; c < 3; c++) {
+				target.normal[c] = n[c] / length;
+			}
+		}
+
+		/** @brief Reference implementation, joint indices are expected to be valid for the given joint matrices */
+		static void skinScalar(const Vertex *source, Vertex *target, size_t count, const glm::mat4 *jointMatrices) {
+			for (size_t v = 0; v < count; v++) {
+				float m[16] = {};
+				for (uint32_t k = 0; k < 4; k++) {
+					const float w = source[v].weight0[k];
+					const float *joint = &jointMatrices[static_cast<int>(source[v].joint0[k])][0][0];
+					for (uint32_t i = 0; i < 16; i++) {
+						m[i] += w * joint[i];
+					}
+				}
+				transformScalar(m, source[v], target[v]);
+			}
+		}
+
+#if defined(VKS_SIMD_X86)
+		/** @brief Cross product of the xyz components, evaluated in the same order as the scalar path */
+		VKS_SIMD_TARGET_SSE2 static inline __m128 crossSSE(__m128 a, __m128 b) {
+			const __m128 aYZX = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1));
+			const __m128 aZXY = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 1, 0, 2));
+			const __m128 bYZX = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+			const __m128 bZXY = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 1, 0, 2));
+			return _mm_sub_ps(_mm_mul_ps(aYZX, bZXY), _mm_mul_ps(aZXY, bYZX));
+		}
+
+		/** @brief Horizontal sum of the xyz components as ((x + y) + z) in the lowest lane */
+		VKS_SIMD_TARGET_SSE2 static inline __m128 sum3SSE(__m128 v) {
+			return _mm_add_ss(_mm_add_ss(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1))), _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2)));
+		}
+
+		/** @brief Same as transformScalar with the blended matrix in four column registers */
+		VKS_SIMD_TARGET_SSE2 static inline void transformSSE(__m128 c0, __m128 c1, __m128 c2, __m128 c3, const Vertex &source, Vertex &target) {
+			const __m128 pos = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(c0, _mm_set1_ps(source.pos.x)), _mm_mul_ps(c1, _mm_set1_ps(source.pos.y))), _mm_mul_ps(c2, _mm_set1_ps(source.pos.z))), c3);
+			const __m128 cofactor0 = crossSSE(c1, c2);
+			const __m128 cofactor1 = crossSSE(c2, c0);
+			const __m128 cofactor2 = crossSSE(c0, c1);
+			const float det = _mm_cvtss_f32(sum3SSE(_mm_mul_ps(c0, cofactor0)));
+			__m128 n = _mm_add_ps(_mm_add_ps(_mm_mul_ps(cofactor0, _mm_set1_ps(source.normal.x)), _mm_mul_ps(cofactor1, _mm_set1_ps(source.normal.y))), _mm_mul_ps(cofactor2, _mm_set1_ps(source.normal.z)));
+			if (det < 0.0f) {
+				n = _mm_xor_ps(n, _mm_set1_ps(-0.0f));
+			}
+			const float lengthSq = _mm_cvtss_f32(sum3SSE(_mm_mul_ps(n, n)));
+			const float length = (lengthSq > 0.0f) ? std::sqrt(lengthSq) : 1.0f;
+			n = _mm_div_ps(n, _mm_set1_ps(length));
+			float p[4], q[4];
+			_mm_storeu_ps(p, pos);
+			_mm_storeu_ps(q, n);
+			target.pos = glm::vec3(p[0], p[1], p[2]);
+			target.normal = glm::vec3(q[0], q[1], q[2]);
+		}
+
+		/** @brief Blends the four joint matrices column by column */
+		VKS_SIMD_TARGET_SSE2 static void skinSSE(const Vertex *source, Vertex *target, size_t count, const glm::mat4 *jointMatrices) {
+			for (size_t v = 0; v < count; v++) {
+				__m128 c[4];
+				for (uint32_t k = 0; k < 4; k++) {
+					const __m128 w = _mm_set1_ps(source[v].weight0[k]);
+					const float *joint = &jointMatrices[static_cast<int>(source[v].joint0[k])][0][0];
+					for (uint32_t i = 0; i < 4; i++) {
+						const __m128 weighted = _mm_mul_ps(w, _mm_loadu_ps(joint + i * 4));
+						c[i] = (k == 0) ? weighted : _mm_add_ps(c[i], weighted);
+					}
+				}
+				transformSSE(c[0], c[1], c[2], c[3], source[v], target[v]);
+			}
+		}
+
+		/** @brief Blends the four joint matrices two columns at a time */
+		VKS_SIMD_TARGET_AVX2 static void skinAVX2(const Vertex *source, Vertex *target, size_t count, const glm::mat4 *jointMatrices) {
+			for (size_t v = 0; v < count; v++) {
+				__m256 lo = _mm256_setzero_ps();
+				__m256 hi = _mm256_setzero_ps();
+				for (uint32_t k = 0; k < 4; k++) {
+					const __m256 w = _mm256_set1_ps(source[v].weight0[k]);
+					const float *joint = &jointMatrices[static_cast<int>(source[v].joint0[k])][0][0];
+					const __m256 weightedLo = _mm256_mul_ps(w, _mm256_loadu_ps(joint));
+					const __m256 weightedHi = _mm256_mul_ps(w, _mm256_loadu_ps(joint + 8));
+					lo = (k == 0) ? weightedLo : _mm256_add_ps(lo, weightedLo);
+					hi = (k == 0) ? weightedHi : _mm256_add_ps(hi, weightedHi);
+				}
+				transformSSE(_mm256_castps256_ps128(lo), _mm256_extractf128_ps(lo, 1), _mm256_castps256_ps128(hi), _mm256_extractf128_ps(hi, 1), source[v], target[v]);
+			}
+		}
+#endif
+
+		/** @brief Skin vertices with the given instruction set, all paths produce the same results as the reference implementation */
+		static void skin(const Vertex *source, Vertex *target, size_t count, const glm::mat4 *jointMatrices, vks::simd::Path path) {
+#if defined(VKS_SIMD_X86)
+			if (path == vks::simd::Path::AVX2) {
+				skinAVX2(source, target, count, jointMatrices);
+				return;
+			}
+			if (path == vks::simd::Path::SSE) {
+				skinSSE(source, target, count, jointMatrices);
+				return;
+			}
+#endif
+			skinScalar(source, target, count, jointMatrices);
+		}
+	};
+
+	/*
+		glTF model loading and rendering class
+	*/
+	struct Model {
+
+		/** @brief Device the model has been loaded for, models built on the host (e.g. for benchmarks) don't have one */
+		vks::VulkanDevice *device = nullptr;
+		VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+		VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE;
+
+		vks::Buffer vertices;
+		struct Indices : public vks::Buffer {
+			int count;
+		} indices;
+
+		std::vector<Node*> nodes;
+		std::vector<Node*> linearNodes;
+		/** @brief All nodes in hierarchy order (parents before their children, subtrees contiguous), used for the linear transform update */
+		std::vector<Node*> sortedNodes;
+
+		/** @brief Per node scratch space for blending animations (indexed by Node::sortedIndex) */
+		struct BlendAccumulator {
+			glm::vec4 value[3] = { glm::vec4(0.0f), glm::vec4(0.0f), glm::vec4(0.0f) };
+			float weight[3] = { 0.0f, 0.0f, 0.0f };
+			bool target = false;
+		};
+		std::vector<BlendAccumulator> blendAccumulators;
+		std::vector<Node*> blendTargets;
+
+		/**
+		* Joint matrices of all skinned meshes, packed into a single persistently mapped storage buffer
+		*
+		* The buffer holds one slice per frame in flight, each mesh's joints are stored at Mesh::UniformBlock::jointOffset within a slice
+		* The slice is selected with a dynamic offset for binding 1 of the model's descriptor set layout (see jointPaletteDynamicOffset):
+		*   layout (set = n, binding = 1) readonly buffer JointMatrices { mat4 jointMatrices[]; };
+		* Only ranges of meshes whose joints changed are written and flushed to a slice
+		*/
+		struct JointPalette {
+			vks::Buffer buffer;
+			/** @brief Size of a slice, aligned to the device's storage buffer offset alignment */
+			VkDeviceSize sliceSize = 0;
+			/** @brief Number of slices, must be set before loading (see framesInFlight) */
+			uint32_t sliceCount = 1;
+			/** @brief Slice written by updates and selected by the dynamic offset */
+			uint32_t currentSlice = 0;
+			/** @brief Host copy of the joint matrices of all meshes */
+			std::vector<glm::mat4> matrices;
+			/** @brief Joint range of a skinned mesh with a version that is incremented on every change */
+			struct Range {
+				uint32_t offset;
+				uint32_t count;
+				uint64_t version;
+			};
+			std::vector<Range> ranges;
+			/** @brief Version of each range last written to a slice (indexed by slice * ranges.size() + range) */
+			std::vector<uint64_t> sliceVersions;
+			/** @brief Upload statistics of the last call to uploadJointPalette */
+			struct Statistics {
+				uint32_t rangesWritten = 0;
+				/** @brief Number of merged writes, each with a single flush */
+				uint32_t writes = 0;
+				VkDeviceSize bytesWritten = 0;
+			} statistics;
+		} jointPalette;
+		/** @brief Number of frames in flight the joint palette is buffered for, has to be set before loading the model */
+		uint32_t framesInFlight = 1;
+
+		/** @brief Instruction set used for evaluating animations, lowered to the one supported by the CPU */
+		vks::simd::Path animationSimdPath = vks::simd::supportedPath();
+		/** @brief Interpolate rotations of linear samplers with a normalized lerp instead of the slerp approximation (cheaper, but not constant velocity for large keyframe angles) */
+		bool animationNlerp = false;
+
+		/**
+		* Skin the vertices of skinned meshes on the host instead of in the vertex shader, has to be set before loading the model
+		*
+		* The vertex buffer is then placed in persistently mapped host visible memory and holds framesInFlight + 1 copies of all vertices (double buffered by default)
+		* Every transform update that changes joints skins the affected primitives into the next copy on multiple threads, draw binds the copy written last
+		* The joint count written to the mesh uniform buffers is zero, so shaders that skin for jointCount > 0 don't apply the joints a second time
+		*
+		* @note Command buffers recorded with draw need to be recorded again after a transform update to pick up the new copy
+		*/
+		bool cpuSkinning = false;
+		/** @brief Number of threads used for host skinning, 0 uses all hardware threads and 1 skins on the calling thread only */
+		uint32_t cpuSkinningThreadCount = 0;
+		/** @brief Instruction set used for host skinning, lowered to the one supported by the CPU */
+		vks::simd::Path cpuSkinningSimdPath = vks::simd::supportedPath();
+		/**
+		* Layout of the device vertex buffer, has to be set before loading the model
+		*
+		* The default (empty) format stores the full Vertex, a compact format only stores the components the shaders need in smaller encodings (see VertexFormat::compact)
+		* Pipelines should take their vertex input state from this format, it falls back to the full Vertex if the model is skinned on the host (see cpuSkinning)
+		*/
+		VertexFormat vertexFormat;
+		/** @brief Size of the device vertex buffer compared to the full Vertex */
+		struct VertexMemory {
+			uint32_t vertexCount = 0;
+			uint32_t fullStride = sizeof(Vertex);
+			uint32_t stride = sizeof(Vertex);
+			/** @brief Time for encoding the vertices in milliseconds */
+			double packTime = 0.0;
+			VkDeviceSize fullSize() const { return static_cast<VkDeviceSize>(vertexCount) * fullStride; }
+			VkDeviceSize size() const { return static_cast<VkDeviceSize>(vertexCount) * stride; }
+		} vertexMemory;
+		/**
+		* Build a flattened list of all primitives with per draw data and bindless materials while loading, so the whole model can be drawn with drawIndirect
+		*
+		* Has to be set before loading the model
+		*/
+		bool indirectDraw = false;
+		/**
+		* Flattened draw list for drawIndirect, one draw per primitive in hierarchy order
+		*
+		* The draw's index is passed as the first instance, shaders bind indirect.descriptorSetLayout and look up their data with gl_InstanceIndex:
+		*   layout (set = n, binding = 0) readonly buffer Draws { DrawData draws[]; };
+		*   layout (set = n, binding = 1) readonly buffer Matrices { mat4 matrices[]; };
+		*   layout (set = n, binding = 2) readonly buffer Materials { MaterialData materials[]; };
+		*   layout (set = n, binding = 3) uniform sampler2D textures[TEXTURE_COUNT]; (only if the model contains textures)
+		*   layout (set = n, binding = 4) readonly buffer JointMatrices { mat4 jointMatrices[]; }; (only if the model contains skins, see jointPaletteDynamicOffset)
+		* Material and texture indices are the same for all invocations of a draw, so the arrays only need dynamic indexing and no descriptor indexing features
+		*/
+		struct IndirectDraw {
+			/** @brief Per draw data (std430) */
+			struct DrawData {
+				uint32_t matrixIndex;
+				uint32_t materialIndex;
+				uint32_t jointOffset;
+				uint32_t jointCount;
+				/** @brief Dequantization of the mesh's positions (see Mesh::UniformBlock) */
+				glm::vec4 positionScale;
+				glm::vec4 positionOffset;
+			};
+			/** @brief Per material data (std430), texture indices are -1 for materials without the texture */
+			struct MaterialData {
+				glm::vec4 baseColorFactor;
+				int32_t baseColorTexture;
+				int32_t normalTexture;
+				int32_t metallicRoughnessTexture;
+				float alphaCutoff;
+			};
+			/** @brief Host copy of the indirect commands, the instance count can be set to zero to hide a draw (see updateIndirectCommands) */
+			std::vector<VkDrawIndexedIndirectCommand> commands;
+			std::vector<DrawData> draws;
+			vks::Buffer commandsBuffer;
+			vks::Buffer countBuffer;
+			vks::Buffer drawsBuffer;
+			vks::Buffer matricesBuffer;
+			vks::Buffer materialsBuffer;
+			VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+			VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE;
+			VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+			/** @brief Only set if VK_KHR_draw_indirect_count has been enabled for the device */
+			PFN_vkCmdDrawIndexedIndirectCountKHR vkCmdDrawIndexedIndirectCountKHR = nullptr;
+		} indirect;
+
+		/** @brief State of the host skinning, only set up if cpuSkinning is enabled and the model contains skinned meshes */
+		struct CpuSkinningState {
+			/** @brief Unskinned vertices of the whole model */
+			std::vector<Vertex> sourceVertices;
+			/** @brief All primitives of skinned meshes */
+			std::vector<VertexSkinning::Range> ranges;
+			/** @brief Number of vertex buffer copies and the size of one copy */
+			uint32_t copyCount = 0;
+			VkDeviceSize copySize = 0;
+			/** @brief Copy bound by draw, i.e. the one written by the last skinning update */
+			uint32_t currentCopy = 0;
+			/** @brief Joint palette range version each copy has been skinned with (indexed by copy * jointPalette.ranges.size() + range) */
+			std::vector<uint64_t> copyVersions;
+			/** @brief Primitives out of date in the copy being written and the index of their first vertex in the flattened work list, kept to avoid allocations per update */
+			std::vector<const VertexSkinning::Range*> pending;
+			std::vector<size_t> pendingStart;
+			std::unique_ptr<vks::JobSystem> jobSystem;
+			/** @brief Statistics of the last skinning update */
+			struct Statistics {
+				uint32_t primitives = 0;
+				uint32_t vertices = 0;
+				double time = 0.0;
+			} statistics;
+		} cpuSkinningState;
+
+		std::vector<Skin*> skins;
+
+		std::vector<Texture> textures;
+		std::vector<Material> materials;
+		std::vector<Animation> animations;
+
+		struct Dimensions {
+			glm::vec3 min = glm::vec3(FLT_MAX);
+			glm::vec3 max = glm::vec3(-FLT_MAX);
+			glm::vec3 size;
+			glm::vec3 center;
+			float radius;
+		} dimensions;
+
+		/**
+		* Bounding volume hierarchy over all nodes with a mesh, built after loading and refitted whenever meshes move (see cull)
+		*
+		* Inner nodes have count == 0 and their two children at first and first + 1, leaves reference count mesh nodes starting at items[first]
+		* Children are always stored after their parent, so a reverse pass over the nodes refits the hierarchy bottom up
+		*/
+		struct BoundingVolumeHierarchy {
+			struct BVHNode {
+				BoundingBox bounds;
+				uint32_t first = 0;
+				uint32_t count = 0;
+			};
+			std::vector<BVHNode> nodes;
+			std::vector<Node*> items;
+			/** @brief Maximum number of mesh nodes per leaf */
+			uint32_t leafSize = 4;
+			/** @brief Number of primitives referenced by the hierarchy */
+			uint32_t primitiveCount = 0;
+			/** @brief Primitives marked visible by the last cull (all primitives before the first one), so only those have to be reset */
+			std::vector<Primitive*> visiblePrimitives;
+			/** @brief Traversal stack of cull, kept to avoid allocations per cull */
+			std::vector<std::pair<uint32_t, uint32_t>> stack;
+		} bvh;
+
+		/** @brief Results of the last cull */
+		struct CullingStatistics {
+			/** @brief Number of bounding boxes tested against the frustum */
+			uint32_t tested = 0;
+			/** @brief Number of primitives inside or intersecting the frustum */
+			uint32_t visible = 0;
+			/** @brief Number of primitives outside of the frustum */
+			uint32_t culled = 0;
+			/** @brief CPU time of the cull in milliseconds */
+			double time = 0.0;
+		} cullingStatistics;
+
+		/** @brief Flags the model has been loaded with (see FileLoadingFlags), bounds account for flipped and pre-transformed vertices */
+		uint32_t fileLoadingFlags = FileLoadingFlags::None;
+
+		bool metallicRoughnessWorkflow = true;
+
+		/** @brief Number of threads used for decoding images and extracting geometry, 0 uses all hardware threads and 1 loads on the calling thread only */
+		uint32_t loadingThreadCount = 0;
+
+		/** @brief Store the processed model in a binary cache file (.vkmesh) in vks::meshcache::cacheDirectory() and load from it if the source and loading parameters are unchanged */
+		bool enableMeshCache = true;
+
+		/** @brief Reorder the triangles and vertices of every primitive for the vertex cache, overdraw and vertex fetch at load time (see vks::meshoptimizer) */
+		bool optimizeMeshes = false;
+		/** @brief Vertex cache statistics of all primitives before and after the optimization (only if optimizeMeshes is set, stored in the mesh cache) */
+		vks::meshoptimizer::Statistics meshOptimization;
+
+		/** @brief Time spent in the different phases of loadFromFile in milliseconds */
+		struct LoadingTimes {
+			double parse = 0.0;
+			double imageDecode = 0.0;
+			double textures = 0.0;
+			double nodes = 0.0;
+			double geometry = 0.0;
+			double optimize = 0.0;
+			double animations = 0.0;
+			double preTransform = 0.0;
+			double upload = 0.0;
+			double cacheWrite = 0.0;
+			double total = 0.0;
+			/** @brief True if the model has been loaded from the mesh cache */
+			bool meshCache = false;
+		} loadingTimes;
+
+		Model() {};
+
+		~Model() 
+		{
+			vertices.destroy();
+			indices.destroy();
+			jointPalette.buffer.destroy();
+			indirect.commandsBuffer.destroy();
+			indirect.countBuffer.destroy();
+			indirect.drawsBuffer.destroy();
+			indirect.matricesBuffer.destroy();
+			indirect.materialsBuffer.destroy();
+			if (indirect.descriptorPool != VK_NULL_HANDLE) {
+				vkDestroyDescriptorSetLayout(device->logicalDevice, indirect.descriptorSetLayout, nullptr);
+				vkDestroyDescriptorPool(device->logicalDevice, indirect.descriptorPool, nullptr);
+			}
+			for (auto texture : textures) {
+				texture.destroy();
+			}
+			for (auto node : nodes) {
+				delete node;
+			}
+			if (device) {
+				vkDestroyDescriptorSetLayout(device->logicalDevice, descriptorSetLayout, nullptr);
+				vkDestroyDescriptorPool(device->logicalDevice, descriptorPool, nullptr);
+			}
+		}
+
+		void loadNode(vkglTF::Node *parent, const tinygltf::Node &node, uint32_t nodeIndex, const tinygltf::Model &model, std::vector<PrimitiveLoadInfo>& primitiveLoads, uint32_t& vertexCount, uint32_t& indexCount, float globalscale)
+		{
+			vkglTF::Node *newNode = new Node{};
+			newNode->index = nodeIndex;
+			newNode->parent = parent;
+			newNode->name = node.name;
+			newNode->skinIndex = node.skin;
+			newNode->matrix = glm::mat4(1.0f);
+
+			// Generate local node matrix
+			glm::vec3 translation = glm::vec3(0.0f);
+			if (node.translation.size() == 3) {
+				translation = glm::make_vec3(node.translation.data());
+				newNode->translation = translation;
+			}
+			glm::mat4 rotation = glm::mat4(1.0f);
+			if (node.rotation.size() == 4) {
+				glm::quat q = glm::make_quat(node.rotation.data());
+				newNode->rotation = glm::mat4(q);
+			}
+			glm::vec3 scale = glm::vec3(1.0f);
+			if (node.scale.size() == 3) {
+				scale = glm::make_vec3(node.scale.data());
+				newNode->scale = scale;
+			}
+			if (node.matrix.size() == 16) {
+				newNode->matrix = glm::make_mat4x4(node.matrix.data());
+				if (globalscale != 1.0f) {
+					//newNode->matrix = glm::scale(newNode->matrix, glm::vec3(globalscale));
+				}
+			};
+
+			// Node with children
+			if (node.children.size() > 0) {
+				for (auto i = 0; i < node.children.size(); i++) {
+					loadNode(newNode, model.nodes[node.children[i]], node.children[i], model, primitiveLoads, vertexCount, indexCount, globalscale);
+				}
+			}
+
+			// Node contains mesh data
+			if (node.mesh > -1) {
+				const tinygltf::Mesh &mesh = model.meshes[node.mesh];
+				Mesh *newMesh = new Mesh(device, newNode->matrix);
+				newMesh->name = mesh.name;
+				for (size_t j = 0; j < mesh.primitives.size(); j++) {
+					const tinygltf::Primitive &primitive = mesh.primitives[j];
+					if (primitive.indices < 0) {
+						continue;
+					}
+					// Position attribute is required
+					assert(primitive.attributes.find("POSITION") != primitive.attributes.end());
+
+					const tinygltf::Accessor &posAccessor = model.accessors[primitive.attributes.find("POSITION")->second];
+					const tinygltf::Accessor &indexAccessor = model.accessors[primitive.indices];
+					if ((indexAccessor.componentType != TINYGLTF_PARAMETER_TYPE_UNSIGNED_INT) && (indexAccessor.componentType != TINYGLTF_PARAMETER_TYPE_UNSIGNED_SHORT) && (indexAccessor.componentType != TINYGLTF_PARAMETER_TYPE_UNSIGNED_BYTE)) {
+						std::cerr << "Index component type " << indexAccessor.componentType << " not supported!" << std::endl;
+						continue;
 					}
-					Primitive *newPrimitive = new Primitive(indexStart, indexCount, materials[primitive.material]);
-					newPrimitive->firstVertex = vertexStart;
-					newPrimitive->vertexCount = vertexCount;
-					newPrimitive->setDimensions(posMin, posMax);
+
+					// Only reserve the primitive's ranges in the vertex and index buffers here, the data is extracted in parallel once all nodes have been loaded
+					Primitive *newPrimitive = new Primitive(indexCount, static_cast<uint32_t>(indexAccessor.count), materials[primitive.material]);
+					newPrimitive->firstVertex = vertexCount;
+					newPrimitive->vertexCount = static_cast<uint32_t>(posAccessor.count);
+					newPrimitive->setDimensions(glm::vec3(posAccessor.minValues[0], posAccessor.minValues[1], posAccessor.minValues[2]), glm::vec3(posAccessor.maxValues[0], posAccessor.maxValues[1], posAccessor.maxValues[2]));
 					newMesh->primitives.push_back(newPrimitive);
+					vertexCount += newPrimitive->vertexCount;
+					indexCount += newPrimitive->indexCount;
+
+					PrimitiveLoadInfo loadInfo;
+					loadInfo.source = &primitive;
+					loadInfo.primitive = newPrimitive;
+					primitiveLoads.push_back(loadInfo);
 				}
 				newNode->mesh = newMesh;
 			}
@@ -799,6 +1814,205 @@ namespace vkglTF
 			linearNodes.push_back(newNode);
 		}
 
+		/**
+		* Extract the vertices and indices of a primitive into the ranges reserved for it by loadNode
+		*
+		* @param model glTF model the primitive is part of
+		* @param loadInfo Source and destination of the primitive's data
+		* @param vertexBuffer Start of the model's vertex data
+		* @param indexBuffer Start of the model's index data
+		*
+		* @note Only writes to the primitive's own ranges, so primitives can be extracted concurrently
+		*/
+		static void loadPrimitiveData(const tinygltf::Model &model, const PrimitiveLoadInfo &loadInfo, Vertex *vertexBuffer, uint32_t *indexBuffer)
+		{
+			const tinygltf::Primitive &primitive = *loadInfo.source;
+			// Vertices
+			{
+				const float *bufferPos = nullptr;
+				const float *bufferNormals = nullptr;
+				const float *bufferTexCoords = nullptr;
+				const float* bufferColors = nullptr;
+				uint32_t numColorComponents;
+				const uint16_t *bufferJoints = nullptr;
+				const float *bufferWeights = nullptr;
+
+				const tinygltf::Accessor &posAccessor = model.accessors[primitive.attributes.find("POSITION")->second];
+				const tinygltf::BufferView &posView = model.bufferViews[posAccessor.bufferView];
+				bufferPos = reinterpret_cast<const float *>(&(model.buffers[posView.buffer].data[posAccessor.byteOffset + posView.byteOffset]));
+
+				if (primitive.attributes.find("NORMAL") != primitive.attributes.end()) {
+					const tinygltf::Accessor &normAccessor = model.accessors[primitive.attributes.find("NORMAL")->second];
+					const tinygltf::BufferView &normView = model.bufferViews[normAccessor.bufferView];
+					bufferNormals = reinterpret_cast<const float *>(&(model.buffers[normView.buffer].data[normAccessor.byteOffset + normView.byteOffset]));
+				}
+
+				if (primitive.attributes.find("TEXCOORD_0") != primitive.attributes.end()) {
+					const tinygltf::Accessor &uvAccessor = model.accessors[primitive.attributes.find("TEXCOORD_0")->second];
+					const tinygltf::BufferView &uvView = model.bufferViews[uvAccessor.bufferView];
+					bufferTexCoords = reinterpret_cast<const float *>(&(model.buffers[uvView.buffer].data[uvAccessor.byteOffset + uvView.byteOffset]));
+				}
+				if (primitive.attributes.find("COLOR_0") != primitive.attributes.end()) {
+					const tinygltf::Accessor& colorAccessor = model.accessors[primitive.attributes.find("COLOR_0")->second];
+					const tinygltf::BufferView& colorView = model.bufferViews[colorAccessor.bufferView];
+					// Color buffer are either of type vec3 or vec4
+					numColorComponents = colorAccessor.type == TINYGLTF_PARAMETER_TYPE_FLOAT_VEC3 ? 3 : 4;
+					bufferColors = reinterpret_cast<const float*>(&(model.buffers[colorView.buffer].data[colorAccessor.byteOffset + colorView.byteOffset]));
+				}
+
+				// Skinning
+				// Joints
+				if (primitive.attributes.find("JOINTS_0") != primitive.attributes.end()) {
+					const tinygltf::Accessor &jointAccessor = model.accessors[primitive.attributes.find("JOINTS_0")->second];
+					const tinygltf::BufferView &jointView = model.bufferViews[jointAccessor.bufferView];
+					bufferJoints = reinterpret_cast<const uint16_t *>(&(model.buffers[jointView.buffer].data[jointAccessor.byteOffset + jointView.byteOffset]));
+				}
+
+				if (primitive.attributes.find("WEIGHTS_0") != primitive.attributes.end()) {
+					const tinygltf::Accessor &uvAccessor = model.accessors[primitive.attributes.find("WEIGHTS_0")->second];
+					const tinygltf::BufferView &uvView = model.bufferViews[uvAccessor.bufferView];
+					bufferWeights = reinterpret_cast<const float *>(&(model.buffers[uvView.buffer].data[uvAccessor.byteOffset + uvView.byteOffset]));
+				}
+
+				const bool hasSkin = (bufferJoints && bufferWeights);
+
+				Vertex *vertices = vertexBuffer + loadInfo.primitive->firstVertex;
+				for (size_t v = 0; v < posAccessor.count; v++) {
+					Vertex &vert = vertices[v];
+					vert.pos = glm::vec4(glm::make_vec3(&bufferPos[v * 3]), 1.0f);
+					vert.normal = glm::normalize(glm::vec3(bufferNormals ? glm::make_vec3(&bufferNormals[v * 3]) : glm::vec3(0.0f)));
+					vert.uv = bufferTexCoords ? glm::make_vec2(&bufferTexCoords[v * 2]) : glm::vec3(0.0f);
+					if (bufferColors) {
+						switch (numColorComponents) {
+							case 3:
+								vert.color = glm::vec4(glm::make_vec3(&bufferColors[v * 3]), 1.0f);
+								break;
+							case 4:
+								vert.color = glm::make_vec4(&bufferColors[v * 4]);
+								break;
+						}
+					}
+					else {
+						vert.color = glm::vec4(1.0f);
+					}
+					vert.joint0 = hasSkin ? glm::vec4(glm::make_vec4(&bufferJoints[v * 4])) : glm::vec4(0.0f);
+					vert.weight0 = hasSkin ? glm::make_vec4(&bufferWeights[v * 4]) : glm::vec4(0.0f);
+				}
+			}
+			// Indices
+			{
+				const tinygltf::Accessor &accessor = model.accessors[primitive.indices];
+				const tinygltf::BufferView &bufferView = model.bufferViews[accessor.bufferView];
+				const tinygltf::Buffer &buffer = model.buffers[bufferView.buffer];
+				const void *data = &buffer.data[accessor.byteOffset + bufferView.byteOffset];
+				const uint32_t vertexStart = loadInfo.primitive->firstVertex;
+				uint32_t *indices = indexBuffer + loadInfo.primitive->firstIndex;
+
+				switch (accessor.componentType) {
+				case TINYGLTF_PARAMETER_TYPE_UNSIGNED_INT: {
+					const uint32_t *buf = static_cast<const uint32_t*>(data);
+					for (size_t index = 0; index < accessor.count; index++) {
+						indices[index] = buf[index] + vertexStart;
+					}
+					break;
+				}
+				case TINYGLTF_PARAMETER_TYPE_UNSIGNED_SHORT: {
+					const uint16_t *buf = static_cast<const uint16_t*>(data);
+					for (size_t index = 0; index < accessor.count; index++) {
+						indices[index] = buf[index] + vertexStart;
+					}
+					break;
+				}
+				case TINYGLTF_PARAMETER_TYPE_UNSIGNED_BYTE: {
+					const uint8_t *buf = static_cast<const uint8_t*>(data);
+					for (size_t index = 0; index < accessor.count; index++) {
+						indices[index] = buf[index] + vertexStart;
+					}
+					break;
+				}
+				}
+			}
+		}
+
+		/**
+		* Reorder a primitive's triangles and vertices for the post-transform vertex cache, overdraw and vertex fetch
+		*
+		* @param loadInfo Source and destination of the primitive's data
+		* @param vertexBuffer Start of the model's vertex data
+		* @param indexBuffer Start of the model's index data
+		*
+		* @note Only touches the primitive's own ranges, so primitives can be optimized concurrently
+		*/
+		static vks::meshoptimizer::Statistics optimizePrimitive(const PrimitiveLoadInfo &loadInfo, Vertex *vertexBuffer, uint32_t *indexBuffer)
+		{
+			const Primitive &primitive = *loadInfo.primitive;
+			// Only triangle lists can be reordered
+			if ((loadInfo.source->mode != TINYGLTF_MODE_TRIANGLES) || (primitive.indexCount < 3)) {
+				return vks::meshoptimizer::Statistics();
+			}
+			// Indices are stored relative to the start of the model's vertex buffer, the optimizer works on the primitive's local range
+			uint32_t *indices = indexBuffer + primitive.firstIndex;
+			for (uint32_t i = 0; i < primitive.indexCount; i++) {
+				indices[i] -= primitive.firstVertex;
+			}
+			const vks::meshoptimizer::Statistics stats = vks::meshoptimizer::optimizeMesh(indices, primitive.indexCount, vertexBuffer + primitive.firstVertex, sizeof(Vertex), primitive.vertexCount, offsetof(Vertex, pos));
+			for (uint32_t i = 0; i < primitive.indexCount; i++) {
+				indices[i] += primitive.firstVertex;
+			}
+			return stats;
+		}
+
+		/**
+		* Encode the vertices in the model's vertex format and set the position dequantization of all meshes
+		*
+		* @param vertexData Full vertices of the whole model
+		* @param vertexCount Number of vertices
+		* @param packedVertices Receives the encoded vertices
+		* @param jobSystem Meshes are encoded concurrently
+		*/
+		void packVertices(const Vertex *vertexData, size_t vertexCount, std::vector<uint8_t> &packedVertices, vks::JobSystem &jobSystem)
+		{
+			assert(vertexFormat.valid());
+			const uint32_t stride = vertexFormat.stride();
+			packedVertices.assign(vertexCount * stride, 0);
+			std::vector<Mesh*> meshes;
+			for (Node *node : linearNodes) {
+				if (node->mesh) {
+					meshes.push_back(node->mesh);
+				}
+			}
+			const bool quantizedPositions = vertexFormat.quantizedPositions();
+			jobSystem.parallelFor(meshes.size(), [&](size_t i) {
+				Mesh *mesh = meshes[i];
+				glm::vec3 positionScale(1.0f);
+				glm::vec3 positionOffset(0.0f);
+				if (quantizedPositions) {
+					// Positions are mapped to the bounds of all primitives of the mesh
+					glm::vec3 minPos(FLT_MAX);
+					glm::vec3 maxPos(-FLT_MAX);
+					for (const Primitive *primitive : mesh->primitives) {
+						for (uint32_t v = 0; v < primitive->vertexCount; v++) {
+							minPos = glm::min(minPos, vertexData[primitive->firstVertex + v].pos);
+							maxPos = glm::max(maxPos, vertexData[primitive->firstVertex + v].pos);
+						}
+					}
+					if (minPos.x <= maxPos.x) {
+						positionOffset = minPos;
+						positionScale = glm::max(maxPos - minPos, glm::vec3(FLT_MIN));
+					}
+				}
+				mesh->uniformBlock.positionScale = glm::vec4(positionScale, 0.0f);
+				mesh->uniformBlock.positionOffset = glm::vec4(positionOffset, 0.0f);
+				memcpy(mesh->uniformBuffer.mapped, &mesh->uniformBlock, sizeof(mesh->uniformBlock));
+				for (const Primitive *primitive : mesh->primitives) {
+					for (uint32_t v = 0; v < primitive->vertexCount; v++) {
+						const uint32_t index = primitive->firstVertex + v;
+						vertexFormat.pack(vertexData[index], &packedVertices[static_cast<size_t>(index) * stride], positionScale, positionOffset);
+					}
+				}
+			});
+		}
+
 		void loadSkins(tinygltf::Model &gltfModel)
 		{
 			for (tinygltf::Skin &source : gltfModel.skins) {
@@ -998,161 +2212,708 @@ namespace vkglTF
 			}
 		}
 
-		void loadFromFile(std::string filename, vks::VulkanDevice *device, VkQueue transferQueue, uint32_t fileLoadingFlags = vkglTF::FileLoadingFlags::None, float scale = 1.0f)
+		/** @brief Decode all images of a model stored by the deferred image loader on all threads of the job system */
+		static void decodeImages(tinygltf::Model &gltfModel, vks::JobSystem &jobSystem)
 		{
-			tinygltf::Model gltfModel;
-			tinygltf::TinyGLTF gltfContext;
-			std::string error, warning;
+			// Images are handed out one at a time as their sizes differ a lot
+			jobSystem.parallelFor(gltfModel.images.size(), [&](size_t i) {
+				tinygltf::Image &image = gltfModel.images[i];
+				if (!decodeImage(image)) {
+					// Replace with a single white texel so materials referencing the image stay valid
+					std::cerr << "Could not decode image " << i << " \"" << image.name << image.uri << "\"" << std::endl;
+					image.width = image.height = 1;
+					image.component = 4;
+					image.image.assign(4, 0xff);
+					image.as_is = false;
+				}
+			}, 1);
+		}
 
-			this->device = device;
+		/*
+			Mesh cache
+			The cache stores the encoded images, the final vertex and index buffers and everything required to rebuild the nodes, materials, skins and animations
+		*/
 
-#if defined(__ANDROID__)
-			AAsset* asset = AAssetManager_open(androidApp->activity->assetManager, filename.c_str(), AASSET_MODE_STREAMING);
-			assert(asset);
-			size_t size = AAsset_getLength(asset);
-			assert(size > 0);
-			char* fileData = new char[size];
-			AAsset_read(asset, fileData, size);
-			AAsset_close(asset);
-			std::string baseDir;
-			bool fileLoaded = gltfContext.LoadASCIIFromString(&gltfModel, &error, &warning, fileData, size, baseDir);
-			free(fileData);
-#else
-			bool fileLoaded = gltfContext.LoadASCIIFromFile(&gltfModel, &error, &warning, filename);
-#endif
-			std::vector<uint32_t> indexBuffer;
-			std::vector<Vertex> vertexBuffer;
+		enum MeshCacheSection : uint32_t {
+			MESH_CACHE_SECTION_IMAGES = 1,
+			MESH_CACHE_SECTION_SCENE = 2,
+			MESH_CACHE_SECTION_VERTICES = 3,
+			MESH_CACHE_SECTION_INDICES = 4,
+			MESH_CACHE_SECTION_OPTIMIZATION = 5
+		};
+
+		/** @brief Hash of all parameters that change the data stored in the mesh cache */
+		static uint64_t meshCacheParameterHash(uint32_t fileLoadingFlags, float scale, bool optimizeMeshes)
+		{
+			const uint32_t layout[] = {
+				fileLoadingFlags,
+				static_cast<uint32_t>(sizeof(Vertex)),
+				static_cast<uint32_t>(offsetof(Vertex, pos)),
+				static_cast<uint32_t>(offsetof(Vertex, normal)),
+				static_cast<uint32_t>(offsetof(Vertex, uv)),
+				static_cast<uint32_t>(offsetof(Vertex, color)),
+				static_cast<uint32_t>(offsetof(Vertex, joint0)),
+				static_cast<uint32_t>(offsetof(Vertex, weight0)),
+				static_cast<uint32_t>(sizeof(glm::mat4))
+			};
+			uint64_t hash = vks::meshcache::hash(&scale, sizeof(scale), vks::meshcache::hash(layout, sizeof(layout)));
+			// Only mixed in if set, so caches of unoptimized models stay valid
+			if (optimizeMeshes) {
+				const uint32_t optimization = vks::meshoptimizer::DEFAULT_CACHE_SIZE;
+				hash = vks::meshcache::hash(&optimization, sizeof(optimization), hash);
+			}
+			return hash;
+		}
+
+		int32_t textureIndex(const Texture *texture) const
+		{
+			return texture ? static_cast<int32_t>(texture - textures.data()) : -1;
+		}
+
+		int32_t nodeSlot(const Node *node, const std::vector<int32_t> &slots) const
+		{
+			return node ? slots[node->index] : -1;
+		}
 
-			if (fileLoaded) {
-				loadImages(gltfModel, device, transferQueue);
-				loadMaterials(gltfModel);
-				const tinygltf::Scene &scene = gltfModel.scenes[gltfModel.defaultScene > -1 ? gltfModel.defaultScene : 0];
-				for (size_t i = 0; i < scene.nodes.size(); i++) {
-					const tinygltf::Node node = gltfModel.nodes[scene.nodes[i]];
-					loadNode(nullptr, node, scene.nodes[i], gltfModel, indexBuffer, vertexBuffer, scale);
+		/**
+		* Write the loaded model to the mesh cache
+		*
+		* @param filename Source file of the model
+		* @param gltfModel glTF model the data has been loaded from, used to find the files the model depends on
+		* @param images Section containing the encoded images, written before the images were decoded
+		* @param vertexBuffer Final vertex data
+		* @param indexBuffer Final index data
+		* @param parameterHash Hash of the loading parameters
+		*/
+		void writeMeshCache(const std::string &filename, const tinygltf::Model &gltfModel, vks::meshcache::Writer &images, const std::vector<Vertex> &vertexBuffer, const std::vector<uint32_t> &indexBuffer, uint64_t parameterHash)
+		{
+			const std::string directory = vks::meshcache::getDirectory(filename);
+			vks::meshcache::CacheWriter cacheWriter;
+			cacheWriter.addDependency(directory, filename.substr(directory.size()));
+			for (const tinygltf::Buffer &buffer : gltfModel.buffers) {
+				if (!buffer.uri.empty() && (buffer.uri.compare(0, 5, "data:") != 0)) {
+					cacheWriter.addDependency(directory, buffer.uri);
 				}
-				if (gltfModel.animations.size() > 0) {
-					loadAnimations(gltfModel);
+			}
+			for (const tinygltf::Image &image : gltfModel.images) {
+				if (!image.uri.empty() && (image.uri.compare(0, 5, "data:") != 0)) {
+					cacheWriter.addDependency(directory, image.uri);
 				}
-				loadSkins(gltfModel);
+			}
 
-				for (auto node : linearNodes) {
-					// Assign skins
-					if (node->skinIndex > -1) {
-						node->skin = skins[node->skinIndex];
+			// Nodes are stored in the order of linearNodes, so parents and skins reference them by their position in that list
+			std::vector<int32_t> slots(gltfModel.nodes.size(), -1);
+			for (size_t i = 0; i < linearNodes.size(); i++) {
+				slots[linearNodes[i]->index] = static_cast<int32_t>(i);
+			}
+
+			vks::meshcache::Writer scene;
+			scene.write(static_cast<uint32_t>(metallicRoughnessWorkflow));
+			scene.write(static_cast<uint32_t>(materials.size()));
+			for (const Material &material : materials) {
+				scene.write(static_cast<uint32_t>(material.alphaMode));
+				scene.write(material.alphaCutoff);
+				scene.write(material.metallicFactor);
+				scene.write(material.roughnessFactor);
+				scene.write(material.baseColorFactor);
+				const Texture *materialTextures[] = { material.baseColorTexture, material.metallicRoughnessTexture, material.normalTexture, material.occlusionTexture, material.emissiveTexture, material.specularGlossinessTexture, material.diffuseTexture };
+				for (const Texture *texture : materialTextures) {
+					scene.write(textureIndex(texture));
+				}
+			}
+			scene.write(static_cast<uint32_t>(linearNodes.size()));
+			for (const Node *node : linearNodes) {
+				scene.write(nodeSlot(node->parent, slots));
+				scene.write(node->index);
+				scene.writeString(node->name);
+				scene.write(node->skinIndex);
+				scene.write(node->matrix);
+				scene.write(node->translation);
+				scene.write(node->scale);
+				scene.write(node->rotation);
+				scene.write(static_cast<uint32_t>(node->mesh ? 1 : 0));
+				if (node->mesh) {
+					scene.writeString(node->mesh->name);
+					scene.write(static_cast<uint32_t>(node->mesh->primitives.size()));
+					for (const Primitive *primitive : node->mesh->primitives) {
+						scene.write(primitive->firstIndex);
+						scene.write(primitive->indexCount);
+						scene.write(primitive->firstVertex);
+						scene.write(primitive->vertexCount);
+						scene.write(static_cast<int32_t>(&primitive->material - materials.data()));
+						scene.write(primitive->dimensions.min);
+						scene.write(primitive->dimensions.max);
 					}
-					// Initial pose
-					if (node->mesh) {
-						node->update();
+				}
+			}
+			scene.write(static_cast<uint32_t>(skins.size()));
+			for (const Skin *skin : skins) {
+				scene.writeString(skin->name);
+				scene.write(nodeSlot(skin->skeletonRoot, slots));
+				std::vector<int32_t> joints;
+				for (const Node *joint : skin->joints) {
+					joints.push_back(nodeSlot(joint, slots));
+				}
+				scene.writeVector(joints);
+				scene.writeVector(skin->inverseBindMatrices);
+			}
+			scene.write(static_cast<uint32_t>(animations.size()));
+			for (const Animation &animation : animations) {
+				scene.writeString(animation.name);
+				scene.write(animation.start);
+				scene.write(animation.end);
+				scene.write(static_cast<uint32_t>(animation.samplers.size()));
+				for (const AnimationSampler &sampler : animation.samplers) {
+					scene.write(static_cast<uint32_t>(sampler.interpolation));
+					scene.writeVector(sampler.inputs);
+					scene.writeVector(sampler.outputsVec4);
+				}
+				scene.write(static_cast<uint32_t>(animation.channels.size()));
+				for (const AnimationChannel &channel : animation.channels) {
+					scene.write(static_cast<uint32_t>(channel.path));
+					scene.write(nodeSlot(channel.node, slots));
+					scene.write(channel.samplerIndex);
+				}
+			}
+
+			vks::meshcache::Writer vertexSection, indexSection;
+			vertexSection.writeVector(vertexBuffer);
+			indexSection.writeVector(indexBuffer);
+
+			cacheWriter.addSection(MESH_CACHE_SECTION_IMAGES, images);
+			cacheWriter.addSection(MESH_CACHE_SECTION_SCENE, scene);
+			cacheWriter.addSection(MESH_CACHE_SECTION_VERTICES, vertexSection);
+			cacheWriter.addSection(MESH_CACHE_SECTION_INDICES, indexSection);
+			if (optimizeMeshes) {
+				vks::meshcache::Writer optimizationSection;
+				optimizationSection.write(meshOptimization);
+				cacheWriter.addSection(MESH_CACHE_SECTION_OPTIMIZATION, optimizationSection);
+			}
+			if (!cacheWriter.save(vks::meshcache::getFileName(filename), vks::meshcache::CONTENT_GLTF, parameterHash)) {
+				std::cerr << "Could not write mesh cache for \"" << filename << "\"" << std::endl;
+			}
+		}
+
+		/** @brief Release everything created by a partial load from the mesh cache */
+		void clearScene()
+		{
+			// Image uploads queued by loadImages may still reference the textures, so they have to finish before the textures are destroyed
+			device->uploadManager.waitIdle();
+			for (auto texture : textures) {
+				texture.destroy();
+			}
+			for (auto node : nodes) {
+				delete node;
+			}
+			for (auto skin : skins) {
+				delete skin;
+			}
+			textures.clear();
+			materials.clear();
+			nodes.clear();
+			linearNodes.clear();
+			sortedNodes.clear();
+			skins.clear();
+			animations.clear();
+		}
+
+		/**
+		* Rebuild the model from a validated mesh cache
+		*
+		* @param cache Mesh cache that has been opened and validated against the source
+		* @param vertexData Pointer to the vertex data in the mapped cache file
+		* @param vertexCount Number of vertices
+		* @param indexData Pointer to the index data in the mapped cache file
+		* @param indexCount Number of indices
+		*
+		* @return False if the cache is inconsistent, the model is left empty in that case
+		*/
+		bool loadMeshCache(const vks::meshcache::CacheReader &cache, vks::JobSystem &jobSystem, VkQueue transferQueue, const Vertex **vertexData, size_t *vertexCount, const uint32_t **indexData, size_t *indexCount)
+		{
+			typedef std::chrono::high_resolution_clock Clock;
+			Clock::time_point phaseStart = Clock::now();
+			auto elapsed = [&phaseStart]() {
+				const Clock::time_point now = Clock::now();
+				const double ms = std::chrono::duration<double, std::milli>(now - phaseStart).count();
+				phaseStart = now;
+				return ms;
+			};
+
+			vks::meshcache::Reader vertexSection = cache.section(MESH_CACHE_SECTION_VERTICES);
+			vks::meshcache::Reader indexSection = cache.section(MESH_CACHE_SECTION_INDICES);
+			uint64_t count;
+			*vertexData = vertexSection.mapVector<Vertex>(&count);
+			*vertexCount = static_cast<size_t>(count);
+			*indexData = indexSection.mapVector<uint32_t>(&count);
+			*indexCount = static_cast<size_t>(count);
+			if (vertexSection.failed || indexSection.failed) {
+				return false;
+			}
+
+			// Images are decoded just like when loading from the source file
+			tinygltf::Model imageModel;
+			vks::meshcache::Reader imageSection = cache.section(MESH_CACHE_SECTION_IMAGES);
+			imageModel.images.resize(imageSection.read<uint32_t>());
+			for (tinygltf::Image &image : imageModel.images) {
+				image.name = imageSection.readString();
+				image.uri = imageSection.readString();
+				uint64_t size;
+				const uint8_t *data = imageSection.mapVector<uint8_t>(&size);
+				if (imageSection.failed) {
+					return false;
+				}
+				image.image.assign(data, data + size);
+				image.as_is = true;
+			}
+			decodeImages(imageModel, jobSystem);
+			loadingTimes.imageDecode = elapsed();
+			loadImages(imageModel, device, transferQueue);
+			loadingTimes.textures = elapsed();
+
+			vks::meshcache::Reader scene = cache.section(MESH_CACHE_SECTION_SCENE);
+			auto readTexture = [&]() -> Texture* {
+				const int32_t index = scene.read<int32_t>();
+				if ((index < -1) || (index >= static_cast<int32_t>(textures.size()))) {
+					scene.failed = true;
+				}
+				return (index >= 0) && !scene.failed ? &textures[index] : nullptr;
+			};
+			metallicRoughnessWorkflow = scene.read<uint32_t>() != 0;
+			materials.resize(scene.read<uint32_t>());
+			for (Material &material : materials) {
+				material.alphaMode = static_cast<Material::AlphaMode>(scene.read<uint32_t>());
+				material.alphaCutoff = scene.read<float>();
+				material.metallicFactor = scene.read<float>();
+				material.roughnessFactor = scene.read<float>();
+				material.baseColorFactor = scene.read<glm::vec4>();
+				material.baseColorTexture = readTexture();
+				material.metallicRoughnessTexture = readTexture();
+				material.normalTexture = readTexture();
+				material.occlusionTexture = readTexture();
+				material.emissiveTexture = readTexture();
+				material.specularGlossinessTexture = readTexture();
+				material.diffuseTexture = readTexture();
+			}
+
+			const uint32_t nodeCount = scene.read<uint32_t>();
+			std::vector<int32_t> parentSlots;
+			for (uint32_t i = 0; (i < nodeCount) && !scene.failed; i++) {
+				Node *node = new Node{};
+				linearNodes.push_back(node);
+				parentSlots.push_back(scene.read<int32_t>());
+				node->index = scene.read<uint32_t>();
+				node->name = scene.readString();
+				node->skinIndex = scene.read<int32_t>();
+				node->matrix = scene.read<glm::mat4>();
+				node->translation = scene.read<glm::vec3>();
+				node->scale = scene.read<glm::vec3>();
+				node->rotation = scene.read<glm::quat>();
+				if (scene.read<uint32_t>() != 0) {
+					node->mesh = new Mesh(device, node->matrix);
+					node->mesh->name = scene.readString();
+					const uint32_t primitiveCount = scene.read<uint32_t>();
+					for (uint32_t j = 0; (j < primitiveCount) && !scene.failed; j++) {
+						const uint32_t firstIndex = scene.read<uint32_t>();
+						const uint32_t primitiveIndexCount = scene.read<uint32_t>();
+						const uint32_t firstVertex = scene.read<uint32_t>();
+						const uint32_t primitiveVertexCount = scene.read<uint32_t>();
+						const int32_t materialIndex = scene.read<int32_t>();
+						const glm::vec3 min = scene.read<glm::vec3>();
+						const glm::vec3 max = scene.read<glm::vec3>();
+						if ((materialIndex < 0) || (materialIndex >= static_cast<int32_t>(materials.size())) || (uint64_t(firstIndex) + primitiveIndexCount > *indexCount) || (uint64_t(firstVertex) + primitiveVertexCount > *vertexCount)) {
+							scene.failed = true;
+							break;
+						}
+						Primitive *primitive = new Primitive(firstIndex, primitiveIndexCount, materials[materialIndex]);
+						primitive->firstVertex = firstVertex;
+						primitive->vertexCount = primitiveVertexCount;
+						primitive->setDimensions(min, max);
+						node->mesh->primitives.push_back(primitive);
 					}
 				}
 			}
-			else {
-				// TODO: throw
-				std::cerr << "Could not load gltf file: " << error << std::endl;
-				return;
+			// Children are stored before their parents, so the hierarchy can only be linked once all nodes exist
+			for (size_t i = 0; (i < parentSlots.size()) && !scene.failed; i++) {
+				if ((parentSlots[i] != -1) && ((parentSlots[i] <= static_cast<int32_t>(i)) || (parentSlots[i] >= static_cast<int32_t>(linearNodes.size())))) {
+					scene.failed = true;
+				}
+			}
+			if (scene.failed) {
+				// Nothing has been linked yet, so every node is deleted on its own
+				for (auto node : linearNodes) {
+					delete node;
+				}
+				linearNodes.clear();
+				clearScene();
+				return false;
+			}
+			for (size_t i = 0; i < linearNodes.size(); i++) {
+				Node *parent = (parentSlots[i] >= 0) ? linearNodes[parentSlots[i]] : nullptr;
+				linearNodes[i]->parent = parent;
+				if (parent) {
+					parent->children.push_back(linearNodes[i]);
+				} else {
+					nodes.push_back(linearNodes[i]);
+				}
 			}
+			loadingTimes.nodes = elapsed();
 
-			// Pre-Calculations for requested features
-			if ((fileLoadingFlags & FileLoadingFlags::PreTransformVertices) || (fileLoadingFlags & FileLoadingFlags::PreMultiplyVertexColors) || (fileLoadingFlags & FileLoadingFlags::FlipY)) {
-				const bool preTransform = fileLoadingFlags & FileLoadingFlags::PreTransformVertices;
-				const bool preMultiplyColor = fileLoadingFlags & FileLoadingFlags::PreMultiplyVertexColors;
-				const bool flipY = fileLoadingFlags & FileLoadingFlags::FlipY;
-				for (Node* node : linearNodes) {
-					if (node->mesh) {
-						const glm::mat4 localMatrix = node->getMatrix();
-						for (Primitive* primitive : node->mesh->primitives) {
-							for (uint32_t i = 0; i < primitive->vertexCount; i++) {
-								Vertex& vertex = vertexBuffer[primitive->firstVertex + i];
-								// Pre-transform vertex positions by node-hierarchy
-								if (preTransform) {
-									vertex.pos = glm::vec3(localMatrix * glm::vec4(vertex.pos, 1.0f));
-								}
-								// Flip Y-Axis of vertex positions
-								if (flipY) {
-									vertex.pos.y *= -1.0f;
-								}
-								// Pre-Multiply vertex colors with material base color
-								if (preMultiplyColor) {
-									vertex.color = primitive->material.baseColorFactor * vertex.color;
+			auto readNode = [&]() -> Node* {
+				const int32_t slot = scene.read<int32_t>();
+				if ((slot < -1) || (slot >= static_cast<int32_t>(linearNodes.size()))) {
+					scene.failed = true;
+				}
+				return (slot >= 0) && !scene.failed ? linearNodes[slot] : nullptr;
+			};
+			const uint32_t skinCount = scene.read<uint32_t>();
+			for (uint32_t i = 0; (i < skinCount) && !scene.failed; i++) {
+				Skin *skin = new Skin{};
+				skins.push_back(skin);
+				skin->name = scene.readString();
+				skin->skeletonRoot = readNode();
+				for (int32_t slot : scene.readVector<int32_t>()) {
+					if ((slot < 0) || (slot >= static_cast<int32_t>(linearNodes.size()))) {
+						scene.failed = true;
+						break;
+					}
+					skin->joints.push_back(linearNodes[slot]);
+				}
+				skin->inverseBindMatrices = scene.readVector<glm::mat4>();
+			}
+			animations.resize(scene.failed ? 0 : scene.read<uint32_t>());
+			for (Animation &animation : animations) {
+				animation.name = scene.readString();
+				animation.start = scene.read<float>();
+				animation.end = scene.read<float>();
+				animation.samplers.resize(scene.read<uint32_t>());
+				for (AnimationSampler &sampler : animation.samplers) {
+					sampler.interpolation = static_cast<AnimationSampler::InterpolationType>(scene.read<uint32_t>());
+					sampler.inputs = scene.readVector<float>();
+					sampler.outputsVec4 = scene.readVector<glm::vec4>();
+				}
+				animation.channels.resize(scene.read<uint32_t>());
+				for (AnimationChannel &channel : animation.channels) {
+					channel.path = static_cast<AnimationChannel::PathType>(scene.read<uint32_t>());
+					channel.node = readNode();
+					channel.samplerIndex = scene.read<uint32_t>();
+				}
+				if (scene.failed) {
+					break;
+				}
+			}
+			if (scene.failed) {
+				clearScene();
+				return false;
+			}
+
+			// Assign skins
+			for (auto node : linearNodes) {
+				if ((node->skinIndex > -1) && (node->skinIndex < static_cast<int32_t>(skins.size()))) {
+					node->skin = skins[node->skinIndex];
+				}
+			}
+			// Initial pose
+			sortNodes();
+			setupJointPalette();
+			updateTransforms();
+			loadingTimes.animations = elapsed();
+
+			// The cached buffers are already optimized, only the statistics of the optimization are read back
+			if (optimizeMeshes) {
+				vks::meshcache::Reader optimizationSection = cache.section(MESH_CACHE_SECTION_OPTIMIZATION);
+				const vks::meshoptimizer::Statistics stats = optimizationSection.read<vks::meshoptimizer::Statistics>();
+				if (!optimizationSection.failed) {
+					meshOptimization = stats;
+				}
+			}
+			return true;
+		}
+
+		void loadFromFile(std::string filename, vks::VulkanDevice *device, VkQueue transferQueue, uint32_t fileLoadingFlags = vkglTF::FileLoadingFlags::None, float scale = 1.0f)
+		{
+			tinygltf::Model gltfModel;
+			tinygltf::TinyGLTF gltfContext;
+			std::string error, warning;
+
+			this->device = device;
+			this->fileLoadingFlags = fileLoadingFlags;
+
+			typedef std::chrono::high_resolution_clock Clock;
+			auto elapsed = [](Clock::time_point &start) {
+				const Clock::time_point now = Clock::now();
+				const double ms = std::chrono::duration<double, std::milli>(now - start).count();
+				start = now;
+				return ms;
+			};
+			const Clock::time_point loadStart = Clock::now();
+			Clock::time_point phaseStart = loadStart;
+			loadingTimes = LoadingTimes();
+
+			// The calling thread takes part in the parallel phases
+			vks::JobSystem jobSystem(loadingThreadCount);
+
+#if defined(__ANDROID__)
+			// Models are read from the apk on Android, which has no place for the cache next to the source
+			const bool useMeshCache = false;
+#else
+			const bool useMeshCache = enableMeshCache;
+#endif
+			const uint64_t meshCacheParameters = meshCacheParameterHash(fileLoadingFlags, scale, optimizeMeshes);
+			vks::meshcache::CacheReader meshCache;
+			std::vector<uint32_t> indexBuffer;
+			std::vector<Vertex> vertexBuffer;
+			const Vertex *vertexData = nullptr;
+			const uint32_t *indexData = nullptr;
+			size_t vertexCount = 0;
+			size_t indexCount = 0;
+
+			loadingTimes.meshCache = useMeshCache && meshCache.open(vks::meshcache::getFileName(filename), vks::meshcache::getDirectory(filename), vks::meshcache::CONTENT_GLTF, meshCacheParameters);
+			if (loadingTimes.meshCache) {
+				loadingTimes.parse = elapsed(phaseStart);
+				// Vertex and index data are uploaded straight from the mapped cache file
+				loadingTimes.meshCache = loadMeshCache(meshCache, jobSystem, transferQueue, &vertexData, &vertexCount, &indexData, &indexCount);
+				if (!loadingTimes.meshCache) {
+					std::cerr << "Ignoring inconsistent mesh cache for \"" << filename << "\"" << std::endl;
+				}
+				phaseStart = Clock::now();
+			}
+
+			if (!loadingTimes.meshCache) {
+				// Images are only decoded after parsing, on all loading threads
+				gltfContext.SetImageLoader(loadImageDataDeferred, nullptr);
+
+#if defined(__ANDROID__)
+				AAsset* asset = AAssetManager_open(androidApp->activity->assetManager, filename.c_str(), AASSET_MODE_STREAMING);
+				assert(asset);
+				size_t size = AAsset_getLength(asset);
+				assert(size > 0);
+				char* fileData = new char[size];
+				AAsset_read(asset, fileData, size);
+				AAsset_close(asset);
+				std::string baseDir;
+				bool fileLoaded = gltfContext.LoadASCIIFromString(&gltfModel, &error, &warning, fileData, size, baseDir);
+				free(fileData);
+#else
+				bool fileLoaded = gltfContext.LoadASCIIFromFile(&gltfModel, &error, &warning, filename);
+#endif
+				loadingTimes.parse = elapsed(phaseStart);
+
+				vks::meshcache::Writer meshCacheImages;
+
+				if (fileLoaded) {
+					if (useMeshCache) {
+						// The cache stores the encoded images, so they need to be written before decoding
+						meshCacheImages.write(static_cast<uint32_t>(gltfModel.images.size()));
+						for (const tinygltf::Image &image : gltfModel.images) {
+							meshCacheImages.writeString(image.name);
+							meshCacheImages.writeString(image.uri);
+							meshCacheImages.writeVector(image.image);
+						}
+					}
+					decodeImages(gltfModel, jobSystem);
+					loadingTimes.imageDecode = elapsed(phaseStart);
+
+					// Vulkan resources are created on the calling thread, all uploads are recorded into the same batch
+					loadImages(gltfModel, device, transferQueue);
+					loadingTimes.textures = elapsed(phaseStart);
+
+					loadMaterials(gltfModel);
+					std::vector<PrimitiveLoadInfo> primitiveLoads;
+					uint32_t totalVertexCount = 0;
+					uint32_t totalIndexCount = 0;
+					const tinygltf::Scene &scene = gltfModel.scenes[gltfModel.defaultScene > -1 ? gltfModel.defaultScene : 0];
+					for (size_t i = 0; i < scene.nodes.size(); i++) {
+						const tinygltf::Node &node = gltfModel.nodes[scene.nodes[i]];
+						loadNode(nullptr, node, scene.nodes[i], gltfModel, primitiveLoads, totalVertexCount, totalIndexCount, scale);
+					}
+					loadingTimes.nodes = elapsed(phaseStart);
+
+					// All primitives write to their own pre-sized ranges, so they can be extracted concurrently
+					vertexBuffer.resize(totalVertexCount);
+					indexBuffer.resize(totalIndexCount);
+					jobSystem.parallelFor(primitiveLoads.size(), [&](size_t i) {
+						loadPrimitiveData(gltfModel, primitiveLoads[i], vertexBuffer.data(), indexBuffer.data());
+					});
+					loadingTimes.geometry = elapsed(phaseStart);
+
+					if (optimizeMeshes) {
+						std::vector<vks::meshoptimizer::Statistics> primitiveStats(primitiveLoads.size());
+						jobSystem.parallelFor(primitiveLoads.size(), [&](size_t i) {
+							primitiveStats[i] = optimizePrimitive(primitiveLoads[i], vertexBuffer.data(), indexBuffer.data());
+						});
+						meshOptimization = vks::meshoptimizer::Statistics();
+						for (const vks::meshoptimizer::Statistics &stats : primitiveStats) {
+							meshOptimization.add(stats);
+						}
+						loadingTimes.optimize = elapsed(phaseStart);
+					}
+
+					if (gltfModel.animations.size() > 0) {
+						loadAnimations(gltfModel);
+					}
+					loadSkins(gltfModel);
+
+					// Assign skins
+					for (auto node : linearNodes) {
+						if (node->skinIndex > -1) {
+							node->skin = skins[node->skinIndex];
+						}
+					}
+					// Initial pose
+					sortNodes();
+					setupJointPalette();
+					updateTransforms();
+					loadingTimes.animations = elapsed(phaseStart);
+				}
+				else {
+					// TODO: throw
+					std::cerr << "Could not load gltf file: " << error << std::endl;
+					return;
+				}
+
+				// Pre-Calculations for requested features
+				if ((fileLoadingFlags & FileLoadingFlags::PreTransformVertices) || (fileLoadingFlags & FileLoadingFlags::PreMultiplyVertexColors) || (fileLoadingFlags & FileLoadingFlags::FlipY)) {
+					const bool preTransform = fileLoadingFlags & FileLoadingFlags::PreTransformVertices;
+					const bool preMultiplyColor = fileLoadingFlags & FileLoadingFlags::PreMultiplyVertexColors;
+					const bool flipY = fileLoadingFlags & FileLoadingFlags::FlipY;
+					// Every node has its own copy of the vertices of its mesh, so nodes can be processed concurrently
+					jobSystem.parallelFor(linearNodes.size(), [&](size_t n) {
+						Node* node = linearNodes[n];
+						if (node->mesh) {
+							const glm::mat4 localMatrix = node->getMatrix();
+							for (Primitive* primitive : node->mesh->primitives) {
+								for (uint32_t i = 0; i < primitive->vertexCount; i++) {
+									Vertex& vertex = vertexBuffer[primitive->firstVertex + i];
+									// Pre-transform vertex positions by node-hierarchy
+									if (preTransform) {
+										vertex.pos = glm::vec3(localMatrix * glm::vec4(vertex.pos, 1.0f));
+									}
+									// Flip Y-Axis of vertex positions
+									if (flipY) {
+										vertex.pos.y *= -1.0f;
+									}
+									// Pre-Multiply vertex colors with material base color
+									if (preMultiplyColor) {
+										vertex.color = primitive->material.baseColorFactor * vertex.color;
+									}
 								}
 							}
 						}
+					});
+				}
+				loadingTimes.preTransform = elapsed(phaseStart);
+
+				for (auto extension : gltfModel.extensionsUsed) {
+					if (extension == "KHR_materials_pbrSpecularGlossiness") {
+						std::cout << "Required extension: " << extension;
+						metallicRoughnessWorkflow = false;
 					}
 				}
-			}
 
-			for (auto extension : gltfModel.extensionsUsed) {
-				if (extension == "KHR_materials_pbrSpecularGlossiness") {
-					std::cout << "Required extension: " << extension;
-					metallicRoughnessWorkflow = false;
+				if (useMeshCache) {
+					writeMeshCache(filename, gltfModel, meshCacheImages, vertexBuffer, indexBuffer, meshCacheParameters);
+					loadingTimes.cacheWrite = elapsed(phaseStart);
 				}
+				vertexData = vertexBuffer.data();
+				vertexCount = vertexBuffer.size();
+				indexData = indexBuffer.data();
+				indexCount = indexBuffer.size();
 			}
 
-			size_t vertexBufferSize = vertexBuffer.size() * sizeof(Vertex);
-			size_t indexBufferSize = indexBuffer.size() * sizeof(uint32_t);
-			indices.count = static_cast<uint32_t>(indexBuffer.size());
-
-			assert((vertexBufferSize > 0) && (indexBufferSize > 0));
+			// Vertex buffer, host visible if it's written by host skinning
+			const bool hostSkinning = cpuSkinning && hasJointPalette();
+			if (hostSkinning && vertexFormat.packed()) {
+				std::cout << "Host skinning writes full vertices, the compact vertex format is ignored" << std::endl;
+				vertexFormat = VertexFormat();
+			}
+			std::vector<uint8_t> packedVertices;
+			if (vertexFormat.packed()) {
+				const Clock::time_point packStart = Clock::now();
+				packVertices(vertexData, vertexCount, packedVertices, jobSystem);
+				vertexMemory.packTime = std::chrono::duration<double, std::milli>(Clock::now() - packStart).count();
+			}
+			vertexMemory.vertexCount = static_cast<uint32_t>(vertexCount);
+			vertexMemory.stride = vertexFormat.stride();
+			const void *deviceVertexData = vertexFormat.packed() ? static_cast<const void*>(packedVertices.data()) : static_cast<const void*>(vertexData);
 
-			struct StagingBuffer {
-				VkBuffer buffer;
-				VkDeviceMemory memory;
-			} vertexStaging, indexStaging;
+			size_t vertexBufferSize = vertexMemory.size();
+			size_t indexBufferSize = indexCount * sizeof(uint32_t);
+			indices.count = static_cast<uint32_t>(indexCount);
 
-			// Create staging buffers
-			// Vertex data
-			VK_CHECK_RESULT(device->createBuffer(
-				VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-				vertexBufferSize,
-				&vertexStaging.buffer,
-				&vertexStaging.memory,
-				vertexBuffer.data()));
-			// Index data
-			VK_CHECK_RESULT(device->createBuffer(
-				VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-				indexBufferSize,
-				&indexStaging.buffer,
-				&indexStaging.memory,
-				indexBuffer.data()));
+			assert((vertexBufferSize > 0) && (indexBufferSize > 0));
 
 			// Create device local buffers
-			// Vertex buffer
-			VK_CHECK_RESULT(device->createBuffer(
-				VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-				vertexBufferSize,
-				&vertices.buffer,
-				&vertices.memory));
+			if (hostSkinning) {
+				setupCpuSkinning(vertexData, vertexCount, jobSystem);
+			} else {
+				VK_CHECK_RESULT(device->createBuffer(
+					VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+					VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+					&vertices,
+					vertexBufferSize));
+			}
 			// Index buffer
 			VK_CHECK_RESULT(device->createBuffer(
 				VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
 				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-				indexBufferSize,
-				&indices.buffer,
-				&indices.memory));
-
-			// Copy from staging buffers
-			VkCommandBuffer copyCmd = device->createCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
-
-			VkBufferCopy copyRegion = {};
+				&indices,
+				indexBufferSize));
 
-			copyRegion.size = vertexBufferSize;
-			vkCmdCopyBuffer(copyCmd, vertexStaging.buffer, vertices.buffer, 1, &copyRegion);
-
-			copyRegion.size = indexBufferSize;
-			vkCmdCopyBuffer(copyCmd, indexStaging.buffer, indices.buffer, 1, &copyRegion);
-
-			device->flushCommandBuffer(copyCmd, transferQueue, true);
-
-			vkDestroyBuffer(device->logicalDevice, vertexStaging.buffer, nullptr);
-			vkFreeMemory(device->logicalDevice, vertexStaging.memory, nullptr);
-			vkDestroyBuffer(device->logicalDevice, indexStaging.buffer, nullptr);
-			vkFreeMemory(device->logicalDevice, indexStaging.memory, nullptr);
+			// Upload vertices and indices in the same batch as the images and submit everything at once
+			if (!hostSkinning) {
+				device->uploadManager.uploadBuffer(vertices.buffer, deviceVertexData, vertexBufferSize);
+			}
+			device->uploadManager.uploadBuffer(indices.buffer, indexData, indexBufferSize);
+			if (indirectDraw) {
+				setupIndirectDraw();
+			}
+			device->uploadManager.submit();
+			loadingTimes.upload = elapsed(phaseStart);
+			loadingTimes.total = std::chrono::duration<double, std::milli>(Clock::now() - loadStart).count();
+
+			if (vks::Benchmark *benchmark = vks::Benchmark::current()) {
+				vks::Benchmark::AssetLoad assetLoad;
+				assetLoad.name = filename;
+				assetLoad.cached = loadingTimes.meshCache;
+				assetLoad.total = loadingTimes.total;
+				assetLoad.phases = {
+					{ loadingTimes.meshCache ? "cacheValidation" : "parse", loadingTimes.parse },
+					{ "imageDecode", loadingTimes.imageDecode },
+					{ "textures", loadingTimes.textures },
+					{ "nodes", loadingTimes.nodes },
+					{ "geometry", loadingTimes.geometry },
+					{ "optimize", loadingTimes.optimize },
+					{ "animations", loadingTimes.animations },
+					{ "preTransform", loadingTimes.preTransform },
+					{ "upload", loadingTimes.upload },
+					{ "cacheWrite", loadingTimes.cacheWrite }
+				};
+				benchmark->recordAssetLoad(assetLoad);
+			}
+			if (fileLoadingFlags & FileLoadingFlags::LogLoadingTimes) {
+				std::cout << std::fixed << std::setprecision(2);
+				std::cout << "Loaded \"" << filename << "\"" << (loadingTimes.meshCache ? " from mesh cache" : "") << " in " << loadingTimes.total << " ms using " << jobSystem.threadCount() << " thread(s)" << std::endl;
+				std::cout << "  " << (loadingTimes.meshCache ? "cache validation " : "parse ") << loadingTimes.parse << " ms, image decode " << loadingTimes.imageDecode << " ms, textures " << loadingTimes.textures << " ms, nodes " << loadingTimes.nodes << " ms" << std::endl;
+				std::cout << "  geometry " << loadingTimes.geometry << " ms, animations " << loadingTimes.animations << " ms, pre-transform " << loadingTimes.preTransform << " ms, upload " << loadingTimes.upload << " ms";
+				if (loadingTimes.cacheWrite > 0.0) {
+					std::cout << ", mesh cache write " << loadingTimes.cacheWrite << " ms";
+				}
+				std::cout << std::endl;
+				if (vertexFormat.packed()) {
+					std::cout << "  vertex buffer " << vertexMemory.fullSize() / 1024.0 << " KB -> " << vertexMemory.size() / 1024.0 << " KB (" << vertexMemory.fullStride << " -> " << vertexMemory.stride << " bytes per vertex), pack " << vertexMemory.packTime << " ms" << std::endl;
+				}
+				if (optimizeMeshes) {
+					std::cout << std::setprecision(3) << "  vertex cache ACMR " << meshOptimization.before.acmr() << " -> " << meshOptimization.after.acmr() << ", ATVR " << meshOptimization.before.atvr() << " -> " << meshOptimization.after.atvr() << ", " << meshOptimization.clusters << " overdraw clusters";
+					if (!loadingTimes.meshCache) {
+						std::cout << std::setprecision(2) << ", optimize " << loadingTimes.optimize << " ms";
+					}
+					std::cout << std::endl;
+				}
+				std::cout.unsetf(std::ios::floatfield);
+			}
 
 			getSceneDimensions();
+			buildBoundingVolumeHierarchy();
 
 			// Setup descriptors
 			uint32_t uboCount{ 0 };
@@ -1164,12 +2925,17 @@ namespace vkglTF
 			std::vector<VkDescriptorPoolSize> poolSizes = {
 				vks::initializers::descriptorPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, uboCount),
 			};
-			VkDescriptorPoolCreateInfo descriptorPoolCI = vks::initializers::descriptorPoolCreateInfo(static_cast<uint32_t>(poolSizes.size()), poolSizes.data(), uboCount);
-			VK_CHECK_RESULT(vkCreateDescriptorPool(device->logicalDevice, &descriptorPoolCI, nullptr, &descriptorPool));
-
 			std::vector<VkDescriptorSetLayoutBinding> setLayoutBindings = {
 				vks::initializers::descriptorSetLayoutBinding(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT, 0),
 			};
+			// The joint palette binding is only added for models with skins, so the layout of static models stays unchanged
+			if (hasJointPalette()) {
+				poolSizes.push_back(vks::initializers::descriptorPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, uboCount));
+				setLayoutBindings.push_back(vks::initializers::descriptorSetLayoutBinding(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, VK_SHADER_STAGE_VERTEX_BIT, 1));
+			}
+			VkDescriptorPoolCreateInfo descriptorPoolCI = vks::initializers::descriptorPoolCreateInfo(static_cast<uint32_t>(poolSizes.size()), poolSizes.data(), uboCount);
+			VK_CHECK_RESULT(vkCreateDescriptorPool(device->logicalDevice, &descriptorPoolCI, nullptr, &descriptorPool));
+
 			VkDescriptorSetLayoutCreateInfo descriptorLayoutCI{};
 			descriptorLayoutCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
 			descriptorLayoutCI.bindingCount = static_cast<uint32_t>(setLayoutBindings.size());
@@ -1194,7 +2960,7 @@ namespace vkglTF
 
 		void draw(VkCommandBuffer commandBuffer)
 		{
-			const VkDeviceSize offsets[1] = { 0 };
+			const VkDeviceSize offsets[1] = { vertexBufferOffset() };
 			vkCmdBindVertexBuffers(commandBuffer, 0, 1, &vertices.buffer, offsets);
 			vkCmdBindIndexBuffer(commandBuffer, indices.buffer, 0, VK_INDEX_TYPE_UINT32);
 			for (auto& node : nodes) {
@@ -1202,18 +2968,87 @@ namespace vkglTF
 			}
 		}
 
+		/**
+		* Draw the primitives inside or intersecting the frustum in the same order as draw (see cull)
+		*
+		* @param frustum Frustum in the model's world space (e.g. updated with projection * view * model)
+		*/
+		void draw(VkCommandBuffer commandBuffer, const vks::Frustum &frustum)
+		{
+			cull(frustum);
+			const VkDeviceSize offsets[1] = { vertexBufferOffset() };
+			vkCmdBindVertexBuffers(commandBuffer, 0, 1, &vertices.buffer, offsets);
+			vkCmdBindIndexBuffer(commandBuffer, indices.buffer, 0, VK_INDEX_TYPE_UINT32);
+			// Sorted nodes are in the order of the recursive traversal of draw
+			for (Node *node : sortedNodes) {
+				if (!node->mesh) {
+					continue;
+				}
+				for (Primitive *primitive : node->mesh->primitives) {
+					if (primitive->visible) {
+						vkCmdDrawIndexed(commandBuffer, primitive->indexCount, 1, primitive->firstIndex, 0, 0);
+					}
+				}
+			}
+		}
+
+		/**
+		* Draw all primitives of the flattened draw list with as few calls as the device allows (requires indirectDraw)
+		*
+		* The caller has to bind indirect.descriptorSet (with the joint palette's dynamic offset for skinned models)
+		* Uses a single vkCmdDrawIndexedIndirectCountKHR if VK_KHR_draw_indirect_count is enabled, a single vkCmdDrawIndexedIndirect if multiDrawIndirect is enabled,
+		* one indirect call per draw if only drawIndirectFirstInstance is enabled and direct draws from the host copy of the commands otherwise
+		*/
+		void drawIndirect(VkCommandBuffer commandBuffer)
+		{
+			const uint32_t drawCount = static_cast<uint32_t>(indirect.commands.size());
+			if (drawCount == 0) {
+				return;
+			}
+			const VkDeviceSize offsets[1] = { vertexBufferOffset() };
+			vkCmdBindVertexBuffers(commandBuffer, 0, 1, &vertices.buffer, offsets);
+			vkCmdBindIndexBuffer(commandBuffer, indices.buffer, 0, VK_INDEX_TYPE_UINT32);
+			const uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+			if (indirect.vkCmdDrawIndexedIndirectCountKHR) {
+				indirect.vkCmdDrawIndexedIndirectCountKHR(commandBuffer, indirect.commandsBuffer.buffer, 0, indirect.countBuffer.buffer, 0, drawCount, stride);
+			} else if (device->enabledFeatures.multiDrawIndirect && (drawCount <= device->properties.limits.maxDrawIndirectCount)) {
+				vkCmdDrawIndexedIndirect(commandBuffer, indirect.commandsBuffer.buffer, 0, drawCount, stride);
+			} else if (device->enabledFeatures.drawIndirectFirstInstance) {
+				for (uint32_t i = 0; i < drawCount; i++) {
+					vkCmdDrawIndexedIndirect(commandBuffer, indirect.commandsBuffer.buffer, i * stride, 1, stride);
+				}
+			} else {
+				// Indirect draws require the drawIndirectFirstInstance feature for passing the draw index
+				for (const VkDrawIndexedIndirectCommand &command : indirect.commands) {
+					if (command.instanceCount > 0) {
+						vkCmdDrawIndexed(commandBuffer, command.indexCount, command.instanceCount, command.firstIndex, command.vertexOffset, command.firstInstance);
+					}
+				}
+			}
+		}
+
+		/**
+		* Write the host copy of the indirect commands to the device (e.g. after changing instance counts)
+		*
+		* @note Without drawIndirectFirstInstance the commands are recorded as direct draws, so command buffers have to be recorded again instead
+		*/
+		void updateIndirectCommands()
+		{
+			if (indirect.commandsBuffer.mapped) {
+				memcpy(indirect.commandsBuffer.mapped, indirect.commands.data(), indirect.commands.size() * sizeof(VkDrawIndexedIndirectCommand));
+			}
+		}
+
 		void getNodeDimensions(Node *node, glm::vec3 &min, glm::vec3 &max)
 		{
 			if (node->mesh) {
+				const glm::mat4 matrix = node->getMatrix();
 				for (Primitive *primitive : node->mesh->primitives) {
-					glm::vec4 locMin = glm::vec4(primitive->dimensions.min, 1.0f) * node->getMatrix();
-					glm::vec4 locMax = glm::vec4(primitive->dimensions.max, 1.0f) * node->getMatrix();
-					if (locMin.x < min.x) { min.x = locMin.x; }
-					if (locMin.y < min.y) { min.y = locMin.y; }
-					if (locMin.z < min.z) { min.z = locMin.z; }
-					if (locMax.x > max.x) { max.x = locMax.x; }
-					if (locMax.y > max.y) { max.y = locMax.y; }
-					if (locMax.z > max.z) { max.z = locMax.z; }
+					const BoundingBox box = worldBounds(localBounds(primitive).transform(matrix));
+					if (box.valid()) {
+						min = glm::min(min, box.min);
+						max = glm::max(max, box.max);
+					}
 				}
 			}
 			for (auto child : node->children) {
@@ -1233,6 +3068,48 @@ namespace vkglTF
 			dimensions.radius = glm::distance(dimensions.min, dimensions.max) / 2.0f;
 		}
 
+		/**
+		* Evaluate all channels of an animation at the given time into the result streams of its batch
+		*
+		* @note Channels with invalid samplers are skipped, the results of stream k belong to the channel stored at batch.streams[path].channels[k]
+		*/
+		void evaluateAnimation(Animation &animation, float time)
+		{
+			AnimationBatch &batch = animation.batch;
+			if (!batch.initialized) {
+				for (uint32_t i = 0; i < static_cast<uint32_t>(animation.channels.size()); i++) {
+					const AnimationChannel &channel = animation.channels[i];
+					if (animation.samplers[channel.samplerIndex].valid()) {
+						batch.streams[channel.path].channels.push_back(i);
+					}
+				}
+				for (uint32_t path = 0; path < 3; path++) {
+					batch.streams[path].resize(static_cast<uint32_t>(batch.streams[path].channels.size()), path == AnimationChannel::PathType::ROTATION);
+				}
+				batch.initialized = true;
+			}
+			const vks::simd::Path simdPath = vks::simd::activePath(animationSimdPath);
+			for (uint32_t path = 0; path < 3; path++) {
+				AnimationBatch::Stream &stream = batch.streams[path];
+				if (stream.channels.empty()) {
+					continue;
+				}
+				const bool rotation = (path == AnimationChannel::PathType::ROTATION);
+				// Gather the surrounding keyframes of all channels, the interpolation itself runs on whole vectors
+				for (uint32_t k = 0; k < static_cast<uint32_t>(stream.channels.size()); k++) {
+					AnimationChannel &channel = animation.channels[stream.channels[k]];
+					glm::vec4 a, b;
+					animation.samplers[channel.samplerIndex].interval(time, channel.keyCursor, rotation, a, b, stream.u[k]);
+					for (uint32_t c = 0; c < 4; c++) {
+						stream.a[c][k] = a[c];
+						stream.b[c][k] = b[c];
+					}
+				}
+				AnimationBatch::interpolate(stream, rotation, animationNlerp, simdPath);
+			}
+		}
+
+		/** @brief Applies an animation at the given time (clamped to the animation's keyframes) to the nodes it targets */
 		void updateAnimation(uint32_t index, float time) 
 		{
 			if (index > static_cast<uint32_t>(animations.size()) - 1) {
@@ -1240,54 +3117,727 @@ namespace vkglTF
 				return;
 			}
 			Animation &animation = animations[index];
+			evaluateAnimation(animation, time);
 
 			bool updated = false;
-			for (auto& channel : animation.channels) {
-				vkglTF::AnimationSampler &sampler = animation.samplers[channel.samplerIndex];
-				if (sampler.inputs.size() > sampler.outputsVec4.size()) {
+			for (uint32_t path = 0; path < 3; path++) {
+				const AnimationBatch::Stream &stream = animation.batch.streams[path];
+				for (uint32_t k = 0; k < static_cast<uint32_t>(stream.channels.size()); k++) {
+					Node *node = animation.channels[stream.channels[k]].node;
+					switch (path) {
+					case vkglTF::AnimationChannel::PathType::TRANSLATION:
+						node->translation = glm::vec3(stream.result[0][k], stream.result[1][k], stream.result[2][k]);
+						break;
+					case vkglTF::AnimationChannel::PathType::SCALE:
+						node->scale = glm::vec3(stream.result[0][k], stream.result[1][k], stream.result[2][k]);
+						break;
+					case vkglTF::AnimationChannel::PathType::ROTATION:
+						node->rotation = glm::quat(stream.result[3][k], stream.result[0][k], stream.result[1][k], stream.result[2][k]);
+						break;
+					}
+					node->setDirty();
+					updated = true;
+				}
+			}
+			if (updated) {
+				updateTransforms();
+			}
+		}
+
+		/**
+		* Blends multiple animations and applies the result to the nodes they target
+		*
+		* @param states Animations to blend with their playback times and weights
+		*
+		* @note Translation and scale are averaged and rotations are normalized-lerped by the weights of the animations that target them, so the weights don't need to add up to one
+		* @note Properties not targeted by any of the animations keep their current value
+		*/
+		void updateAnimations(const std::vector<AnimationState> &states)
+		{
+			// Accumulators are left cleared by the previous call
+			blendAccumulators.resize(sortedNodes.size());
+			blendTargets.clear();
+			for (const AnimationState &state : states) {
+				if ((state.index >= animations.size()) || (state.weight <= 0.0f)) {
 					continue;
 				}
+				Animation &animation = animations[state.index];
+				evaluateAnimation(animation, state.time);
+				for (uint32_t path = 0; path < 3; path++) {
+					const AnimationBatch::Stream &stream = animation.batch.streams[path];
+					for (uint32_t k = 0; k < static_cast<uint32_t>(stream.channels.size()); k++) {
+						Node *node = animation.channels[stream.channels[k]].node;
+						glm::vec4 value(stream.result[0][k], stream.result[1][k], stream.result[2][k], stream.result[3][k]);
+						BlendAccumulator &accumulator = blendAccumulators[node->sortedIndex];
+						if (!accumulator.target) {
+							accumulator.target = true;
+							blendTargets.push_back(node);
+						}
+						// q and -q are the same rotation, so quaternions are flipped into the hemisphere of the first one to blend along the shortest arc
+						if ((path == AnimationChannel::PathType::ROTATION) && (accumulator.weight[path] > 0.0f) && (glm::dot(accumulator.value[path], value) < 0.0f)) {
+							value = -value;
+						}
+						accumulator.value[path] += value * state.weight;
+						accumulator.weight[path] += state.weight;
+					}
+				}
+			}
+			for (Node *node : blendTargets) {
+				const BlendAccumulator &accumulator = blendAccumulators[node->sortedIndex];
+				if (accumulator.weight[AnimationChannel::PathType::TRANSLATION] > 0.0f) {
+					node->translation = glm::vec3(accumulator.value[AnimationChannel::PathType::TRANSLATION] / accumulator.weight[AnimationChannel::PathType::TRANSLATION]);
+				}
+				if (accumulator.weight[AnimationChannel::PathType::SCALE] > 0.0f) {
+					node->scale = glm::vec3(accumulator.value[AnimationChannel::PathType::SCALE] / accumulator.weight[AnimationChannel::PathType::SCALE]);
+				}
+				if (accumulator.weight[AnimationChannel::PathType::ROTATION] > 0.0f) {
+					const glm::vec4 q = glm::normalize(accumulator.value[AnimationChannel::PathType::ROTATION]);
+					node->rotation = glm::quat(q.w, q.x, q.y, q.z);
+				}
+				node->setDirty();
+				blendAccumulators[node->sortedIndex] = BlendAccumulator();
+			}
+			if (!blendTargets.empty()) {
+				updateTransforms();
+			}
+		}
 
-				for (auto i = 0; i < sampler.inputs.size() - 1; i++) {
-					if ((time >= sampler.inputs[i]) && (time <= sampler.inputs[i + 1])) {
-						float u = std::max(0.0f, time - sampler.inputs[i]) / (sampler.inputs[i + 1] - sampler.inputs[i]);
-						if (u <= 1.0f) {
-							switch (channel.path) {
-							case vkglTF::AnimationChannel::PathType::TRANSLATION: {
-								glm::vec4 trans = glm::mix(sampler.outputsVec4[i], sampler.outputsVec4[i + 1], u);
-								channel.node->translation = glm::vec3(trans);
-								break;
-							}
-							case vkglTF::AnimationChannel::PathType::SCALE: {
-								glm::vec4 trans = glm::mix(sampler.outputsVec4[i], sampler.outputsVec4[i + 1], u);
-								channel.node->scale = glm::vec3(trans);
-								break;
-							}
-							case vkglTF::AnimationChannel::PathType::ROTATION: {
-								glm::quat q1;
-								q1.x = sampler.outputsVec4[i].x;
-								q1.y = sampler.outputsVec4[i].y;
-								q1.z = sampler.outputsVec4[i].z;
-								q1.w = sampler.outputsVec4[i].w;
-								glm::quat q2;
-								q2.x = sampler.outputsVec4[i + 1].x;
-								q2.y = sampler.outputsVec4[i + 1].y;
-								q2.z = sampler.outputsVec4[i + 1].z;
-								q2.w = sampler.outputsVec4[i + 1].w;
-								channel.node->rotation = glm::normalize(glm::slerp(q1, q2, u));
-								break;
+		/** @brief Sort all nodes so that parents precede their children (depth first, so subtrees stay contiguous) */
+		void sortNodes()
+		{
+			sortedNodes.clear();
+			sortedNodes.reserve(linearNodes.size());
+			std::vector<Node*> stack(nodes.rbegin(), nodes.rend());
+			while (!stack.empty()) {
+				Node *node = stack.back();
+				stack.pop_back();
+				node->sortedIndex = static_cast<uint32_t>(sortedNodes.size());
+				sortedNodes.push_back(node);
+				for (auto child = node->children.rbegin(); child != node->children.rend(); ++child) {
+					stack.push_back(*child);
+				}
+			}
+		}
+
+		/**
+		* Update the cached matrices of all changed nodes and their subtrees and write the matrices of all affected meshes
+		*
+		* @note Single linear pass over the sorted nodes, matrices are only recalculated for nodes that have been marked dirty or whose parent changed
+		*/
+		void updateTransforms()
+		{
+			for (Node *node : sortedNodes) {
+				// The parent has already been processed in this pass
+				node->worldChanged = node->dirty || (node->parent && node->parent->worldChanged);
+				if (node->dirty) {
+					node->cachedLocalMatrix = node->localMatrix();
+					node->dirty = false;
+				}
+				if (node->worldChanged) {
+					node->cachedWorldMatrix = node->parent ? node->parent->cachedWorldMatrix * node->cachedLocalMatrix : node->cachedLocalMatrix;
+				}
+			}
+			// Skinned meshes also depend on their joints, which may be anywhere in the hierarchy, so meshes are only updated once all matrices are final
+			bool boundsChanged = false;
+			for (Node *node : sortedNodes) {
+				if (node->meshChanged()) {
+					node->update(jointPalette.matrices.data());
+					if (indirect.matricesBuffer.mapped) {
+						memcpy(static_cast<glm::mat4*>(indirect.matricesBuffer.mapped) + node->mesh->matrixIndex, &node->mesh->uniformBlock.matrix, sizeof(glm::mat4));
+					}
+					if (node->mesh->uniformBlock.jointCount > 0) {
+						jointPalette.ranges[node->mesh->jointRange].version++;
+					}
+					updateNodeBounds(node);
+					boundsChanged = true;
+				}
+			}
+			if (boundsChanged) {
+				updateSubtreeBounds();
+				refitBoundingVolumeHierarchy();
+			}
+			uploadJointPalette();
+			skinVertices();
+		}
+
+		/** @brief Bounds of a primitive in the space of its mesh (as its vertices are stored in the vertex buffer unless pre-transformed) */
+		BoundingBox localBounds(const Primitive *primitive) const
+		{
+			const BoundingBox box(primitive->dimensions.min, primitive->dimensions.max);
+			if ((fileLoadingFlags & FileLoadingFlags::FlipY) && !(fileLoadingFlags & FileLoadingFlags::PreTransformVertices) && box.valid()) {
+				return BoundingBox(glm::vec3(box.min.x, -box.max.y, box.min.z), glm::vec3(box.max.x, -box.min.y, box.max.z));
+			}
+			return box;
+		}
+
+		/** @brief Bounds transformed to world space with the node's matrix, flipped if the vertices have been flipped after pre-transforming them */
+		BoundingBox worldBounds(const BoundingBox &box) const
+		{
+			if ((fileLoadingFlags & FileLoadingFlags::FlipY) && (fileLoadingFlags & FileLoadingFlags::PreTransformVertices) && box.valid()) {
+				return BoundingBox(glm::vec3(box.min.x, -box.max.y, box.min.z), glm::vec3(box.max.x, -box.min.y, box.max.z));
+			}
+			return box;
+		}
+
+		/**
+		* Recalculate the world space bounds of a node's mesh and its primitives from the cached world and joint matrices
+		*
+		* A skinned vertex is a weighted average of the vertex transformed by its joints, so it lies within the union of the primitive's bounds transformed by each joint of the skin
+		*/
+		void updateNodeBounds(Node *node)
+		{
+			node->bounds = BoundingBox();
+			if (!node->mesh) {
+				return;
+			}
+			Mesh *mesh = node->mesh;
+			const glm::mat4 *jointMatrices = nullptr;
+			uint32_t jointCount = 0;
+			if (mesh->uniformBlock.jointCount > 0) {
+				jointMatrices = &jointPalette.matrices[mesh->uniformBlock.jointOffset];
+				jointCount = mesh->uniformBlock.jointCount;
+			}
+			for (Primitive *primitive : mesh->primitives) {
+				BoundingBox box = localBounds(primitive);
+				if (!box.valid()) {
+					// Primitives without bounds are never culled
+					primitive->bounds = BoundingBox(glm::vec3(-FLT_MAX), glm::vec3(FLT_MAX));
+				} else {
+					if (jointCount > 0) {
+						BoundingBox skinned;
+						for (uint32_t i = 0; i < jointCount; i++) {
+							skinned.expand(box.transform(jointMatrices[i]));
+						}
+						box = skinned;
+					}
+					primitive->bounds = worldBounds(box.transform(node->cachedWorldMatrix));
+				}
+				node->bounds.expand(primitive->bounds);
+			}
+		}
+
+		/** @brief Merge the bounds of all nodes into the subtree bounds of their ancestors (children are processed before their parents) */
+		void updateSubtreeBounds()
+		{
+			for (auto it = sortedNodes.rbegin(); it != sortedNodes.rend(); ++it) {
+				Node *node = *it;
+				node->subtreeBounds = node->bounds;
+				for (Node *child : node->children) {
+					node->subtreeBounds.expand(child->subtreeBounds);
+				}
+			}
+		}
+
+		/**
+		* Build the bounding volume hierarchy over all nodes with a mesh from their current bounds
+		*
+		* @note Called by loadFromFile, the hierarchy is only refitted when nodes move, so it may be rebuilt after animations changed the layout of the scene considerably
+		*/
+		void buildBoundingVolumeHierarchy()
+		{
+			bvh.nodes.clear();
+			bvh.items.clear();
+			bvh.visiblePrimitives.clear();
+			for (Node *node : sortedNodes) {
+				if (node->mesh && !node->mesh->primitives.empty()) {
+					bvh.items.push_back(node);
+					for (Primitive *primitive : node->mesh->primitives) {
+						primitive->visible = true;
+						bvh.visiblePrimitives.push_back(primitive);
+					}
+				}
+			}
+			bvh.primitiveCount = static_cast<uint32_t>(bvh.visiblePrimitives.size());
+			if (bvh.items.empty()) {
+				return;
+			}
+			// A binary tree with n leaves has 2n - 1 nodes
+			bvh.nodes.reserve(2 * bvh.items.size());
+			bvh.nodes.push_back(BoundingVolumeHierarchy::BVHNode());
+			splitBoundingVolume(0, 0, static_cast<uint32_t>(bvh.items.size()));
+			refitBoundingVolumeHierarchy();
+		}
+
+		/** @brief Split the items of a hierarchy node at the median of their centers along the axis with the largest spread */
+		void splitBoundingVolume(uint32_t index, uint32_t first, uint32_t count)
+		{
+			if (count <= std::max(bvh.leafSize, 1u)) {
+				bvh.nodes[index].first = first;
+				bvh.nodes[index].count = count;
+				return;
+			}
+			BoundingBox centers;
+			for (uint32_t i = first; i < first + count; i++) {
+				const glm::vec3 center = bvh.items[i]->bounds.center();
+				centers.expand(BoundingBox(center, center));
+			}
+			const glm::vec3 spread = centers.max - centers.min;
+			const uint32_t axis = (spread.x >= spread.y) ? ((spread.x >= spread.z) ? 0 : 2) : ((spread.y >= spread.z) ? 1 : 2);
+			const uint32_t middle = first + count / 2;
+			std::nth_element(bvh.items.begin() + first, bvh.items.begin() + middle, bvh.items.begin() + first + count, [axis](const Node *a, const Node *b) {
+				return a->bounds.center()[axis] < b->bounds.center()[axis];
+			});
+			const uint32_t child = static_cast<uint32_t>(bvh.nodes.size());
+			bvh.nodes[index].first = child;
+			bvh.nodes[index].count = 0;
+			bvh.nodes.push_back(BoundingVolumeHierarchy::BVHNode());
+			bvh.nodes.push_back(BoundingVolumeHierarchy::BVHNode());
+			splitBoundingVolume(child, first, middle - first);
+			splitBoundingVolume(child + 1, middle, first + count - middle);
+		}
+
+		/** @brief Update the bounds of all hierarchy nodes from the current bounds of the mesh nodes without changing the tree */
+		void refitBoundingVolumeHierarchy()
+		{
+			for (size_t i = bvh.nodes.size(); i-- > 0;) {
+				BoundingVolumeHierarchy::BVHNode &bvhNode = bvh.nodes[i];
+				bvhNode.bounds = BoundingBox();
+				if (bvhNode.count > 0) {
+					for (uint32_t k = 0; k < bvhNode.count; k++) {
+						bvhNode.bounds.expand(bvh.items[bvhNode.first + k]->bounds);
+					}
+				} else {
+					bvhNode.bounds.expand(bvh.nodes[bvhNode.first].bounds);
+					bvhNode.bounds.expand(bvh.nodes[bvhNode.first + 1].bounds);
+				}
+			}
+		}
+
+		/**
+		* Determine the primitives inside or intersecting the frustum, results are stored in Primitive::visible and cullingStatistics
+		*
+		* Subtrees of the hierarchy outside of the frustum are skipped as a whole, planes a box lies completely in front of are not tested again for its contents,
+		* so subtrees completely inside of the frustum are accepted without further tests
+		*
+		* @param frustum Frustum in the model's world space (e.g. updated with projection * view * model)
+		*/
+		void cull(const vks::Frustum &frustum)
+		{
+			const std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+			cullingStatistics = CullingStatistics();
+			for (Primitive *primitive : bvh.visiblePrimitives) {
+				primitive->visible = false;
+			}
+			bvh.visiblePrimitives.clear();
+			bvh.stack.clear();
+			if (!bvh.nodes.empty()) {
+				bvh.stack.push_back(std::make_pair(0u, static_cast<uint32_t>(vks::Frustum::ALL_PLANES)));
+			}
+			while (!bvh.stack.empty()) {
+				const uint32_t index = bvh.stack.back().first;
+				uint32_t planeMask = bvh.stack.back().second;
+				bvh.stack.pop_back();
+				const BoundingVolumeHierarchy::BVHNode &bvhNode = bvh.nodes[index];
+				if (planeMask != 0) {
+					cullingStatistics.tested++;
+					if (frustum.classifyAABB(bvhNode.bounds.min, bvhNode.bounds.max, planeMask) == vks::Frustum::OUTSIDE) {
+						continue;
+					}
+				}
+				if (bvhNode.count == 0) {
+					bvh.stack.push_back(std::make_pair(bvhNode.first + 1, planeMask));
+					bvh.stack.push_back(std::make_pair(bvhNode.first, planeMask));
+					continue;
+				}
+				for (uint32_t i = 0; i < bvhNode.count; i++) {
+					Node *node = bvh.items[bvhNode.first + i];
+					uint32_t nodeMask = planeMask;
+					// The bounds of a single node leaf or a single primitive mesh have already been tested
+					if ((nodeMask != 0) && (bvhNode.count > 1) && (node->mesh->primitives.size() > 1)) {
+						cullingStatistics.tested++;
+						if (frustum.classifyAABB(node->bounds.min, node->bounds.max, nodeMask) == vks::Frustum::OUTSIDE) {
+							continue;
+						}
+					}
+					for (Primitive *primitive : node->mesh->primitives) {
+						uint32_t primitiveMask = nodeMask;
+						if ((primitiveMask != 0) && ((bvhNode.count > 1) || (node->mesh->primitives.size() > 1))) {
+							cullingStatistics.tested++;
+							if (frustum.classifyAABB(primitive->bounds.min, primitive->bounds.max, primitiveMask) == vks::Frustum::OUTSIDE) {
+								continue;
 							}
+						}
+						primitive->visible = true;
+						bvh.visiblePrimitives.push_back(primitive);
+					}
+				}
+			}
+			cullingStatistics.visible = static_cast<uint32_t>(bvh.visiblePrimitives.size());
+			cullingStatistics.culled = bvh.primitiveCount - cullingStatistics.visible;
+			cullingStatistics.time = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		}
+
+		/**
+		* Assign the joints of all skinned meshes to consecutive ranges of the joint palette and create its buffer
+		*
+		* @note Ranges follow the hierarchy order, so meshes updated in the same pass are written as contiguous blocks
+		*/
+		void setupJointPalette()
+		{
+			jointPalette.buffer.destroy();
+			jointPalette.matrices.clear();
+			jointPalette.ranges.clear();
+			for (Node *node : sortedNodes) {
+				if (!node->mesh || !node->skin || node->skin->joints.empty()) {
+					continue;
+				}
+				Skin *skin = node->skin;
+				// Inverse bind matrices are optional and default to identity
+				if (skin->inverseBindMatrices.size() < skin->joints.size()) {
+					skin->inverseBindMatrices.resize(skin->joints.size(), glm::mat4(1.0f));
+				}
+				JointPalette::Range range{};
+				range.offset = static_cast<uint32_t>(jointPalette.matrices.size());
+				range.count = static_cast<uint32_t>(skin->joints.size());
+				range.version = 1;
+				node->mesh->jointRange = static_cast<uint32_t>(jointPalette.ranges.size());
+				node->mesh->uniformBlock.jointOffset = range.offset;
+				node->mesh->uniformBlock.jointCount = range.count;
+				memcpy(node->mesh->uniformBuffer.mapped, &node->mesh->uniformBlock, sizeof(node->mesh->uniformBlock));
+				jointPalette.ranges.push_back(range);
+				jointPalette.matrices.resize(jointPalette.matrices.size() + range.count, glm::mat4(1.0f));
+			}
+			jointPalette.sliceCount = std::max(framesInFlight, 1u);
+			jointPalette.currentSlice = 0;
+			jointPalette.sliceVersions.assign(jointPalette.sliceCount * jointPalette.ranges.size(), 0);
+			if (jointPalette.matrices.empty()) {
+				return;
+			}
+			const VkDeviceSize alignment = std::max(device->properties.limits.minStorageBufferOffsetAlignment, static_cast<VkDeviceSize>(1));
+			jointPalette.sliceSize = (jointPalette.matrices.size() * sizeof(glm::mat4) + alignment - 1) / alignment * alignment;
+			// Written by the host every frame and read once per vertex shader invocation, so it stays in host visible memory
+			VK_CHECK_RESULT(device->createBuffer(
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
+				&jointPalette.buffer,
+				jointPalette.sliceSize * jointPalette.sliceCount));
+			VK_CHECK_RESULT(jointPalette.buffer.map());
+			jointPalette.buffer.setupDescriptor(jointPalette.sliceSize);
+		}
+
+		/** @brief Select the joint palette slice of the given frame in flight and write all ranges that changed since it was last used */
+		void setJointPaletteFrame(uint32_t frameIndex)
+		{
+			jointPalette.currentSlice = frameIndex % jointPalette.sliceCount;
+			uploadJointPalette();
+		}
+
+		/** @brief Dynamic offset for the joint palette binding of the current frame (only if the model has a joint palette, see hasJointPalette) */
+		uint32_t jointPaletteDynamicOffset() const
+		{
+			return static_cast<uint32_t>(jointPalette.currentSlice * jointPalette.sliceSize);
+		}
+
+		/** @brief True if the model contains skinned meshes, in which case the descriptor set layout contains the dynamic joint palette binding */
+		bool hasJointPalette() const
+		{
+			return !jointPalette.ranges.empty();
+		}
+
+		/** @brief Write all joint ranges that are out of date in the current slice, adjacent ranges are merged into a single write and flush */
+		void uploadJointPalette()
+		{
+			jointPalette.statistics = JointPalette::Statistics();
+			if (!jointPalette.buffer.mapped) {
+				return;
+			}
+			const size_t rangeCount = jointPalette.ranges.size();
+			uint64_t *versions = &jointPalette.sliceVersions[jointPalette.currentSlice * rangeCount];
+			const VkDeviceSize sliceOffset = jointPalette.currentSlice * jointPalette.sliceSize;
+			size_t i = 0;
+			while (i < rangeCount) {
+				if (versions[i] == jointPalette.ranges[i].version) {
+					i++;
+					continue;
+				}
+				const uint32_t first = jointPalette.ranges[i].offset;
+				uint32_t count = 0;
+				while ((i < rangeCount) && (versions[i] != jointPalette.ranges[i].version)) {
+					versions[i] = jointPalette.ranges[i].version;
+					count += jointPalette.ranges[i].count;
+					jointPalette.statistics.rangesWritten++;
+					i++;
+				}
+				const VkDeviceSize offset = sliceOffset + first * sizeof(glm::mat4);
+				const VkDeviceSize size = count * sizeof(glm::mat4);
+				memcpy(static_cast<uint8_t*>(jointPalette.buffer.mapped) + offset, &jointPalette.matrices[first], size);
+				// Does nothing if the allocator placed the buffer in host coherent memory
+				VK_CHECK_RESULT(jointPalette.buffer.flush(size, offset));
+				jointPalette.statistics.writes++;
+				jointPalette.statistics.bytesWritten += size;
+			}
+		}
+
+		/**
+		* Create the multi-buffered host visible vertex buffer and the job system for host skinning (see cpuSkinning)
+		*
+		* @param vertexData Unskinned vertices of the whole model
+		* @param vertexCount Number of vertices
+		* @param loadingJobSystem Job system of the loader, used for skinning the initial pose
+		*/
+		void setupCpuSkinning(const Vertex *vertexData, size_t vertexCount, vks::JobSystem &loadingJobSystem)
+		{
+			CpuSkinningState &state = cpuSkinningState;
+			state.sourceVertices.assign(vertexData, vertexData + vertexCount);
+			state.ranges.clear();
+			for (Node *node : sortedNodes) {
+				if (!node->mesh || (node->mesh->uniformBlock.jointCount == 0)) {
+					continue;
+				}
+				Mesh *mesh = node->mesh;
+				const float jointCount = static_cast<float>(mesh->uniformBlock.jointCount);
+				for (Primitive *primitive : mesh->primitives) {
+					if (primitive->vertexCount == 0) {
+						continue;
+					}
+					// Joints outside of the skin are dropped instead of reading outside of the mesh's palette range
+					for (uint32_t i = 0; i < primitive->vertexCount; i++) {
+						Vertex &vertex = state.sourceVertices[primitive->firstVertex + i];
+						for (uint32_t k = 0; k < 4; k++) {
+							if (!((vertex.joint0[k] >= 0.0f) && (vertex.joint0[k] < jointCount))) {
+								vertex.joint0[k] = 0.0f;
+								vertex.weight0[k] = 0.0f;
 							}
-							updated = true;
 						}
 					}
+					state.ranges.push_back({ primitive->firstVertex, primitive->vertexCount, mesh->uniformBlock.jointOffset, mesh->jointRange });
 				}
+				// Shaders see the mesh as unskinned, the host copy keeps the joint count for the palette updates
+				const uint32_t shaderJointCount = 0;
+				memcpy(static_cast<uint8_t*>(mesh->uniformBuffer.mapped) + offsetof(Mesh::UniformBlock, jointCount), &shaderJointCount, sizeof(shaderJointCount));
 			}
-			if (updated) {
-				for (auto &node : nodes) {
-					node->update();
+			// One copy more than frames in flight, so the host can write the next copy while the device reads the others
+			state.copyCount = std::max(framesInFlight, 1u) + 1;
+			state.copySize = vertexCount * sizeof(Vertex);
+			state.currentCopy = 0;
+			state.copyVersions.assign(state.copyCount * jointPalette.ranges.size(), 0);
+			VK_CHECK_RESULT(device->createBuffer(
+				VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
+				&vertices,
+				state.copySize * state.copyCount));
+			VK_CHECK_RESULT(vertices.map());
+			// Unskinned meshes are never written again
+			for (uint32_t i = 0; i < state.copyCount; i++) {
+				memcpy(static_cast<uint8_t*>(vertices.mapped) + i * state.copySize, state.sourceVertices.data(), state.copySize);
+			}
+			VK_CHECK_RESULT(vertices.flush());
+			// Initial pose
+			skinVertices(loadingJobSystem);
+		}
+
+		/**
+		* Skin all primitives whose joints changed since the copy after the current one was written into that copy and make it the current one
+		*
+		* @note Called by updateTransforms, does nothing if host skinning is disabled or no joints changed since the last update
+		*/
+		void skinVertices()
+		{
+			cpuSkinningState.statistics = CpuSkinningState::Statistics();
+			if (cpuSkinningState.copyCount == 0) {
+				return;
+			}
+			// Created on first use, so models that are never animated don't start worker threads
+			if (!cpuSkinningState.jobSystem) {
+				cpuSkinningState.jobSystem.reset(new vks::JobSystem(cpuSkinningThreadCount));
+			}
+			skinVertices(*cpuSkinningState.jobSystem);
+		}
+
+		void skinVertices(vks::JobSystem &jobSystem)
+		{
+			CpuSkinningState &state = cpuSkinningState;
+			const std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+			const size_t rangeCount = jointPalette.ranges.size();
+			const uint64_t *currentVersions = &state.copyVersions[state.currentCopy * rangeCount];
+			bool changed = false;
+			for (size_t r = 0; r < rangeCount; r++) {
+				changed |= (currentVersions[r] != jointPalette.ranges[r].version);
+			}
+			if (!changed) {
+				return;
+			}
+			const uint32_t copy = (state.currentCopy + 1) % state.copyCount;
+			uint64_t *versions = &state.copyVersions[copy * rangeCount];
+			std::vector<const VertexSkinning::Range*> &pending = state.pending;
+			std::vector<size_t> &pendingStart = state.pendingStart;
+			pending.clear();
+			pendingStart.clear();
+			size_t vertexCount = 0;
+			for (const VertexSkinning::Range &range : state.ranges) {
+				if (versions[range.jointRange] != jointPalette.ranges[range.jointRange].version) {
+					pending.push_back(&range);
+					pendingStart.push_back(vertexCount);
+					vertexCount += range.vertexCount;
+				}
+			}
+			const Vertex *source = state.sourceVertices.data();
+			Vertex *target = reinterpret_cast<Vertex*>(static_cast<uint8_t*>(vertices.mapped) + copy * state.copySize);
+			const vks::simd::Path path = vks::simd::activePath(cpuSkinningSimdPath);
+			// Work is split by vertices instead of primitives, so a single large primitive is spread across all threads
+			jobSystem.parallelForRange(vertexCount, [&](size_t begin, size_t end) {
+				size_t p = std::upper_bound(pendingStart.begin(), pendingStart.end(), begin) - pendingStart.begin() - 1;
+				while (begin < end) {
+					const VertexSkinning::Range &range = *pending[p];
+					const size_t first = range.firstVertex + (begin - pendingStart[p]);
+					const size_t count = std::min(end, pendingStart[p] + range.vertexCount) - begin;
+					VertexSkinning::skin(source + first, target + first, count, &jointPalette.matrices[range.jointOffset], path);
+					begin += count;
+					p++;
 				}
+			}, 1024);
+			for (size_t r = 0; r < rangeCount; r++) {
+				versions[r] = jointPalette.ranges[r].version;
 			}
+			// Does nothing if the allocator placed the buffer in host coherent memory
+			VK_CHECK_RESULT(vertices.flush(state.copySize, copy * state.copySize));
+			state.currentCopy = copy;
+			state.statistics.primitives = static_cast<uint32_t>(pending.size());
+			state.statistics.vertices = static_cast<uint32_t>(vertexCount);
+			state.statistics.time = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		}
+
+		/** @brief Offset of the vertex buffer copy to bind, non-zero only if host skinning is used (see cpuSkinning) */
+		VkDeviceSize vertexBufferOffset() const
+		{
+			return cpuSkinningState.currentCopy * cpuSkinningState.copySize;
+		}
+
+		/**
+		* Build the flattened draw list and create the buffers and the descriptor set for drawIndirect (see indirectDraw)
+		*
+		* @note Static data is added to the pending uploads of the device's upload manager
+		*/
+		void setupIndirectDraw()
+		{
+			indirect.commands.clear();
+			indirect.draws.clear();
+			uint32_t matrixCount = 0;
+			for (Node *node : sortedNodes) {
+				if (!node->mesh) {
+					continue;
+				}
+				Mesh *mesh = node->mesh;
+				mesh->matrixIndex = matrixCount++;
+				mesh->firstDraw = static_cast<uint32_t>(indirect.draws.size());
+				for (Primitive *primitive : mesh->primitives) {
+					if (primitive->indexCount == 0) {
+						continue;
+					}
+					VkDrawIndexedIndirectCommand command{};
+					command.indexCount = primitive->indexCount;
+					command.instanceCount = 1;
+					command.firstIndex = primitive->firstIndex;
+					command.vertexOffset = 0;
+					command.firstInstance = static_cast<uint32_t>(indirect.draws.size());
+					indirect.commands.push_back(command);
+					IndirectDraw::DrawData draw{};
+					draw.matrixIndex = mesh->matrixIndex;
+					draw.materialIndex = static_cast<uint32_t>(&primitive->material - materials.data());
+					draw.jointOffset = mesh->uniformBlock.jointOffset;
+					// Meshes skinned on the host are drawn unskinned (see cpuSkinning)
+					draw.jointCount = (cpuSkinningState.copyCount > 0) ? 0 : mesh->uniformBlock.jointCount;
+					draw.positionScale = mesh->uniformBlock.positionScale;
+					draw.positionOffset = mesh->uniformBlock.positionOffset;
+					indirect.draws.push_back(draw);
+				}
+			}
+			if (indirect.commands.empty()) {
+				return;
+			}
+			auto textureIndex = [this](const Texture *texture) {
+				return texture ? static_cast<int32_t>(texture - textures.data()) : -1;
+			};
+			std::vector<IndirectDraw::MaterialData> materialData;
+			for (const Material &material : materials) {
+				IndirectDraw::MaterialData data{};
+				data.baseColorFactor = material.baseColorFactor;
+				data.baseColorTexture = textureIndex(material.baseColorTexture);
+				data.normalTexture = textureIndex(material.normalTexture);
+				data.metallicRoughnessTexture = textureIndex(material.metallicRoughnessTexture);
+				data.alphaCutoff = material.alphaCutoff;
+				materialData.push_back(data);
+			}
+			if (materialData.empty()) {
+				materialData.push_back(IndirectDraw::MaterialData{ glm::vec4(1.0f), -1, -1, -1, 1.0f });
+			}
+			const uint32_t drawCount = static_cast<uint32_t>(indirect.commands.size());
+
+			// Commands and matrices are changed by the host, draw data, materials and the draw count only once here
+			VK_CHECK_RESULT(device->createBuffer(
+				VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+				&indirect.commandsBuffer,
+				drawCount * sizeof(VkDrawIndexedIndirectCommand)));
+			VK_CHECK_RESULT(indirect.commandsBuffer.map());
+			updateIndirectCommands();
+			VK_CHECK_RESULT(device->createBuffer(
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+				&indirect.matricesBuffer,
+				matrixCount * sizeof(glm::mat4)));
+			VK_CHECK_RESULT(indirect.matricesBuffer.map());
+			for (Node *node : sortedNodes) {
+				if (node->mesh) {
+					memcpy(static_cast<glm::mat4*>(indirect.matricesBuffer.mapped) + node->mesh->matrixIndex, &node->mesh->uniformBlock.matrix, sizeof(glm::mat4));
+				}
+			}
+			const VkDeviceSize drawsSize = indirect.draws.size() * sizeof(IndirectDraw::DrawData);
+			const VkDeviceSize materialsSize = materialData.size() * sizeof(IndirectDraw::MaterialData);
+			VK_CHECK_RESULT(device->createBuffer(VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &indirect.drawsBuffer, drawsSize));
+			VK_CHECK_RESULT(device->createBuffer(VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &indirect.materialsBuffer, materialsSize));
+			VK_CHECK_RESULT(device->createBuffer(VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &indirect.countBuffer, sizeof(uint32_t)));
+			device->uploadManager.uploadBuffer(indirect.drawsBuffer.buffer, indirect.draws.data(), drawsSize);
+			device->uploadManager.uploadBuffer(indirect.materialsBuffer.buffer, materialData.data(), materialsSize);
+			device->uploadManager.uploadBuffer(indirect.countBuffer.buffer, &drawCount, sizeof(uint32_t));
+			indirect.drawsBuffer.setupDescriptor();
+			indirect.matricesBuffer.setupDescriptor();
+			indirect.materialsBuffer.setupDescriptor();
+
+			if (device->extensionEnabled(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME)) {
+				indirect.vkCmdDrawIndexedIndirectCountKHR = reinterpret_cast<PFN_vkCmdDrawIndexedIndirectCountKHR>(vkGetDeviceProcAddr(device->logicalDevice, "vkCmdDrawIndexedIndirectCountKHR"));
+			}
+
+			// Descriptors
+			const uint32_t textureCount = static_cast<uint32_t>(textures.size());
+			std::vector<VkDescriptorPoolSize> poolSizes = {
+				vks::initializers::descriptorPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 3),
+			};
+			std::vector<VkDescriptorSetLayoutBinding> setLayoutBindings = {
+				vks::initializers::descriptorSetLayoutBinding(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0),
+				vks::initializers::descriptorSetLayoutBinding(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT, 1),
+				vks::initializers::descriptorSetLayoutBinding(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 2),
+			};
+			if (textureCount > 0) {
+				poolSizes.push_back(vks::initializers::descriptorPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, textureCount));
+				setLayoutBindings.push_back(vks::initializers::descriptorSetLayoutBinding(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, 3, textureCount));
+			}
+			if (hasJointPalette()) {
+				poolSizes.push_back(vks::initializers::descriptorPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 1));
+				setLayoutBindings.push_back(vks::initializers::descriptorSetLayoutBinding(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, VK_SHADER_STAGE_VERTEX_BIT, 4));
+			}
+			VkDescriptorPoolCreateInfo descriptorPoolCI = vks::initializers::descriptorPoolCreateInfo(static_cast<uint32_t>(poolSizes.size()), poolSizes.data(), 1);
+			VK_CHECK_RESULT(vkCreateDescriptorPool(device->logicalDevice, &descriptorPoolCI, nullptr, &indirect.descriptorPool));
+			VkDescriptorSetLayoutCreateInfo descriptorLayoutCI = vks::initializers::descriptorSetLayoutCreateInfo(setLayoutBindings.data(), static_cast<uint32_t>(setLayoutBindings.size()));
+			VK_CHECK_RESULT(vkCreateDescriptorSetLayout(device->logicalDevice, &descriptorLayoutCI, nullptr, &indirect.descriptorSetLayout));
+			VkDescriptorSetAllocateInfo descriptorSetAllocInfo = vks::initializers::descriptorSetAllocateInfo(indirect.descriptorPool, &indirect.descriptorSetLayout, 1);
+			VK_CHECK_RESULT(vkAllocateDescriptorSets(device->logicalDevice, &descriptorSetAllocInfo, &indirect.descriptorSet));
+			std::vector<VkWriteDescriptorSet> writeDescriptorSets = {
+				vks::initializers::writeDescriptorSet(indirect.descriptorSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 0, &indirect.drawsBuffer.descriptor),
+				vks::initializers::writeDescriptorSet(indirect.descriptorSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, &indirect.matricesBuffer.descriptor),
+				vks::initializers::writeDescriptorSet(indirect.descriptorSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2, &indirect.materialsBuffer.descriptor),
+			};
+			std::vector<VkDescriptorImageInfo> textureDescriptors;
+			for (const Texture &texture : textures) {
+				textureDescriptors.push_back(texture.descriptor);
+			}
+			if (textureCount > 0) {
+				writeDescriptorSets.push_back(vks::initializers::writeDescriptorSet(indirect.descriptorSet, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 3, textureDescriptors.data(), textureCount));
+			}
+			if (hasJointPalette()) {
+				writeDescriptorSets.push_back(vks::initializers::writeDescriptorSet(indirect.descriptorSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 4, &jointPalette.buffer.descriptor));
+			}
+			vkUpdateDescriptorSets(device->logicalDevice, static_cast<uint32_t>(writeDescriptorSets.size()), writeDescriptorSets.data(), 0, nullptr);
 		}
 
 		/*
@@ -1327,15 +3877,14 @@ namespace vkglTF
 				descriptorSetAllocInfo.descriptorSetCount = 1;
 				VK_CHECK_RESULT(vkAllocateDescriptorSets(device->logicalDevice, &descriptorSetAllocInfo, &node->mesh->uniformBuffer.descriptorSet));
 
-				VkWriteDescriptorSet writeDescriptorSet{};
-				writeDescriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-				writeDescriptorSet.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-				writeDescriptorSet.descriptorCount = 1;
-				writeDescriptorSet.dstSet = node->mesh->uniformBuffer.descriptorSet;
-				writeDescriptorSet.dstBinding = 0;
-				writeDescriptorSet.pBufferInfo = &node->mesh->uniformBuffer.descriptor;
-
-				vkUpdateDescriptorSets(device->logicalDevice, 1, &writeDescriptorSet, 0, nullptr);
+				std::vector<VkWriteDescriptorSet> writeDescriptorSets = {
+					vks::initializers::writeDescriptorSet(node->mesh->uniformBuffer.descriptorSet, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 0, &node->mesh->uniformBuffer.descriptor),
+				};
+				// Meshes without skin still need a valid palette descriptor as the binding is part of the layout
+				if (hasJointPalette()) {
+					writeDescriptorSets.push_back(vks::initializers::writeDescriptorSet(node->mesh->uniformBuffer.descriptorSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 1, &jointPalette.buffer.descriptor));
+				}
+				vkUpdateDescriptorSets(device->logicalDevice, static_cast<uint32_t>(writeDescriptorSets.size()), writeDescriptorSets.data(), 0, nullptr);
 			}
 			for (auto& child : node->children) {
 				prepareNodeDescriptor(child, descriptorSetLayout);
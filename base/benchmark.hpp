@@ -6,31 +6,409 @@
 * This code is licensed under the MIT license (MIT) (http://opensource.org/licenses/MIT)
 */
 
+#pragma once
+
 #include <vector>
+#include <utility>
 #include <string>
 #include <algorithm>
 #include <limits>
 #include <functional>
 #include <chrono>
 #include <iomanip>
+#include <numeric>
+#include <sstream>
+#include <fstream>
+#include <math.h>
+#include <time.h>
+
+#include "vulkan/vulkan.h"
+#include "VulkanDevice.hpp"
 
 namespace vks
 {
 	class Benchmark {
+	public:
+		/** @brief Summary of a series of per-frame measurements in ms */
+		struct Statistics {
+			size_t count = 0;
+			double min = 0.0;
+			double max = 0.0;
+			double mean = 0.0;
+			double stddev = 0.0;
+			double p50 = 0.0;
+			double p90 = 0.0;
+			double p99 = 0.0;
+			double p999 = 0.0;
+			/** @brief Number of frames taking longer than stutterFactor times the median */
+			uint32_t stutters = 0;
+			/** @brief Frame counts per histogram bucket, bucket i holds frames up to histogramBucketLimit(i) ms */
+			std::vector<uint32_t> histogram;
+		};
+
+		/** @brief Number of histogram buckets, the limits double with every bucket starting at 1/8 ms, the last one takes all longer frames */
+		static const uint32_t HISTOGRAM_BUCKETS = 16;
+
+		/** @brief Upper limit of a histogram bucket in ms */
+		static double histogramBucketLimit(uint32_t bucket)
+		{
+			return (bucket < HISTOGRAM_BUCKETS - 1) ? ldexp(0.125, bucket) : std::numeric_limits<double>::infinity();
+		}
+
 	private:
 		FILE *stream;
 		VkPhysicalDeviceProperties deviceProps;
+
+		// GPU timing uses timestamps written at the start and the end of the frame's command buffer, so the time the GPU waits for the CPU
+		// (or the swap chain) between submissions is not included. There is one pair of queries per command buffer the frames are recorded to.
+		struct GpuTimerSlot {
+			/** @brief Set once the timestamps have been recorded into the slot's command buffer, examples with their own recording may not write them */
+			bool recorded = false;
+			bool submitted = false;
+			bool measured = false;
+		};
+		struct {
+			vks::VulkanDevice *device = nullptr;
+			VkQueryPool queryPool = VK_NULL_HANDLE;
+			std::vector<GpuTimerSlot> slots;
+			uint64_t timestampMask = 0;
+		} gpuTimer;
+		bool measuring = false;
+
+		static Benchmark *&currentInstance()
+		{
+			static Benchmark *instance = nullptr;
+			return instance;
+		}
+
+		/** @brief CPU time consumed by all threads of the process in ms */
+		static double processCpuTime()
+		{
+#if defined(_WIN32)
+			FILETIME creationTime, exitTime, kernelTime, userTime;
+			if (!GetProcessTimes(GetCurrentProcess(), &creationTime, &exitTime, &kernelTime, &userTime)) {
+				return 0.0;
+			}
+			auto toMs = [](const FILETIME &t) { return (double)((uint64_t(t.dwHighDateTime) << 32) | t.dwLowDateTime) / 10000.0; };
+			return toMs(kernelTime) + toMs(userTime);
+#else
+			timespec t;
+			clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &t);
+			return (double)t.tv_sec * 1000.0 + (double)t.tv_nsec / 1000000.0;
+#endif
+		}
+
+		/** @brief Waits for the frames still in flight and reads their GPU times before the query pool is destroyed */
+		void destroyGpuTimer()
+		{
+			if (!gpuTimer.device) {
+				return;
+			}
+			VK_CHECK_RESULT(vkDeviceWaitIdle(gpuTimer.device->logicalDevice));
+			for (uint32_t i = 0; i < static_cast<uint32_t>(gpuTimer.slots.size()); i++) {
+				collectGpuFrame(i);
+			}
+			vkDestroyQueryPool(gpuTimer.device->logicalDevice, gpuTimer.queryPool, nullptr);
+			gpuTimer.slots.clear();
+			gpuTimer.device = nullptr;
+		}
+
+		static std::string jsonString(const std::string &value)
+		{
+			std::stringstream ss;
+			ss << "\"";
+			for (char c : value) {
+				switch (c) {
+				case '"': ss << "\\\""; break;
+				case '\\': ss << "\\\\"; break;
+				case '\n': ss << "\\n"; break;
+				case '\t': ss << "\\t"; break;
+				default:
+					if ((unsigned char)c < 0x20) {
+						ss << "\\u" << std::hex << std::setw(4) << std::setfill('0') << (int)c << std::dec << std::setfill(' ');
+					} else {
+						ss << c;
+					}
+				}
+			}
+			ss << "\"";
+			return ss.str();
+		}
+
+		static void writeStatistics(std::ostream &os, const std::string &name, const Statistics &stats, bool last)
+		{
+			os << "    " << jsonString(name) << ": {" << std::endl;
+			os << "      \"count\": " << stats.count << "," << std::endl;
+			os << "      \"min\": " << stats.min << ", \"max\": " << stats.max << ", \"mean\": " << stats.mean << ", \"stddev\": " << stats.stddev << "," << std::endl;
+			os << "      \"p50\": " << stats.p50 << ", \"p90\": " << stats.p90 << ", \"p99\": " << stats.p99 << ", \"p99_9\": " << stats.p999 << "," << std::endl;
+			os << "      \"stutters\": " << stats.stutters << "," << std::endl;
+			os << "      \"histogram\": [";
+			for (uint32_t i = 0; i < stats.histogram.size(); i++) {
+				os << (i > 0 ? ", " : "") << "{\"le\": ";
+				if (i < HISTOGRAM_BUCKETS - 1) {
+					os << histogramBucketLimit(i);
+				} else {
+					os << "null";
+				}
+				os << ", \"frames\": " << stats.histogram[i] << "}";
+			}
+			os << "]" << std::endl;
+			os << "    }" << (last ? "" : ",") << std::endl;
+		}
+
+		static void writeArray(std::ostream &os, const std::string &name, const std::vector<double> &values, bool last)
+		{
+			os << "  " << jsonString(name) << ": [";
+			for (size_t i = 0; i < values.size(); i++) {
+				os << (i > 0 ? ", " : "") << values[i];
+			}
+			os << "]" << (last ? "" : ",") << std::endl;
+		}
+
+		void printStatistics(const std::string &name, const Statistics &stats, const std::string &unit = "ms")
+		{
+			if (stats.count == 0) {
+				return;
+			}
+			const std::string u = " " + unit;
+			std::cout << name << "mean " << stats.mean << u << ", stddev " << stats.stddev << u << ", min " << stats.min << u << ", max " << stats.max << u << std::endl;
+			std::cout << std::string(name.size(), ' ') << "p50 " << stats.p50 << u << ", p90 " << stats.p90 << u << ", p99 " << stats.p99 << u << ", p99.9 " << stats.p999 << u << ", " << stats.stutters << " stutter(s)" << std::endl;
+		}
+
 	public:
 		bool active = false;
 		bool outputFrameTimes = false;
 		uint32_t warmup = 1;
 		uint32_t duration = 10;
+		/** @brief If not zero, the benchmark runs for exactly this number of frames instead of a fixed duration */
+		uint32_t frameLimit = 0;
+		/** @brief Frames taking longer than this factor times the median frame time count as stutters */
+		double stutterFactor = 2.0;
+		/** @brief Wall clock time of each frame in ms */
 		std::vector<double> frameTimes;
+		/** @brief CPU time consumed by the process (all threads) during each frame in ms */
+		std::vector<double> cpuTimes;
+		/** @brief GPU time of each frame from timestamp queries in ms, empty if the queue does not support timestamps */
+		std::vector<double> gpuTimes;
+		/** @brief Results are written as JSON if the file name ends with ".json", as CSV otherwise */
 		std::string filename = "";
 
 		double runtime = 0.0;
 		uint32_t frameCount = 0;
 
+		/** @brief Time from the start of the example's preparation until the first frame in ms (set by the example base) */
+		double startupTime = 0.0;
+		/** @brief True if the pipeline cache was loaded from disk (warm start), false if all pipelines had to be compiled (cold start) */
+		bool pipelineCacheWarm = false;
+
+		/** @brief Information about the run stored with the results (set by the example base) */
+		std::string exampleName;
+		uint32_t width = 0;
+		uint32_t height = 0;
+		bool validation = false;
+		bool headless = false;
+		/** @brief Number of frames the CPU could prepare ahead of the GPU during the run */
+		uint32_t framesInFlight = 1;
+		/** @brief Keep the UI overlay enabled while measuring, its CPU time per frame is reported as the "ui" series */
+		bool overlay = false;
+		/** @brief Overlay refresh rate in Hz used during the run (0 if the overlay was rebuilt every frame) */
+		float overlayRefreshRate = 0.0f;
+		/** @brief Example specific configuration that was measured (e.g. one of several code paths), set by the example */
+		std::string variant;
+
+		/** @brief Example specific value measured once per frame (e.g. a counter or the time spent in one part of the frame) */
+		struct Series {
+			std::string name;
+			std::string unit;
+			std::vector<double> values;
+		};
+		/** @brief Example specific series, reported with the frame, cpu and gpu statistics under their name */
+		std::vector<Series> series;
+
+		/** @brief Loading time of an asset split into named phases in ms, reported by the asset loaders (e.g. vkglTF::Model) */
+		struct AssetLoad {
+			std::string name;
+			/** @brief True if the asset has been loaded from a cache instead of its source */
+			bool cached = false;
+			double total = 0.0;
+			std::vector<std::pair<std::string, double>> phases;
+		};
+		/** @brief Assets loaded while the benchmark was current, in loading order */
+		std::vector<AssetLoad> assetLoads;
+
+		/**
+		* Benchmark asset loaders report their loading times to
+		*
+		* @return The benchmark of the running example if it has been started with --benchmark, nullptr otherwise
+		*/
+		static Benchmark *current()
+		{
+			return currentInstance();
+		}
+
+		/** @brief Set by the example base when benchmarking is enabled, so assets loaded during preparation are reported */
+		static void setCurrent(Benchmark *benchmark)
+		{
+			currentInstance() = benchmark;
+		}
+
+		/** @brief Add the loading times of an asset to the results */
+		void recordAssetLoad(const AssetLoad &assetLoad)
+		{
+			assetLoads.push_back(assetLoad);
+		}
+
+		/**
+		* Add the value of the current frame to an example specific series, ignored outside of the measured frames
+		*
+		* @param name Name of the series, must differ from "frame", "cpu" and "gpu"
+		* @param value Value of the current frame
+		* @param unit Unit of the value for the printed statistics
+		*/
+		void record(const std::string &name, double value, const std::string &unit = "ms")
+		{
+			if (!measuring) {
+				return;
+			}
+			for (Series &s : series) {
+				if (s.name == name) {
+					s.values.push_back(value);
+					return;
+				}
+			}
+			Series s;
+			s.name = name;
+			s.unit = unit;
+			s.values.reserve(frameLimit);
+			s.values.push_back(value);
+			series.push_back(s);
+		}
+
+		/** @brief Calculate the statistics for a series of measurements */
+		Statistics calculateStatistics(const std::vector<double> &values) const
+		{
+			Statistics stats;
+			stats.count = values.size();
+			stats.histogram.resize(HISTOGRAM_BUCKETS, 0);
+			if (values.empty()) {
+				return stats;
+			}
+			std::vector<double> sorted(values);
+			std::sort(sorted.begin(), sorted.end());
+			// Nearest rank percentiles
+			auto percentile = [&sorted](double p) {
+				size_t rank = static_cast<size_t>(ceil(p / 100.0 * (double)sorted.size()));
+				return sorted[std::min(std::max(rank, (size_t)1), sorted.size()) - 1];
+			};
+			stats.min = sorted.front();
+			stats.max = sorted.back();
+			stats.mean = std::accumulate(sorted.begin(), sorted.end(), 0.0) / (double)sorted.size();
+			double variance = 0.0;
+			for (double value : sorted) {
+				variance += (value - stats.mean) * (value - stats.mean);
+			}
+			stats.stddev = sqrt(variance / (double)sorted.size());
+			stats.p50 = percentile(50.0);
+			stats.p90 = percentile(90.0);
+			stats.p99 = percentile(99.0);
+			stats.p999 = percentile(99.9);
+			for (double value : values) {
+				if (value > stats.p50 * stutterFactor) {
+					stats.stutters++;
+				}
+				uint32_t bucket = 0;
+				while (value > histogramBucketLimit(bucket)) {
+					bucket++;
+				}
+				stats.histogram[bucket]++;
+			}
+			return stats;
+		}
+
+		/**
+		* Set up timestamp queries to measure the GPU time of each frame
+		*
+		* @param device Device the example runs on
+		* @param queueFamilyIndex Family of the queue the example submits its frames to
+		* @param slotCount Number of command buffers the frames are recorded to (one per swap chain image for prebuilt command buffers)
+		*
+		* @note Must be called before the command buffers are recorded, does nothing if the queue family does not support timestamps
+		*/
+		void prepareGpuTimer(vks::VulkanDevice *device, uint32_t queueFamilyIndex, uint32_t slotCount)
+		{
+			const uint32_t validBits = device->queueFamilyProperties[queueFamilyIndex].timestampValidBits;
+			if ((validBits == 0) || (device->properties.limits.timestampPeriod == 0.0f)) {
+				std::cout << "GPU timestamps are not supported by the queue, GPU times will not be recorded" << std::endl;
+				return;
+			}
+			gpuTimer.device = device;
+			gpuTimer.timestampMask = (validBits >= 64) ? ~0ull : ((1ull << validBits) - 1);
+			gpuTimer.slots.resize(slotCount);
+			VkQueryPoolCreateInfo queryPoolCI = {};
+			queryPoolCI.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+			queryPoolCI.queryType = VK_QUERY_TYPE_TIMESTAMP;
+			queryPoolCI.queryCount = slotCount * 2;
+			VK_CHECK_RESULT(vkCreateQueryPool(device->logicalDevice, &queryPoolCI, nullptr, &gpuTimer.queryPool));
+		}
+
+		/**
+		* Write the start timestamp of a frame into the frame's command buffer
+		*
+		* @param commandBuffer Command buffer the frame is recorded to, right after it has been begun (outside of a render pass)
+		* @param slot Index of the command buffer, e.g. the swap chain image index of a prebuilt command buffer
+		*/
+		void beginGpuFrame(VkCommandBuffer commandBuffer, uint32_t slot)
+		{
+			if (!gpuTimer.device || (slot >= gpuTimer.slots.size())) {
+				return;
+			}
+			vkCmdResetQueryPool(commandBuffer, gpuTimer.queryPool, slot * 2, 2);
+			vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, gpuTimer.queryPool, slot * 2);
+			gpuTimer.slots[slot].recorded = true;
+		}
+
+		/** @brief Write the end timestamp of a frame into the frame's command buffer, right before it is ended */
+		void endGpuFrame(VkCommandBuffer commandBuffer, uint32_t slot)
+		{
+			if (!gpuTimer.device || (slot >= gpuTimer.slots.size())) {
+				return;
+			}
+			// Waits for all previous commands of the command buffer to finish
+			vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, gpuTimer.queryPool, slot * 2 + 1);
+		}
+
+		/** @brief Called by the example base after the command buffer with the given slot has been submitted for a frame */
+		void submitGpuFrame(uint32_t slot)
+		{
+			if (!gpuTimer.device || (slot >= gpuTimer.slots.size())) {
+				return;
+			}
+			gpuTimer.slots[slot].submitted = true;
+			gpuTimer.slots[slot].measured = measuring;
+		}
+
+		/**
+		* Read the GPU time of the last frame submitted with the given slot
+		*
+		* @note Called by the example base once the frame's fence has been waited on, before the slot's command buffer is submitted again
+		*/
+		void collectGpuFrame(uint32_t slot)
+		{
+			if (!gpuTimer.device || (slot >= gpuTimer.slots.size()) || !gpuTimer.slots[slot].submitted) {
+				return;
+			}
+			GpuTimerSlot &timerSlot = gpuTimer.slots[slot];
+			timerSlot.submitted = false;
+			if (!timerSlot.measured || !timerSlot.recorded) {
+				return;
+			}
+			uint64_t timestamps[2];
+			if (vkGetQueryPoolResults(gpuTimer.device->logicalDevice, gpuTimer.queryPool, slot * 2, 2, sizeof(timestamps), timestamps, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) == VK_SUCCESS) {
+				const uint64_t ticks = (timestamps[1] - timestamps[0]) & gpuTimer.timestampMask;
+				gpuTimes.push_back((double)ticks * (double)deviceProps.limits.timestampPeriod / 1000000.0);
+			}
+		}
+
 		void run(std::function<void()> renderFunc, VkPhysicalDeviceProperties deviceProps) {
 			active = true;
 			this->deviceProps = deviceProps;
@@ -54,42 +432,207 @@ namespace vks
 
 			// Benchmark phase
 			{
-				while (runtime < (duration * 1000.0)) {
+				measuring = true;
+				frameTimes.reserve(frameLimit);
+				cpuTimes.reserve(frameLimit);
+				while ((frameLimit > 0) ? (frameCount < frameLimit) : (runtime < (duration * 1000.0))) {
+					const double cpuStart = processCpuTime();
 					auto tStart = std::chrono::high_resolution_clock::now();
 					renderFunc();
 					auto tDiff = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - tStart).count();
+					cpuTimes.push_back(processCpuTime() - cpuStart);
 					runtime += tDiff;
 					frameTimes.push_back(tDiff);
 					frameCount++;
 				};
+				destroyGpuTimer();
+				measuring = false;
 				std::cout << "Benchmark finished" << std::endl;
 				std::cout << "device : " << deviceProps.deviceName << " (driver version: " << deviceProps.driverVersion << ")" << std::endl;
 				std::cout << "runtime: " << (runtime / 1000.0) << std::endl;
-				std::cout << "frames : " << frameCount << std::endl;
+				std::cout << "frames : " << frameCount << " (" << framesInFlight << " in flight)" << std::endl;
 				std::cout << "fps    : " << frameCount / (runtime / 1000.0) << std::endl;
+				if (!variant.empty()) {
+					std::cout << "variant: " << variant << std::endl;
+				}
+				if (overlay) {
+					if (overlayRefreshRate > 0.0f) {
+						std::cout << "overlay: " << overlayRefreshRate << " Hz refresh" << std::endl;
+					} else {
+						std::cout << "overlay: updated every frame" << std::endl;
+					}
+				}
+				std::cout << "startup: " << startupTime << " ms (" << (pipelineCacheWarm ? "warm" : "cold") << " pipeline cache)" << std::endl;
+				for (const AssetLoad &assetLoad : assetLoads) {
+					std::cout << "asset  : " << assetLoad.name << (assetLoad.cached ? " (cached)" : "") << " " << assetLoad.total << " ms" << std::endl;
+					std::cout << "         ";
+					for (size_t i = 0; i < assetLoad.phases.size(); i++) {
+						std::cout << (i > 0 ? ", " : "") << assetLoad.phases[i].first << " " << assetLoad.phases[i].second << " ms";
+					}
+					std::cout << std::endl;
+				}
+				printStatistics("frame  : ", calculateStatistics(frameTimes));
+				printStatistics("cpu    : ", calculateStatistics(cpuTimes));
+				printStatistics("gpu    : ", calculateStatistics(gpuTimes));
+				for (const Series &s : series) {
+					std::string name = s.name;
+					name.resize(std::max(name.size(), (size_t)7), ' ');
+					printStatistics(name + ": ", calculateStatistics(s.values), s.unit);
+				}
 			}
 		}
 
+		/** @brief Driver version decoded with the vendor specific scheme where known */
+		std::string driverVersionString() const
+		{
+			const uint32_t version = deviceProps.driverVersion;
+			std::stringstream ss;
+			if (deviceProps.vendorID == 0x10DE) {
+				// NVIDIA: 10.8.8.6 bits
+				ss << ((version >> 22) & 0x3ff) << "." << ((version >> 14) & 0xff) << "." << ((version >> 6) & 0xff) << "." << (version & 0x3f);
+			}
+#if defined(_WIN32)
+			else if (deviceProps.vendorID == 0x8086) {
+				// Intel on Windows: 18.14 bits
+				ss << (version >> 14) << "." << (version & 0x3fff);
+			}
+#endif
+			else {
+				ss << VK_VERSION_MAJOR(version) << "." << VK_VERSION_MINOR(version) << "." << VK_VERSION_PATCH(version);
+			}
+			return ss.str();
+		}
+
+		/** @brief Compiler, configuration and target of the current build */
+		static std::string buildConfiguration()
+		{
+			std::stringstream ss;
+#if defined(__clang__)
+			ss << "clang " << __clang_major__ << "." << __clang_minor__;
+#elif defined(__GNUC__)
+			ss << "gcc " << __GNUC__ << "." << __GNUC_MINOR__;
+#elif defined(_MSC_VER)
+			ss << "msvc " << _MSC_VER;
+#else
+			ss << "unknown compiler";
+#endif
+#if defined(NDEBUG)
+			ss << ", release";
+#else
+			ss << ", debug";
+#endif
+#if defined(__x86_64__) || defined(_M_X64)
+			ss << ", x86_64";
+#elif defined(__i386__) || defined(_M_IX86)
+			ss << ", x86";
+#elif defined(__aarch64__) || defined(_M_ARM64)
+			ss << ", arm64";
+#elif defined(__arm__) || defined(_M_ARM)
+			ss << ", arm";
+#endif
+#if defined(__AVX2__)
+			ss << ", avx2";
+#endif
+#if defined(VK_USE_PLATFORM_WIN32_KHR)
+			ss << ", win32";
+#elif defined(VK_USE_PLATFORM_ANDROID_KHR)
+			ss << ", android";
+#elif defined(VK_USE_PLATFORM_WAYLAND_KHR)
+			ss << ", wayland";
+#elif defined(VK_USE_PLATFORM_XCB_KHR)
+			ss << ", xcb";
+#elif defined(_DIRECT2DISPLAY)
+			ss << ", direct2display";
+#endif
+			return ss.str();
+		}
+
 		void saveResults() {
 			std::ofstream result(filename, std::ios::out);
 			if (result.is_open()) {
 				result << std::fixed << std::setprecision(4);
 
-				result << "device,driverversion,duration (ms),frames,fps" << std::endl;
-				result << deviceProps.deviceName << "," << deviceProps.driverVersion << "," << runtime << "," << frameCount << "," << frameCount / (runtime / 1000.0) << std::endl;
+				const bool json = (filename.size() >= 5) && (filename.compare(filename.size() - 5, 5, ".json") == 0);
+				if (json) {
+					result << "{" << std::endl;
+					result << "  \"example\": " << jsonString(exampleName) << "," << std::endl;
+					result << "  \"variant\": " << jsonString(variant) << "," << std::endl;
+					result << "  \"device\": {" << std::endl;
+					result << "    \"name\": " << jsonString(deviceProps.deviceName) << "," << std::endl;
+					result << "    \"vendorID\": " << deviceProps.vendorID << "," << std::endl;
+					result << "    \"deviceID\": " << deviceProps.deviceID << "," << std::endl;
+					result << "    \"type\": " << jsonString(vks::tools::physicalDeviceTypeString(deviceProps.deviceType)) << "," << std::endl;
+					result << "    \"apiVersion\": \"" << VK_VERSION_MAJOR(deviceProps.apiVersion) << "." << VK_VERSION_MINOR(deviceProps.apiVersion) << "." << VK_VERSION_PATCH(deviceProps.apiVersion) << "\"," << std::endl;
+					result << "    \"driverVersion\": " << deviceProps.driverVersion << "," << std::endl;
+					result << "    \"driver\": " << jsonString(driverVersionString()) << std::endl;
+					result << "  }," << std::endl;
+					result << "  \"build\": " << jsonString(buildConfiguration()) << "," << std::endl;
+					result << "  \"validation\": " << (validation ? "true" : "false") << "," << std::endl;
+					result << "  \"headless\": " << (headless ? "true" : "false") << "," << std::endl;
+					result << "  \"framesInFlight\": " << framesInFlight << "," << std::endl;
+					result << "  \"overlay\": " << (overlay ? "true" : "false") << "," << std::endl;
+					result << "  \"overlayRefreshRate\": " << overlayRefreshRate << "," << std::endl;
+					result << "  \"resolution\": { \"width\": " << width << ", \"height\": " << height << " }," << std::endl;
+					result << "  \"warmup\": " << warmup << "," << std::endl;
+					result << "  \"frameLimit\": " << frameLimit << "," << std::endl;
+					result << "  \"runtime\": " << runtime << "," << std::endl;
+					result << "  \"frames\": " << frameCount << "," << std::endl;
+					result << "  \"fps\": " << frameCount / (runtime / 1000.0) << "," << std::endl;
+					result << "  \"startup\": " << startupTime << "," << std::endl;
+					result << "  \"pipelineCache\": \"" << (pipelineCacheWarm ? "warm" : "cold") << "\"," << std::endl;
+					result << "  \"stutterFactor\": " << stutterFactor << "," << std::endl;
+					result << "  \"assets\": [";
+					for (size_t i = 0; i < assetLoads.size(); i++) {
+						const AssetLoad &assetLoad = assetLoads[i];
+						result << (i > 0 ? "," : "") << std::endl;
+						result << "    { \"name\": " << jsonString(assetLoad.name) << ", \"cached\": " << (assetLoad.cached ? "true" : "false") << ", \"total\": " << assetLoad.total << ", \"phases\": {";
+						for (size_t j = 0; j < assetLoad.phases.size(); j++) {
+							result << (j > 0 ? ", " : " ") << jsonString(assetLoad.phases[j].first) << ": " << assetLoad.phases[j].second;
+						}
+						result << " } }";
+					}
+					result << (assetLoads.empty() ? "" : "\n  ") << "]," << std::endl;
+					result << "  \"statistics\": {" << std::endl;
+					writeStatistics(result, "frame", calculateStatistics(frameTimes), false);
+					writeStatistics(result, "cpu", calculateStatistics(cpuTimes), false);
+					writeStatistics(result, "gpu", calculateStatistics(gpuTimes), series.empty());
+					for (size_t i = 0; i < series.size(); i++) {
+						writeStatistics(result, series[i].name, calculateStatistics(series[i].values), i == series.size() - 1);
+					}
+					result << "  }" << (outputFrameTimes ? "," : "") << std::endl;
+					if (outputFrameTimes) {
+						writeArray(result, "frameTimes", frameTimes, false);
+						writeArray(result, "cpuTimes", cpuTimes, false);
+						writeArray(result, "gpuTimes", gpuTimes, series.empty());
+						for (size_t i = 0; i < series.size(); i++) {
+							writeArray(result, series[i].name + "Values", series[i].values, i == series.size() - 1);
+						}
+					}
+					result << "}" << std::endl;
+				} else {
+					result << "device,driverversion,duration (ms),frames,fps,startup (ms),pipeline cache" << std::endl;
+					result << deviceProps.deviceName << "," << deviceProps.driverVersion << "," << runtime << "," << frameCount << "," << frameCount / (runtime / 1000.0) << "," << startupTime << "," << (pipelineCacheWarm ? "warm" : "cold") << std::endl;
 
-				if (outputFrameTimes) {
-					result << std::endl << "frame,ms" << std::endl;
-					for (size_t i = 0; i < frameTimes.size(); i++) {
-						result << i << "," << frameTimes[i] << std::endl;
+					if (!assetLoads.empty()) {
+						result << std::endl << "asset,cached,phase,ms" << std::endl;
+						for (const AssetLoad &assetLoad : assetLoads) {
+							result << assetLoad.name << "," << (assetLoad.cached ? 1 : 0) << ",total," << assetLoad.total << std::endl;
+							for (auto &phase : assetLoad.phases) {
+								result << assetLoad.name << "," << (assetLoad.cached ? 1 : 0) << "," << phase.first << "," << phase.second << std::endl;
+							}
+						}
+					}
+
+					if (outputFrameTimes) {
+						result << std::endl << "frame,ms,cpu ms,gpu ms" << std::endl;
+						for (size_t i = 0; i < frameTimes.size(); i++) {
+							result << i << "," << frameTimes[i] << "," << cpuTimes[i] << ",";
+							if (i < gpuTimes.size()) {
+								result << gpuTimes[i];
+							}
+							result << std::endl;
+						}
 					}
-					double tMin = *std::min_element(frameTimes.begin(), frameTimes.end());
-					double tMax = *std::max_element(frameTimes.begin(), frameTimes.end());
-					double tAvg = std::accumulate(frameTimes.begin(), frameTimes.end(), 0.0) / (double)frameTimes.size();
-					std::cout << "best   : " << (1000.0 / tMin) << " fps (" << tMin << " ms)" << std::endl;
-					std::cout << "worst  : " << (1000.0 / tMax) << " fps (" << tMax << " ms)" << std::endl;
-					std::cout << "avg    : " << (1000.0 / tAvg) << " fps (" << tAvg << " ms)" << std::endl;
-					std::cout << std::endl;
 				}
 
 				result.flush();
@@ -99,4 +642,4 @@ namespace vks
 			}
 		}
 	};
-}
\ No newline at end of file
+}
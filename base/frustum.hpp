@@ -6,9 +6,14 @@
 * This code is licensed under the MIT license (MIT) (http://opensource.org/licenses/MIT)
 */
 
+#pragma once
+
 #include <array>
 #include <math.h>
+#include <stdint.h>
+#include <stddef.h>
 #include <glm/glm.hpp>
+#include "simd.hpp"
 
 namespace vks
 {
@@ -18,6 +23,30 @@ namespace vks
 		enum side { LEFT = 0, RIGHT = 1, TOP = 2, BOTTOM = 3, BACK = 4, FRONT = 5 };
 		std::array<glm::vec4, 6> planes;
 
+		/** @brief Instruction sets used by the batch culling functions */
+		typedef vks::simd::Path SimdPath;
+
+		/** @brief Best instruction set supported by the CPU, detected once at runtime */
+		static SimdPath supportedSimdPath()
+		{
+			return vks::simd::supportedPath();
+		}
+
+		/** @brief Instruction set used by the batch culling functions, lowered to the supported one if the CPU lacks it */
+		SimdPath simdPath = supportedSimdPath();
+
+		/** @brief Number of 32 bit words required for the visibility mask of count objects */
+		static size_t visibilityMaskSize(size_t count)
+		{
+			return (count + 31) / 32;
+		}
+
+		/** @brief Read the visibility of an object from a mask written by one of the batch culling functions */
+		static bool isVisible(const uint32_t *visibilityMask, size_t index)
+		{
+			return (visibilityMask[index / 32] & (1u << (index % 32))) != 0;
+		}
+
 		void update(glm::mat4 matrix)
 		{
 			planes[LEFT].x = matrix[0].w + matrix[0].x;
@@ -56,8 +85,8 @@ namespace vks
 				planes[i] /= length;
 			}
 		}
-		
-		bool checkSphere(glm::vec3 pos, float radius)
+
+		bool checkSphere(glm::vec3 pos, float radius) const
 		{
 			for (auto i = 0; i < planes.size(); i++)
 			{
@@ -68,5 +97,305 @@ namespace vks
 			}
 			return true;
 		}
+
+		/** @brief Check if an axis aligned bounding box is (partially) inside the frustum */
+		bool checkAABB(glm::vec3 min, glm::vec3 max) const
+		{
+			const glm::vec3 center = (min + max) * 0.5f;
+			const glm::vec3 extent = (max - min) * 0.5f;
+			for (size_t i = 0; i < planes.size(); i++)
+			{
+				// Projected extent of the box onto the plane normal
+				const float radius = (fabsf(planes[i].x) * extent.x) + (fabsf(planes[i].y) * extent.y) + (fabsf(planes[i].z) * extent.z);
+				if ((planes[i].x * center.x) + (planes[i].y * center.y) + (planes[i].z * center.z) + planes[i].w <= -radius)
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+		/**
+		* Check if an oriented bounding box is (partially) inside the frustum
+		*
+		* @param transform Matrix transforming the box to world space (e.g. a node's model matrix), may contain scaling
+		* @param min Minimum corner of the box in local space
+		* @param max Maximum corner of the box in local space
+		*/
+		bool checkOBB(const glm::mat4 &transform, glm::vec3 min, glm::vec3 max) const
+		{
+			const glm::vec3 localCenter = (min + max) * 0.5f;
+			const glm::vec3 localExtent = (max - min) * 0.5f;
+			const glm::vec3 center = glm::vec3(transform * glm::vec4(localCenter, 1.0f));
+			// Half axes of the box in world space
+			const glm::vec3 axes[3] = {
+				glm::vec3(transform[0]) * localExtent.x,
+				glm::vec3(transform[1]) * localExtent.y,
+				glm::vec3(transform[2]) * localExtent.z,
+			};
+			for (size_t i = 0; i < planes.size(); i++)
+			{
+				const glm::vec3 normal = glm::vec3(planes[i]);
+				const float radius = fabsf(glm::dot(normal, axes[0])) + fabsf(glm::dot(normal, axes[1])) + fabsf(glm::dot(normal, axes[2]));
+				if (glm::dot(normal, center) + planes[i].w <= -radius)
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+		/** @brief Result of classifyAABB */
+		enum Intersection { OUTSIDE = 0, INTERSECTING = 1, INSIDE = 2 };
+
+		/** @brief Plane mask selecting all six planes for classifyAABB */
+		static const uint32_t ALL_PLANES = 0x3f;
+
+		/**
+		* Classify an axis aligned bounding box against a subset of the planes for hierarchical culling
+		*
+		* @param min Minimum corner of the box
+		* @param max Maximum corner of the box
+		* @param planeMask Planes to test (bit i selects planes[i]), planes the box lies completely in front of are removed from the mask
+		*
+		* @return OUTSIDE if the box is behind one of the tested planes (same result as checkAABB), INSIDE if no planes are left in the mask, INTERSECTING otherwise
+		*
+		* @note Everything contained in the box lies in front of the removed planes too, so tests of contained boxes can start with the returned mask
+		*/
+		Intersection classifyAABB(glm::vec3 min, glm::vec3 max, uint32_t &planeMask) const
+		{
+			const glm::vec3 center = (min + max) * 0.5f;
+			const glm::vec3 extent = (max - min) * 0.5f;
+			for (size_t i = 0; i < planes.size(); i++)
+			{
+				const uint32_t bit = 1u << i;
+				if (!(planeMask & bit))
+				{
+					continue;
+				}
+				const float radius = (fabsf(planes[i].x) * extent.x) + (fabsf(planes[i].y) * extent.y) + (fabsf(planes[i].z) * extent.z);
+				const float distance = (planes[i].x * center.x) + (planes[i].y * center.y) + (planes[i].z * center.z) + planes[i].w;
+				if (distance <= -radius)
+				{
+					return OUTSIDE;
+				}
+				if (distance >= radius)
+				{
+					planeMask &= ~bit;
+				}
+			}
+			return (planeMask == 0) ? INSIDE : INTERSECTING;
+		}
+
+		/**
+		* Check a batch of spheres stored as structure of arrays against the frustum
+		*
+		* @param x X coordinates of the sphere centers
+		* @param y Y coordinates of the sphere centers
+		* @param z Z coordinates of the sphere centers
+		* @param radius Sphere radii
+		* @param count Number of spheres
+		* @param visibilityMask Receives one bit per sphere (set if visible), must hold visibilityMaskSize(count) words
+		*
+		* @note Gives the same results as calling checkSphere for every sphere
+		*/
+		void cullSpheres(const float *x, const float *y, const float *z, const float *radius, size_t count, uint32_t *visibilityMask) const
+		{
+			const SimdPath path = activeSimdPath();
+			for (size_t word = 0; word < visibilityMaskSize(count); word++)
+			{
+				const size_t first = word * 32;
+				const size_t last = (first + 32 < count) ? first + 32 : count;
+#if defined(VKS_SIMD_X86)
+				if ((last - first == 32) && (path == SimdPath::AVX2))
+				{
+					visibilityMask[word] = cullSpheresAVX2(x + first, y + first, z + first, radius + first);
+					continue;
+				}
+				if ((last - first == 32) && (path == SimdPath::SSE))
+				{
+					visibilityMask[word] = cullSpheresSSE(x + first, y + first, z + first, radius + first);
+					continue;
+				}
+#endif
+				uint32_t bits = 0;
+				for (size_t i = first; i < last; i++)
+				{
+					if (checkSphere(glm::vec3(x[i], y[i], z[i]), radius[i]))
+					{
+						bits |= 1u << (i - first);
+					}
+				}
+				visibilityMask[word] = bits;
+			}
+		}
+
+		/**
+		* Check a batch of axis aligned bounding boxes stored as structure of arrays against the frustum
+		*
+		* @param minX Minimum x coordinates of the boxes
+		* @param minY Minimum y coordinates of the boxes
+		* @param minZ Minimum z coordinates of the boxes
+		* @param maxX Maximum x coordinates of the boxes
+		* @param maxY Maximum y coordinates of the boxes
+		* @param maxZ Maximum z coordinates of the boxes
+		* @param count Number of boxes
+		* @param visibilityMask Receives one bit per box (set if visible), must hold visibilityMaskSize(count) words
+		*
+		* @note Gives the same results as calling checkAABB for every box
+		*/
+		void cullAABBs(const float *minX, const float *minY, const float *minZ, const float *maxX, const float *maxY, const float *maxZ, size_t count, uint32_t *visibilityMask) const
+		{
+			const SimdPath path = activeSimdPath();
+			for (size_t word = 0; word < visibilityMaskSize(count); word++)
+			{
+				const size_t first = word * 32;
+				const size_t last = (first + 32 < count) ? first + 32 : count;
+#if defined(VKS_SIMD_X86)
+				if ((last - first == 32) && (path == SimdPath::AVX2))
+				{
+					visibilityMask[word] = cullAABBsAVX2(minX + first, minY + first, minZ + first, maxX + first, maxY + first, maxZ + first);
+					continue;
+				}
+				if ((last - first == 32) && (path == SimdPath::SSE))
+				{
+					visibilityMask[word] = cullAABBsSSE(minX + first, minY + first, minZ + first, maxX + first, maxY + first, maxZ + first);
+					continue;
+				}
+#endif
+				uint32_t bits = 0;
+				for (size_t i = first; i < last; i++)
+				{
+					if (checkAABB(glm::vec3(minX[i], minY[i], minZ[i]), glm::vec3(maxX[i], maxY[i], maxZ[i])))
+					{
+						bits |= 1u << (i - first);
+					}
+				}
+				visibilityMask[word] = bits;
+			}
+		}
+
+	private:
+		SimdPath activeSimdPath() const
+		{
+			return vks::simd::activePath(simdPath);
+		}
+
+#if defined(VKS_SIMD_X86)
+		// The SIMD versions test blocks of 32 objects and use the same operations in the same order as the scalar versions,
+		// so they give bit identical results. The comparisons are the negation of the scalar "<= -radius" to match for NaNs too.
+
+		VKS_SIMD_TARGET_SSE2 uint32_t cullSpheresSSE(const float *x, const float *y, const float *z, const float *radius) const
+		{
+			uint32_t bits = 0;
+			for (uint32_t i = 0; i < 32; i += 4)
+			{
+				const __m128 px = _mm_loadu_ps(x + i);
+				const __m128 py = _mm_loadu_ps(y + i);
+				const __m128 pz = _mm_loadu_ps(z + i);
+				const __m128 negRadius = _mm_xor_ps(_mm_loadu_ps(radius + i), _mm_set1_ps(-0.0f));
+				__m128 visible = _mm_castsi128_ps(_mm_set1_epi32(-1));
+				for (uint32_t p = 0; p < 6; p++)
+				{
+					__m128 distance = _mm_mul_ps(_mm_set1_ps(planes[p].x), px);
+					distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(planes[p].y), py));
+					distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(planes[p].z), pz));
+					distance = _mm_add_ps(distance, _mm_set1_ps(planes[p].w));
+					visible = _mm_and_ps(visible, _mm_cmpnle_ps(distance, negRadius));
+				}
+				bits |= static_cast<uint32_t>(_mm_movemask_ps(visible)) << i;
+			}
+			return bits;
+		}
+
+		VKS_SIMD_TARGET_AVX2 uint32_t cullSpheresAVX2(const float *x, const float *y, const float *z, const float *radius) const
+		{
+			uint32_t bits = 0;
+			for (uint32_t i = 0; i < 32; i += 8)
+			{
+				const __m256 px = _mm256_loadu_ps(x + i);
+				const __m256 py = _mm256_loadu_ps(y + i);
+				const __m256 pz = _mm256_loadu_ps(z + i);
+				const __m256 negRadius = _mm256_xor_ps(_mm256_loadu_ps(radius + i), _mm256_set1_ps(-0.0f));
+				__m256 visible = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+				for (uint32_t p = 0; p < 6; p++)
+				{
+					__m256 distance = _mm256_mul_ps(_mm256_set1_ps(planes[p].x), px);
+					distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_set1_ps(planes[p].y), py));
+					distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_set1_ps(planes[p].z), pz));
+					distance = _mm256_add_ps(distance, _mm256_set1_ps(planes[p].w));
+					visible = _mm256_and_ps(visible, _mm256_cmp_ps(distance, negRadius, _CMP_NLE_UQ));
+				}
+				bits |= static_cast<uint32_t>(_mm256_movemask_ps(visible)) << i;
+			}
+			return bits;
+		}
+
+		VKS_SIMD_TARGET_SSE2 uint32_t cullAABBsSSE(const float *minX, const float *minY, const float *minZ, const float *maxX, const float *maxY, const float *maxZ) const
+		{
+			const __m128 half = _mm_set1_ps(0.5f);
+			const __m128 signMask = _mm_set1_ps(-0.0f);
+			uint32_t bits = 0;
+			for (uint32_t i = 0; i < 32; i += 4)
+			{
+				const __m128 loX = _mm_loadu_ps(minX + i), hiX = _mm_loadu_ps(maxX + i);
+				const __m128 loY = _mm_loadu_ps(minY + i), hiY = _mm_loadu_ps(maxY + i);
+				const __m128 loZ = _mm_loadu_ps(minZ + i), hiZ = _mm_loadu_ps(maxZ + i);
+				const __m128 cx = _mm_mul_ps(_mm_add_ps(loX, hiX), half);
+				const __m128 cy = _mm_mul_ps(_mm_add_ps(loY, hiY), half);
+				const __m128 cz = _mm_mul_ps(_mm_add_ps(loZ, hiZ), half);
+				const __m128 ex = _mm_mul_ps(_mm_sub_ps(hiX, loX), half);
+				const __m128 ey = _mm_mul_ps(_mm_sub_ps(hiY, loY), half);
+				const __m128 ez = _mm_mul_ps(_mm_sub_ps(hiZ, loZ), half);
+				__m128 visible = _mm_castsi128_ps(_mm_set1_epi32(-1));
+				for (uint32_t p = 0; p < 6; p++)
+				{
+					__m128 radius = _mm_mul_ps(_mm_set1_ps(fabsf(planes[p].x)), ex);
+					radius = _mm_add_ps(radius, _mm_mul_ps(_mm_set1_ps(fabsf(planes[p].y)), ey));
+					radius = _mm_add_ps(radius, _mm_mul_ps(_mm_set1_ps(fabsf(planes[p].z)), ez));
+					__m128 distance = _mm_mul_ps(_mm_set1_ps(planes[p].x), cx);
+					distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(planes[p].y), cy));
+					distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(planes[p].z), cz));
+					distance = _mm_add_ps(distance, _mm_set1_ps(planes[p].w));
+					visible = _mm_and_ps(visible, _mm_cmpnle_ps(distance, _mm_xor_ps(radius, signMask)));
+				}
+				bits |= static_cast<uint32_t>(_mm_movemask_ps(visible)) << i;
+			}
+			return bits;
+		}
+
+		VKS_SIMD_TARGET_AVX2 uint32_t cullAABBsAVX2(const float *minX, const float *minY, const float *minZ, const float *maxX, const float *maxY, const float *maxZ) const
+		{
+			const __m256 half = _mm256_set1_ps(0.5f);
+			const __m256 signMask = _mm256_set1_ps(-0.0f);
+			uint32_t bits = 0;
+			for (uint32_t i = 0; i < 32; i += 8)
+			{
+				const __m256 loX = _mm256_loadu_ps(minX + i), hiX = _mm256_loadu_ps(maxX + i);
+				const __m256 loY = _mm256_loadu_ps(minY + i), hiY = _mm256_loadu_ps(maxY + i);
+				const __m256 loZ = _mm256_loadu_ps(minZ + i), hiZ = _mm256_loadu_ps(maxZ + i);
+				const __m256 cx = _mm256_mul_ps(_mm256_add_ps(loX, hiX), half);
+				const __m256 cy = _mm256_mul_ps(_mm256_add_ps(loY, hiY), half);
+				const __m256 cz = _mm256_mul_ps(_mm256_add_ps(loZ, hiZ), half);
+				const __m256 ex = _mm256_mul_ps(_mm256_sub_ps(hiX, loX), half);
+				const __m256 ey = _mm256_mul_ps(_mm256_sub_ps(hiY, loY), half);
+				const __m256 ez = _mm256_mul_ps(_mm256_sub_ps(hiZ, loZ), half);
+				__m256 visible = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+				for (uint32_t p = 0; p < 6; p++)
+				{
+					__m256 radius = _mm256_mul_ps(_mm256_set1_ps(fabsf(planes[p].x)), ex);
+					radius = _mm256_add_ps(radius, _mm256_mul_ps(_mm256_set1_ps(fabsf(planes[p].y)), ey));
+					radius = _mm256_add_ps(radius, _mm256_mul_ps(_mm256_set1_ps(fabsf(planes[p].z)), ez));
+					__m256 distance = _mm256_mul_ps(_mm256_set1_ps(planes[p].x), cx);
+					distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_set1_ps(planes[p].y), cy));
+					distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_set1_ps(planes[p].z), cz));
+					distance = _mm256_add_ps(distance, _mm256_set1_ps(planes[p].w));
+					visible = _mm256_and_ps(visible, _mm256_cmp_ps(distance, _mm256_xor_ps(radius, signMask), _CMP_NLE_UQ));
+				}
+				bits |= static_cast<uint32_t>(_mm256_movemask_ps(visible)) << i;
+			}
+			return bits;
+		}
+#endif
 	};
 }
@@ -0,0 +1,414 @@
+/*
+* C++11 work stealing job system
+*
+* Every thread taking part in the job system owns a lock-free deque (Chase-Lev) it pushes jobs to and pops them from (LIFO),
+* idle threads steal the oldest jobs from the other deques (FIFO), so work is balanced automatically
+*
+* Copyright (C) by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license (MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <algorithm>
+#include <assert.h>
+#include <stdint.h>
+
+namespace vks
+{
+	class JobSystem;
+
+	/**
+	* @brief Counter for a set of jobs that can be waited on (fork-join)
+	* @note A group must not be destroyed before it has been waited on
+	*/
+	class TaskGroup
+	{
+		friend class JobSystem;
+		std::atomic<uint32_t> pending;
+	public:
+		TaskGroup() : pending(0) {}
+		TaskGroup(const TaskGroup&) = delete;
+		TaskGroup &operator=(const TaskGroup&) = delete;
+		/** @brief True if all jobs added to the group have been finished */
+		bool done() const { return pending.load(std::memory_order_acquire) == 0; }
+	};
+
+	class JobSystem
+	{
+	public:
+		/** @brief Returned by currentThreadIndex for threads that are not part of the job system */
+		static const uint32_t INVALID_THREAD_INDEX = ~0u;
+
+	private:
+		struct Job
+		{
+			std::function<void()> function;
+			TaskGroup *group;
+		};
+
+		/**
+		* @brief Fixed size work stealing deque (Chase-Lev, with the memory orderings from Le et al. 2013)
+		* @note Only the owning thread may push and pop, any thread may steal
+		*/
+		class WorkStealingDeque
+		{
+			static const int64_t CAPACITY = 4096;
+			std::atomic<int64_t> top;
+			std::atomic<int64_t> bottom;
+			std::atomic<Job*> jobs[CAPACITY];
+		public:
+			WorkStealingDeque() : top(0), bottom(0)
+			{
+				for (auto &job : jobs) {
+					job.store(nullptr, std::memory_order_relaxed);
+				}
+			}
+
+			/** @brief Returns false if the deque is full */
+			bool push(Job *job)
+			{
+				const int64_t b = bottom.load(std::memory_order_relaxed);
+				const int64_t t = top.load(std::memory_order_acquire);
+				if (b - t >= CAPACITY) {
+					return false;
+				}
+				jobs[b & (CAPACITY - 1)].store(job, std::memory_order_relaxed);
+				bottom.store(b + 1, std::memory_order_release);
+				return true;
+			}
+
+			Job *pop()
+			{
+				const int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+				bottom.store(b, std::memory_order_relaxed);
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+				int64_t t = top.load(std::memory_order_relaxed);
+				Job *job = nullptr;
+				if (t <= b) {
+					job = jobs[b & (CAPACITY - 1)].load(std::memory_order_relaxed);
+					if (t == b) {
+						// Last job, race against stealers
+						if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+							job = nullptr;
+						}
+						bottom.store(b + 1, std::memory_order_relaxed);
+					}
+				} else {
+					bottom.store(b + 1, std::memory_order_relaxed);
+				}
+				return job;
+			}
+
+			Job *steal()
+			{
+				int64_t t = top.load(std::memory_order_acquire);
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+				const int64_t b = bottom.load(std::memory_order_acquire);
+				if (t < b) {
+					Job *job = jobs[t & (CAPACITY - 1)].load(std::memory_order_relaxed);
+					if (top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+						return job;
+					}
+				}
+				return nullptr;
+			}
+		};
+
+		/** @brief Membership of the calling thread in a job system, identifies the deque it owns there */
+		struct ThreadContext
+		{
+			JobSystem *jobSystem;
+			uint32_t index;
+		};
+		/**
+		* @brief Job systems the calling thread takes part in
+		* @note A thread can create (and so take part in) several job systems, e.g. a loader's pool next to the frame's pool, and workers of one job system may create others
+		*/
+		static std::vector<ThreadContext> &threadContexts()
+		{
+			static thread_local std::vector<ThreadContext> contexts;
+			return contexts;
+		}
+		/** @brief Index of the calling thread's deque in this job system, INVALID_THREAD_INDEX if the thread is not part of it */
+		uint32_t threadIndex() const
+		{
+			for (const ThreadContext &context : threadContexts()) {
+				if (context.jobSystem == this) {
+					return context.index;
+				}
+			}
+			return INVALID_THREAD_INDEX;
+		}
+		void joinThread(uint32_t index)
+		{
+			threadContexts().push_back({ this, index });
+		}
+		void leaveThread()
+		{
+			std::vector<ThreadContext> &contexts = threadContexts();
+			contexts.erase(std::remove_if(contexts.begin(), contexts.end(), [this](const ThreadContext &context) { return context.jobSystem == this; }), contexts.end());
+		}
+
+		// Slot 0 belongs to the thread that created the job system, slots 1..n to the worker threads
+		std::vector<std::unique_ptr<WorkStealingDeque>> deques;
+		std::vector<std::thread> workers;
+		std::thread::id ownerThread;
+
+		// Jobs added by threads that are not part of the job system
+		std::deque<Job*> externalJobs;
+		std::mutex externalMutex;
+		std::atomic<uint32_t> externalJobCount;
+
+		// Idle workers sleep until new jobs are added
+		std::mutex sleepMutex;
+		std::condition_variable sleepCondition;
+		std::atomic<uint64_t> jobEpoch;
+		std::atomic<uint32_t> sleepingWorkers;
+		std::atomic<bool> stopping;
+
+		// Number of failed attempts to find a job before a worker goes to sleep
+		static const uint32_t SPIN_COUNT = 64;
+
+		void wakeWorkers()
+		{
+			jobEpoch.fetch_add(1, std::memory_order_seq_cst);
+			if (sleepingWorkers.load(std::memory_order_seq_cst) > 0) {
+				std::lock_guard<std::mutex> lock(sleepMutex);
+				sleepCondition.notify_one();
+			}
+		}
+
+		void enqueue(Job *job)
+		{
+			const uint32_t index = threadIndex();
+			if (index != INVALID_THREAD_INDEX) {
+				if (!deques[index]->push(job)) {
+					// The deque is full, so there is enough parallel work left for everybody
+					execute(job);
+					return;
+				}
+			} else {
+				std::lock_guard<std::mutex> lock(externalMutex);
+				externalJobs.push_back(job);
+				externalJobCount.fetch_add(1, std::memory_order_release);
+			}
+			wakeWorkers();
+		}
+
+		/** @brief Pop from the calling thread's own deque first, then try to steal from the others */
+		Job *findJob(uint32_t index)
+		{
+			Job *job = nullptr;
+			if (index != INVALID_THREAD_INDEX) {
+				job = deques[index]->pop();
+				if (job) {
+					return job;
+				}
+			}
+			const uint32_t count = static_cast<uint32_t>(deques.size());
+			const uint32_t first = (index != INVALID_THREAD_INDEX) ? index + 1 : 0;
+			for (uint32_t i = 0; i < count; i++) {
+				const uint32_t victim = (first + i) % count;
+				if (victim == index) {
+					continue;
+				}
+				job = deques[victim]->steal();
+				if (job) {
+					return job;
+				}
+			}
+			if (externalJobCount.load(std::memory_order_acquire) > 0) {
+				std::lock_guard<std::mutex> lock(externalMutex);
+				if (!externalJobs.empty()) {
+					job = externalJobs.front();
+					externalJobs.pop_front();
+					externalJobCount.fetch_sub(1, std::memory_order_relaxed);
+				}
+			}
+			return job;
+		}
+
+		void execute(Job *job)
+		{
+			job->function();
+			TaskGroup *group = job->group;
+			delete job;
+			if (group) {
+				group->pending.fetch_sub(1, std::memory_order_acq_rel);
+			}
+		}
+
+		void workerLoop(uint32_t index)
+		{
+			joinThread(index);
+			uint32_t failedAttempts = 0;
+			while (!stopping.load(std::memory_order_acquire)) {
+				const uint64_t epoch = jobEpoch.load(std::memory_order_seq_cst);
+				Job *job = findJob(index);
+				if (job) {
+					execute(job);
+					failedAttempts = 0;
+					continue;
+				}
+				if (++failedAttempts < SPIN_COUNT) {
+					std::this_thread::yield();
+					continue;
+				}
+				// No job has been added since the epoch was read, so it's safe to sleep until the next one is
+				std::unique_lock<std::mutex> lock(sleepMutex);
+				sleepingWorkers.fetch_add(1, std::memory_order_seq_cst);
+				sleepCondition.wait(lock, [&] { return stopping.load(std::memory_order_acquire) || (jobEpoch.load(std::memory_order_seq_cst) != epoch); });
+				sleepingWorkers.fetch_sub(1, std::memory_order_seq_cst);
+				failedAttempts = 0;
+			}
+			leaveThread();
+		}
+
+		void splitRange(TaskGroup &group, size_t begin, size_t end, size_t grainSize, const std::function<void(size_t, size_t)> &func)
+		{
+			// Hand the upper half of the range to other threads until the remainder is small enough (lazy binary splitting)
+			while (end - begin > grainSize) {
+				const size_t middle = begin + (end - begin) / 2;
+				const size_t upperEnd = end;
+				run(group, [this, &group, middle, upperEnd, grainSize, &func] { splitRange(group, middle, upperEnd, grainSize, func); });
+				end = middle;
+			}
+			func(begin, end);
+		}
+
+	public:
+		/**
+		* Create the job system and start the worker threads
+		*
+		* @param threadCount (Optional) Number of threads taking part in the job system including the calling thread, defaults to the number of hardware threads
+		*
+		* @note The creating thread takes part in the job system (with index 0) while it's waiting on task groups
+		* @note The job system must be destroyed on the thread that created it
+		*/
+		explicit JobSystem(uint32_t threadCount = 0) : externalJobCount(0), jobEpoch(0), sleepingWorkers(0), stopping(false)
+		{
+			if (threadCount == 0) {
+				threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+			}
+			for (uint32_t i = 0; i < threadCount; i++) {
+				deques.push_back(std::unique_ptr<WorkStealingDeque>(new WorkStealingDeque()));
+			}
+			ownerThread = std::this_thread::get_id();
+			joinThread(0);
+			for (uint32_t i = 1; i < threadCount; i++) {
+				workers.push_back(std::thread(&JobSystem::workerLoop, this, i));
+			}
+		}
+
+		/** @note All task groups must have been waited on before the job system is destroyed */
+		~JobSystem()
+		{
+			{
+				std::lock_guard<std::mutex> lock(sleepMutex);
+				stopping.store(true, std::memory_order_release);
+				sleepCondition.notify_all();
+			}
+			for (auto &worker : workers) {
+				worker.join();
+			}
+			assert(std::this_thread::get_id() == ownerThread);
+			leaveThread();
+			for (Job *job : externalJobs) {
+				delete job;
+			}
+		}
+
+		JobSystem(const JobSystem&) = delete;
+		JobSystem &operator=(const JobSystem&) = delete;
+
+		/** @brief Number of threads taking part in the job system, including the thread that created it */
+		uint32_t threadCount() const
+		{
+			return static_cast<uint32_t>(deques.size());
+		}
+
+		/**
+		* Index of the calling thread within the job system
+		*
+		* @return Index in [0, threadCount()) or INVALID_THREAD_INDEX if the calling thread is not part of this job system
+		*
+		* @note Stays the same while a job runs, so it can be used to access per-thread resources like command pools
+		*/
+		uint32_t currentThreadIndex() const
+		{
+			return threadIndex();
+		}
+
+		/** @brief Add a job to a task group, the job may be run on any thread of the job system */
+		void run(TaskGroup &group, std::function<void()> function)
+		{
+			group.pending.fetch_add(1, std::memory_order_relaxed);
+			enqueue(new Job{ std::move(function), &group });
+		}
+
+		/** @brief Wait for all jobs of a task group to finish, the calling thread executes pending jobs while waiting */
+		void wait(TaskGroup &group)
+		{
+			const uint32_t index = currentThreadIndex();
+			while (!group.done()) {
+				Job *job = findJob(index);
+				if (job) {
+					execute(job);
+				} else {
+					std::this_thread::yield();
+				}
+			}
+		}
+
+		/**
+		* Run a function for ranges covering [0, count) on all threads of the job system and wait for them to finish
+		*
+		* @param count Number of indices
+		* @param func Function called with [begin, end) sub ranges, must be safe to call concurrently for different ranges
+		* @param grainSize (Optional) Maximum number of indices passed to a single call, chosen based on the thread count if zero
+		*/
+		void parallelForRange(size_t count, const std::function<void(size_t, size_t)> &func, size_t grainSize = 0)
+		{
+			if (count == 0) {
+				return;
+			}
+			if (grainSize == 0) {
+				// Several ranges per thread leave room for balancing differently expensive items
+				grainSize = std::max<size_t>(count / (threadCount() * 8), 1);
+			}
+			if ((threadCount() == 1) || (count <= grainSize)) {
+				func(0, count);
+				return;
+			}
+			TaskGroup group;
+			splitRange(group, 0, count, grainSize, func);
+			wait(group);
+		}
+
+		/**
+		* Run a function for all indices in [0, count) on all threads of the job system and wait for them to finish
+		*
+		* @param count Number of indices
+		* @param func Function called for every index, must be safe to call concurrently for different indices
+		* @param grainSize (Optional) Maximum number of indices processed by a single job, chosen based on the thread count if zero
+		*/
+		void parallelFor(size_t count, const std::function<void(size_t)> &func, size_t grainSize = 0)
+		{
+			parallelForRange(count, [&func](size_t begin, size_t end) {
+				for (size_t i = begin; i < end; i++) {
+					func(i);
+				}
+			}, grainSize);
+		}
+	};
+}
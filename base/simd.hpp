@@ -0,0 +1,78 @@
+/*
+* SIMD instruction set detection shared by the batch processing helpers
+*
+* Copyright (C) by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license (MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#pragma once
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define VKS_SIMD_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+// MSVC allows using all intrinsics without changing the target of the function
+#define VKS_SIMD_TARGET_SSE2
+#define VKS_SIMD_TARGET_AVX2
+#else
+#define VKS_SIMD_TARGET_SSE2 __attribute__((target("sse2")))
+#define VKS_SIMD_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace vks
+{
+	namespace simd
+	{
+		/** @brief Instruction sets with specialized code paths, ordered so that a path can be compared against the supported one */
+		enum class Path { Scalar = 0, SSE = 1, AVX2 = 2 };
+
+		inline Path detectPath()
+		{
+#if defined(VKS_SIMD_X86)
+#if defined(_MSC_VER) && !defined(__clang__)
+			int info[4];
+			__cpuid(info, 1);
+			const bool sse2 = (info[3] & (1 << 26)) != 0;
+			const bool osxsave = (info[2] & (1 << 27)) != 0;
+			const bool avx = (info[2] & (1 << 28)) != 0;
+			bool avx2 = false;
+			// AVX registers can only be used if the OS saves them on context switches
+			if (osxsave && avx && ((_xgetbv(0) & 0x6) == 0x6))
+			{
+				__cpuidex(info, 7, 0);
+				avx2 = (info[1] & (1 << 5)) != 0;
+			}
+#else
+			__builtin_cpu_init();
+			const bool sse2 = __builtin_cpu_supports("sse2");
+			const bool avx2 = __builtin_cpu_supports("avx2");
+#endif
+			if (avx2)
+			{
+				return Path::AVX2;
+			}
+			if (sse2)
+			{
+				return Path::SSE;
+			}
+#endif
+			return Path::Scalar;
+		}
+
+		/** @brief Best instruction set supported by the CPU, detected once at runtime */
+		inline Path supportedPath()
+		{
+			static const Path path = detectPath();
+			return path;
+		}
+
+		/** @brief Lowers the requested instruction set to the supported one if the CPU lacks it */
+		inline Path activePath(Path requested)
+		{
+			return (requested < supportedPath()) ? requested : supportedPath();
+		}
+	}
+}
@@ -25,24 +25,27 @@ VkResult VulkanExampleBase::createInstance(bool enableValidation)
 	appInfo.pEngineName = name.c_str();
 	appInfo.apiVersion = apiVersion;
 
-	std::vector<const char*> instanceExtensions = { VK_KHR_SURFACE_EXTENSION_NAME };
+	std::vector<const char*> instanceExtensions;
 
-	// Enable surface extensions depending on os
+	// Enable surface extensions depending on os (not required in headless mode, which doesn't present to a surface)
+	if (!settings.headless) {
+		instanceExtensions.push_back(VK_KHR_SURFACE_EXTENSION_NAME);
 #if defined(_WIN32)
-	instanceExtensions.push_back(VK_KHR_WIN32_SURFACE_EXTENSION_NAME);
+		instanceExtensions.push_back(VK_KHR_WIN32_SURFACE_EXTENSION_NAME);
 #elif defined(VK_USE_PLATFORM_ANDROID_KHR)
-	instanceExtensions.push_back(VK_KHR_ANDROID_SURFACE_EXTENSION_NAME);
+		instanceExtensions.push_back(VK_KHR_ANDROID_SURFACE_EXTENSION_NAME);
 #elif defined(_DIRECT2DISPLAY)
-	instanceExtensions.push_back(VK_KHR_DISPLAY_EXTENSION_NAME);
+		instanceExtensions.push_back(VK_KHR_DISPLAY_EXTENSION_NAME);
 #elif defined(VK_USE_PLATFORM_WAYLAND_KHR)
-	instanceExtensions.push_back(VK_KHR_WAYLAND_SURFACE_EXTENSION_NAME);
+		instanceExtensions.push_back(VK_KHR_WAYLAND_SURFACE_EXTENSION_NAME);
 #elif defined(VK_USE_PLATFORM_XCB_KHR)
-	instanceExtensions.push_back(VK_KHR_XCB_SURFACE_EXTENSION_NAME);
+		instanceExtensions.push_back(VK_KHR_XCB_SURFACE_EXTENSION_NAME);
 #elif defined(VK_USE_PLATFORM_IOS_MVK)
-	instanceExtensions.push_back(VK_MVK_IOS_SURFACE_EXTENSION_NAME);
+		instanceExtensions.push_back(VK_MVK_IOS_SURFACE_EXTENSION_NAME);
 #elif defined(VK_USE_PLATFORM_MACOS_MVK)
-	instanceExtensions.push_back(VK_MVK_MACOS_SURFACE_EXTENSION_NAME);
+		instanceExtensions.push_back(VK_MVK_MACOS_SURFACE_EXTENSION_NAME);
 #endif
+	}
 
 	if (enabledInstanceExtensions.size() > 0) {
 		for (auto enabledExtension : enabledInstanceExtensions) {
@@ -54,12 +57,12 @@ VkResult VulkanExampleBase::createInstance(bool enableValidation)
 	instanceCreateInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
 	instanceCreateInfo.pNext = NULL;
 	instanceCreateInfo.pApplicationInfo = &appInfo;
+	if (settings.validation)
+	{
+		instanceExtensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+	}
 	if (instanceExtensions.size() > 0)
 	{
-		if (settings.validation)
-		{
-			instanceExtensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
-		}
 		instanceCreateInfo.enabledExtensionCount = (uint32_t)instanceExtensions.size();
 		instanceCreateInfo.ppEnabledExtensionNames = instanceExtensions.data();
 	}
@@ -93,8 +96,9 @@ VkResult VulkanExampleBase::createInstance(bool enableValidation)
 void VulkanExampleBase::renderFrame()
 {
 	VulkanExampleBase::prepareFrame();
+	const VkCommandBuffer commandBuffer = recordPerFrame ? recordFrameCommandBuffer() : drawCmdBuffers[currentBuffer];
 	submitInfo.commandBufferCount = 1;
-	submitInfo.pCommandBuffers = &drawCmdBuffers[currentBuffer];
+	submitInfo.pCommandBuffers = &commandBuffer;
 	VK_CHECK_RESULT(vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE));
 	VulkanExampleBase::submitFrame();
 }
@@ -136,13 +140,28 @@ std::string VulkanExampleBase::getShadersPath() const
 
 void VulkanExampleBase::createPipelineCache()
 {
-	VkPipelineCacheCreateInfo pipelineCacheCreateInfo = {};
-	pipelineCacheCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
-	VK_CHECK_RESULT(vkCreatePipelineCache(device, &pipelineCacheCreateInfo, nullptr, &pipelineCache));
+	// The pipeline cache is persisted per example and device, so pipelines only need to be compiled on the first start
+#if defined(VK_USE_PLATFORM_ANDROID_KHR)
+	const std::string cacheDir = std::string(androidApp->activity->internalDataPath) + "/";
+#else
+	const std::string cacheDir = "";
+#endif
+	pipelineCacheFile = vks::pipelinecache::getFileName(cacheDir, name, deviceProperties);
+	// Model mesh caches are kept next to the pipeline cache instead of the asset directory
+	vks::meshcache::cacheDirectory() = cacheDir;
+	benchmark.pipelineCacheWarm = vks::pipelinecache::create(device, deviceProperties, pipelineCacheFile, &pipelineCache);
+}
+
+void VulkanExampleBase::savePipelineCache()
+{
+	if (!vks::pipelinecache::save(device, deviceProperties, pipelineCache, pipelineCacheFile)) {
+		std::cerr << "Could not write pipeline cache to \"" << pipelineCacheFile << "\"" << std::endl;
+	}
 }
 
 void VulkanExampleBase::prepare()
 {
+	prepareTimestamp = std::chrono::high_resolution_clock::now();
 	if (vulkanDevice->enableDebugMarkers) {
 		vks::debugmarker::setup(device);
 	}
@@ -151,14 +170,21 @@ void VulkanExampleBase::prepare()
 	setupSwapChain();
 	createCommandBuffers();
 	createSynchronizationPrimitives();
+	createFrameResources();
+	gpuProfiler.prepare(vulkanDevice, vulkanDevice->queueFamilyIndices.graphics, settings.framesInFlight);
+	if (benchmark.active) {
+		// Examples write the frame timestamps while recording their command buffers, so the queries have to exist before that
+		benchmark.prepareGpuTimer(vulkanDevice, vulkanDevice->queueFamilyIndices.graphics, std::max(swapChain.imageCount, settings.framesInFlight));
+	}
 	setupDepthStencil();
 	setupRenderPass();
 	createPipelineCache();
 	setupFrameBuffer();
-	settings.overlay = settings.overlay && (!benchmark.active);
+	settings.overlay = settings.overlay && (!benchmark.active || benchmark.overlay);
 	if (settings.overlay) {
 		UIOverlay.device = vulkanDevice;
 		UIOverlay.queue = queue;
+		UIOverlay.frameCount = settings.framesInFlight;
 		UIOverlay.shaders = {
 			loadShader(getShadersPath() + "base/uioverlay.vert.spv", VK_SHADER_STAGE_VERTEX_BIT),
 			loadShader(getShadersPath() + "base/uioverlay.frag.spv", VK_SHADER_STAGE_FRAGMENT_BIT),
@@ -217,7 +243,7 @@ void VulkanExampleBase::nextFrame()
 	{
 		lastFPS = static_cast<uint32_t>((float)frameCounter * (1000.0f / fpsTimer));
 #if defined(_WIN32)
-		if (!settings.overlay)	{
+		if (!settings.overlay && !settings.headless)	{
 			std::string windowTitle = getWindowTitle();
 			SetWindowText(window, windowTitle.c_str());
 		}
@@ -225,15 +251,26 @@ void VulkanExampleBase::nextFrame()
 		frameCounter = 0;
 		lastTimestamp = tEnd;
 	}
-	// TODO: Cap UI overlay update rates
 	updateOverlay();
 }
 
 void VulkanExampleBase::renderLoop()
 {
+	// Resources uploaded during preparation may still be in flight, they need to be complete before other queues can access them
+	vulkanDevice->uploadManager.waitIdle();
 	if (benchmark.active) {
-		benchmark.run([=] { render(); }, vulkanDevice->properties);
+		benchmark.startupTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - prepareTimestamp).count();
+		benchmark.exampleName = title;
+		benchmark.width = width;
+		benchmark.height = height;
+		benchmark.validation = settings.validation;
+		benchmark.headless = settings.headless;
+		benchmark.framesInFlight = settings.framesInFlight;
+		benchmark.overlay = settings.overlay;
+		benchmark.overlayRefreshRate = settings.overlayRefreshRate;
+		benchmark.run([=] { render(); updateOverlay(); }, vulkanDevice->properties);
 		vkDeviceWaitIdle(device);
+		vulkanDevice->memoryAllocator.printStatistics();
 		if (benchmark.filename != "") {
 			benchmark.saveResults();
 		}
@@ -243,6 +280,14 @@ void VulkanExampleBase::renderLoop()
 	destWidth = width;
 	destHeight = height;
 	lastTimestamp = std::chrono::high_resolution_clock::now();
+	if (settings.headless) {
+		// There is no window to receive events from, so a fixed number of frames is rendered
+		for (uint32_t i = 0; i < settings.headlessFrameCount; i++) {
+			nextFrame();
+		}
+		vkDeviceWaitIdle(device);
+		return;
+	}
 #if defined(_WIN32)
 	MSG msg;
 	bool quitMessageReceived = false;
@@ -318,7 +363,6 @@ void VulkanExampleBase::renderLoop()
 				lastTimestamp = tEnd;
 			}
 
-			// TODO: Cap UI overlay update rates/only issue when update requested
 			updateOverlay();
 
 			bool updateView = false;
@@ -521,10 +565,31 @@ void VulkanExampleBase::updateOverlay()
 	if (!settings.overlay)
 		return;
 
+	// Rebuilding the overlay runs ImGui, the examples' overlay callbacks and the buffer upload, so it's skipped unless
+	// there was input, the example invalidated the overlay or the refresh interval has passed
+	// The draw data of the last update stays valid and is drawn again until then
+	auto tStart = std::chrono::high_resolution_clock::now();
+	const double sinceLastUpdate = std::chrono::duration<double>(tStart - overlayState.lastUpdate).count();
+	const bool inputChanged = (mousePos != overlayState.mousePos) || (mouseButtons.left != overlayState.mouseLeft) || (mouseButtons.right != overlayState.mouseRight) || (width != overlayState.width) || (height != overlayState.height);
+	const bool refreshDue = (settings.overlayRefreshRate <= 0.0f) || (sinceLastUpdate * settings.overlayRefreshRate >= 1.0);
+	const uint32_t slice = currentFrame % UIOverlay.frameCount;
+	if (!inputChanged && !refreshDue && !overlayState.followUp && !UIOverlay.invalidated) {
+		frames[currentFrame].overlaySlice = UIOverlay.currentSlice;
+		benchmark.record("ui", 0.0);
+		return;
+	}
+	overlayState.mousePos = mousePos;
+	overlayState.mouseLeft = mouseButtons.left;
+	overlayState.mouseRight = mouseButtons.right;
+	overlayState.width = width;
+	overlayState.height = height;
+	overlayState.lastUpdate = tStart;
+
 	ImGuiIO& io = ImGui::GetIO();
 
 	io.DisplaySize = ImVec2((float)width, (float)height);
-	io.DeltaTime = frameTimer;
+	// Time since the last update instead of the last frame, so ImGui's timers (e.g. for double clicks) keep running while updates are skipped
+	io.DeltaTime = (float)std::min(std::max(sinceLastUpdate, 1e-4), 1.0);
 
 	io.MousePos = ImVec2(mousePos.x, mousePos.y);
 	io.MouseDown[0] = mouseButtons.left;
@@ -539,6 +604,19 @@ void VulkanExampleBase::updateOverlay()
 	ImGui::TextUnformatted(title.c_str());
 	ImGui::TextUnformatted(deviceProperties.deviceName);
 	ImGui::Text("%.2f ms/frame (%.1d fps)", (1000.0f / lastFPS), lastFPS);
+	if (recordPerFrame) {
+		if (recordingJobSystem) {
+			ImGui::Text("%.3f ms recording (%d threads)", recordTime, recordingJobSystem->threadCount());
+		} else {
+			ImGui::Text("%.3f ms recording", recordTime);
+		}
+	}
+	ImGui::Text("UI: %u KB/frame, %u reallocations, %u rebuilds", UIOverlay.statistics.uploadBytes / 1024, UIOverlay.statistics.reallocations, UIOverlay.statistics.rebuilds);
+	if (!gpuProfiler.results.empty() && UIOverlay.header("GPU profiler")) {
+		for (auto& scope : gpuProfiler.results) {
+			ImGui::Text("%*s%s: %.3f ms", (int)scope.depth * 2, "", scope.name.c_str(), scope.time);
+		}
+	}
 
 #if defined(VK_USE_PLATFORM_ANDROID_KHR)
 	ImGui::PushStyleVar(ImGuiStyleVar_ItemSpacing, ImVec2(0.0f, 5.0f * UIOverlay.scale));
@@ -554,8 +632,33 @@ void VulkanExampleBase::updateOverlay()
 	ImGui::PopStyleVar();
 	ImGui::Render();
 
-	if (UIOverlay.update() || UIOverlay.updated) {
-		buildCommandBuffers();
+	// The overlay writes the slice of the next frame, which may still be read by frames in flight that drew it
+	// Frames that skipped the update draw the slice of the last update, so this isn't limited to the next frame's fence
+	if (frames.size() > 1) {
+		std::vector<VkFence> sliceFences;
+		for (auto& frame : frames) {
+			if (frame.overlaySlice == slice) {
+				sliceFences.push_back(frame.fence);
+			}
+		}
+		if (!sliceFences.empty()) {
+			VK_CHECK_RESULT(vkWaitForFences(device, (uint32_t)sliceFences.size(), sliceFences.data(), VK_TRUE, UINT64_MAX));
+		}
+	}
+	const bool changed = UIOverlay.update(currentFrame) || UIOverlay.updated;
+	frames[currentFrame].overlaySlice = UIOverlay.currentSlice;
+	UIOverlay.invalidated = false;
+	// Changes (input or layout) may take one more frame to settle, but a follow-up doesn't request another one
+	overlayState.followUp = !overlayState.followUp && (changed || inputChanged);
+	if (changed) {
+		// Examples recording every frame pick up the changes with their next frame
+		if (!recordPerFrame) {
+			// Prebuilt command buffers may still be executing for other frames in flight
+			if (frames.size() > 1) {
+				VK_CHECK_RESULT(vkQueueWaitIdle(queue));
+			}
+			buildCommandBuffers();
+		}
 		UIOverlay.updated = false;
 	}
 
@@ -564,6 +667,7 @@ void VulkanExampleBase::updateOverlay()
 		mouseButtons.left = false;
 	}
 #endif
+	benchmark.record("ui", std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - tStart).count());
 }
 
 void VulkanExampleBase::drawUI(const VkCommandBuffer commandBuffer)
@@ -580,6 +684,27 @@ void VulkanExampleBase::drawUI(const VkCommandBuffer commandBuffer)
 
 void VulkanExampleBase::prepareFrame()
 {
+	// Wait until the GPU has finished the last frame that used this frame's resources
+	FrameResources &frame = frames[currentFrame];
+	auto tWait = std::chrono::high_resolution_clock::now();
+	VK_CHECK_RESULT(vkWaitForFences(device, 1, &frame.fence, VK_TRUE, UINT64_MAX));
+	frameWaitTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - tWait).count();
+	// The frame's timestamps are available now that its fence has been waited on
+	gpuProfiler.resolveFrame(currentFrame);
+	for (auto& scope : gpuProfiler.results) {
+		benchmark.record("gpu:" + scope.path, scope.time);
+	}
+	if (recordPerFrame) {
+		benchmark.collectGpuFrame(currentFrame);
+	}
+	// Resetting the pools recycles all of the frame's command buffers at once, their memory is kept for the next recording
+	VK_CHECK_RESULT(vkResetCommandPool(device, frame.commandPool, 0));
+	for (auto& threadPool : frame.threadCommandPools) {
+		VK_CHECK_RESULT(vkResetCommandPool(device, threadPool.commandPool, 0));
+		threadPool.used = 0;
+	}
+	semaphores.presentComplete = frame.presentComplete;
+	semaphores.renderComplete = frame.renderComplete;
 	// Acquire the next image from the swap chain
 	VkResult result = swapChain.acquireNextImage(semaphores.presentComplete, &currentBuffer);
 	// Recreate the swapchain if it's no longer compatible with the surface (OUT_OF_DATE) or no longer optimal for presentation (SUBOPTIMAL)
@@ -589,10 +714,27 @@ void VulkanExampleBase::prepareFrame()
 	else {
 		VK_CHECK_RESULT(result);
 	}
+	// Images may be acquired out of order, so the image's command buffer can still be in use by another frame in flight
+	if (currentBuffer < imageFences.size()) {
+		if ((imageFences[currentBuffer] != VK_NULL_HANDLE) && (imageFences[currentBuffer] != frame.fence)) {
+			VK_CHECK_RESULT(vkWaitForFences(device, 1, &imageFences[currentBuffer], VK_TRUE, UINT64_MAX));
+		}
+		imageFences[currentBuffer] = frame.fence;
+	}
+	// Prebuilt command buffers are used once per swap chain image, the last use of this image's one has finished now
+	if (!recordPerFrame) {
+		benchmark.collectGpuFrame(currentBuffer);
+	}
+	VK_CHECK_RESULT(vkResetFences(device, 1, &frame.fence));
 }
 
 void VulkanExampleBase::submitFrame()
 {
+	benchmark.submitGpuFrame(recordPerFrame ? currentFrame : currentBuffer);
+	// Examples submit their work without a fence, an empty submission signals the frame's fence once all of it has finished
+	// This is done before presenting so the fence is always signaled, even if the swap chain has to be recreated
+	VK_CHECK_RESULT(vkQueueSubmit(queue, 0, nullptr, frames[currentFrame].fence));
+	currentFrame = (currentFrame + 1) % static_cast<uint32_t>(frames.size());
 	VkResult result = swapChain.queuePresent(queue, currentBuffer, semaphores.renderComplete);
 	if (!((result == VK_SUCCESS) || (result == VK_SUBOPTIMAL_KHR))) {
 		if (result == VK_ERROR_OUT_OF_DATE_KHR) {
@@ -603,7 +745,14 @@ void VulkanExampleBase::submitFrame()
 			VK_CHECK_RESULT(result);
 		}
 	}
-	VK_CHECK_RESULT(vkQueueWaitIdle(queue));
+	// With a single frame in flight the CPU waits for the GPU, which also allows examples to update their resources right after submitting a frame
+	if (frames.size() == 1) {
+		auto tWait = std::chrono::high_resolution_clock::now();
+		VK_CHECK_RESULT(vkQueueWaitIdle(queue));
+		frameWaitTime += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - tWait).count();
+	}
+	// Time the CPU spent blocked on the GPU, this is what overlapping frames saves
+	benchmark.record("wait", frameWaitTime);
 }
 
 VulkanExampleBase::VulkanExampleBase(bool enableValidation)
@@ -663,6 +812,8 @@ VulkanExampleBase::VulkanExampleBase(bool enableValidation)
 		if ((args[i] == std::string("-b")) || (args[i] == std::string("--benchmark"))) {
 			benchmark.active = true;
 			vks::tools::errorModeSilent = true;
+			// Assets loaded during preparation report their loading times to the benchmark
+			vks::Benchmark::setCurrent(&benchmark);
 		}
 		// Warmup time (in seconds)
 		if ((args[i] == std::string("-bw")) || (args[i] == std::string("--benchwarmup"))) {
@@ -697,12 +848,88 @@ VulkanExampleBase::VulkanExampleBase(bool enableValidation)
 				}
 			}
 		}
+		// Fixed number of benchmark frames (instead of a fixed duration)
+		if ((args[i] == std::string("-bfs")) || (args[i] == std::string("--benchframes"))) {
+			if (args.size() > i + 1) {
+				uint32_t num = strtol(args[i + 1], &numConvPtr, 10);
+				if (numConvPtr != args[i + 1]) {
+					benchmark.frameLimit = num;
+				}
+				else {
+					std::cerr << "Benchmark frame count must be specified as a number!" << std::endl;
+				}
+			}
+		}
 		// Output frame times to benchmark result file
 		if ((args[i] == std::string("-bt")) || (args[i] == std::string("--benchframetimes"))) {
 			benchmark.outputFrameTimes = true;
 		}
+		// Keep the UI overlay enabled in benchmark mode to measure its CPU time
+		if ((args[i] == std::string("-bo")) || (args[i] == std::string("--benchoverlay"))) {
+			benchmark.overlay = true;
+		}
+		// Render offscreen without a window
+		if (args[i] == std::string("--headless")) {
+			settings.headless = true;
+		}
+		// Number of frames to render in headless mode
+		if (args[i] == std::string("--headlessframes")) {
+			if (args.size() > i + 1) {
+				uint32_t num = strtol(args[i + 1], &numConvPtr, 10);
+				if (numConvPtr != args[i + 1]) {
+					settings.headlessFrameCount = num;
+				}
+				else {
+					std::cerr << "Headless frame count must be specified as a number!" << std::endl;
+				}
+			}
+		}
+		// Number of frames the CPU may prepare ahead of the GPU
+		if (args[i] == std::string("--frames-in-flight")) {
+			if (args.size() > i + 1) {
+				uint32_t num = strtol(args[i + 1], &numConvPtr, 10);
+				if ((numConvPtr != args[i + 1]) && (num >= 1) && (num <= MAX_FRAMES_IN_FLIGHT)) {
+					settings.framesInFlight = num;
+				}
+				else {
+					std::cerr << "Frames in flight must be a number between 1 and " << MAX_FRAMES_IN_FLIGHT << "!" << std::endl;
+				}
+			}
+		}
+		// Record per frame command buffers on all cores
+		if (args[i] == std::string("--parallel-recording")) {
+			settings.parallelRecording = true;
+		}
+		// Maximum rate at which the UI overlay is rebuilt without input (0 = every frame)
+		if (args[i] == std::string("--overlay-refresh-rate")) {
+			if (args.size() > i + 1) {
+				float rate = strtof(args[i + 1], &numConvPtr);
+				if ((numConvPtr != args[i + 1]) && (rate >= 0.0f)) {
+					settings.overlayRefreshRate = rate;
+				}
+				else {
+					std::cerr << "Overlay refresh rate must be a positive number (or 0 to update the overlay every frame)!" << std::endl;
+				}
+			}
+		}
+		// Write every headless frame to the given directory
+		if (args[i] == std::string("--dumpframes")) {
+			if (args.size() > i + 1) {
+				if (args[i + 1][0] == '-') {
+					std::cerr << "Directory for frame dumps must not start with a hyphen!" << std::endl;
+				} else {
+					swapChain.dumpPath = args[i + 1];
+				}
+			}
+		}
 	}
 
+	if (!swapChain.dumpPath.empty() && !settings.headless) {
+		std::cerr << "Frame dumps are only supported in headless mode" << std::endl;
+		swapChain.dumpPath = "";
+	}
+	swapChain.headless = settings.headless;
+
 #if defined(VK_USE_PLATFORM_ANDROID_KHR)
 	// Vulkan library is loaded dynamically on Android
 	bool libLoaded = vks::android::loadVulkanLibrary();
@@ -710,9 +937,13 @@ VulkanExampleBase::VulkanExampleBase(bool enableValidation)
 #elif defined(_DIRECT2DISPLAY)
 
 #elif defined(VK_USE_PLATFORM_WAYLAND_KHR)
-	initWaylandConnection();
+	if (!settings.headless) {
+		initWaylandConnection();
+	}
 #elif defined(VK_USE_PLATFORM_XCB_KHR)
-	initxcbConnection();
+	if (!settings.headless) {
+		initxcbConnection();
+	}
 #endif
 
 #if defined(_WIN32)
@@ -728,6 +959,9 @@ VulkanExampleBase::VulkanExampleBase(bool enableValidation)
 
 VulkanExampleBase::~VulkanExampleBase()
 {
+	if (vks::Benchmark::current() == &benchmark) {
+		vks::Benchmark::setCurrent(nullptr);
+	}
 	// Clean up Vulkan resources
 	swapChain.cleanup();
 	if (descriptorPool != VK_NULL_HANDLE)
@@ -749,12 +983,14 @@ VulkanExampleBase::~VulkanExampleBase()
 	vkDestroyImage(device, depthStencil.image, nullptr);
 	vkFreeMemory(device, depthStencil.mem, nullptr);
 
-	vkDestroyPipelineCache(device, pipelineCache, nullptr);
+	if (pipelineCache != VK_NULL_HANDLE) {
+		savePipelineCache();
+		vkDestroyPipelineCache(device, pipelineCache, nullptr);
+	}
 
 	vkDestroyCommandPool(device, cmdPool, nullptr);
 
-	vkDestroySemaphore(device, semaphores.presentComplete, nullptr);
-	vkDestroySemaphore(device, semaphores.renderComplete, nullptr);
+	destroyFrameResources();
 	for (auto& fence : waitFences) {
 		vkDestroyFence(device, fence, nullptr);
 	}
@@ -763,6 +999,7 @@ VulkanExampleBase::~VulkanExampleBase()
 		UIOverlay.freeResources();
 	}
 
+	gpuProfiler.destroy();
 	delete vulkanDevice;
 
 	if (settings.validation)
@@ -775,23 +1012,27 @@ VulkanExampleBase::~VulkanExampleBase()
 #if defined(_DIRECT2DISPLAY)
 
 #elif defined(VK_USE_PLATFORM_WAYLAND_KHR)
-	xdg_toplevel_destroy(xdg_toplevel);
-	xdg_surface_destroy(xdg_surface);
-	wl_surface_destroy(surface);
-	if (keyboard)
-		wl_keyboard_destroy(keyboard);
-	if (pointer)
-		wl_pointer_destroy(pointer);
-	wl_seat_destroy(seat);
-	xdg_wm_base_destroy(shell);
-	wl_compositor_destroy(compositor);
-	wl_registry_destroy(registry);
-	wl_display_disconnect(display);
+	if (!settings.headless) {
+		xdg_toplevel_destroy(xdg_toplevel);
+		xdg_surface_destroy(xdg_surface);
+		wl_surface_destroy(surface);
+		if (keyboard)
+			wl_keyboard_destroy(keyboard);
+		if (pointer)
+			wl_pointer_destroy(pointer);
+		wl_seat_destroy(seat);
+		xdg_wm_base_destroy(shell);
+		wl_compositor_destroy(compositor);
+		wl_registry_destroy(registry);
+		wl_display_disconnect(display);
+	}
 #elif defined(VK_USE_PLATFORM_ANDROID_KHR)
 	// todo : android cleanup (if required)
 #elif defined(VK_USE_PLATFORM_XCB_KHR)
-	xcb_destroy_window(connection, window);
-	xcb_disconnect(connection);
+	if (!settings.headless) {
+		xcb_destroy_window(connection, window);
+		xcb_disconnect(connection);
+	}
 #endif
 }
 
@@ -903,7 +1144,9 @@ bool VulkanExampleBase::initVulkan()
 	// This is handled by a separate class that gets a logical device representation
 	// and encapsulates functions related to a device
 	vulkanDevice = new vks::VulkanDevice(physicalDevice);
-	VkResult res = vulkanDevice->createLogicalDevice(enabledFeatures, enabledDeviceExtensions, deviceCreatepNextChain);
+	// The swapchain extension is kept in headless mode if available, as the examples transition the images to the present layout
+	const bool useSwapChain = !settings.headless || vulkanDevice->extensionSupported(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+	VkResult res = vulkanDevice->createLogicalDevice(enabledFeatures, enabledDeviceExtensions, deviceCreatepNextChain, useSwapChain);
 	if (res != VK_SUCCESS) {
 		vks::tools::exitFatal("Could not create Vulkan device: \n" + vks::tools::errorString(res), res);
 		return false;
@@ -919,17 +1162,12 @@ bool VulkanExampleBase::initVulkan()
 
 	swapChain.connect(instance, physicalDevice, device);
 
-	// Create synchronization objects
-	VkSemaphoreCreateInfo semaphoreCreateInfo = vks::initializers::semaphoreCreateInfo();
-	// Create a semaphore used to synchronize image presentation
-	// Ensures that the image is displayed before we start submitting new commands to the queu
-	VK_CHECK_RESULT(vkCreateSemaphore(device, &semaphoreCreateInfo, nullptr, &semaphores.presentComplete));
-	// Create a semaphore used to synchronize command submission
-	// Ensures that the image is not presented until all commands have been sumbitted and executed
-	VK_CHECK_RESULT(vkCreateSemaphore(device, &semaphoreCreateInfo, nullptr, &semaphores.renderComplete));
+	// Synchronization objects are created per frame in flight (see createFrameResources)
+	semaphores.presentComplete = VK_NULL_HANDLE;
+	semaphores.renderComplete = VK_NULL_HANDLE;
 
 	// Set up submit info structure
-	// Semaphores will stay the same during application lifetime
+	// The semaphores pointed to are switched to those of the current frame in flight by prepareFrame
 	// Command buffer submission info is set by each example
 	submitInfo = vks::initializers::submitInfo();
 	submitInfo.pWaitDstStageMask = &submitPipelineStages;
@@ -990,6 +1228,10 @@ void VulkanExampleBase::setupDPIAwareness()
 HWND VulkanExampleBase::setupWindow(HINSTANCE hinstance, WNDPROC wndproc)
 {
 	this->windowInstance = hinstance;
+	if (settings.headless) {
+		window = nullptr;
+		return window;
+	}
 
 	WNDCLASSEX wndClass;
 
@@ -1732,6 +1974,9 @@ static const struct xdg_toplevel_listener xdg_toplevel_listener = {
 
 struct xdg_surface *VulkanExampleBase::setupWindow()
 {
+	if (settings.headless) {
+		return nullptr;
+	}
 	surface = wl_compositor_create_surface(compositor);
 	xdg_surface = xdg_wm_base_get_xdg_surface(shell, surface);
 
@@ -1758,6 +2003,11 @@ xcb_window_t VulkanExampleBase::setupWindow()
 {
 	uint32_t value_mask, value_list[32];
 
+	if (settings.headless) {
+		window = 0;
+		return window;
+	}
+
 	window = xcb_generate_id(connection);
 
 	value_mask = XCB_CW_BACK_PIXEL | XCB_CW_EVENT_MASK;
@@ -1961,6 +2211,8 @@ void VulkanExampleBase::mouseMoved(double x, double y, bool & handled) {}
 
 void VulkanExampleBase::buildCommandBuffers() {}
 
+void VulkanExampleBase::buildFrameCommandBuffer(VkCommandBuffer commandBuffer) {}
+
 void VulkanExampleBase::createSynchronizationPrimitives()
 {
 	// Wait fences to sync command buffer access
@@ -1971,6 +2223,148 @@ void VulkanExampleBase::createSynchronizationPrimitives()
 	}
 }
 
+void VulkanExampleBase::createFrameResources()
+{
+	// The requested number of frames in flight is limited to what the example supports
+	settings.framesInFlight = std::max(1u, std::min(settings.framesInFlight, maxFramesInFlight));
+	frames.resize(settings.framesInFlight);
+	currentFrame = 0;
+	imageFences.assign(swapChain.imageCount, VK_NULL_HANDLE);
+	// The job system's threads (including this one) each get their own command pools
+	settings.parallelRecording = settings.parallelRecording && recordPerFrame;
+	if (settings.parallelRecording) {
+		recordingJobSystem.reset(new vks::JobSystem());
+	}
+	const uint32_t recordingThreadCount = recordingJobSystem ? recordingJobSystem->threadCount() : 1;
+	VkSemaphoreCreateInfo semaphoreCreateInfo = vks::initializers::semaphoreCreateInfo();
+	VkFenceCreateInfo fenceCreateInfo = vks::initializers::fenceCreateInfo(VK_FENCE_CREATE_SIGNALED_BIT);
+	// Command buffers are recorded once per use and only reset together with their pool
+	VkCommandPoolCreateInfo cmdPoolInfo = vks::initializers::commandPoolCreateInfo();
+	cmdPoolInfo.queueFamilyIndex = swapChain.queueNodeIndex;
+	cmdPoolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+	for (auto& frame : frames) {
+		// Ensures that the image is displayed before we start submitting new commands to the queue
+		VK_CHECK_RESULT(vkCreateSemaphore(device, &semaphoreCreateInfo, nullptr, &frame.presentComplete));
+		// Ensures that the image is not presented until all commands have been submitted and executed
+		VK_CHECK_RESULT(vkCreateSemaphore(device, &semaphoreCreateInfo, nullptr, &frame.renderComplete));
+		// Created signaled, so the first wait for each frame returns immediately
+		VK_CHECK_RESULT(vkCreateFence(device, &fenceCreateInfo, nullptr, &frame.fence));
+		VK_CHECK_RESULT(vkCreateCommandPool(device, &cmdPoolInfo, nullptr, &frame.commandPool));
+		VkCommandBufferAllocateInfo cmdBufAllocateInfo = vks::initializers::commandBufferAllocateInfo(frame.commandPool, VK_COMMAND_BUFFER_LEVEL_PRIMARY, 1);
+		VK_CHECK_RESULT(vkAllocateCommandBuffers(device, &cmdBufAllocateInfo, &frame.commandBuffer));
+		frame.threadCommandPools.resize(recordingThreadCount);
+		for (auto& threadPool : frame.threadCommandPools) {
+			VK_CHECK_RESULT(vkCreateCommandPool(device, &cmdPoolInfo, nullptr, &threadPool.commandPool));
+		}
+	}
+	semaphores.presentComplete = frames[0].presentComplete;
+	semaphores.renderComplete = frames[0].renderComplete;
+}
+
+void VulkanExampleBase::destroyFrameResources()
+{
+	for (auto& frame : frames) {
+		vkDestroySemaphore(device, frame.presentComplete, nullptr);
+		vkDestroySemaphore(device, frame.renderComplete, nullptr);
+		vkDestroyFence(device, frame.fence, nullptr);
+		// Destroying the pools frees their command buffers
+		vkDestroyCommandPool(device, frame.commandPool, nullptr);
+		for (auto& threadPool : frame.threadCommandPools) {
+			vkDestroyCommandPool(device, threadPool.commandPool, nullptr);
+		}
+	}
+	frames.clear();
+}
+
+VkDeviceSize VulkanExampleBase::getFrameSliceSize(VkDeviceSize size) const
+{
+	// Both limits are powers of two, so aligning to the larger one satisfies both
+	VkDeviceSize alignment = std::max(deviceProperties.limits.minUniformBufferOffsetAlignment, deviceProperties.limits.nonCoherentAtomSize);
+	alignment = std::max(alignment, (VkDeviceSize)1);
+	return (size + alignment - 1) & ~(alignment - 1);
+}
+
+uint32_t VulkanExampleBase::getFrameSliceOffset(VkDeviceSize size) const
+{
+	return static_cast<uint32_t>(getFrameSliceSize(size) * currentFrame);
+}
+
+void VulkanExampleBase::createFrameUniformBuffer(vks::Buffer *buffer, VkDeviceSize size)
+{
+	const VkDeviceSize sliceSize = getFrameSliceSize(size);
+	VK_CHECK_RESULT(vulkanDevice->createBuffer(
+		VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
+		buffer,
+		sliceSize * frames.size()));
+	VK_CHECK_RESULT(buffer->map());
+	// Descriptors cover a single slice, the slice is selected with a dynamic offset
+	buffer->setupDescriptor(sliceSize);
+}
+
+VkCommandBuffer VulkanExampleBase::recordFrameCommandBuffer()
+{
+	auto tStart = std::chrono::high_resolution_clock::now();
+	const VkCommandBuffer commandBuffer = frames[currentFrame].commandBuffer;
+	VkCommandBufferBeginInfo cmdBufInfo = vks::initializers::commandBufferBeginInfo();
+	cmdBufInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	VK_CHECK_RESULT(vkBeginCommandBuffer(commandBuffer, &cmdBufInfo));
+	gpuProfiler.beginFrame(commandBuffer, currentFrame);
+	benchmark.beginGpuFrame(commandBuffer, currentFrame);
+	{
+		vks::GpuProfiler::Scope frameScope(gpuProfiler, commandBuffer, "frame");
+		frameProfilerScope = frameScope.id();
+		buildFrameCommandBuffer(commandBuffer);
+	}
+	frameProfilerScope = vks::GpuProfiler::INVALID_SCOPE;
+	benchmark.endGpuFrame(commandBuffer, currentFrame);
+	VK_CHECK_RESULT(vkEndCommandBuffer(commandBuffer));
+	recordTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - tStart).count();
+	benchmark.record("record", recordTime);
+	return commandBuffer;
+}
+
+void VulkanExampleBase::recordSecondaryCommandBuffers(uint32_t count, const VkCommandBufferInheritanceInfo &inheritanceInfo, const std::function<void(VkCommandBuffer commandBuffer, uint32_t first, uint32_t last)> &recordFunc, std::vector<VkCommandBuffer> &commandBuffers)
+{
+	FrameResources &frame = frames[currentFrame];
+	// Several chunks per thread, so the job system can balance threads that get preempted
+	const uint32_t threadCount = static_cast<uint32_t>(frame.threadCommandPools.size());
+	const uint32_t chunkCount = std::min(count, threadCount * 4);
+	const size_t firstCommandBuffer = commandBuffers.size();
+	commandBuffers.resize(firstCommandBuffer + chunkCount);
+
+	auto recordChunk = [&](size_t chunk) {
+		const uint32_t threadIndex = recordingJobSystem ? recordingJobSystem->currentThreadIndex() : 0;
+		assert(threadIndex < threadCount);
+		ThreadCommandPool &threadPool = frame.threadCommandPools[threadIndex];
+		if (threadPool.used == threadPool.commandBuffers.size()) {
+			// Only the owning thread allocates from its pool
+			VkCommandBuffer commandBuffer;
+			VkCommandBufferAllocateInfo cmdBufAllocateInfo = vks::initializers::commandBufferAllocateInfo(threadPool.commandPool, VK_COMMAND_BUFFER_LEVEL_SECONDARY, 1);
+			VK_CHECK_RESULT(vkAllocateCommandBuffers(device, &cmdBufAllocateInfo, &commandBuffer));
+			threadPool.commandBuffers.push_back(commandBuffer);
+		}
+		const VkCommandBuffer commandBuffer = threadPool.commandBuffers[threadPool.used++];
+		VkCommandBufferBeginInfo cmdBufInfo = vks::initializers::commandBufferBeginInfo();
+		cmdBufInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		cmdBufInfo.pInheritanceInfo = &inheritanceInfo;
+		VK_CHECK_RESULT(vkBeginCommandBuffer(commandBuffer, &cmdBufInfo));
+		const uint32_t first = static_cast<uint32_t>((uint64_t)count * chunk / chunkCount);
+		const uint32_t last = static_cast<uint32_t>((uint64_t)count * (chunk + 1) / chunkCount);
+		recordFunc(commandBuffer, first, last);
+		VK_CHECK_RESULT(vkEndCommandBuffer(commandBuffer));
+		commandBuffers[firstCommandBuffer + chunk] = commandBuffer;
+	};
+
+	if (recordingJobSystem && (chunkCount > 1)) {
+		recordingJobSystem->parallelFor(chunkCount, recordChunk, 1);
+	} else {
+		for (uint32_t chunk = 0; chunk < chunkCount; chunk++) {
+			recordChunk(chunk);
+		}
+	}
+}
+
 void VulkanExampleBase::createCommandPool()
 {
 	VkCommandPoolCreateInfo cmdPoolInfo = {};
@@ -2139,6 +2533,7 @@ void VulkanExampleBase::windowResize()
 	width = destWidth;
 	height = destHeight;
 	setupSwapChain();
+	imageFences.assign(swapChain.imageCount, VK_NULL_HANDLE);
 
 	// Recreate the frame buffers
 	vkDestroyImageView(device, depthStencil.view, nullptr);
@@ -2215,6 +2610,10 @@ void VulkanExampleBase::windowResized()
 
 void VulkanExampleBase::initSwapchain()
 {
+	if (settings.headless) {
+		swapChain.initHeadless(queue, vulkanDevice->queueFamilyIndices.graphics);
+		return;
+	}
 #if defined(_WIN32)
 	swapChain.initSurface(windowInstance, window);
 #elif defined(VK_USE_PLATFORM_ANDROID_KHR)
@@ -39,6 +39,7 @@
 #include <glm/glm.hpp>
 #include <string>
 #include <numeric>
+#include <algorithm>
 #include <array>
 
 #include "vulkan/vulkan.h"
@@ -51,8 +52,12 @@
 #include "VulkanInitializers.hpp"
 #include "VulkanDevice.hpp"
 #include "VulkanSwapChain.hpp"
+#include "VulkanPipelineCache.hpp"
+#include "VulkanMeshCache.hpp"
 #include "camera.hpp"
 #include "benchmark.hpp"
+#include "VulkanGpuProfiler.hpp"
+#include "jobsystem.hpp"
 
 class VulkanExampleBase
 {
@@ -67,13 +72,35 @@ private:
 	void nextFrame();
 	void updateOverlay();
 	void createPipelineCache();
+	void savePipelineCache();
 	void createCommandPool();
 	void createSynchronizationPrimitives();
+	void createFrameResources();
+	void destroyFrameResources();
 	void initSwapchain();
 	void setupSwapChain();
 	void createCommandBuffers();
 	void destroyCommandBuffers();
 	std::string shaderDir = "glsl";
+	/** @brief File the pipeline cache is loaded from at startup and stored to on shutdown */
+	std::string pipelineCacheFile;
+	/** @brief Start of the example's preparation, used to measure startup time */
+	std::chrono::time_point<std::chrono::high_resolution_clock> prepareTimestamp;
+	/** @brief Fence of the frame in flight that last rendered to each swap chain image (VK_NULL_HANDLE if unused) */
+	std::vector<VkFence> imageFences;
+	/** @brief Time in ms the CPU waited for the GPU to finish earlier frames during the current frame */
+	double frameWaitTime = 0.0;
+	/** @brief Input state and time of the last overlay update, the overlay is only rebuilt if these change (see updateOverlay) */
+	struct {
+		glm::vec2 mousePos;
+		bool mouseLeft = false;
+		bool mouseRight = false;
+		uint32_t width = 0;
+		uint32_t height = 0;
+		std::chrono::time_point<std::chrono::high_resolution_clock> lastUpdate;
+		/** @brief Forces an update with the next frame, as ImGui applies some changes (e.g. window sizes) one frame late */
+		bool followUp = true;
+	} overlayState;
 protected:
 	// Returns the path to the root of the glsl or hlsl shader directory.
 	std::string getShadersPath() const;
@@ -124,10 +151,10 @@ protected:
 	// List of shader modules created (stored for cleanup)
 	std::vector<VkShaderModule> shaderModules;
 	// Pipeline cache object
-	VkPipelineCache pipelineCache;
+	VkPipelineCache pipelineCache = VK_NULL_HANDLE;
 	// Wraps the swap chain to present images (framebuffers) to the windowing system
 	VulkanSwapChain swapChain;
-	// Synchronization semaphores
+	// Synchronization semaphores of the current frame in flight (set by prepareFrame)
 	struct {
 		// Swap chain image presentation
 		VkSemaphore presentComplete;
@@ -135,6 +162,69 @@ protected:
 		VkSemaphore renderComplete;
 	} semaphores;
 	std::vector<VkFence> waitFences;
+	/** @brief Secondary command buffers of one recording thread for a frame in flight, a command pool must only be used by one thread at a time */
+	struct ThreadCommandPool {
+		VkCommandPool commandPool = VK_NULL_HANDLE;
+		/** @brief Grows on demand and is kept across frames, resetting the pool makes all buffers available again */
+		std::vector<VkCommandBuffer> commandBuffers;
+		/** @brief Number of command buffers handed out since the last reset */
+		uint32_t used = 0;
+	};
+	/** @brief Resources owned by a single frame in flight, reused once the GPU has finished that frame */
+	struct FrameResources {
+		VkSemaphore presentComplete = VK_NULL_HANDLE;
+		VkSemaphore renderComplete = VK_NULL_HANDLE;
+		/** @brief Signaled when all work submitted for this frame has finished executing */
+		VkFence fence = VK_NULL_HANDLE;
+		/** @brief Transient pool of the frame's primary command buffer, reset as a whole by prepareFrame */
+		VkCommandPool commandPool = VK_NULL_HANDLE;
+		/** @brief Primary command buffer for examples that record their commands every frame */
+		VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+		/** @brief Transient pools for secondary command buffers, one per recording thread (see recordSecondaryCommandBuffers) */
+		std::vector<ThreadCommandPool> threadCommandPools;
+		/** @brief Slice of the overlay's vertex and index buffers drawn by this frame */
+		uint32_t overlaySlice = 0;
+	};
+	/** @brief One entry per frame in flight (settings.framesInFlight) */
+	std::vector<FrameResources> frames;
+	/** @brief Index of the frame in flight that is currently prepared by the CPU */
+	uint32_t currentFrame = 0;
+	/**
+	* @brief Highest number of frames in flight the example supports (must be set in the derived constructor)
+	*
+	* Examples that update buffers or re-record command buffers while earlier frames are still executing need one copy of these per frame in flight,
+	* so the default of one keeps the CPU waiting for the GPU at the end of each frame
+	*/
+	uint32_t maxFramesInFlight = 1;
+	/** @brief Returns the size of one frame's slice of a per-frame uniform buffer, aligned for use as a dynamic offset and for flushing */
+	VkDeviceSize getFrameSliceSize(VkDeviceSize size) const;
+	/** @brief Returns the dynamic offset of the current frame's slice in a per-frame uniform buffer */
+	uint32_t getFrameSliceOffset(VkDeviceSize size) const;
+	/** @brief Creates a persistently mapped uniform buffer with one slice of the given size for each frame in flight */
+	void createFrameUniformBuffer(vks::Buffer *buffer, VkDeviceSize size);
+	/**
+	* @brief Examples that record their commands every frame (via buildFrameCommandBuffer) instead of prebuilding drawCmdBuffers set this in their constructor
+	*
+	* Changes like overlay updates are then picked up by the next frame's recording instead of rebuilding the command buffers of all swap chain images
+	*/
+	bool recordPerFrame = false;
+	/** @brief Job system recording secondary command buffers in parallel, only created if settings.parallelRecording is set */
+	std::unique_ptr<vks::JobSystem> recordingJobSystem;
+	/** @brief CPU time in ms spent recording the last frame's command buffer (recordPerFrame only) */
+	double recordTime = 0.0;
+	/** @brief Records the current frame's primary command buffer using buildFrameCommandBuffer and measures the time spent */
+	VkCommandBuffer recordFrameCommandBuffer();
+	/** @brief GPU profiler scope wrapping buildFrameCommandBuffer, to be used as the parent of the example's scopes */
+	uint32_t frameProfilerScope = vks::GpuProfiler::INVALID_SCOPE;
+	/**
+	* @brief Splits count items into chunks that are recorded into secondary command buffers, in parallel if settings.parallelRecording is set
+	*
+	* @param count Number of items (e.g. draws) to record
+	* @param inheritanceInfo Render pass state the secondary command buffers continue
+	* @param recordFunc Records the items [first, last) into the given command buffer, must be safe to call concurrently for different ranges
+	* @param commandBuffers The recorded secondary command buffers are appended in item order, ready for vkCmdExecuteCommands
+	*/
+	void recordSecondaryCommandBuffers(uint32_t count, const VkCommandBufferInheritanceInfo &inheritanceInfo, const std::function<void(VkCommandBuffer commandBuffer, uint32_t first, uint32_t last)> &recordFunc, std::vector<VkCommandBuffer> &commandBuffers);
 public:
 	bool prepared = false;
 	uint32_t width = 1280;
@@ -147,9 +237,20 @@ public:
 
 	vks::Benchmark benchmark;
 
+	/**
+	* @brief Timestamp profiler for scopes of the command buffers recorded for the current frame
+	*
+	* recordFrameCommandBuffer starts the profiler's frame and wraps buildFrameCommandBuffer in a "frame" scope, examples that record their command buffers
+	* themselves call gpuProfiler.beginFrame first. Results are shown in the overlay and recorded as "gpu:<scope path>" benchmark series.
+	*/
+	vks::GpuProfiler gpuProfiler;
+
 	/** @brief Encapsulated physical and logical vulkan device */
 	vks::VulkanDevice *vulkanDevice;
 
+	/** @brief Upper limit for the number of frames in flight that can be requested */
+	static const uint32_t MAX_FRAMES_IN_FLIGHT = 3;
+
 	/** @brief Example settings that can be changed e.g. by command line arguments */
 	struct Settings {
 		/** @brief Activates validation layers (and message output) when set to true */
@@ -160,6 +261,16 @@ public:
 		bool vsync = false;
 		/** @brief Enable UI overlay */
 		bool overlay = false;
+		/** @brief Render to an offscreen image ring instead of a window, no display or windowing system is required */
+		bool headless = false;
+		/** @brief Number of frames rendered in headless mode (outside of benchmark mode) before the example exits */
+		uint32_t headlessFrameCount = 100;
+		/** @brief Number of frames the CPU may prepare while the GPU is still rendering earlier ones (1 to MAX_FRAMES_IN_FLIGHT), limited to maxFramesInFlight */
+		uint32_t framesInFlight = 2;
+		/** @brief Record per frame command buffers on all CPU cores using secondary command buffers (examples with recordPerFrame only) */
+		bool parallelRecording = false;
+		/** @brief Maximum rate in Hz at which the overlay is rebuilt without input or invalidation (e.g. for statistics), 0 rebuilds it every frame */
+		float overlayRefreshRate = 10.0f;
 	} settings;
 
 	VkClearColorValue defaultClearColor = { { 0.025f, 0.025f, 0.025f, 1.0f } };
@@ -318,6 +429,8 @@ public:
 	virtual void windowResized();
 	/** @brief (Virtual) Called when resources have been recreated that require a rebuild of the command buffers (e.g. frame buffer), to be implemente by the sample application */
 	virtual void buildCommandBuffers();
+	/** @brief (Virtual) Records the commands of the current frame into the given (already begun) command buffer, called every frame for examples with recordPerFrame */
+	virtual void buildFrameCommandBuffer(VkCommandBuffer commandBuffer);
 	/** @brief (Virtual) Setup default depth and stencil views */
 	virtual void setupDepthStencil();
 	/** @brief (Virtual) Setup default framebuffers for all requested swapchain images */
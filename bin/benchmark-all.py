@@ -1,84 +1,204 @@
+#!/usr/bin/env python3
 # Benchmark all examples
-import subprocess
-import sys
+#
+# Runs every example in benchmark mode, writes a consolidated report and
+# optionally compares it against a baseline report from a previous run.
+# Returns a non-zero exit code if an example regressed beyond the threshold or failed to run.
+import argparse
+import json
 import os
 import platform
+import re
+import subprocess
+import sys
+
+SCRIPT_DIR = os.path.dirname(os.path.abspath(__file__))
+
+# Metrics stored in the report for each example, "<series>.<statistic>" refers to the statistics written by the benchmark
+METRICS = ["frame.mean", "frame.p50", "frame.p90", "frame.p99", "frame.p99_9", "frame.stddev", "frame.stutters", "cpu.p50", "gpu.p50", "gpu.p99", "ui.mean"]
+
+
+def read_examples(cmake_file):
+	# The list of examples is taken from the EXAMPLES variable of the examples' CMakeLists.txt
+	with open(cmake_file) as f:
+		match = re.search(r"set\(EXAMPLES(.*?)\)", f.read(), re.DOTALL)
+	if not match:
+		sys.exit("Could not find the list of examples in %s" % cmake_file)
+	return match.group(1).split()
+
+
+def get_metric(result, metric):
+	series, statistic = metric.split(".")
+	stats = result.get("statistics", {}).get(series, {})
+	if stats.get("count", 0) == 0:
+		return None
+	return stats.get(statistic)
+
+
+def run_example(example, args, frames_in_flight=None):
+	executable = os.path.join(args.bin_dir, example + (".exe" if platform.system() == "Windows" else ""))
+	if not os.path.isfile(executable):
+		return {"status": "missing"}
+	result_file = os.path.join(args.output_dir, "%s.json" % example if frames_in_flight is None else "%s.inflight%d.json" % (example, frames_in_flight))
+	if os.path.isfile(result_file):
+		os.remove(result_file)
+	command = [executable, "-b", "-bw", str(args.warmup), "-bfs", str(args.frames), "-bf", result_file, "-w", str(args.width), "-h", str(args.height)]
+	if args.headless:
+		command.append("--headless")
+	if frames_in_flight is not None:
+		command += ["--frames-in-flight", str(frames_in_flight)]
+	command += args.extra_args.split()
+	try:
+		result_code = subprocess.call(command, cwd=args.bin_dir, timeout=args.timeout)
+	except subprocess.TimeoutExpired:
+		return {"status": "timeout"}
+	if result_code != 0 or not os.path.isfile(result_file):
+		return {"status": "failed", "resultCode": result_code}
+	with open(result_file) as f:
+		result = json.load(f)
+	entry = {"status": "ok", "fps": result.get("fps"), "frames": result.get("frames"), "startup": result.get("startup"), "variant": result.get("variant", ""), "framesInFlight": result.get("framesInFlight", 1)}
+	for metric in METRICS:
+		entry[metric] = get_metric(result, metric)
+	entry["device"] = result.get("device", {})
+	entry["build"] = result.get("build")
+	return entry
+
+
+def compare(report, baseline, metric, threshold):
+	regressions = []
+	improvements = []
+	for example, current in sorted(report["results"].items()):
+		previous = baseline.get("results", {}).get(example)
+		if previous is None or previous.get("status") != "ok":
+			continue
+		if current["status"] != "ok":
+			regressions.append((example, "%s (ok in baseline)" % current["status"]))
+			continue
+		old = previous.get(metric)
+		new = current.get(metric)
+		if not old or new is None:
+			continue
+		# All metrics are times, so larger values are worse
+		change = (new - old) / old * 100.0
+		line = "%s %.3f -> %.3f (%+.1f%%)" % (metric, old, new, change)
+		if change > threshold:
+			regressions.append((example, line))
+		elif change < -threshold:
+			improvements.append((example, line))
+	return regressions, improvements
+
+
+def main():
+	parser = argparse.ArgumentParser(description="Run all examples in benchmark mode and compare the results against a baseline")
+	parser.add_argument("--bin-dir", default=os.getcwd(), help="directory containing the example binaries (default: current directory)")
+	parser.add_argument("--examples-list", default=os.path.join(SCRIPT_DIR, "..", "examples", "CMakeLists.txt"), help="CMakeLists.txt containing the list of examples")
+	parser.add_argument("--examples", nargs="*", help="only run the given examples")
+	parser.add_argument("--output-dir", default="./benchmark", help="directory for the per-example results and the report")
+	parser.add_argument("--frames", type=int, default=1000, help="number of frames to benchmark per example (default: 1000)")
+	parser.add_argument("--warmup", type=int, default=1, help="warmup time in seconds (default: 1)")
+	parser.add_argument("--width", type=int, default=1280)
+	parser.add_argument("--height", type=int, default=720)
+	parser.add_argument("--timeout", type=int, default=300, help="maximum run time per example in seconds (default: 300)")
+	parser.add_argument("--headless", action="store_true", help="render offscreen without a window, for machines without a display")
+	parser.add_argument("--extra-args", default="", help="additional arguments passed to every example")
+	parser.add_argument("--frames-in-flight", type=int, choices=[2, 3], help="run every example a second time with the given number of frames in flight and report the throughput against a single frame in flight")
+	parser.add_argument("--baseline", help="report of a previous run to compare against")
+	parser.add_argument("--update-baseline", action="store_true", help="store the report of this run as the baseline")
+	parser.add_argument("--metric", default="frame.p50", choices=METRICS, help="metric compared against the baseline (default: frame.p50)")
+	parser.add_argument("--threshold", type=float, default=5.0, help="relative change in percent flagged as a regression (default: 5)")
+	args = parser.parse_args()
+	if args.update_baseline and not args.baseline:
+		parser.error("--update-baseline requires --baseline")
+
+	args.bin_dir = os.path.abspath(args.bin_dir)
+	args.output_dir = os.path.abspath(args.output_dir)
+	os.makedirs(args.output_dir, exist_ok=True)
+
+	examples = args.examples if args.examples else read_examples(args.examples_list)
+
+	print("Benchmarking all examples...")
+
+	report = {"frames": args.frames, "warmup": args.warmup, "resolution": {"width": args.width, "height": args.height}, "headless": args.headless, "extraArgs": args.extra_args, "results": {}}
+	if args.frames_in_flight:
+		report["framesInFlight"] = args.frames_in_flight
+	for index, example in enumerate(examples):
+		print("---- (%d/%d) Running %s in benchmark mode ----" % (index + 1, len(examples), example))
+		# The regular results are measured with a single frame in flight, so they can be compared against the pipelined run
+		entry = run_example(example, args, 1 if args.frames_in_flight else None)
+		if args.frames_in_flight and entry["status"] == "ok":
+			print("---- (%d/%d) Running %s with %d frames in flight ----" % (index + 1, len(examples), example, args.frames_in_flight))
+			pipelined = run_example(example, args, args.frames_in_flight)
+			if pipelined["status"] == "ok":
+				# Examples that don't support more frames in flight fall back to one
+				entry["pipelined"] = {"framesInFlight": pipelined["framesInFlight"], "fps": pipelined["fps"], "frame.p50": pipelined["frame.p50"], "frame.p99": pipelined["frame.p99"], "speedup": pipelined["fps"] / entry["fps"] if entry["fps"] else None}
+			else:
+				entry["pipelined"] = {"status": pipelined["status"]}
+		report["results"][example] = entry
+		if entry["status"] == "ok":
+			# Device and build are the same for all examples of a run
+			report["device"] = entry.pop("device")
+			report["build"] = entry.pop("build")
+			print("Results written to %s" % os.path.join(args.output_dir, "%s.json" % example))
+		else:
+			print("Error, status = %s" % entry["status"])
+
+	report_file = os.path.join(args.output_dir, "report.json")
+	with open(report_file, "w") as f:
+		json.dump(report, f, indent=2, sort_keys=True)
+
+	print()
+	print("%-28s %10s %10s %10s %10s %10s" % ("example", "fps", "p50 ms", "p99 ms", "gpu p50", "stutters"))
+	for example, entry in report["results"].items():
+		if entry["status"] != "ok":
+			print("%-28s %s" % (example, entry["status"]))
+			continue
+		gpu = entry["gpu.p50"]
+		print("%-28s %10.1f %10.3f %10.3f %10s %10d" % (example, entry["fps"], entry["frame.p50"], entry["frame.p99"], "%.3f" % gpu if gpu is not None else "-", entry["frame.stutters"]))
+
+	if args.frames_in_flight:
+		print()
+		print("%-28s %10s %10s %10s %10s" % ("example", "in flight", "fps", "fps (1)", "speedup"))
+		for example, entry in report["results"].items():
+			pipelined = entry.get("pipelined")
+			if pipelined is None:
+				continue
+			if "status" in pipelined:
+				print("%-28s %s" % (example, pipelined["status"]))
+				continue
+			speedup = pipelined["speedup"]
+			print("%-28s %10d %10.1f %10.1f %10s" % (example, pipelined["framesInFlight"], pipelined["fps"], entry["fps"], "%.2fx" % speedup if speedup is not None else "-"))
+	print("Report written to %s" % report_file)
+
+	regressions = []
+	if args.baseline:
+		if os.path.isfile(args.baseline):
+			with open(args.baseline) as f:
+				baseline = json.load(f)
+			if baseline.get("device") != report.get("device") or baseline.get("build") != report.get("build"):
+				print("Warning: baseline was recorded with a different device, driver or build")
+			if baseline.get("headless", False) != report["headless"]:
+				print("Warning: baseline was recorded %s" % ("with a window" if report["headless"] else "in headless mode"))
+			regressions, improvements = compare(report, baseline, args.metric, args.threshold)
+			print()
+			print("Compared against %s (%s, threshold %.1f%%)" % (args.baseline, args.metric, args.threshold))
+			for example, line in improvements:
+				print("  improved  %-28s %s" % (example, line))
+			for example, line in regressions:
+				print("  REGRESSED %-28s %s" % (example, line))
+			if not regressions:
+				print("No regressions")
+		else:
+			print("Baseline %s does not exist yet" % args.baseline)
+		if args.update_baseline:
+			with open(args.baseline, "w") as f:
+				json.dump(report, f, indent=2, sort_keys=True)
+			print("Baseline updated")
+
+	failed = [example for example, entry in report["results"].items() if entry["status"] not in ("ok", "missing")]
+	print("Benchmark run finished")
+	if regressions or failed:
+		sys.exit(1)
+
 
-EXAMPLES = [
-	"bloom",
-	"computecloth",
-	"computecullandlod",
-	"computenbody",
-	"computeparticles",
-	"computeshader",
-	"debugmarker",
-	"deferred",
-	"deferredmultisampling",
-	"deferredshadows",
-	"displacement",
-	"distancefieldfonts",
-	"dynamicuniformbuffer",
-	"gears",
-	"geometryshader",
-	"hdr",
-	"imgui",
-	"indirectdraw",
-	"instancing",
-	"mesh",
-	"multisampling",
-	"multithreading",
-	"occlusionquery",
-	"offscreen",
-	"parallaxmapping",
-	"particlefire",
-	"pbrbasic",
-	"pbribl",
-	"pbrtexture",
-	"pipelines",
-	"pushconstants",
-	"radialblur",
-	"raytracing",
-	"scenerendering",
-	"shadowmapping",
-	"shadowmappingomni",
-	"skeletalanimation",
-	"specializationconstants",
-	"sphericalenvmapping",
-	"ssao",
-	"stencilbuffer",
-	"subpasses",
-	"terraintessellation",
-	"tessellation",
-	"textoverlay",
-	"texture",
-	"texture3d",
-	"texturearray",
-	"texturecubemap",
-	"texturemipmapgen",
-	"texturesparseresidency",
-	"triangle",
-	"viewportarray",
-	"vulkanscene"
-]
-
-CURR_INDEX = 0
-
-ARGS = "-fullscreen -b"
-
-print("Benchmarking all examples...")
-
-os.makedirs("./benchmark", exist_ok=True)
-
-for example in EXAMPLES:
-	print("---- (%d/%d) Running %s in benchmark mode ----" % (CURR_INDEX+1, len(EXAMPLES), example))
-	if platform.system() == 'Linux':
-		RESULT_CODE = subprocess.call("./%s %s -bf ./benchmark/%s.csv 5" % (example, ARGS, example), shell=True)
-	else:
-		RESULT_CODE = subprocess.call("%s %s -bf ./benchmark/%s.csv 5" % (example, ARGS, example))
-	if RESULT_CODE == 0:
-		print("Results written to ./benchmark/%s.csv" % example)
-	else:
-		print("Error, result code = %d" % RESULT_CODE)
-	CURR_INDEX += 1
-
-print("Benchmark run finished")
+if __name__ == "__main__":
+	main()
@@ -0,0 +1,79 @@
+#version 450
+
+// Positions are dequantized with the draw's scale and offset (identity for float positions)
+layout (location = 0) in vec3 inPos;
+// Octahedral encoded normals only fill the first two components
+layout (location = 1) in vec3 inNormal;
+
+layout (constant_id = 0) const bool OCTAHEDRAL_NORMALS = false;
+
+layout (set = 0, binding = 0) uniform UBO {
+	mat4 projection;
+	mat4 view;
+	mat4 model;
+} ubo;
+
+// Flattened draw list of the model, the index of the draw is passed as its first instance
+struct DrawData {
+	uint matrixIndex;
+	uint materialIndex;
+	uint jointOffset;
+	uint jointCount;
+	vec4 positionScale;
+	vec4 positionOffset;
+};
+
+struct Material {
+	vec4 baseColorFactor;
+	int baseColorTexture;
+	int normalTexture;
+	int metallicRoughnessTexture;
+	float alphaCutoff;
+};
+
+layout (std430, set = 1, binding = 0) readonly buffer Draws {
+	DrawData draws[];
+};
+
+layout (std430, set = 1, binding = 1) readonly buffer Matrices {
+	mat4 matrices[];
+};
+
+layout (std430, set = 1, binding = 2) readonly buffer Materials {
+	Material materials[];
+};
+
+layout (location = 0) out vec3 outNormal;
+layout (location = 1) out vec3 outColor;
+layout (location = 2) out vec3 outViewVec;
+layout (location = 3) out vec3 outLightVec;
+
+out gl_PerVertex
+{
+	vec4 gl_Position;
+};
+
+vec3 octahedralDecode(vec2 e)
+{
+	vec3 n = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+	float t = max(-n.z, 0.0);
+	n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+	return normalize(n);
+}
+
+void main() 
+{
+	DrawData draw = draws[gl_InstanceIndex];
+	mat4 nodeMatrix = matrices[draw.matrixIndex];
+	outColor = materials[draw.materialIndex].baseColorFactor.rgb;
+	vec4 pos = vec4(draw.positionOffset.xyz + draw.positionScale.xyz * inPos, 1.0);
+	gl_Position = ubo.projection * ubo.view * ubo.model * nodeMatrix * pos;
+
+	vec3 normal = OCTAHEDRAL_NORMALS ? octahedralDecode(inNormal.xy) : inNormal;
+	outNormal = mat3(ubo.view * ubo.model * nodeMatrix) * normal;
+
+	vec4 localpos = ubo.view * ubo.model * nodeMatrix * pos;
+	vec3 lightPos = vec3(10.0f, -10.0f, 10.0f);
+	outLightVec = lightPos.xyz - localpos.xyz;
+	outViewVec = -localpos.xyz;		
+}
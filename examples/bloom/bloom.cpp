@@ -372,6 +372,7 @@ public:
 		for (int32_t i = 0; i < drawCmdBuffers.size(); ++i)
 		{
 			VK_CHECK_RESULT(vkBeginCommandBuffer(drawCmdBuffers[i], &cmdBufInfo));
+			benchmark.beginGpuFrame(drawCmdBuffers[i], i);
 
 			if (bloom) {
 				clearValues[0].color = { { 0.0f, 0.0f, 0.0f, 1.0f } };
@@ -486,6 +487,7 @@ public:
 
 			}
 
+			benchmark.endGpuFrame(drawCmdBuffers[i], i);
 			VK_CHECK_RESULT(vkEndCommandBuffer(drawCmdBuffers[i]));
 		}
 	}
@@ -252,6 +252,7 @@ public:
 			renderPassBeginInfo.framebuffer = frameBuffers[i];
 
 			VK_CHECK_RESULT(vkBeginCommandBuffer(drawCmdBuffers[i], &cmdBufInfo));
+			benchmark.beginGpuFrame(drawCmdBuffers[i], i);
 
 			// Acquire storage buffers from compute queue
 			addComputeToGraphicsBarriers(drawCmdBuffers[i]);
@@ -291,6 +292,7 @@ public:
 			// release the storage buffers to the compute queue
 			addGraphicsToComputeBarriers(drawCmdBuffers[i]);
 
+			benchmark.endGpuFrame(drawCmdBuffers[i], i);
 			VK_CHECK_RESULT(vkEndCommandBuffer(drawCmdBuffers[i]));
 		}
 
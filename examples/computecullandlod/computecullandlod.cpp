@@ -179,6 +179,7 @@ public:
 			renderPassBeginInfo.framebuffer = frameBuffers[i];
 
 			VK_CHECK_RESULT(vkBeginCommandBuffer(drawCmdBuffers[i], &cmdBufInfo));
+			benchmark.beginGpuFrame(drawCmdBuffers[i], i);
 
 			vkCmdBeginRenderPass(drawCmdBuffers[i], &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
 
@@ -215,6 +216,7 @@ public:
 
 			vkCmdEndRenderPass(drawCmdBuffers[i]);
 
+			benchmark.endGpuFrame(drawCmdBuffers[i], i);
 			VK_CHECK_RESULT(vkEndCommandBuffer(drawCmdBuffers[i]));
 		}
 	}
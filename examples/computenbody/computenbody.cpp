@@ -156,6 +156,7 @@ public:
 			renderPassBeginInfo.framebuffer = frameBuffers[i];
 
 			VK_CHECK_RESULT(vkBeginCommandBuffer(drawCmdBuffers[i], &cmdBufInfo));
+			benchmark.beginGpuFrame(drawCmdBuffers[i], i);
 
 			// Acquire barrier
 			if (graphics.queueFamilyIndex != compute.queueFamilyIndex)
@@ -229,6 +230,7 @@ public:
 					0, nullptr);
 			}
 
+			benchmark.endGpuFrame(drawCmdBuffers[i], i);
 			VK_CHECK_RESULT(vkEndCommandBuffer(drawCmdBuffers[i]));
 		}
 
@@ -6,6 +6,15 @@
 * With conditional rendering it's possible to execute certain rendering commands based on a buffer value instead of having to rebuild the command buffers.
 * This example sets up a conditonal buffer with one value per glTF part, that is used to toggle visibility of single model parts.
 *
+* With --indirect the model is drawn from its flattened draw list with a single indirect call instead, visibility is then toggled via the instance counts of the indirect commands.
+*
+* With --cull parts outside of the view frustum are skipped on the host using the bounding volume hierarchy of the model, command buffers are recorded again whenever the camera moves.
+*
+* With --optimize-meshes the triangles and vertices of all parts are reordered for the vertex cache, overdraw and vertex fetch at load time.
+*
+* With --compact-vertices the vertex buffer only stores the components used by the shaders in smaller formats that are converted by the vertex input,
+* --quantize-vertices additionally stores quantized positions and octahedral normals that are decoded in the vertex shader.
+*
 * Copyright (C) 2018 by Sascha Willems - www.saschawillems.de
 *
 * This code is licensed under the MIT license (MIT) (http://opensource.org/licenses/MIT)
@@ -16,6 +25,7 @@
 #include <string.h>
 #include <assert.h>
 #include <vector>
+#include <chrono>
 
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
@@ -25,6 +35,7 @@
 #include <vulkan/vulkan.h>
 #include "vulkanexamplebase.h"
 #include "VulkanglTFModel.hpp"
+#include "frustum.hpp"
 
 #define ENABLE_VALIDATION false
 
@@ -52,6 +63,25 @@ public:
 	VkDescriptorSetLayout descriptorSetLayout;
 	VkDescriptorSet descriptorSet;
 
+	// Draw the model from its flattened draw list with the bindless descriptor set of the model instead of per node
+	bool indirectDraw = false;
+	VkPipelineLayout pipelineLayoutIndirect = VK_NULL_HANDLE;
+	VkPipeline pipelineIndirect = VK_NULL_HANDLE;
+
+	// Skip parts outside of the view frustum
+	bool frustumCulling = false;
+	vks::Frustum frustum;
+
+	// Reorder the model's triangles and vertices at load time
+	bool optimizeMeshes = false;
+
+	// Compact vertex format, quantized positions and octahedral normals are decoded by model_quantized.vert
+	bool compactVertices = false;
+	bool quantizeVertices = false;
+
+	// CPU time for recording a single command buffer in milliseconds
+	double recordTime = 0.0;
+
 	VulkanExample() : VulkanExampleBase(ENABLE_VALIDATION)
 	{
 		title = "Conditional rendering";
@@ -66,25 +96,75 @@ public:
 			[POI] Enable extension required for conditional rendering
 		*/
 		enabledDeviceExtensions.push_back(VK_EXT_CONDITIONAL_RENDERING_EXTENSION_NAME);
+
+		for (const char *arg : args) {
+			if (arg == std::string("--indirect")) {
+				indirectDraw = true;
+			}
+			if (arg == std::string("--cull")) {
+				frustumCulling = true;
+			}
+			if (arg == std::string("--optimize-meshes")) {
+				optimizeMeshes = true;
+			}
+			if (arg == std::string("--compact-vertices")) {
+				compactVertices = true;
+			}
+			if (arg == std::string("--quantize-vertices")) {
+				compactVertices = true;
+				quantizeVertices = true;
+			}
+		}
 	}
 
 	~VulkanExample()
 	{
 		vkDestroyPipeline(device, pipeline, nullptr);
 		vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
+		vkDestroyPipeline(device, pipelineIndirect, nullptr);
+		vkDestroyPipelineLayout(device, pipelineLayoutIndirect, nullptr);
 		vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr);
 		uniformBuffer.destroy();
 		conditionalBuffer.destroy();
 	}
 
+	// Enable physical device features required for this example
+	virtual void getEnabledFeatures()
+	{
+		/*
+			[POI] The indirect path draws the whole model with a single call if multi draw indirect or the draw indirect count extension are available
+			The index of a draw is passed as its first instance, which requires drawIndirectFirstInstance for indirect draws
+		*/
+		if (deviceFeatures.multiDrawIndirect) {
+			enabledFeatures.multiDrawIndirect = VK_TRUE;
+		}
+		if (deviceFeatures.drawIndirectFirstInstance) {
+			enabledFeatures.drawIndirectFirstInstance = VK_TRUE;
+		}
+		uint32_t extensionCount = 0;
+		vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
+		std::vector<VkExtensionProperties> extensions(extensionCount);
+		vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, extensions.data());
+		for (const VkExtensionProperties &extension : extensions) {
+			if (strcmp(extension.extensionName, VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME) == 0) {
+				enabledDeviceExtensions.push_back(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+			}
+		}
+	}
+
 	void renderNode(vkglTF::Node *node, VkCommandBuffer commandBuffer) {
 		if (node->mesh) {
 			for (vkglTF::Primitive * primitive : node->mesh->primitives) {
+				if (frustumCulling && !primitive->visible) {
+					continue;
+				}
 				const std::vector<VkDescriptorSet> descriptorsets = {
 					descriptorSet,
 					node->mesh->uniformBuffer.descriptorSet
 				};
-				vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, static_cast<uint32_t>(descriptorsets.size()), descriptorsets.data(), 0, NULL);
+				// Skinned models select the joint palette of the current frame with a dynamic offset
+				const uint32_t jointPaletteOffset = scene.jointPaletteDynamicOffset();
+				vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, static_cast<uint32_t>(descriptorsets.size()), descriptorsets.data(), scene.hasJointPalette() ? 1 : 0, &jointPaletteOffset);
 
 				struct PushBlock {
 					glm::vec4 baseColorFactor;
@@ -137,10 +217,12 @@ public:
 		renderPassBeginInfo.clearValueCount = 2;
 		renderPassBeginInfo.pClearValues = clearValues;
 
+		const std::chrono::high_resolution_clock::time_point recordStart = std::chrono::high_resolution_clock::now();
 		for (int32_t i = 0; i < drawCmdBuffers.size(); ++i) {
 			renderPassBeginInfo.framebuffer = frameBuffers[i];
 
 			VK_CHECK_RESULT(vkBeginCommandBuffer(drawCmdBuffers[i], &cmdBufInfo));
+			benchmark.beginGpuFrame(drawCmdBuffers[i], i);
 
 			vkCmdBeginRenderPass(drawCmdBuffers[i], &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
 
@@ -149,27 +231,46 @@ public:
 			VkRect2D scissor = vks::initializers::rect2D(width, height, 0, 0);
 			vkCmdSetScissor(drawCmdBuffers[i], 0, 1, &scissor);
 
-			vkCmdBindDescriptorSets(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSet, 0, NULL);
-
-			vkCmdBindPipeline(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
-
-			const VkDeviceSize offsets[1] = { 0 };
-			vkCmdBindVertexBuffers(drawCmdBuffers[i], 0, 1, &scene.vertices.buffer, offsets);
-			vkCmdBindIndexBuffer(drawCmdBuffers[i], scene.indices.buffer, 0, VK_INDEX_TYPE_UINT32);
-			for (auto node : scene.nodes) {
-				renderNode(node, drawCmdBuffers[i]);
+			if (indirectDraw) {
+				/*
+					[POI] All draws of the model share a single descriptor set, per draw data is looked up with the draw's index in the shaders
+				*/
+				const std::array<VkDescriptorSet, 2> descriptorSets = { descriptorSet, scene.indirect.descriptorSet };
+				const uint32_t jointPaletteOffset = scene.jointPaletteDynamicOffset();
+				vkCmdBindDescriptorSets(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayoutIndirect, 0, static_cast<uint32_t>(descriptorSets.size()), descriptorSets.data(), scene.hasJointPalette() ? 1 : 0, &jointPaletteOffset);
+				vkCmdBindPipeline(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineIndirect);
+				scene.drawIndirect(drawCmdBuffers[i]);
+			} else {
+				vkCmdBindDescriptorSets(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSet, 0, NULL);
+
+				vkCmdBindPipeline(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+
+				const VkDeviceSize offsets[1] = { 0 };
+				vkCmdBindVertexBuffers(drawCmdBuffers[i], 0, 1, &scene.vertices.buffer, offsets);
+				vkCmdBindIndexBuffer(drawCmdBuffers[i], scene.indices.buffer, 0, VK_INDEX_TYPE_UINT32);
+				for (auto node : scene.nodes) {
+					renderNode(node, drawCmdBuffers[i]);
+				}
 			}
 
 			drawUI(drawCmdBuffers[i]);
 
 			vkCmdEndRenderPass(drawCmdBuffers[i]);
 
+			benchmark.endGpuFrame(drawCmdBuffers[i], i);
 			VK_CHECK_RESULT(vkEndCommandBuffer(drawCmdBuffers[i]));
 		}
+		recordTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - recordStart).count() / drawCmdBuffers.size();
 	}
 
 	void loadAssets()
 	{
+		// The flattened draw list is always built, so the indirect path can be toggled at runtime
+		scene.indirectDraw = true;
+		scene.optimizeMeshes = optimizeMeshes;
+		if (compactVertices) {
+			scene.vertexFormat = vkglTF::VertexFormat::compact({ vkglTF::VertexComponent::Position, vkglTF::VertexComponent::Normal, vkglTF::VertexComponent::UV }, quantizeVertices);
+		}
 		scene.loadFromFile(getAssetPath() + "models/gltf/glTF-Embedded/Buggy.gltf", vulkanDevice, queue);
 	}
 
@@ -199,6 +300,11 @@ public:
 		pipelineLayoutCI.pPushConstantRanges = &pushConstantRange;
 		VK_CHECK_RESULT(vkCreatePipelineLayout(device, &pipelineLayoutCI, nullptr, &pipelineLayout));
 
+		// Materials are read from the model's descriptor set, so the indirect path doesn't need push constants
+		const std::array<VkDescriptorSetLayout, 2> setLayoutsIndirect = { descriptorSetLayout, scene.indirect.descriptorSetLayout };
+		VkPipelineLayoutCreateInfo pipelineLayoutIndirectCI = vks::initializers::pipelineLayoutCreateInfo(setLayoutsIndirect.data(), 2);
+		VK_CHECK_RESULT(vkCreatePipelineLayout(device, &pipelineLayoutIndirectCI, nullptr, &pipelineLayoutIndirect));
+
 		VkDescriptorSetAllocateInfo descriptorSetAllocateInfo = vks::initializers::descriptorSetAllocateInfo(descriptorPool, &descriptorSetLayout, 1);
 		VK_CHECK_RESULT(vkAllocateDescriptorSets(device, &descriptorSetAllocateInfo, &descriptorSet));
 		std::vector<VkWriteDescriptorSet> writeDescriptorSets = {
@@ -220,13 +326,9 @@ public:
 		VkPipelineMultisampleStateCreateInfo multisampleStateCI = vks::initializers::pipelineMultisampleStateCreateInfo(VK_SAMPLE_COUNT_1_BIT, 0);
 		VkPipelineDynamicStateCreateInfo dynamicStateCI = vks::initializers::pipelineDynamicStateCreateInfo(dynamicStateEnables.data(), static_cast<uint32_t>(dynamicStateEnables.size()), 0);
 
-		// Vertex bindings and attributes
-		VkVertexInputBindingDescription vertexInputBinding = vkglTF::Vertex::inputBindingDescription(0);
-		const std::vector<VkVertexInputAttributeDescription> vertexInputAttributes = {
-			vkglTF::Vertex::inputAttributeDescription(0, 0, vkglTF::VertexComponent::Position),
-			vkglTF::Vertex::inputAttributeDescription(0, 1, vkglTF::VertexComponent::Normal),
-			vkglTF::Vertex::inputAttributeDescription(0, 2, vkglTF::VertexComponent::UV)
-		};
+		// Vertex bindings and attributes, generated from the vertex format the model has been loaded with
+		VkVertexInputBindingDescription vertexInputBinding = scene.vertexFormat.inputBindingDescription(0);
+		const std::vector<VkVertexInputAttributeDescription> vertexInputAttributes = scene.vertexFormat.inputAttributeDescriptions(0, { vkglTF::VertexComponent::Position, vkglTF::VertexComponent::Normal, vkglTF::VertexComponent::UV });
 		VkPipelineVertexInputStateCreateInfo vertexInputState = vks::initializers::pipelineVertexInputStateCreateInfo();
 		vertexInputState.vertexBindingDescriptionCount = 1;
 		vertexInputState.pVertexBindingDescriptions = &vertexInputBinding;
@@ -244,7 +346,7 @@ public:
 		pipelineCreateInfoCI.pDynamicState = &dynamicStateCI;
 
 		const std::array<VkPipelineShaderStageCreateInfo, 2> shaderStages = {
-			loadShader(getShadersPath() + "conditionalrender/model.vert.spv", VK_SHADER_STAGE_VERTEX_BIT),
+			loadShader(getShadersPath() + (scene.vertexFormat.quantizedPositions() ? "conditionalrender/model_quantized.vert.spv" : "conditionalrender/model.vert.spv"), VK_SHADER_STAGE_VERTEX_BIT),
 			loadShader(getShadersPath() + "conditionalrender/model.frag.spv", VK_SHADER_STAGE_FRAGMENT_BIT)
 		};
 
@@ -252,6 +354,19 @@ public:
 		pipelineCreateInfoCI.pStages = shaderStages.data();
 
 		VK_CHECK_RESULT(vkCreateGraphicsPipelines(device, pipelineCache, 1, &pipelineCreateInfoCI, nullptr, &pipeline));
+
+		std::array<VkPipelineShaderStageCreateInfo, 2> shaderStagesIndirect = {
+			loadShader(getShadersPath() + "conditionalrender/model_indirect.vert.spv", VK_SHADER_STAGE_VERTEX_BIT),
+			loadShader(getShadersPath() + "conditionalrender/model_indirect.frag.spv", VK_SHADER_STAGE_FRAGMENT_BIT)
+		};
+		// The indirect shader always applies the dequantization of the draw, only the normal decoding is selected here
+		const VkBool32 octahedralNormals = quantizeVertices ? VK_TRUE : VK_FALSE;
+		const VkSpecializationMapEntry specializationEntry = vks::initializers::specializationMapEntry(0, 0, sizeof(VkBool32));
+		const VkSpecializationInfo specializationInfo = vks::initializers::specializationInfo(1, &specializationEntry, sizeof(VkBool32), &octahedralNormals);
+		shaderStagesIndirect[0].pSpecializationInfo = &specializationInfo;
+		pipelineCreateInfoCI.layout = pipelineLayoutIndirect;
+		pipelineCreateInfoCI.pStages = shaderStagesIndirect.data();
+		VK_CHECK_RESULT(vkCreateGraphicsPipelines(device, pipelineCache, 1, &pipelineCreateInfoCI, nullptr, &pipelineIndirect));
 	}
 
 	void prepareUniformBuffers()
@@ -276,6 +391,53 @@ public:
 	void updateConditionalBuffer()
 	{
 		memcpy(conditionalBuffer.mapped, conditionalVisibility.data(), sizeof(int32_t) * conditionalVisibility.size());
+		updateIndirectVisibility();
+	}
+
+	/*
+		[POI] The indirect path hides parts by setting the instance count of their draws to zero
+	*/
+	void updateIndirectVisibility()
+	{
+		for (auto node : scene.linearNodes) {
+			if (!node->mesh) {
+				continue;
+			}
+			// Primitives without indices have no draw
+			uint32_t drawIndex = node->mesh->firstDraw;
+			for (vkglTF::Primitive *primitive : node->mesh->primitives) {
+				if (primitive->indexCount > 0) {
+					const bool visible = conditionalVisibility[node->index] && (!frustumCulling || primitive->visible);
+					scene.indirect.commands[drawIndex++].instanceCount = visible ? 1 : 0;
+				}
+			}
+		}
+		scene.updateIndirectCommands();
+		// Without drawIndirectFirstInstance the draws are recorded as direct draws from the host copy of the commands
+		if (indirectDraw && prepared && !vulkanDevice->enabledFeatures.drawIndirectFirstInstance) {
+			buildCommandBuffers();
+		}
+	}
+
+	/*
+		[POI] Determine the parts inside the view frustum, the frustum is transformed to the model's space with the same matrices as the vertices
+	*/
+	void cullScene()
+	{
+		frustum.update(uboVS.projection * uboVS.view * uboVS.model);
+		scene.cull(frustum);
+	}
+
+	// Culled parts are skipped while recording the command buffers, or hidden via the instance counts of the indirect commands
+	void updateCulling()
+	{
+		if (frustumCulling) {
+			cullScene();
+		}
+		updateIndirectVisibility();
+		if (!indirectDraw) {
+			buildCommandBuffers();
+		}
 	}
 
 	/*
@@ -342,7 +504,12 @@ public:
 		prepareUniformBuffers();
 		setupDescriptorSets();
 		preparePipelines();
+		if (frustumCulling) {
+			cullScene();
+			updateIndirectVisibility();
+		}
 		buildCommandBuffers();
+		benchmark.variant = std::string(indirectDraw ? "indirect" : "per node") + (frustumCulling ? ", frustum culling" : "") + (optimizeMeshes ? ", optimized meshes" : "") + (quantizeVertices ? ", quantized vertices" : (compactVertices ? ", compact vertices" : ""));
 		prepared = true;
 	}
 
@@ -353,11 +520,42 @@ public:
 		draw();
 		if (camera.updated) {
 			updateUniformBuffers();
+			if (frustumCulling) {
+				updateCulling();
+			}
+		}
+		if (frustumCulling) {
+			benchmark.record("visible", scene.cullingStatistics.visible, "primitives");
+			benchmark.record("culled", scene.cullingStatistics.culled, "primitives");
+			benchmark.record("cull", scene.cullingStatistics.time);
 		}
 	}
 
 	virtual void OnUpdateUIOverlay(vks::UIOverlay *overlay)
 	{
+		if (overlay->header("Settings")) {
+			if (overlay->checkBox("Indirect draw", &indirectDraw)) {
+				buildCommandBuffers();
+			}
+			if (overlay->checkBox("Frustum culling", &frustumCulling)) {
+				updateCulling();
+			}
+			overlay->text("Record time: %.3f ms", recordTime);
+			if (frustumCulling) {
+				const vkglTF::Model::CullingStatistics &stats = scene.cullingStatistics;
+				overlay->text("Primitives: %u visible, %u culled", stats.visible, stats.culled);
+				overlay->text("Cull: %u tests, %.3f ms", stats.tested, stats.time);
+			}
+			if (compactVertices) {
+				overlay->text("Vertex buffer: %.1f KB -> %.1f KB", scene.vertexMemory.fullSize() / 1024.0f, scene.vertexMemory.size() / 1024.0f);
+				overlay->text("Vertex stride: %u -> %u bytes", scene.vertexMemory.fullStride, scene.vertexMemory.stride);
+			}
+			if (optimizeMeshes) {
+				const vks::meshoptimizer::Statistics &stats = scene.meshOptimization;
+				overlay->text("ACMR: %.3f -> %.3f", stats.before.acmr(), stats.after.acmr());
+				overlay->text("ATVR: %.3f -> %.3f", stats.before.atvr(), stats.after.atvr());
+			}
+		}
 		if (overlay->header("Visibility")) {
 
 			if (overlay->button("All")) {
@@ -327,6 +327,7 @@ public:
 
 		for (int32_t i = 0; i < drawCmdBuffers.size(); ++i) {
 			VK_CHECK_RESULT(vkBeginCommandBuffer(drawCmdBuffers[i], &cmdBufInfo));
+			benchmark.beginGpuFrame(drawCmdBuffers[i], i);
 
 			/*
 				First render pass: Render a low res triangle to an offscreen framebuffer to use for visualization in second pass
@@ -410,6 +411,7 @@ public:
 				vkCmdEndRenderPass(drawCmdBuffers[i]);
 			}
 
+			benchmark.endGpuFrame(drawCmdBuffers[i], i);
 			VK_CHECK_RESULT(vkEndCommandBuffer(drawCmdBuffers[i]));
 		}
 	}
@@ -14,6 +14,9 @@
 *
 * The used descriptor type VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC then allows to set a dynamic
 * offset used to pass data from the single uniform buffer to the connected shader binding point.
+*
+* Dynamic offsets are also used to select the current frame's slice of the uniform buffers, so the
+* CPU can update and record a frame while the GPU is still rendering earlier frames (see --frames-in-flight).
 */
 
 #include <stdio.h>
@@ -110,6 +113,9 @@ public:
 
 	size_t dynamicAlignment;
 
+	// Secondary command buffers of the current frame if recording in parallel
+	std::vector<VkCommandBuffer> secondaryCommandBuffers;
+
 	VulkanExample() : VulkanExampleBase(ENABLE_VALIDATION)
 	{
 		title = "Dynamic uniform buffers";
@@ -118,6 +124,9 @@ public:
 		camera.setRotation(glm::vec3(0.0f));
 		camera.setPerspective(60.0f, (float)width / (float)height, 0.1f, 256.0f);
 		settings.overlay = true;
+		// Uniform buffers have one slice per frame and the command buffer is recorded per frame
+		maxFramesInFlight = MAX_FRAMES_IN_FLIGHT;
+		recordPerFrame = true;
 	}
 
 	~VulkanExample()
@@ -140,10 +149,39 @@ public:
 		uniformBuffers.dynamic.destroy();
 	}
 
-	void buildCommandBuffers()
+	// Records the draws for the objects [first, last)
+	void drawObjects(VkCommandBuffer commandBuffer, uint32_t first, uint32_t last)
 	{
-		VkCommandBufferBeginInfo cmdBufInfo = vks::initializers::commandBufferBeginInfo();
+		VkViewport viewport = vks::initializers::viewport((float)width, (float)height, 0.0f, 1.0f);
+		vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+
+		VkRect2D scissor = vks::initializers::rect2D(width, height, 0, 0);
+		vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+
+		VkDeviceSize offsets[1] = { 0 };
+		vkCmdBindVertexBuffers(commandBuffer, VERTEX_BUFFER_BIND_ID, 1, &vertexBuffer.buffer, offsets);
+		vkCmdBindIndexBuffer(commandBuffer, indexBuffer.buffer, 0, VK_INDEX_TYPE_UINT32);
 
+		const uint32_t viewOffset = getFrameSliceOffset(sizeof(uboVS));
+		const uint32_t dynamicFrameOffset = getFrameSliceOffset(OBJECT_INSTANCES * dynamicAlignment);
+
+		// Render multiple objects using different model matrices by dynamically offsetting into one uniform buffer
+		for (uint32_t j = first; j < last; j++)
+		{
+			// One dynamic offset per dynamic descriptor (in binding order): the frame's view matrices and the object's matrix within the frame's slice
+			uint32_t dynamicOffsets[2] = { viewOffset, dynamicFrameOffset + j * static_cast<uint32_t>(dynamicAlignment) };
+			// Bind the descriptor set for rendering a mesh using the dynamic offset
+			vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSet, 2, dynamicOffsets);
+
+			vkCmdDrawIndexed(commandBuffer, indexCount, 1, 0, 0, 0);
+		}
+	}
+
+	// The dynamic offsets select the current frame's uniform buffer slices, so the command buffer is recorded for each frame
+	void buildFrameCommandBuffer(VkCommandBuffer commandBuffer)
+	{
 		VkClearValue clearValues[2];
 		clearValues[0].color = defaultClearColor;
 		clearValues[1].depthStencil = { 1.0f, 0 };
@@ -156,53 +194,55 @@ public:
 		renderPassBeginInfo.renderArea.extent.height = height;
 		renderPassBeginInfo.clearValueCount = 2;
 		renderPassBeginInfo.pClearValues = clearValues;
+		renderPassBeginInfo.framebuffer = frameBuffers[currentBuffer];
 
-		for (int32_t i = 0; i < drawCmdBuffers.size(); ++i)
-		{
-			renderPassBeginInfo.framebuffer = frameBuffers[i];
-
-			VK_CHECK_RESULT(vkBeginCommandBuffer(drawCmdBuffers[i], &cmdBufInfo));
-
-			vkCmdBeginRenderPass(drawCmdBuffers[i], &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
-
-			VkViewport viewport = vks::initializers::viewport((float)width, (float)height, 0.0f, 1.0f);
-			vkCmdSetViewport(drawCmdBuffers[i], 0, 1, &viewport);
-
-			VkRect2D scissor = vks::initializers::rect2D(width, height, 0, 0);
-			vkCmdSetScissor(drawCmdBuffers[i], 0, 1, &scissor);
-
-			vkCmdBindPipeline(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
-
-			VkDeviceSize offsets[1] = { 0 };
-			vkCmdBindVertexBuffers(drawCmdBuffers[i], VERTEX_BUFFER_BIND_ID, 1, &vertexBuffer.buffer, offsets);
-			vkCmdBindIndexBuffer(drawCmdBuffers[i], indexBuffer.buffer, 0, VK_INDEX_TYPE_UINT32);
-
-			// Render multiple objects using different model matrices by dynamically offsetting into one uniform buffer
-			for (uint32_t j = 0; j < OBJECT_INSTANCES; j++)
+		// The base class wraps the frame in a "frame" scope of the GPU profiler, the scopes below are nested in it
+		vks::GpuProfiler::Scope sceneScope(gpuProfiler, commandBuffer, "scene", frameProfilerScope);
+		if (!settings.parallelRecording) {
+			vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
 			{
-				// One dynamic offset per dynamic descriptor to offset into the ubo containing all model matrices
-				uint32_t dynamicOffset = j * static_cast<uint32_t>(dynamicAlignment);
-				// Bind the descriptor set for rendering a mesh using the dynamic offset
-				vkCmdBindDescriptorSets(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSet, 1, &dynamicOffset);
-
-				vkCmdDrawIndexed(drawCmdBuffers[i], indexCount, 1, 0, 0, 0);
+				vks::GpuProfiler::Scope objectsScope(sceneScope, "objects");
+				drawObjects(commandBuffer, 0, OBJECT_INSTANCES);
 			}
+			{
+				vks::GpuProfiler::Scope uiScope(sceneScope, "ui");
+				drawUI(commandBuffer);
+			}
+			vkCmdEndRenderPass(commandBuffer);
+			return;
+		}
 
-			drawUI(drawCmdBuffers[i]);
-
-			vkCmdEndRenderPass(drawCmdBuffers[i]);
-
-			VK_CHECK_RESULT(vkEndCommandBuffer(drawCmdBuffers[i]));
+		// The objects are recorded into secondary command buffers on all threads, which also requires the UI to be recorded into a secondary command buffer
+		vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+		VkCommandBufferInheritanceInfo inheritanceInfo = vks::initializers::commandBufferInheritanceInfo();
+		inheritanceInfo.renderPass = renderPass;
+		inheritanceInfo.framebuffer = frameBuffers[currentBuffer];
+		secondaryCommandBuffers.clear();
+		recordSecondaryCommandBuffers(OBJECT_INSTANCES, inheritanceInfo, [this](VkCommandBuffer secondaryCommandBuffer, uint32_t first, uint32_t last) {
+			drawObjects(secondaryCommandBuffer, first, last);
+		}, secondaryCommandBuffers);
+		if (settings.overlay) {
+			recordSecondaryCommandBuffers(1, inheritanceInfo, [&](VkCommandBuffer secondaryCommandBuffer, uint32_t first, uint32_t last) {
+				// Timestamps can't be written to the primary command buffer within the render pass, but to the secondary ones
+				vks::GpuProfiler::Scope uiScope(sceneScope, secondaryCommandBuffer, "ui");
+				drawUI(secondaryCommandBuffer);
+			}, secondaryCommandBuffers);
 		}
+		vkCmdExecuteCommands(commandBuffer, static_cast<uint32_t>(secondaryCommandBuffers.size()), secondaryCommandBuffers.data());
+		vkCmdEndRenderPass(commandBuffer);
 	}
 
 	void draw()
 	{
 		VulkanExampleBase::prepareFrame();
 
+		// Once prepareFrame returns the GPU no longer uses the current frame's uniform buffer slices and command buffers
+		updateFrameUniformBuffers();
+		const VkCommandBuffer commandBuffer = recordFrameCommandBuffer();
+
 		// Command buffer to be sumitted to the queue
 		submitInfo.commandBufferCount = 1;
-		submitInfo.pCommandBuffers = &drawCmdBuffers[currentBuffer];
+		submitInfo.pCommandBuffers = &commandBuffer;
 
 		// Submit to queue
 		VK_CHECK_RESULT(vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE));
@@ -270,11 +310,10 @@ public:
 
 	void setupDescriptorPool()
 	{
-		// Example uses one ubo and one image sampler
+		// Example uses two dynamic ubos
 		std::vector<VkDescriptorPoolSize> poolSizes =
 		{
-			vks::initializers::descriptorPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1),
-			vks::initializers::descriptorPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1)
+			vks::initializers::descriptorPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 2)
 		};
 
 		VkDescriptorPoolCreateInfo descriptorPoolInfo =
@@ -290,7 +329,7 @@ public:
 	{
 		std::vector<VkDescriptorSetLayoutBinding> setLayoutBindings =
 		{
-			vks::initializers::descriptorSetLayoutBinding(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT, 0),
+			vks::initializers::descriptorSetLayoutBinding(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_VERTEX_BIT, 0),
 			vks::initializers::descriptorSetLayoutBinding(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_VERTEX_BIT, 1)
 		};
 
@@ -320,8 +359,8 @@ public:
 		VK_CHECK_RESULT(vkAllocateDescriptorSets(device, &allocInfo, &descriptorSet));
 
 		std::vector<VkWriteDescriptorSet> writeDescriptorSets = {
-			// Binding 0 : Projection/View matrix uniform buffer
-			vks::initializers::writeDescriptorSet(descriptorSet, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 0, &uniformBuffers.view.descriptor),
+			// Binding 0 : Projection/View matrix uniform buffer, dynamic to select the frame's slice
+			vks::initializers::writeDescriptorSet(descriptorSet, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 0, &uniformBuffers.view.descriptor),
 			// Binding 1 : Instance matrix as dynamic uniform buffer
 			vks::initializers::writeDescriptorSet(descriptorSet, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1, &uniformBuffers.dynamic.descriptor),
 		};
@@ -426,24 +465,15 @@ public:
 		std::cout << "dynamicAlignment = " << dynamicAlignment << std::endl;
 
 		// Vertex shader uniform buffer block
+		// Both buffers contain one slice per frame in flight and are mapped persistently
 
-		// Static shared uniform buffer object with projection and view matrix
-		VK_CHECK_RESULT(vulkanDevice->createBuffer(
-			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-			&uniformBuffers.view,
-			sizeof(uboVS)));
+		// Shared uniform buffer object with projection and view matrix
+		createFrameUniformBuffer(&uniformBuffers.view, sizeof(uboVS));
 
 		// Uniform buffer object with per-object matrices
-		VK_CHECK_RESULT(vulkanDevice->createBuffer(
-			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
-			&uniformBuffers.dynamic,
-			bufferSize));
-
-		// Map persistent
-		VK_CHECK_RESULT(uniformBuffers.view.map());
-		VK_CHECK_RESULT(uniformBuffers.dynamic.map());
+		createFrameUniformBuffer(&uniformBuffers.dynamic, bufferSize);
+		// The descriptor covers a single object's matrix, the dynamic offset selects frame slice and object
+		uniformBuffers.dynamic.setupDescriptor(sizeof(glm::mat4));
 
 		// Prepare per-object matrices with offsets and random rotations
 		std::default_random_engine rndEngine(benchmark.active ? 0 : (unsigned)time(nullptr));
@@ -462,8 +492,20 @@ public:
 		// Fixed ubo with projection and view matrices
 		uboVS.projection = camera.matrices.perspective;
 		uboVS.view = camera.matrices.view;
+	}
 
-		memcpy(uniformBuffers.view.mapped, &uboVS, sizeof(uboVS));
+	// Copy the current matrices into the current frame's slices, the slices of earlier frames may still be read by the GPU
+	void updateFrameUniformBuffers()
+	{
+		const VkDeviceSize viewOffset = getFrameSliceOffset(sizeof(uboVS));
+		memcpy((uint8_t*)uniformBuffers.view.mapped + viewOffset, &uboVS, sizeof(uboVS));
+		uniformBuffers.view.flush(getFrameSliceSize(sizeof(uboVS)), viewOffset);
+
+		const VkDeviceSize dynamicSize = OBJECT_INSTANCES * dynamicAlignment;
+		const VkDeviceSize dynamicOffset = getFrameSliceOffset(dynamicSize);
+		memcpy((uint8_t*)uniformBuffers.dynamic.mapped + dynamicOffset, uboDataDynamic.model, dynamicSize);
+		// Flush to make changes visible to the device
+		uniformBuffers.dynamic.flush(getFrameSliceSize(dynamicSize), dynamicOffset);
 	}
 
 	void updateDynamicUniformBuffer(bool force = false)
@@ -503,13 +545,6 @@ public:
 		}
 
 		animationTimer = 0.0f;
-
-		memcpy(uniformBuffers.dynamic.mapped, uboDataDynamic.model, uniformBuffers.dynamic.size);
-		// Flush to make changes visible to the host
-		VkMappedMemoryRange memoryRange = vks::initializers::mappedMemoryRange();
-		memoryRange.memory = uniformBuffers.dynamic.memory;
-		memoryRange.size = uniformBuffers.dynamic.size;
-		vkFlushMappedMemoryRanges(device, 1, &memoryRange);
 	}
 
 	void prepare()
@@ -522,7 +557,9 @@ public:
 		preparePipelines();
 		setupDescriptorPool();
 		setupDescriptorSet();
-		buildCommandBuffers();
+		if (settings.parallelRecording) {
+			benchmark.variant = "parallel recording (" + std::to_string(recordingJobSystem->threadCount()) + " threads)";
+		}
 		prepared = true;
 	}
 
@@ -530,9 +567,9 @@ public:
 	{
 		if (!prepared)
 			return;
-		draw();
 		if (!paused)
 			updateDynamicUniformBuffer();
+		draw();
 	}
 
 	virtual void viewChanged()
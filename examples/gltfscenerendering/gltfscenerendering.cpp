@@ -22,14 +22,11 @@ VulkanglTFScene::~VulkanglTFScene()
 {
 	// Release all Vulkan resources allocated for the model
 	vkDestroyBuffer(vulkanDevice->logicalDevice, vertices.buffer, nullptr);
-	vkFreeMemory(vulkanDevice->logicalDevice, vertices.memory, nullptr);
+	vulkanDevice->memoryAllocator.free(vertices.allocation);
 	vkDestroyBuffer(vulkanDevice->logicalDevice, indices.buffer, nullptr);
-	vkFreeMemory(vulkanDevice->logicalDevice, indices.memory, nullptr);
+	vulkanDevice->memoryAllocator.free(indices.allocation);
 	for (Image image : images) {
-		vkDestroyImageView(vulkanDevice->logicalDevice, image.texture.view, nullptr);
-		vkDestroyImage(vulkanDevice->logicalDevice, image.texture.image, nullptr);
-		vkDestroySampler(vulkanDevice->logicalDevice, image.texture.sampler, nullptr);
-		vkFreeMemory(vulkanDevice->logicalDevice, image.texture.deviceMemory, nullptr);
+		image.texture.destroy();
 	}
 	for (Material material : materials) {
 		vkDestroyPipeline(vulkanDevice->logicalDevice, material.pipeline, nullptr);
@@ -332,6 +329,7 @@ void VulkanExample::buildCommandBuffers()
 	{
 		renderPassBeginInfo.framebuffer = frameBuffers[i];
 		VK_CHECK_RESULT(vkBeginCommandBuffer(drawCmdBuffers[i], &cmdBufInfo));
+		benchmark.beginGpuFrame(drawCmdBuffers[i], i);
 		vkCmdBeginRenderPass(drawCmdBuffers[i], &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
 		vkCmdSetViewport(drawCmdBuffers[i], 0, 1, &viewport);
 		vkCmdSetScissor(drawCmdBuffers[i], 0, 1, &scissor);
@@ -343,6 +341,7 @@ void VulkanExample::buildCommandBuffers()
 
 		drawUI(drawCmdBuffers[i]);
 		vkCmdEndRenderPass(drawCmdBuffers[i]);
+		benchmark.endGpuFrame(drawCmdBuffers[i], i);
 		VK_CHECK_RESULT(vkEndCommandBuffer(drawCmdBuffers[i]));
 	}
 }
@@ -398,26 +397,21 @@ void VulkanExample::loadglTFFile(std::string filename)
 	size_t indexBufferSize = indexBuffer.size() * sizeof(uint32_t);
 	glTFScene.indices.count = static_cast<uint32_t>(indexBuffer.size());
 
-	struct StagingBuffer {
-		VkBuffer buffer;
-		VkDeviceMemory memory;
-	} vertexStaging, indexStaging;
+	vks::Buffer vertexStaging, indexStaging;
 
 	// Create host visible staging buffers (source)
 	VK_CHECK_RESULT(vulkanDevice->createBuffer(
 		VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
 		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		&vertexStaging,
 		vertexBufferSize,
-		&vertexStaging.buffer,
-		&vertexStaging.memory,
 		vertexBuffer.data()));
 	// Index data
 	VK_CHECK_RESULT(vulkanDevice->createBuffer(
 		VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
 		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		&indexStaging,
 		indexBufferSize,
-		&indexStaging.buffer,
-		&indexStaging.memory,
 		indexBuffer.data()));
 
 	// Create device local buffers (targat)
@@ -426,13 +420,13 @@ void VulkanExample::loadglTFFile(std::string filename)
 		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
 		vertexBufferSize,
 		&glTFScene.vertices.buffer,
-		&glTFScene.vertices.memory));
+		&glTFScene.vertices.allocation));
 	VK_CHECK_RESULT(vulkanDevice->createBuffer(
 		VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
 		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
 		indexBufferSize,
 		&glTFScene.indices.buffer,
-		&glTFScene.indices.memory));
+		&glTFScene.indices.allocation));
 
 	// Copy data from staging buffers (host) do device local buffer (gpu)
 	VkCommandBuffer copyCmd = vulkanDevice->createCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
@@ -457,10 +451,8 @@ void VulkanExample::loadglTFFile(std::string filename)
 	vulkanDevice->flushCommandBuffer(copyCmd, queue, true);
 
 	// Free staging resources
-	vkDestroyBuffer(device, vertexStaging.buffer, nullptr);
-	vkFreeMemory(device, vertexStaging.memory, nullptr);
-	vkDestroyBuffer(device, indexStaging.buffer, nullptr);
-	vkFreeMemory(device, indexStaging.memory, nullptr);
+	vertexStaging.destroy();
+	indexStaging.destroy();
 }
 
 void VulkanExample::loadAssets()
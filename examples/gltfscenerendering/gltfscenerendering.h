@@ -62,14 +62,14 @@ public:
 	// Single vertex buffer for all primitives
 	struct {
 		VkBuffer buffer;
-		VkDeviceMemory memory;
+		vks::Allocation allocation;
 	} vertices;
 
 	// Single index buffer for all primitives
 	struct {
 		int count;
 		VkBuffer buffer;
-		VkDeviceMemory memory;
+		vks::Allocation allocation;
 	} indices;
 
 	// The following structures roughly represent the glTF scene structure
@@ -41,15 +41,12 @@ glm::mat4 VulkanglTFModel::Node::getLocalMatrix()
 VulkanglTFModel::~VulkanglTFModel()
 {
 	vkDestroyBuffer(vulkanDevice->logicalDevice, vertices.buffer, nullptr);
-	vkFreeMemory(vulkanDevice->logicalDevice, vertices.memory, nullptr);
+	vulkanDevice->memoryAllocator.free(vertices.allocation);
 	vkDestroyBuffer(vulkanDevice->logicalDevice, indices.buffer, nullptr);
-	vkFreeMemory(vulkanDevice->logicalDevice, indices.memory, nullptr);
+	vulkanDevice->memoryAllocator.free(indices.allocation);
 	for (Image image : images)
 	{
-		vkDestroyImageView(vulkanDevice->logicalDevice, image.texture.view, nullptr);
-		vkDestroyImage(vulkanDevice->logicalDevice, image.texture.image, nullptr);
-		vkDestroySampler(vulkanDevice->logicalDevice, image.texture.sampler, nullptr);
-		vkFreeMemory(vulkanDevice->logicalDevice, image.texture.deviceMemory, nullptr);
+		image.texture.destroy();
 	}
 	for (Skin skin : skins)
 	{
@@ -460,6 +457,8 @@ void VulkanglTFModel::loadNode(const tinygltf::Node &inputNode, const tinygltf::
 			Primitive primitive{};
 			primitive.firstIndex    = firstIndex;
 			primitive.indexCount    = indexCount;
+			primitive.firstVertex   = vertexStart;
+			primitive.vertexCount   = static_cast<uint32_t>(vertexBuffer.size()) - vertexStart;
 			primitive.materialIndex = glTFPrimitive.material;
 			node->mesh.primitives.push_back(primitive);
 		}
@@ -498,10 +497,11 @@ void VulkanglTFModel::updateJoints(VulkanglTFModel::Node *node)
 	if (node->skin > -1)
 	{
 		// Update the joint matrices
-		glm::mat4              inverseTransform = glm::inverse(getNodeMatrix(node));
-		Skin                   skin             = skins[node->skin];
-		size_t                 numJoints        = (uint32_t) skin.joints.size();
-		std::vector<glm::mat4> jointMatrices(numJoints);
+		glm::mat4               inverseTransform = glm::inverse(getNodeMatrix(node));
+		Skin &                  skin             = skins[node->skin];
+		size_t                  numJoints        = (uint32_t) skin.joints.size();
+		std::vector<glm::mat4> &jointMatrices    = skin.jointMatrices;
+		jointMatrices.resize(numJoints);
 		for (size_t i = 0; i < numJoints; i++)
 		{
 			jointMatrices[i] = getNodeMatrix(skin.joints[i]) * skin.inverseBindMatrices[i];
@@ -634,6 +634,58 @@ void VulkanglTFModel::draw(VkCommandBuffer commandBuffer, VkPipelineLayout pipel
 	}
 }
 
+// POI: Dispatch the skinning compute shader for the vertices of all primitives of a skinned node
+void VulkanglTFModel::skinNode(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout, VulkanglTFModel::Node *node)
+{
+	if ((node->skin > -1) && (node->mesh.primitives.size() > 0))
+	{
+		// Bind SSBO with the joint matrices of the node's skin to set 1
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 1, 1, &skins[node->skin].descriptorSet, 0, nullptr);
+		for (VulkanglTFModel::Primitive &primitive : node->mesh.primitives)
+		{
+			if (primitive.vertexCount > 0)
+			{
+				// Pass the vertex range of the primitive to the compute shader
+				const uint32_t range[2] = {primitive.firstVertex, primitive.vertexCount};
+				vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(range), range);
+				vkCmdDispatch(commandBuffer, (primitive.vertexCount + 63) / 64, 1, 1);
+			}
+		}
+	}
+	for (auto &child : node->children)
+	{
+		skinNode(commandBuffer, pipelineLayout, child);
+	}
+}
+
+// Skin the vertices of all nodes, expects the skinning compute pipeline and its vertex buffer descriptors to be bound
+void VulkanglTFModel::skin(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout)
+{
+	for (auto &node : nodes)
+	{
+		skinNode(commandBuffer, pipelineLayout, node);
+	}
+}
+
+// Collect the vertex ranges of all primitives of skinned nodes for skinning on the host
+void VulkanglTFModel::getSkinnedPrimitives(VulkanglTFModel::Node *node, std::vector<SkinnedPrimitive> &skinnedPrimitives)
+{
+	if (node->skin > -1)
+	{
+		for (VulkanglTFModel::Primitive &primitive : node->mesh.primitives)
+		{
+			if (primitive.vertexCount > 0)
+			{
+				skinnedPrimitives.push_back({primitive.firstVertex, primitive.vertexCount, node->skin});
+			}
+		}
+	}
+	for (auto &child : node->children)
+	{
+		getSkinnedPrimitives(child, skinnedPrimitives);
+	}
+}
+
 /*
 
 	Vulkan Example class
@@ -650,6 +702,22 @@ VulkanExample::VulkanExample() :
 	camera.setRotation(glm::vec3(0.0f, 0.0f, 0.0f));
 	camera.setPerspective(60.0f, (float) width / (float) height, 0.1f, 256.0f);
 	settings.overlay = true;
+	for (const char *arg : args)
+	{
+		if (arg == std::string("--computeskinning"))
+		{
+			computeSkinning = true;
+		}
+		if (arg == std::string("--cpuskinning"))
+		{
+			cpuSkinning = true;
+		}
+	}
+	// Only one of the skinning paths can be active
+	if (cpuSkinning)
+	{
+		computeSkinning = false;
+	}
 }
 
 VulkanExample::~VulkanExample()
@@ -659,6 +727,21 @@ VulkanExample::~VulkanExample()
 	{
 		vkDestroyPipeline(device, pipelines.wireframe, nullptr);
 	}
+	vkDestroyPipeline(device, pipelines.preskinnedSolid, nullptr);
+	if (pipelines.preskinnedWireframe != VK_NULL_HANDLE)
+	{
+		vkDestroyPipeline(device, pipelines.preskinnedWireframe, nullptr);
+	}
+	vkDestroyPipeline(device, pipelines.hostSkinnedSolid, nullptr);
+	if (pipelines.hostSkinnedWireframe != VK_NULL_HANDLE)
+	{
+		vkDestroyPipeline(device, pipelines.hostSkinnedWireframe, nullptr);
+	}
+	vkDestroyPipeline(device, compute.pipeline, nullptr);
+	vkDestroyPipelineLayout(device, compute.pipelineLayout, nullptr);
+	vkDestroyDescriptorSetLayout(device, compute.descriptorSetLayout, nullptr);
+	compute.skinnedVertices.destroy();
+	cpu.skinnedVertices.destroy();
 
 	vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
 	vkDestroyDescriptorSetLayout(device, descriptorSetLayouts.matrices, nullptr);
@@ -702,15 +785,58 @@ void VulkanExample::buildCommandBuffers()
 	{
 		renderPassBeginInfo.framebuffer = frameBuffers[i];
 		VK_CHECK_RESULT(vkBeginCommandBuffer(drawCmdBuffers[i], &cmdBufInfo));
+		benchmark.beginGpuFrame(drawCmdBuffers[i], i);
+
+		// POI: Skin all vertices once before any pass reads them
+		if (computeSkinning)
+		{
+			VkBufferMemoryBarrier bufferBarrier = vks::initializers::bufferMemoryBarrier();
+			bufferBarrier.buffer                = compute.skinnedVertices.buffer;
+			bufferBarrier.size                  = VK_WHOLE_SIZE;
+			bufferBarrier.srcQueueFamilyIndex   = VK_QUEUE_FAMILY_IGNORED;
+			bufferBarrier.dstQueueFamilyIndex   = VK_QUEUE_FAMILY_IGNORED;
+			// The previous frame's vertex input must have finished reading before the vertices are overwritten (write-after-read only needs an execution dependency)
+			bufferBarrier.srcAccessMask = 0;
+			bufferBarrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+			vkCmdPipelineBarrier(drawCmdBuffers[i], VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 1, &bufferBarrier, 0, nullptr);
+
+			vkCmdBindPipeline(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_COMPUTE, compute.pipeline);
+			vkCmdBindDescriptorSets(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_COMPUTE, compute.pipelineLayout, 0, 1, &compute.descriptorSet, 0, nullptr);
+			glTFModel.skin(drawCmdBuffers[i], compute.pipelineLayout);
+
+			// Make the skinned vertices visible to the vertex input of all following passes
+			bufferBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+			bufferBarrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+			vkCmdPipelineBarrier(drawCmdBuffers[i], VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, 0, 0, nullptr, 1, &bufferBarrier, 0, nullptr);
+		}
+
 		vkCmdBeginRenderPass(drawCmdBuffers[i], &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
 		vkCmdSetViewport(drawCmdBuffers[i], 0, 1, &viewport);
 		vkCmdSetScissor(drawCmdBuffers[i], 0, 1, &scissor);
 		// Bind scene matrices descriptor to set 0
 		vkCmdBindDescriptorSets(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSet, 0, nullptr);
-		vkCmdBindPipeline(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, wireframe ? pipelines.wireframe : pipelines.solid);
+		if (cpuSkinning)
+		{
+			// Host skinning writes a separate copy for each swap chain image, so the command buffer of an image always reads the same copy
+			VkDeviceSize offsets[1] = {i * cpu.copySize};
+			vkCmdBindVertexBuffers(drawCmdBuffers[i], 1, 1, &cpu.skinnedVertices.buffer, offsets);
+			vkCmdBindPipeline(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, wireframe ? pipelines.hostSkinnedWireframe : pipelines.hostSkinnedSolid);
+		}
+		else if (computeSkinning)
+		{
+			// Skinned positions and normals are read from binding 1, the remaining attributes from the model's vertex buffer bound to binding 0
+			VkDeviceSize offsets[1] = {0};
+			vkCmdBindVertexBuffers(drawCmdBuffers[i], 1, 1, &compute.skinnedVertices.buffer, offsets);
+			vkCmdBindPipeline(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, wireframe ? pipelines.preskinnedWireframe : pipelines.preskinnedSolid);
+		}
+		else
+		{
+			vkCmdBindPipeline(drawCmdBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, wireframe ? pipelines.wireframe : pipelines.solid);
+		}
 		glTFModel.draw(drawCmdBuffers[i], pipelineLayout);
 		drawUI(drawCmdBuffers[i]);
 		vkCmdEndRenderPass(drawCmdBuffers[i]);
+		benchmark.endGpuFrame(drawCmdBuffers[i], i);
 		VK_CHECK_RESULT(vkEndCommandBuffer(drawCmdBuffers[i]));
 	}
 }
@@ -763,46 +889,42 @@ void VulkanExample::loadglTFFile(std::string filename)
 	}
 
 	// Create and upload vertex and index buffer
-	size_t vertexBufferSize = vertexBuffer.size() * sizeof(VulkanglTFModel::Vertex);
-	size_t indexBufferSize  = indexBuffer.size() * sizeof(uint32_t);
-	glTFModel.indices.count = static_cast<uint32_t>(indexBuffer.size());
+	size_t vertexBufferSize  = vertexBuffer.size() * sizeof(VulkanglTFModel::Vertex);
+	size_t indexBufferSize   = indexBuffer.size() * sizeof(uint32_t);
+	glTFModel.vertices.count = static_cast<uint32_t>(vertexBuffer.size());
+	glTFModel.indices.count  = static_cast<uint32_t>(indexBuffer.size());
 
-	struct StagingBuffer
-	{
-		VkBuffer       buffer;
-		VkDeviceMemory memory;
-	} vertexStaging, indexStaging;
+	vks::Buffer vertexStaging, indexStaging;
 
 	// Create host visible staging buffers (source)
 	VK_CHECK_RESULT(vulkanDevice->createBuffer(
 	    VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
 	    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+	    &vertexStaging,
 	    vertexBufferSize,
-	    &vertexStaging.buffer,
-	    &vertexStaging.memory,
 	    vertexBuffer.data()));
 	// Index data
 	VK_CHECK_RESULT(vulkanDevice->createBuffer(
 	    VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
 	    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+	    &indexStaging,
 	    indexBufferSize,
-	    &indexStaging.buffer,
-	    &indexStaging.memory,
 	    indexBuffer.data()));
 
 	// Create device local buffers (targat)
+	// The vertex buffer is also read as a storage buffer by the skinning compute shader
 	VK_CHECK_RESULT(vulkanDevice->createBuffer(
-	    VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+	    VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
 	    VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
 	    vertexBufferSize,
 	    &glTFModel.vertices.buffer,
-	    &glTFModel.vertices.memory));
+	    &glTFModel.vertices.allocation));
 	VK_CHECK_RESULT(vulkanDevice->createBuffer(
 	    VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
 	    VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
 	    indexBufferSize,
 	    &glTFModel.indices.buffer,
-	    &glTFModel.indices.memory));
+	    &glTFModel.indices.allocation));
 
 	// Copy data from staging buffers (host) do device local buffer (gpu)
 	VkCommandBuffer copyCmd    = vulkanDevice->createCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
@@ -814,10 +936,20 @@ void VulkanExample::loadglTFFile(std::string filename)
 	vulkanDevice->flushCommandBuffer(copyCmd, queue, true);
 
 	// Free staging resources
-	vkDestroyBuffer(device, vertexStaging.buffer, nullptr);
-	vkFreeMemory(device, vertexStaging.memory, nullptr);
-	vkDestroyBuffer(device, indexStaging.buffer, nullptr);
-	vkFreeMemory(device, indexStaging.memory, nullptr);
+	vertexStaging.destroy();
+	indexStaging.destroy();
+
+	// Host skinning reads the unskinned vertices every frame, converted to the vertex layout of vkglTF::VertexSkinning
+	cpu.sourceVertices.resize(vertexBuffer.size());
+	for (size_t v = 0; v < vertexBuffer.size(); v++)
+	{
+		cpu.sourceVertices[v].pos     = vertexBuffer[v].pos;
+		cpu.sourceVertices[v].normal  = vertexBuffer[v].normal;
+		cpu.sourceVertices[v].uv      = vertexBuffer[v].uv;
+		cpu.sourceVertices[v].color   = glm::vec4(vertexBuffer[v].color, 1.0f);
+		cpu.sourceVertices[v].joint0  = vertexBuffer[v].jointIndices;
+		cpu.sourceVertices[v].weight0 = vertexBuffer[v].jointWeights;
+	}
 }
 
 void VulkanExample::setupDescriptors()
@@ -830,11 +962,11 @@ void VulkanExample::setupDescriptors()
 	    vks::initializers::descriptorPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1),
 	    // One combined image sampler per material image/texture
 	    vks::initializers::descriptorPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, static_cast<uint32_t>(glTFModel.images.size())),
-	    // One ssbo per skin
-	    vks::initializers::descriptorPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, static_cast<uint32_t>(glTFModel.skins.size())),
+	    // One ssbo per skin and the input and output vertices of the skinning compute shader
+	    vks::initializers::descriptorPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, static_cast<uint32_t>(glTFModel.skins.size()) + 2),
 	};
-	// Number of descriptor sets = One for the scene ubo + one per image + one per skin
-	const uint32_t             maxSetCount        = static_cast<uint32_t>(glTFModel.images.size()) + static_cast<uint32_t>(glTFModel.skins.size()) + 1;
+	// Number of descriptor sets = One for the scene ubo + one per image + one per skin + one for the skinning compute shader
+	const uint32_t             maxSetCount        = static_cast<uint32_t>(glTFModel.images.size()) + static_cast<uint32_t>(glTFModel.skins.size()) + 2;
 	VkDescriptorPoolCreateInfo descriptorPoolInfo = vks::initializers::descriptorPoolCreateInfo(poolSizes, maxSetCount);
 	VK_CHECK_RESULT(vkCreateDescriptorPool(device, &descriptorPoolInfo, nullptr, &descriptorPool));
 
@@ -850,8 +982,8 @@ void VulkanExample::setupDescriptors()
 	setLayoutBinding = vks::initializers::descriptorSetLayoutBinding(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, 0);
 	VK_CHECK_RESULT(vkCreateDescriptorSetLayout(device, &descriptorSetLayoutCI, nullptr, &descriptorSetLayouts.textures));
 
-	// Descriptor set layout for passing skin joint matrices
-	setLayoutBinding = vks::initializers::descriptorSetLayoutBinding(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT, 0);
+	// Descriptor set layout for passing skin joint matrices (also used by the skinning compute shader)
+	setLayoutBinding = vks::initializers::descriptorSetLayoutBinding(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_COMPUTE_BIT, 0);
 	VK_CHECK_RESULT(vkCreateDescriptorSetLayout(device, &descriptorSetLayoutCI, nullptr, &descriptorSetLayouts.jointMatrices));
 
 	// The pipeline layout uses three sets:
@@ -953,6 +1085,152 @@ void VulkanExample::preparePipelines()
 		rasterizationStateCI.lineWidth   = 1.0f;
 		VK_CHECK_RESULT(vkCreateGraphicsPipelines(device, pipelineCache, 1, &pipelineCI, nullptr, &pipelines.wireframe));
 	}
+
+	// POI: Pipelines for vertices skinned by the compute pre-pass
+	// Skinned position and normal come from the output of the compute shader, the remaining attributes from the model's vertex buffer
+	const std::vector<VkVertexInputBindingDescription> preskinnedInputBindings = {
+	    vks::initializers::vertexInputBindingDescription(0, sizeof(VulkanglTFModel::Vertex), VK_VERTEX_INPUT_RATE_VERTEX),
+	    vks::initializers::vertexInputBindingDescription(1, sizeof(glm::vec3) * 2, VK_VERTEX_INPUT_RATE_VERTEX),
+	};
+	const std::vector<VkVertexInputAttributeDescription> preskinnedInputAttributes = {
+	    {0, 1, VK_FORMAT_R32G32B32_SFLOAT, 0},
+	    {1, 1, VK_FORMAT_R32G32B32_SFLOAT, sizeof(glm::vec3)},
+	    {2, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(VulkanglTFModel::Vertex, uv)},
+	    {3, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(VulkanglTFModel::Vertex, color)},
+	};
+	vertexInputStateCI.vertexBindingDescriptionCount   = static_cast<uint32_t>(preskinnedInputBindings.size());
+	vertexInputStateCI.pVertexBindingDescriptions      = preskinnedInputBindings.data();
+	vertexInputStateCI.vertexAttributeDescriptionCount = static_cast<uint32_t>(preskinnedInputAttributes.size());
+	vertexInputStateCI.pVertexAttributeDescriptions    = preskinnedInputAttributes.data();
+
+	const std::array<VkPipelineShaderStageCreateInfo, 2> preskinnedShaderStages = {
+	    loadShader(getShadersPath() + "gltfskinning/preskinnedmodel.vert.spv", VK_SHADER_STAGE_VERTEX_BIT),
+	    loadShader(getShadersPath() + "gltfskinning/skinnedmodel.frag.spv", VK_SHADER_STAGE_FRAGMENT_BIT)};
+	pipelineCI.pStages = preskinnedShaderStages.data();
+
+	rasterizationStateCI.polygonMode = VK_POLYGON_MODE_FILL;
+	VK_CHECK_RESULT(vkCreateGraphicsPipelines(device, pipelineCache, 1, &pipelineCI, nullptr, &pipelines.preskinnedSolid));
+	if (deviceFeatures.fillModeNonSolid)
+	{
+		rasterizationStateCI.polygonMode = VK_POLYGON_MODE_LINE;
+		VK_CHECK_RESULT(vkCreateGraphicsPipelines(device, pipelineCache, 1, &pipelineCI, nullptr, &pipelines.preskinnedWireframe));
+	}
+
+	// POI: Pipelines for vertices skinned on the host
+	// Same shaders as for the compute pre-pass, but the skinned position and normal are read from vertices with the layout of vkglTF::Vertex
+	const std::vector<VkVertexInputBindingDescription> hostSkinnedInputBindings = {
+	    vks::initializers::vertexInputBindingDescription(0, sizeof(VulkanglTFModel::Vertex), VK_VERTEX_INPUT_RATE_VERTEX),
+	    vks::initializers::vertexInputBindingDescription(1, sizeof(vkglTF::Vertex), VK_VERTEX_INPUT_RATE_VERTEX),
+	};
+	const std::vector<VkVertexInputAttributeDescription> hostSkinnedInputAttributes = {
+	    {0, 1, VK_FORMAT_R32G32B32_SFLOAT, offsetof(vkglTF::Vertex, pos)},
+	    {1, 1, VK_FORMAT_R32G32B32_SFLOAT, offsetof(vkglTF::Vertex, normal)},
+	    {2, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(VulkanglTFModel::Vertex, uv)},
+	    {3, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(VulkanglTFModel::Vertex, color)},
+	};
+	vertexInputStateCI.vertexBindingDescriptionCount   = static_cast<uint32_t>(hostSkinnedInputBindings.size());
+	vertexInputStateCI.pVertexBindingDescriptions      = hostSkinnedInputBindings.data();
+	vertexInputStateCI.vertexAttributeDescriptionCount = static_cast<uint32_t>(hostSkinnedInputAttributes.size());
+	vertexInputStateCI.pVertexAttributeDescriptions    = hostSkinnedInputAttributes.data();
+
+	rasterizationStateCI.polygonMode = VK_POLYGON_MODE_FILL;
+	VK_CHECK_RESULT(vkCreateGraphicsPipelines(device, pipelineCache, 1, &pipelineCI, nullptr, &pipelines.hostSkinnedSolid));
+	if (deviceFeatures.fillModeNonSolid)
+	{
+		rasterizationStateCI.polygonMode = VK_POLYGON_MODE_LINE;
+		VK_CHECK_RESULT(vkCreateGraphicsPipelines(device, pipelineCache, 1, &pipelineCI, nullptr, &pipelines.hostSkinnedWireframe));
+	}
+}
+
+// POI: Setup the compute pre-pass that writes the skinned position and normal of every vertex to a separate vertex buffer
+void VulkanExample::prepareComputeSkinning()
+{
+	// Position and normal (tightly packed) for every vertex
+	VK_CHECK_RESULT(vulkanDevice->createBuffer(
+	    VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+	    VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+	    &compute.skinnedVertices,
+	    std::max(glTFModel.vertices.count, 1u) * sizeof(glm::vec3) * 2));
+
+	// Set 0 = Input vertices and output skinned vertices
+	const std::vector<VkDescriptorSetLayoutBinding> setLayoutBindings = {
+	    vks::initializers::descriptorSetLayoutBinding(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 0),
+	    vks::initializers::descriptorSetLayoutBinding(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1),
+	};
+	VkDescriptorSetLayoutCreateInfo descriptorSetLayoutCI = vks::initializers::descriptorSetLayoutCreateInfo(setLayoutBindings);
+	VK_CHECK_RESULT(vkCreateDescriptorSetLayout(device, &descriptorSetLayoutCI, nullptr, &compute.descriptorSetLayout));
+
+	// Set 1 = Joint matrices of the skin (shared with the graphics pipeline)
+	const std::array<VkDescriptorSetLayout, 2> setLayouts       = {compute.descriptorSetLayout, descriptorSetLayouts.jointMatrices};
+	VkPipelineLayoutCreateInfo                 pipelineLayoutCI = vks::initializers::pipelineLayoutCreateInfo(setLayouts.data(), static_cast<uint32_t>(setLayouts.size()));
+	// The vertex range of the dispatched primitive is passed via push constants
+	VkPushConstantRange pushConstantRange   = vks::initializers::pushConstantRange(VK_SHADER_STAGE_COMPUTE_BIT, sizeof(uint32_t) * 2, 0);
+	pipelineLayoutCI.pushConstantRangeCount = 1;
+	pipelineLayoutCI.pPushConstantRanges    = &pushConstantRange;
+	VK_CHECK_RESULT(vkCreatePipelineLayout(device, &pipelineLayoutCI, nullptr, &compute.pipelineLayout));
+
+	VkDescriptorSetAllocateInfo allocInfo = vks::initializers::descriptorSetAllocateInfo(descriptorPool, &compute.descriptorSetLayout, 1);
+	VK_CHECK_RESULT(vkAllocateDescriptorSets(device, &allocInfo, &compute.descriptorSet));
+	VkDescriptorBufferInfo                  inputDescriptor  = {glTFModel.vertices.buffer, 0, VK_WHOLE_SIZE};
+	const std::vector<VkWriteDescriptorSet> writeDescriptorSets = {
+	    vks::initializers::writeDescriptorSet(compute.descriptorSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 0, &inputDescriptor),
+	    vks::initializers::writeDescriptorSet(compute.descriptorSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, &compute.skinnedVertices.descriptor),
+	};
+	vkUpdateDescriptorSets(device, static_cast<uint32_t>(writeDescriptorSets.size()), writeDescriptorSets.data(), 0, nullptr);
+
+	VkComputePipelineCreateInfo computePipelineCI = vks::initializers::computePipelineCreateInfo(compute.pipelineLayout, 0);
+	computePipelineCI.stage                       = loadShader(getShadersPath() + "gltfskinning/skinning.comp.spv", VK_SHADER_STAGE_COMPUTE_BIT);
+	VK_CHECK_RESULT(vkCreateComputePipelines(device, pipelineCache, 1, &computePipelineCI, nullptr, &compute.pipeline));
+}
+
+// POI: Setup the host skinning, which writes the skinned vertices to a host visible vertex buffer
+void VulkanExample::prepareCpuSkinning()
+{
+	// The command buffers are built once per swap chain image, so there is one copy per image
+	// An image's copy is only written after acquiring the image, once its previous frame has finished reading the copy
+	cpu.copySize = std::max(glTFModel.vertices.count, 1u) * sizeof(vkglTF::Vertex);
+	VK_CHECK_RESULT(vulkanDevice->createBuffer(
+	    VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+	    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+	    &cpu.skinnedVertices,
+	    cpu.copySize * drawCmdBuffers.size()));
+	VK_CHECK_RESULT(cpu.skinnedVertices.map());
+	// Vertices of nodes without a skin are never written by the skinning, so all copies start with the unskinned vertices
+	for (size_t copy = 0; copy < drawCmdBuffers.size(); copy++)
+	{
+		memcpy(static_cast<uint8_t *>(cpu.skinnedVertices.mapped) + copy * cpu.copySize, cpu.sourceVertices.data(), cpu.sourceVertices.size() * sizeof(vkglTF::Vertex));
+	}
+
+	// Work is split by vertices instead of primitives, so a single large primitive is spread across all threads
+	for (auto &node : glTFModel.nodes)
+	{
+		glTFModel.getSkinnedPrimitives(node, cpu.primitives);
+	}
+	for (const VulkanglTFModel::SkinnedPrimitive &primitive : cpu.primitives)
+	{
+		cpu.primitiveStart.push_back(cpu.vertexCount);
+		cpu.vertexCount += primitive.vertexCount;
+	}
+	cpu.jobSystem.reset(new vks::JobSystem());
+}
+
+// POI: Skin the vertices of all skinned primitives on all CPU cores with the widest instruction set supported by the CPU
+void VulkanExample::skinVerticesOnHost(vkglTF::Vertex *skinnedVertices)
+{
+	const vkglTF::Vertex * sourceVertices = cpu.sourceVertices.data();
+	const vks::simd::Path  path           = vks::simd::supportedPath();
+	cpu.jobSystem->parallelForRange(cpu.vertexCount, [&](size_t begin, size_t end) {
+		size_t p = std::upper_bound(cpu.primitiveStart.begin(), cpu.primitiveStart.end(), begin) - cpu.primitiveStart.begin() - 1;
+		while (begin < end)
+		{
+			const VulkanglTFModel::SkinnedPrimitive &primitive = cpu.primitives[p];
+			const size_t                             first     = primitive.firstVertex + (begin - cpu.primitiveStart[p]);
+			const size_t                             count     = std::min(end, cpu.primitiveStart[p] + primitive.vertexCount) - begin;
+			vkglTF::VertexSkinning::skin(sourceVertices + first, skinnedVertices + first, count, glTFModel.skins[primitive.skin].jointMatrices.data(), path);
+			begin += count;
+			p++;
+		}
+	}, 1024);
 }
 
 void VulkanExample::prepareUniformBuffers()
@@ -980,14 +1258,33 @@ void VulkanExample::prepare()
 	loadAssets();
 	prepareUniformBuffers();
 	setupDescriptors();
+	prepareComputeSkinning();
+	prepareCpuSkinning();
 	preparePipelines();
 	buildCommandBuffers();
+	// Store the skinning path with the benchmark results, so runs of the different paths can be compared
+	benchmark.variant = cpuSkinning ? "cpu skinning" : (computeSkinning ? "compute skinning" : "vertex shader skinning");
 	prepared = true;
 }
 
 void VulkanExample::render()
 {
-	renderFrame();
+	if (cpuSkinning)
+	{
+		// POI: The frame is submitted here instead of in renderFrame, so the vertices can be skinned into the copy of the acquired image
+		VulkanExampleBase::prepareFrame();
+		const auto tStart = std::chrono::high_resolution_clock::now();
+		skinVerticesOnHost(reinterpret_cast<vkglTF::Vertex *>(static_cast<uint8_t *>(cpu.skinnedVertices.mapped) + currentBuffer * cpu.copySize));
+		benchmark.record("skinning", std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - tStart).count());
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers    = &drawCmdBuffers[currentBuffer];
+		VK_CHECK_RESULT(vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE));
+		VulkanExampleBase::submitFrame();
+	}
+	else
+	{
+		renderFrame();
+	}
 	if (camera.updated)
 	{
 		updateUniformBuffers();
@@ -1007,6 +1304,16 @@ void VulkanExample::OnUpdateUIOverlay(vks::UIOverlay *overlay)
 		{
 			buildCommandBuffers();
 		}
+		if (overlay->checkBox("Compute skinning pre-pass", &computeSkinning))
+		{
+			cpuSkinning = cpuSkinning && !computeSkinning;
+			buildCommandBuffers();
+		}
+		if (overlay->checkBox("CPU skinning", &cpuSkinning))
+		{
+			computeSkinning = computeSkinning && !cpuSkinning;
+			buildCommandBuffers();
+		}
 	}
 }
 
@@ -27,15 +27,14 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
-#define TINYGLTF_IMPLEMENTATION
-#define STB_IMAGE_IMPLEMENTATION
-#define TINYGLTF_NO_STB_IMAGE_WRITE
+// tinyglTF is compiled by VulkanglTFModel.hpp, which also provides the vertex skinning functions used for skinning on the host
 #ifdef VK_USE_PLATFORM_ANDROID_KHR
 #	define TINYGLTF_ANDROID_LOAD_FROM_ASSETS
 #endif
-#include "tiny_gltf.h"
+#include "VulkanglTFModel.hpp"
 
 #include "VulkanTexture.hpp"
+#include "jobsystem.hpp"
 #include "vulkanexamplebase.h"
 #include <vulkan/vulkan.h>
 
@@ -55,15 +54,16 @@ class VulkanglTFModel
 
 	struct Vertices
 	{
+		uint32_t       count;
 		VkBuffer       buffer;
-		VkDeviceMemory memory;
+		vks::Allocation allocation;
 	} vertices;
 
 	struct Indices
 	{
 		int            count;
 		VkBuffer       buffer;
-		VkDeviceMemory memory;
+		vks::Allocation allocation;
 	} indices;
 
 	struct Node;
@@ -89,6 +89,8 @@ class VulkanglTFModel
 	{
 		uint32_t firstIndex;
 		uint32_t indexCount;
+		uint32_t firstVertex;
+		uint32_t vertexCount;
 		int32_t  materialIndex;
 	};
 
@@ -131,10 +133,20 @@ class VulkanglTFModel
 		Node *                 skeletonRoot = nullptr;
 		std::vector<glm::mat4> inverseBindMatrices;
 		std::vector<Node *>    joints;
+		// Current joint matrices, uploaded to the ssbo and also used for skinning on the host
+		std::vector<glm::mat4> jointMatrices;
 		vks::Buffer            ssbo;
 		VkDescriptorSet        descriptorSet;
 	};
 
+	// Vertex range of a primitive of a skinned node and the skin whose joints it uses
+	struct SkinnedPrimitive
+	{
+		uint32_t firstVertex;
+		uint32_t vertexCount;
+		int32_t  skin;
+	};
+
 	/*
 		Animation related structures
 	*/
@@ -186,6 +198,9 @@ class VulkanglTFModel
 	void      updateAnimation(float deltaTime);
 	void      drawNode(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout, VulkanglTFModel::Node node);
 	void      draw(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout);
+	void      skinNode(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout, VulkanglTFModel::Node *node);
+	void      skin(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout);
+	void      getSkinnedPrimitives(VulkanglTFModel::Node *node, std::vector<SkinnedPrimitive> &skinnedPrimitives);
 };
 
 class VulkanExample : public VulkanExampleBase
@@ -209,8 +224,44 @@ class VulkanExample : public VulkanExampleBase
 	{
 		VkPipeline solid;
 		VkPipeline wireframe = VK_NULL_HANDLE;
+		// Variants reading the vertices skinned by the compute pre-pass
+		VkPipeline preskinnedSolid     = VK_NULL_HANDLE;
+		VkPipeline preskinnedWireframe = VK_NULL_HANDLE;
+		// Variants reading the vertices skinned on the host, which are stored with the full vertex layout of the skinning functions
+		VkPipeline hostSkinnedSolid     = VK_NULL_HANDLE;
+		VkPipeline hostSkinnedWireframe = VK_NULL_HANDLE;
 	} pipelines;
 
+	// POI: Optional compute pre-pass that skins all vertices once per frame, so every pass drawing the model reads the skinned vertices instead of blending the joints again
+	// Can be enabled at start with the "--computeskinning" command line argument, e.g. to compare both paths in benchmark mode
+	bool computeSkinning = false;
+	struct ComputeSkinning
+	{
+		// Skinned position and normal for every vertex of the model
+		vks::Buffer           skinnedVertices;
+		VkDescriptorSetLayout descriptorSetLayout;
+		VkDescriptorSet       descriptorSet;
+		VkPipelineLayout      pipelineLayout;
+		VkPipeline            pipeline;
+	} compute;
+
+	// POI: Optional host skinning that skins all vertices on the CPU every frame with vkglTF::VertexSkinning and writes them to a host visible vertex buffer
+	// Can be enabled at start with the "--cpuskinning" command line argument, e.g. to compare it with the GPU paths in benchmark mode
+	bool cpuSkinning = false;
+	struct CpuSkinning
+	{
+		// Unskinned vertices of the model in the vertex layout of the skinning functions
+		std::vector<vkglTF::Vertex> sourceVertices;
+		// Skinned vertices, one copy per swap chain image
+		vks::Buffer  skinnedVertices;
+		VkDeviceSize copySize = 0;
+		// Primitives of skinned nodes and the index of their first vertex in the flattened work list
+		std::vector<VulkanglTFModel::SkinnedPrimitive> primitives;
+		std::vector<size_t>                            primitiveStart;
+		size_t                                         vertexCount = 0;
+		std::unique_ptr<vks::JobSystem>                jobSystem;
+	} cpu;
+
 	struct DescriptorSetLayouts
 	{
 		VkDescriptorSetLayout matrices;
@@ -229,6 +280,9 @@ class VulkanExample : public VulkanExampleBase
 	void         loadAssets();
 	void         setupDescriptors();
 	void         preparePipelines();
+	void         prepareComputeSkinning();
+	void         prepareCpuSkinning();
+	void         skinVerticesOnHost(vkglTF::Vertex *skinnedVertices);
 	void         prepareUniformBuffers();
 	void         updateUniformBuffers();
 	void         prepare();
@@ -65,7 +65,7 @@ public:
 	// Contains the instanced data
 	struct InstanceBuffer {
 		VkBuffer buffer = VK_NULL_HANDLE;
-		VkDeviceMemory memory = VK_NULL_HANDLE;
+		vks::Allocation allocation;
 		size_t size = 0;
 		VkDescriptorBufferInfo descriptor;
 	} instanceBuffer;
@@ -113,7 +113,7 @@ public:
 		vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
 		vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr);
 		vkDestroyBuffer(device, instanceBuffer.buffer, nullptr);
-		vkFreeMemory(device, instanceBuffer.memory, nullptr);
+		vulkanDevice->memoryAllocator.free(instanceBuffer.allocation);
 		models.rock.destroy();
 		models.planet.destroy();
 		textures.rocks.destroy();
@@ -161,6 +161,7 @@ public:
 			renderPassBeginInfo.framebuffer = frameBuffers[i];
 
 			VK_CHECK_RESULT(vkBeginCommandBuffer(drawCmdBuffers[i], &cmdBufInfo));
+			benchmark.beginGpuFrame(drawCmdBuffers[i], i);
 
 			vkCmdBeginRenderPass(drawCmdBuffers[i], &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
 
@@ -201,6 +202,7 @@ public:
 
 			vkCmdEndRenderPass(drawCmdBuffers[i]);
 
+			benchmark.endGpuFrame(drawCmdBuffers[i], i);
 			VK_CHECK_RESULT(vkEndCommandBuffer(drawCmdBuffers[i]));
 		}
 	}
@@ -483,17 +485,13 @@ public:
 		// Instanced data is static, copy to device local memory
 		// This results in better performance
 
-		struct {
-			VkDeviceMemory memory;
-			VkBuffer buffer;
-		} stagingBuffer;
+		vks::Buffer stagingBuffer;
 
 		VK_CHECK_RESULT(vulkanDevice->createBuffer(
 			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
 			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			&stagingBuffer,
 			instanceBuffer.size,
-			&stagingBuffer.buffer,
-			&stagingBuffer.memory,
 			instanceData.data()));
 
 		VK_CHECK_RESULT(vulkanDevice->createBuffer(
@@ -501,7 +499,7 @@ public:
 			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
 			instanceBuffer.size,
 			&instanceBuffer.buffer,
-			&instanceBuffer.memory));
+			&instanceBuffer.allocation));
 
 		// Copy to staging buffer
 		VkCommandBuffer copyCmd = vulkanDevice->createCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
@@ -522,8 +520,7 @@ public:
 		instanceBuffer.descriptor.offset = 0;
 
 		// Destroy staging resources
-		vkDestroyBuffer(device, stagingBuffer.buffer, nullptr);
-		vkFreeMemory(device, stagingBuffer.memory, nullptr);
+		stagingBuffer.destroy();
 	}
 
 	void prepareUniformBuffers()
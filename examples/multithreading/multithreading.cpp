@@ -13,6 +13,7 @@
 #include <vector>
 #include <thread>
 #include <random>
+#include <chrono>
 
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
@@ -22,7 +23,7 @@
 #include <vulkan/vulkan.h>
 #include "vulkanexamplebase.h"
 
-#include "threadpool.hpp"
+#include "jobsystem.hpp"
 #include "frustum.hpp"
 
 #include "VulkanModel.hpp"
@@ -69,10 +70,10 @@ public:
 
 	// Number of animated objects to be renderer
 	// by using threads and secondary command buffers
-	uint32_t numObjectsPerThread;
+	const uint32_t numObjects = 512;
 
 	// Multi threaded stuff
-	// Max. number of concurrent threads
+	// Number of threads recording command buffers (including the main thread)
 	uint32_t numThreads;
 
 	// Use push constants to update shader
@@ -91,21 +92,27 @@ public:
 		float scale;
 		float deltaT;
 		float stateT = 0;
-		bool visible = true;
 	};
 
+	// One push constant block per render object
+	std::vector<ThreadPushConstantBlock> pushConstBlock;
+	// Per object information (position, rotation, etc.)
+	std::vector<ObjectData> objectData;
+	// Secondary command buffer an object has been recorded to in the current frame
+	std::vector<VkCommandBuffer> objectCommandBuffers;
+
+	// Objects are not bound to a thread, the job system balances them across all threads
+	// Command pools must only be used by one thread at a time, so every thread records to command buffers from its own pool
 	struct ThreadData {
 		VkCommandPool commandPool;
-		// One command buffer per render object
+		// Grows on demand, a thread may have to record all objects if the others are busy
 		std::vector<VkCommandBuffer> commandBuffer;
-		// One push constant block per render object
-		std::vector<ThreadPushConstantBlock> pushConstBlock;
-		// Per object information (position, rotation, etc.)
-		std::vector<ObjectData> objectData;
+		// Number of command buffers recorded in the current frame
+		uint32_t usedCommandBuffers = 0;
 	};
 	std::vector<ThreadData> threadData;
 
-	vks::ThreadPool threadPool;
+	vks::JobSystem jobSystem;
 
 	// Fence to wait for all command buffers to finish before
 	// presenting to the swap chain
@@ -118,6 +125,15 @@ public:
 	// View frustum for culling invisible objects
 	vks::Frustum frustum;
 
+	// Object bounding spheres stored as structure of arrays, so all objects can be culled with one batch call
+	struct {
+		std::vector<float> x, y, z, radius;
+		std::vector<uint32_t> visibilityMask;
+		// Indices of the objects that passed culling in the current frame
+		std::vector<uint32_t> visibleObjects;
+		double cpuTime = 0.0;
+	} culling;
+
 	std::default_random_engine rndEngine;
 
 	VulkanExample() : VulkanExampleBase(ENABLE_VALIDATION)
@@ -129,16 +145,14 @@ public:
 		camera.setRotationSpeed(0.5f);
 		camera.setPerspective(60.0f, (float)width / (float)height, 0.1f, 256.0f);
 		settings.overlay = true;
-		// Get number of max. concurrrent threads
-		numThreads = std::thread::hardware_concurrency();
+		// The job system uses all hardware threads
+		numThreads = jobSystem.threadCount();
 		assert(numThreads > 0);
 #if defined(__ANDROID__)
 		LOGD("numThreads = %d", numThreads);
 #else
 		std::cout << "numThreads = " << numThreads << std::endl;
 #endif
-		threadPool.setThreadCount(numThreads);
-		numObjectsPerThread = 512 / numThreads;
 		rndEngine.seed(benchmark.active ? 0 : (unsigned)time(nullptr));
 	}
 
@@ -155,7 +169,9 @@ public:
 		models.skysphere.destroy();
 
 		for (auto& thread : threadData) {
-			vkFreeCommandBuffers(device, thread.commandPool, thread.commandBuffer.size(), thread.commandBuffer.data());
+			if (!thread.commandBuffer.empty()) {
+				vkFreeCommandBuffers(device, thread.commandPool, thread.commandBuffer.size(), thread.commandBuffer.data());
+			}
 			vkDestroyCommandPool(device, thread.commandPool, nullptr);
 		}
 
@@ -188,69 +204,80 @@ public:
 
 		threadData.resize(numThreads);
 
-		float maxX = std::floor(std::sqrt(numThreads * numObjectsPerThread));
-		uint32_t posX = 0;
-		uint32_t posZ = 0;
-
 		for (uint32_t i = 0; i < numThreads; i++) {
-			ThreadData *thread = &threadData[i];
-
 			// Create one command pool for each thread
+			// The secondary command buffers are re-recorded every frame, so they are reset together with their pool instead of one by one
 			VkCommandPoolCreateInfo cmdPoolInfo = vks::initializers::commandPoolCreateInfo();
 			cmdPoolInfo.queueFamilyIndex = swapChain.queueNodeIndex;
-			cmdPoolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
-			VK_CHECK_RESULT(vkCreateCommandPool(device, &cmdPoolInfo, nullptr, &thread->commandPool));
-
-			// One secondary command buffer per object that is updated by this thread
-			thread->commandBuffer.resize(numObjectsPerThread);
-			// Generate secondary command buffers for each thread
-			VkCommandBufferAllocateInfo secondaryCmdBufAllocateInfo =
-				vks::initializers::commandBufferAllocateInfo(
-					thread->commandPool,
-					VK_COMMAND_BUFFER_LEVEL_SECONDARY,
-					thread->commandBuffer.size());
-			VK_CHECK_RESULT(vkAllocateCommandBuffers(device, &secondaryCmdBufAllocateInfo, thread->commandBuffer.data()));
-
-			thread->pushConstBlock.resize(numObjectsPerThread);
-			thread->objectData.resize(numObjectsPerThread);
-
-			for (uint32_t j = 0; j < numObjectsPerThread; j++) {
-				float theta = 2.0f * float(M_PI) * rnd(1.0f);
-				float phi = acos(1.0f - 2.0f * rnd(1.0f));
-				thread->objectData[j].pos = glm::vec3(sin(phi) * cos(theta), 0.0f, cos(phi)) * 35.0f;
-
-				thread->objectData[j].rotation = glm::vec3(0.0f, rnd(360.0f), 0.0f);
-				thread->objectData[j].deltaT = rnd(1.0f);
-				thread->objectData[j].rotationDir = (rnd(100.0f) < 50.0f) ? 1.0f : -1.0f;
-				thread->objectData[j].rotationSpeed = (2.0f + rnd(4.0f)) * thread->objectData[j].rotationDir;
-				thread->objectData[j].scale = 0.75f + rnd(0.5f);
-
-				thread->pushConstBlock[j].color = glm::vec3(rnd(1.0f), rnd(1.0f), rnd(1.0f));
-			}
+			cmdPoolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+			VK_CHECK_RESULT(vkCreateCommandPool(device, &cmdPoolInfo, nullptr, &threadData[i].commandPool));
+			// Start with an even share of the objects, more secondary command buffers are allocated on demand
+			allocateThreadCommandBuffers(threadData[i], (numObjects + numThreads - 1) / numThreads);
+		}
+
+		pushConstBlock.resize(numObjects);
+		objectData.resize(numObjects);
+		objectCommandBuffers.resize(numObjects, VK_NULL_HANDLE);
+
+		for (uint32_t i = 0; i < numObjects; i++) {
+			float theta = 2.0f * float(M_PI) * rnd(1.0f);
+			float phi = acos(1.0f - 2.0f * rnd(1.0f));
+			objectData[i].pos = glm::vec3(sin(phi) * cos(theta), 0.0f, cos(phi)) * 35.0f;
+
+			objectData[i].rotation = glm::vec3(0.0f, rnd(360.0f), 0.0f);
+			objectData[i].deltaT = rnd(1.0f);
+			objectData[i].rotationDir = (rnd(100.0f) < 50.0f) ? 1.0f : -1.0f;
+			objectData[i].rotationSpeed = (2.0f + rnd(4.0f)) * objectData[i].rotationDir;
+			objectData[i].scale = 0.75f + rnd(0.5f);
+
+			pushConstBlock[i].color = glm::vec3(rnd(1.0f), rnd(1.0f), rnd(1.0f));
+		}
+
+		culling.x.resize(numObjects);
+		culling.y.resize(numObjects);
+		culling.z.resize(numObjects);
+		culling.radius.resize(numObjects, objectSphereDim * 0.5f);
+		culling.visibilityMask.resize(vks::Frustum::visibilityMaskSize(numObjects));
+		culling.visibleObjects.reserve(numObjects);
+		for (uint32_t i = 0; i < numObjects; i++) {
+			culling.x[i] = objectData[i].pos.x;
+			culling.y[i] = objectData[i].pos.y;
+			culling.z[i] = objectData[i].pos.z;
 		}
 
 	}
 
-	// Builds the secondary command buffer for each thread
-	void threadRenderCode(uint32_t threadIndex, uint32_t cmdBufferIndex, VkCommandBufferInheritanceInfo inheritanceInfo)
+	// Allocates additional secondary command buffers from a thread's command pool
+	// Only called by the thread owning the pool (or before rendering starts)
+	void allocateThreadCommandBuffers(ThreadData &thread, uint32_t count)
 	{
-		ThreadData *thread = &threadData[threadIndex];
-		ObjectData *objectData = &thread->objectData[cmdBufferIndex];
+		const size_t first = thread.commandBuffer.size();
+		thread.commandBuffer.resize(first + count);
+		VkCommandBufferAllocateInfo secondaryCmdBufAllocateInfo =
+			vks::initializers::commandBufferAllocateInfo(
+				thread.commandPool,
+				VK_COMMAND_BUFFER_LEVEL_SECONDARY,
+				count);
+		VK_CHECK_RESULT(vkAllocateCommandBuffers(device, &secondaryCmdBufAllocateInfo, &thread.commandBuffer[first]));
+	}
 
-		// Check visibility against view frustum
-		objectData->visible = frustum.checkSphere(objectData->pos, objectSphereDim * 0.5f);
+	// Builds the secondary command buffer for a visible object on the thread given by threadIndex
+	void threadRenderCode(uint32_t threadIndex, uint32_t objectIndex, const VkCommandBufferInheritanceInfo &inheritanceInfo)
+	{
+		ThreadData *thread = &threadData[threadIndex];
+		ObjectData *objectData = &this->objectData[objectIndex];
 
-		if (!objectData->visible)
-		{
-			return;
+		// Take the next free command buffer from this thread's pool
+		if (thread->usedCommandBuffers == thread->commandBuffer.size()) {
+			allocateThreadCommandBuffers(*thread, std::max<uint32_t>(static_cast<uint32_t>(thread->commandBuffer.size()) / 2, 16));
 		}
+		VkCommandBuffer cmdBuffer = thread->commandBuffer[thread->usedCommandBuffers++];
+		objectCommandBuffers[objectIndex] = cmdBuffer;
 
 		VkCommandBufferBeginInfo commandBufferBeginInfo = vks::initializers::commandBufferBeginInfo();
 		commandBufferBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
 		commandBufferBeginInfo.pInheritanceInfo = &inheritanceInfo;
 
-		VkCommandBuffer cmdBuffer = thread->commandBuffer[cmdBufferIndex];
-
 		VK_CHECK_RESULT(vkBeginCommandBuffer(cmdBuffer, &commandBufferBeginInfo));
 
 		VkViewport viewport = vks::initializers::viewport((float)width, (float)height, 0.0f, 1.0f);
@@ -271,6 +298,7 @@ public:
 			if (objectData->deltaT > 1.0f)
 				objectData->deltaT -= 1.0f;
 			objectData->pos.y = sin(glm::radians(objectData->deltaT * 360.0f)) * 2.5f;
+			culling.y[objectIndex] = objectData->pos.y;
 		}
 
 		objectData->model = glm::translate(glm::mat4(1.0f), objectData->pos);
@@ -279,7 +307,7 @@ public:
 		objectData->model = glm::rotate(objectData->model, glm::radians(objectData->deltaT * 360.0f), glm::vec3(0.0f, objectData->rotationDir, 0.0f));
 		objectData->model = glm::scale(objectData->model, glm::vec3(objectData->scale));
 
-		thread->pushConstBlock[cmdBufferIndex].mvp = matrices.projection * matrices.view * objectData->model;
+		pushConstBlock[objectIndex].mvp = matrices.projection * matrices.view * objectData->model;
 
 		// Update shader push constant block
 		// Contains model view matrix
@@ -289,7 +317,7 @@ public:
 			VK_SHADER_STAGE_VERTEX_BIT,
 			0,
 			sizeof(ThreadPushConstantBlock),
-			&thread->pushConstBlock[cmdBufferIndex]);
+			&pushConstBlock[objectIndex]);
 
 		VkDeviceSize offsets[1] = { 0 };
 		vkCmdBindVertexBuffers(cmdBuffer, 0, 1, &models.ufo.vertices.buffer, offsets);
@@ -299,7 +327,7 @@ public:
 		VK_CHECK_RESULT(vkEndCommandBuffer(cmdBuffer));
 	}
 
-	void updateSecondaryCommandBuffers(VkCommandBufferInheritanceInfo inheritanceInfo)
+	void updateSecondaryCommandBuffers(VkCommandBufferInheritanceInfo inheritanceInfo, uint32_t parentScope)
 	{
 		// Secondary command buffer for the sky sphere
 		VkCommandBufferBeginInfo commandBufferBeginInfo = vks::initializers::commandBufferBeginInfo();
@@ -314,6 +342,7 @@ public:
 		*/
 
 		VK_CHECK_RESULT(vkBeginCommandBuffer(secondaryCommandBuffers.background, &commandBufferBeginInfo));
+		const uint32_t backgroundScope = gpuProfiler.beginScope(secondaryCommandBuffers.background, "background", parentScope);
 
 		vkCmdSetViewport(secondaryCommandBuffers.background, 0, 1, &viewport);
 		vkCmdSetScissor(secondaryCommandBuffers.background, 0, 1, &scissor);
@@ -336,6 +365,7 @@ public:
 		vkCmdBindIndexBuffer(secondaryCommandBuffers.background, models.skysphere.indices.buffer, 0, VK_INDEX_TYPE_UINT32);
 		vkCmdDrawIndexed(secondaryCommandBuffers.background, models.skysphere.indexCount, 1, 0, 0, 0);
 
+		gpuProfiler.endScope(secondaryCommandBuffers.background, backgroundScope);
 		VK_CHECK_RESULT(vkEndCommandBuffer(secondaryCommandBuffers.background));
 
 		/*
@@ -346,6 +376,7 @@ public:
 		*/
 
 		VK_CHECK_RESULT(vkBeginCommandBuffer(secondaryCommandBuffers.ui, &commandBufferBeginInfo));
+		const uint32_t uiScope = gpuProfiler.beginScope(secondaryCommandBuffers.ui, "ui", parentScope);
 
 		vkCmdSetViewport(secondaryCommandBuffers.ui, 0, 1, &viewport);
 		vkCmdSetScissor(secondaryCommandBuffers.ui, 0, 1, &scissor);
@@ -356,10 +387,11 @@ public:
 			drawUI(secondaryCommandBuffers.ui);
 		}
 
+		gpuProfiler.endScope(secondaryCommandBuffers.ui, uiScope);
 		VK_CHECK_RESULT(vkEndCommandBuffer(secondaryCommandBuffers.ui));
 	}
 
-	// Updates the secondary command buffers using a thread pool
+	// Updates the secondary command buffers using the job system
 	// and puts them into the primary command buffer that's
 	// lat submitted to the queue for rendering
 	void updateCommandBuffers(VkFramebuffer frameBuffer)
@@ -387,6 +419,12 @@ public:
 
 		VK_CHECK_RESULT(vkBeginCommandBuffer(primaryCommandBuffer, &cmdBufInfo));
 
+		// The primary command buffer is recorded every frame, so it can hold the GPU profiler's scopes
+		// Timestamps can't be written to the primary command buffer within the render pass, the nested scopes are written to the secondary ones instead
+		gpuProfiler.beginFrame(primaryCommandBuffer, currentFrame);
+		benchmark.beginGpuFrame(primaryCommandBuffer, currentBuffer);
+		const uint32_t frameScope = gpuProfiler.beginScope(primaryCommandBuffer, "frame");
+
 		// The primary command buffer does not contain any rendering commands
 		// These are stored (and retrieved) from the secondary command buffers
 		vkCmdBeginRenderPass(primaryCommandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
@@ -398,33 +436,43 @@ public:
 		inheritanceInfo.framebuffer = frameBuffer;
 
 		// Update secondary sene command buffers
-		updateSecondaryCommandBuffers(inheritanceInfo);
+		updateSecondaryCommandBuffers(inheritanceInfo, frameScope);
 
 		if (displaySkybox) {
 			commandBuffers.push_back(secondaryCommandBuffers.background);
 		}
 
-		// Add a job to the thread's queue for each object to be rendered
-		for (uint32_t t = 0; t < numThreads; t++)
+		// Check visibility of all objects against the view frustum at once, so only visible objects are handed to the threads
+		auto cullStart = std::chrono::high_resolution_clock::now();
+		frustum.cullSpheres(culling.x.data(), culling.y.data(), culling.z.data(), culling.radius.data(), numObjects, culling.visibilityMask.data());
+		culling.visibleObjects.clear();
+		for (uint32_t i = 0; i < numObjects; i++)
 		{
-			for (uint32_t i = 0; i < numObjectsPerThread; i++)
+			if (vks::Frustum::isVisible(culling.visibilityMask.data(), i))
 			{
-				threadPool.threads[t]->addJob([=] { threadRenderCode(t, i, inheritanceInfo); });
+				culling.visibleObjects.push_back(i);
 			}
 		}
+		culling.cpuTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - cullStart).count();
 
-		threadPool.wait();
+		// The objects are split into chunks that idle threads steal from busy ones, so a thread
+		// being preempted doesn't leave the other threads waiting
+		// The GPU has finished the previous frame, so all secondary command buffers can be recycled at once
+		for (auto& thread : threadData) {
+			VK_CHECK_RESULT(vkResetCommandPool(device, thread.commandPool, 0));
+			thread.usedCommandBuffers = 0;
+		}
+		jobSystem.parallelForRange(culling.visibleObjects.size(), [&](size_t begin, size_t end) {
+			const uint32_t threadIndex = jobSystem.currentThreadIndex();
+			assert(threadIndex != vks::JobSystem::INVALID_THREAD_INDEX);
+			for (size_t i = begin; i < end; i++) {
+				threadRenderCode(threadIndex, culling.visibleObjects[i], inheritanceInfo);
+			}
+		});
 
-		// Only submit if object is within the current view frustum
-		for (uint32_t t = 0; t < numThreads; t++)
+		for (uint32_t objectIndex : culling.visibleObjects)
 		{
-			for (uint32_t i = 0; i < numObjectsPerThread; i++)
-			{
-				if (threadData[t].objectData[i].visible)
-				{
-					commandBuffers.push_back(threadData[t].commandBuffer[i]);
-				}
-			}
+			commandBuffers.push_back(objectCommandBuffers[objectIndex]);
 		}
 
 		// Render ui last
@@ -437,6 +485,8 @@ public:
 
 		vkCmdEndRenderPass(primaryCommandBuffer);
 
+		gpuProfiler.endScope(primaryCommandBuffer, frameScope);
+		benchmark.endGpuFrame(primaryCommandBuffer, currentBuffer);
 		VK_CHECK_RESULT(vkEndCommandBuffer(primaryCommandBuffer));
 	}
 
@@ -578,7 +628,10 @@ public:
 
 		VulkanExampleBase::prepareFrame();
 
+		auto recordStart = std::chrono::high_resolution_clock::now();
 		updateCommandBuffers(frameBuffers[currentBuffer]);
+		recordTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - recordStart).count();
+		benchmark.record("record", recordTime);
 
 		submitInfo.commandBufferCount = 1;
 		submitInfo.pCommandBuffers = &primaryCommandBuffer;
@@ -618,9 +671,21 @@ public:
 	{
 		if (overlay->header("Statistics")) {
 			overlay->text("Active threads: %d", numThreads);
+			for (uint32_t i = 0; i < numThreads; i++) {
+				overlay->text("Thread %d: %d draws", i, threadData[i].usedCommandBuffers);
+			}
+			overlay->text("Culling: %.3f ms (%d of %d visible)", culling.cpuTime, static_cast<int32_t>(culling.visibleObjects.size()), numObjects);
+			overlay->text("Recording: %.3f ms", recordTime);
 		}
 		if (overlay->header("Settings")) {
 			overlay->checkBox("Skybox", &displaySkybox);
+			// Only offer the instruction sets supported by the CPU
+			const std::vector<std::string> simdPaths = { "Scalar", "SSE", "AVX2" };
+			std::vector<std::string> supportedPaths(simdPaths.begin(), simdPaths.begin() + static_cast<int32_t>(vks::Frustum::supportedSimdPath()) + 1);
+			int32_t simdPath = static_cast<int32_t>(frustum.simdPath);
+			if (overlay->comboBox("Culling", &simdPath, supportedPaths)) {
+				frustum.simdPath = static_cast<vks::Frustum::SimdPath>(simdPath);
+			}
 		}
 
 	}
@@ -375,6 +375,7 @@ public:
 				renderPassBeginInfo.framebuffer = frameBuffers[i];
 
 				VK_CHECK_RESULT(vkBeginCommandBuffer(drawCmdBuffers[i], &cmdBufInfo));
+				benchmark.beginGpuFrame(drawCmdBuffers[i], i);
 				vkCmdBeginRenderPass(drawCmdBuffers[i], &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
 				VkViewport viewport = vks::initializers::viewport((float)width / 2.0f, (float)height, 0.0f, 1.0f);
 				VkRect2D scissor = vks::initializers::rect2D(width / 2, height, 0, 0);
@@ -399,6 +400,7 @@ public:
 				drawUI(drawCmdBuffers[i]);
 
 				vkCmdEndRenderPass(drawCmdBuffers[i]);
+				benchmark.endGpuFrame(drawCmdBuffers[i], i);
 				VK_CHECK_RESULT(vkEndCommandBuffer(drawCmdBuffers[i]));
 			}
 		}
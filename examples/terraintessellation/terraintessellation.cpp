@@ -327,6 +327,7 @@ public:
 			renderPassBeginInfo.framebuffer = frameBuffers[i];
 
 			VK_CHECK_RESULT(vkBeginCommandBuffer(drawCmdBuffers[i], &cmdBufInfo));
+			benchmark.beginGpuFrame(drawCmdBuffers[i], i);
 
 			if (deviceFeatures.pipelineStatisticsQuery) {
 				vkCmdResetQueryPool(drawCmdBuffers[i], queryPool, 0, 2);
@@ -371,6 +372,7 @@ public:
 
 			vkCmdEndRenderPass(drawCmdBuffers[i]);
 
+			benchmark.endGpuFrame(drawCmdBuffers[i], i);
 			VK_CHECK_RESULT(vkEndCommandBuffer(drawCmdBuffers[i]));
 		}
 	}
@@ -514,42 +516,35 @@ public:
 		uint32_t vertexBufferSize = vertexCount * sizeof(Vertex);
 		uint32_t indexBufferSize = indexCount * sizeof(uint32_t);
 
-		struct {
-			VkBuffer buffer;
-			VkDeviceMemory memory;
-		} vertexStaging, indexStaging;
+		vks::Buffer vertexStaging, indexStaging;
 
 		// Create staging buffers
 
 		VK_CHECK_RESULT(vulkanDevice->createBuffer(
 			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
 			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			&vertexStaging,
 			vertexBufferSize,
-			&vertexStaging.buffer,
-			&vertexStaging.memory,
 			vertices));
 
 		VK_CHECK_RESULT(vulkanDevice->createBuffer(
 			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
 			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			&indexStaging,
 			indexBufferSize,
-			&indexStaging.buffer,
-			&indexStaging.memory,
 			indices));
 
 		VK_CHECK_RESULT(vulkanDevice->createBuffer(
 			VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
 			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-			vertexBufferSize,
-			&models.terrain.vertices.buffer,
-			&models.terrain.vertices.memory));
+			&models.terrain.vertices,
+			vertexBufferSize));
 
 		VK_CHECK_RESULT(vulkanDevice->createBuffer(
 			VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
 			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-			indexBufferSize,
-			&models.terrain.indices.buffer,
-			&models.terrain.indices.memory));
+			&models.terrain.indices,
+			indexBufferSize));
 
 		// Copy from staging buffers
 		VkCommandBuffer copyCmd = vulkanDevice->createCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
@@ -576,10 +571,8 @@ public:
 
 		models.terrain.device = device;
 
-		vkDestroyBuffer(device, vertexStaging.buffer, nullptr);
-		vkFreeMemory(device, vertexStaging.memory, nullptr);
-		vkDestroyBuffer(device, indexStaging.buffer, nullptr);
-		vkFreeMemory(device, indexStaging.memory, nullptr);
+		vertexStaging.destroy();
+		indexStaging.destroy();
 
 		delete[] vertices;
 		delete[] indices;
@@ -0,0 +1,256 @@
+/*
+* Animation crowd benchmark
+*
+* Animates a crowd of synthetic skinned characters that each blend two clips with their own playback times and weights,
+* and writes the joint palette of every frame in flight like an example drawing the crowd would do.
+* The animation evaluation is timed with every instruction set supported by the CPU, and the joint matrices of the SIMD
+* paths are checked against the scalar path.
+*
+* Copyright (C) by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license (MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+
+#include <vulkan/vulkan.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include "VulkanTools.h"
+#include "VulkanDevice.hpp"
+#include "VulkanglTFModel.hpp"
+#include "testing.hpp"
+
+// Maximum difference between the joint matrices of the SIMD and the scalar paths, relative to the magnitude of the scalar values
+static const float MAX_ERROR = 1e-4f;
+
+static const uint32_t FRAMES_IN_FLIGHT = 2;
+
+/**
+* Adds a character with a skeleton of the given number of joints, a skinned mesh using all of them and two clips animating them
+*
+* @note Every fourth joint starts a new limb at the character's root, so the skeletons are branched instead of a single chain
+*/
+static void addCharacter(vkglTF::Model &model, vks::VulkanDevice *device, uint32_t index, uint32_t jointCount, std::mt19937 &rng)
+{
+	std::uniform_real_distribution<float> angle(-0.5f, 0.5f);
+	std::uniform_real_distribution<float> offset(-0.05f, 0.05f);
+
+	vkglTF::Node *root = new vkglTF::Node{};
+	root->index = static_cast<uint32_t>(model.linearNodes.size());
+	root->matrix = glm::mat4(1.0f);
+	root->translation = glm::vec3(static_cast<float>(index % 16) * 2.0f, 0.0f, static_cast<float>(index / 16) * 2.0f);
+	model.nodes.push_back(root);
+	model.linearNodes.push_back(root);
+
+	vkglTF::Skin *skin = new vkglTF::Skin{};
+	skin->skeletonRoot = root;
+	vkglTF::Node *parent = root;
+	for (uint32_t j = 0; j < jointCount; j++) {
+		vkglTF::Node *joint = new vkglTF::Node{};
+		joint->index = static_cast<uint32_t>(model.linearNodes.size());
+		joint->parent = parent;
+		joint->matrix = glm::mat4(1.0f);
+		joint->translation = glm::vec3(0.0f, 0.25f, 0.0f);
+		parent->children.push_back(joint);
+		model.linearNodes.push_back(joint);
+		skin->joints.push_back(joint);
+		skin->inverseBindMatrices.push_back(glm::mat4(1.0f));
+		parent = (j % 4 == 3) ? root : joint;
+	}
+	model.skins.push_back(skin);
+
+	vkglTF::Node *meshNode = new vkglTF::Node{};
+	meshNode->index = static_cast<uint32_t>(model.linearNodes.size());
+	meshNode->parent = root;
+	meshNode->matrix = glm::mat4(1.0f);
+	meshNode->mesh = new vkglTF::Mesh(device, glm::mat4(1.0f));
+	meshNode->skin = skin;
+	meshNode->skinIndex = static_cast<int32_t>(model.skins.size() - 1);
+	root->children.push_back(meshNode);
+	model.linearNodes.push_back(meshNode);
+
+	// Two clips of different length, e.g. a walk and a run cycle
+	for (uint32_t clip = 0; clip < 2; clip++) {
+		const uint32_t keyCount = (clip == 0) ? 31 : 21;
+		vkglTF::Animation animation;
+		animation.start = 0.0f;
+		animation.end = (keyCount - 1) / 30.0f;
+		for (vkglTF::Node *joint : skin->joints) {
+			for (uint32_t path = 0; path < 2; path++) {
+				vkglTF::AnimationSampler sampler;
+				sampler.interpolation = vkglTF::AnimationSampler::LINEAR;
+				for (uint32_t k = 0; k < keyCount; k++) {
+					sampler.inputs.push_back(k / 30.0f);
+					if (path == 0) {
+						sampler.outputsVec4.push_back(glm::vec4(offset(rng), 0.25f + offset(rng), offset(rng), 0.0f));
+					} else {
+						const glm::quat q = glm::angleAxis(angle(rng), glm::normalize(glm::vec3(offset(rng), 1.0f, offset(rng))));
+						sampler.outputsVec4.push_back(glm::vec4(q.x, q.y, q.z, q.w));
+					}
+				}
+				vkglTF::AnimationChannel channel;
+				channel.path = (path == 0) ? vkglTF::AnimationChannel::PathType::TRANSLATION : vkglTF::AnimationChannel::PathType::ROTATION;
+				channel.node = joint;
+				channel.samplerIndex = static_cast<uint32_t>(animation.samplers.size());
+				animation.samplers.push_back(sampler);
+				animation.channels.push_back(channel);
+			}
+		}
+		model.animations.push_back(animation);
+	}
+}
+
+/** @brief Playback state of every character's two clips at the given time, each character has its own phase and blend weight */
+static void setStates(const vkglTF::Model &model, uint32_t characterCount, float time, std::vector<vkglTF::AnimationState> &states)
+{
+	states.resize(characterCount * 2);
+	for (uint32_t c = 0; c < characterCount; c++) {
+		const float phase = static_cast<float>(c) * 0.137f;
+		const float runWeight = 0.5f + 0.5f * std::sin(time + phase);
+		for (uint32_t clip = 0; clip < 2; clip++) {
+			vkglTF::AnimationState &state = states[c * 2 + clip];
+			state.index = c * 2 + clip;
+			state.time = std::fmod(time + phase, model.animations[state.index].end);
+			state.weight = (clip == 0) ? 1.0f - runWeight : runWeight;
+		}
+	}
+}
+
+static const char *pathName(vks::simd::Path path)
+{
+	switch (path) {
+	case vks::simd::Path::AVX2:
+		return "AVX2";
+	case vks::simd::Path::SSE:
+		return "SSE";
+	default:
+		return "scalar";
+	}
+}
+
+static bool runCrowd(vks::VulkanDevice *device, uint32_t characterCount, uint32_t jointCount, uint32_t frames)
+{
+	vkglTF::Model model;
+	model.device = device;
+	model.framesInFlight = FRAMES_IN_FLIGHT;
+	std::mt19937 rng(42);
+	for (uint32_t c = 0; c < characterCount; c++) {
+		addCharacter(model, device, c, jointCount, rng);
+	}
+	model.sortNodes();
+	model.setupJointPalette();
+	model.updateTransforms();
+
+	std::vector<vkglTF::AnimationState> states;
+	std::vector<glm::mat4> scalarMatrices;
+	const vks::simd::Path paths[] = { vks::simd::Path::Scalar, vks::simd::Path::SSE, vks::simd::Path::AVX2 };
+	bool passed = true;
+	double scalarTime = 0.0;
+	for (vks::simd::Path path : paths) {
+		if (static_cast<int>(path) > static_cast<int>(vks::simd::supportedPath())) {
+			std::cout << pathName(path) << ": not supported by the CPU, skipped" << std::endl;
+			continue;
+		}
+		model.animationSimdPath = path;
+		VkDeviceSize bytesWritten = 0;
+		auto start = std::chrono::high_resolution_clock::now();
+		for (uint32_t f = 0; f < frames; f++) {
+			setStates(model, characterCount, f / 60.0f, states);
+			model.updateAnimations(states);
+			// Selecting the frame's slice writes the joint ranges that changed since the slice was used last
+			model.setJointPaletteFrame(f % FRAMES_IN_FLIGHT);
+			bytesWritten += model.jointPalette.statistics.bytesWritten;
+		}
+		const double time = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count() / frames;
+
+		// All paths evaluate the same pose
+		setStates(model, characterCount, 1.2345f, states);
+		model.updateAnimations(states);
+		float error = 0.0f;
+		if (path == vks::simd::Path::Scalar) {
+			scalarTime = time;
+			scalarMatrices = model.jointPalette.matrices;
+		} else {
+			for (size_t i = 0; i < scalarMatrices.size(); i++) {
+				for (uint32_t c = 0; c < 4; c++) {
+					for (uint32_t r = 0; r < 4; r++) {
+						const float reference = scalarMatrices[i][c][r];
+						error = std::max(error, std::fabs(model.jointPalette.matrices[i][c][r] - reference) / std::max(std::fabs(reference), 1.0f));
+					}
+				}
+			}
+		}
+		printf("%-6s: %8.3f ms per frame (%5.2fx), %8.1f KB joint palette writes per frame, max error %g\n", pathName(path), time, scalarTime / time, bytesWritten / 1024.0 / frames, error);
+		if (error > MAX_ERROR) {
+			std::cerr << "FAILED: joint matrices of the " << pathName(path) << " path differ from the scalar path by " << error << std::endl;
+			passed = false;
+		}
+	}
+	for (vkglTF::Skin *skin : model.skins) {
+		delete skin;
+	}
+	model.skins.clear();
+	return passed;
+}
+
+int main(const int argc, const char *argv[])
+{
+	uint32_t characterCount = 256;
+	uint32_t jointCount = 48;
+	uint32_t frames = 100;
+	for (int i = 1; i < argc - 1; i++) {
+		if (strcmp(argv[i], "--characters") == 0) {
+			characterCount = std::max(static_cast<uint32_t>(atoi(argv[i + 1])), 1u);
+		}
+		if (strcmp(argv[i], "--joints") == 0) {
+			jointCount = std::max(static_cast<uint32_t>(atoi(argv[i + 1])), 1u);
+		}
+		if (strcmp(argv[i], "--frames") == 0) {
+			frames = std::max(static_cast<uint32_t>(atoi(argv[i + 1])), 1u);
+		}
+	}
+
+	// The joint palette and the mesh uniform buffers live in device memory
+	VkApplicationInfo appInfo = {};
+	appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+	appInfo.pApplicationName = "animationcrowd";
+	appInfo.pEngineName = "animationcrowd";
+	appInfo.apiVersion = VK_API_VERSION_1_0;
+	VkInstanceCreateInfo instanceCreateInfo = {};
+	instanceCreateInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+	instanceCreateInfo.pApplicationInfo = &appInfo;
+	VkInstance instance;
+	if (vkCreateInstance(&instanceCreateInfo, nullptr, &instance) != VK_SUCCESS) {
+		std::cout << "Could not create a Vulkan instance, skipping the benchmark" << std::endl;
+		return TEST_SKIPPED;
+	}
+	uint32_t deviceCount = 0;
+	vkEnumeratePhysicalDevices(instance, &deviceCount, nullptr);
+	if (deviceCount == 0) {
+		std::cout << "No Vulkan device found, skipping the benchmark" << std::endl;
+		vkDestroyInstance(instance, nullptr);
+		return TEST_SKIPPED;
+	}
+	std::vector<VkPhysicalDevice> physicalDevices(deviceCount);
+	VK_CHECK_RESULT(vkEnumeratePhysicalDevices(instance, &deviceCount, physicalDevices.data()));
+
+	bool passed = true;
+	{
+		vks::VulkanDevice device(physicalDevices[0]);
+		VK_CHECK_RESULT(device.createLogicalDevice({}, {}, nullptr, false, VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_TRANSFER_BIT));
+		std::cout << characterCount << " characters with " << jointCount << " joints blending two clips, " << frames << " frames on " << device.properties.deviceName << std::endl;
+		std::cout << "Supported instruction set: " << pathName(vks::simd::supportedPath()) << std::endl;
+		passed = runCrowd(&device, characterCount, jointCount, frames);
+	}
+	vkDestroyInstance(instance, nullptr);
+	return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
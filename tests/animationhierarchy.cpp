@@ -0,0 +1,211 @@
+/*
+* Animation hierarchy benchmark
+*
+* Animates synthetic node hierarchies of increasing depth with a single clip and with two weighted clips blended by
+* vkglTF::Model::updateAnimations, times the animation and transform updates and checks the cached world matrices
+* against matrices calculated by walking the parent chain of every node
+*
+* Copyright (C) by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license (MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include "VulkanglTFModel.hpp"
+
+// Maximum relative difference between the cached and the reference world matrices per level of the hierarchy, rounding errors add up along the chains
+static const float MAX_ERROR_PER_LEVEL = 1e-6f;
+// Maximum difference of the node properties between blending a single clip and playing it, rotations are normalized after blending
+static const float MAX_BLEND_ERROR = 1e-5f;
+
+/** @brief Largest difference between two matrices, relative to the magnitude of the reference values */
+static float matrixError(const glm::mat4 &matrix, const glm::mat4 &reference)
+{
+	float error = 0.0f;
+	for (uint32_t c = 0; c < 4; c++) {
+		for (uint32_t r = 0; r < 4; r++) {
+			error = std::max(error, std::fabs(matrix[c][r] - reference[c][r]) / std::max(std::fabs(reference[c][r]), 1.0f));
+		}
+	}
+	return error;
+}
+
+/** @brief Builds chains of the given depth below a single root, so the hierarchy has nodeCount + 1 nodes */
+static void buildHierarchy(vkglTF::Model &model, uint32_t nodeCount, uint32_t depth)
+{
+	vkglTF::Node *root = new vkglTF::Node{};
+	model.nodes.push_back(root);
+	model.linearNodes.push_back(root);
+	for (uint32_t chain = 0; chain < nodeCount / depth; chain++) {
+		vkglTF::Node *parent = root;
+		for (uint32_t i = 0; i < depth; i++) {
+			vkglTF::Node *node = new vkglTF::Node{};
+			node->index = static_cast<uint32_t>(model.linearNodes.size());
+			node->parent = parent;
+			node->matrix = glm::mat4(1.0f);
+			node->translation = glm::vec3(0.0f, 0.1f, 0.0f);
+			parent->children.push_back(node);
+			model.linearNodes.push_back(node);
+			parent = node;
+		}
+	}
+	model.sortNodes();
+}
+
+/** @brief Adds a clip with random rotation and translation keyframes for every node but the root */
+static void addClip(vkglTF::Model &model, uint32_t keyCount, uint32_t seed)
+{
+	std::mt19937 rng(seed);
+	std::uniform_real_distribution<float> angle(-0.3f, 0.3f);
+	std::uniform_real_distribution<float> offset(-0.01f, 0.01f);
+	vkglTF::Animation animation;
+	animation.start = 0.0f;
+	animation.end = (keyCount - 1) / 30.0f;
+	for (size_t n = 1; n < model.linearNodes.size(); n++) {
+		for (uint32_t path = 0; path < 2; path++) {
+			vkglTF::AnimationSampler sampler;
+			sampler.interpolation = vkglTF::AnimationSampler::LINEAR;
+			for (uint32_t k = 0; k < keyCount; k++) {
+				sampler.inputs.push_back(k / 30.0f);
+				if (path == vkglTF::AnimationChannel::PathType::ROTATION) {
+					const glm::quat q = glm::angleAxis(angle(rng), glm::vec3(0.0f, 0.0f, 1.0f));
+					sampler.outputsVec4.push_back(glm::vec4(q.x, q.y, q.z, q.w));
+				} else {
+					sampler.outputsVec4.push_back(glm::vec4(offset(rng), 0.1f + offset(rng), offset(rng), 0.0f));
+				}
+			}
+			vkglTF::AnimationChannel channel;
+			channel.path = (path == 0) ? vkglTF::AnimationChannel::PathType::TRANSLATION : vkglTF::AnimationChannel::PathType::ROTATION;
+			channel.node = model.linearNodes[n];
+			channel.samplerIndex = static_cast<uint32_t>(animation.samplers.size());
+			animation.samplers.push_back(sampler);
+			animation.channels.push_back(channel);
+		}
+	}
+	model.animations.push_back(animation);
+}
+
+/** @brief Largest difference between the cached world matrices and the ones calculated from the local matrices of each node's parent chain */
+static float worldMatrixError(vkglTF::Model &model)
+{
+	float error = 0.0f;
+	for (vkglTF::Node *node : model.linearNodes) {
+		glm::mat4 reference = node->localMatrix();
+		for (vkglTF::Node *parent = node->parent; parent; parent = parent->parent) {
+			reference = parent->localMatrix() * reference;
+		}
+		error = std::max(error, matrixError(node->cachedWorldMatrix, reference));
+	}
+	return error;
+}
+
+static double elapsed(const std::chrono::high_resolution_clock::time_point &start)
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+int main(const int argc, const char *argv[])
+{
+	uint32_t nodeCount = 4096;
+	uint32_t frames = 100;
+	for (int i = 1; i < argc - 1; i++) {
+		if (strcmp(argv[i], "--nodes") == 0) {
+			nodeCount = static_cast<uint32_t>(atoi(argv[i + 1]));
+		}
+		if (strcmp(argv[i], "--frames") == 0) {
+			frames = std::max(static_cast<uint32_t>(atoi(argv[i + 1])), 1u);
+		}
+	}
+
+	std::cout << nodeCount << " animated nodes, " << frames << " frames" << std::endl;
+	bool passed = true;
+	for (uint32_t depth : { 4u, 16u, 64u, 256u, 1024u }) {
+		if (depth > nodeCount) {
+			continue;
+		}
+		vkglTF::Model model;
+		buildHierarchy(model, nodeCount, depth);
+		addClip(model, 60, 1);
+		addClip(model, 45, 2);
+		const float duration = model.animations[0].end;
+
+		// Single clip
+		auto start = std::chrono::high_resolution_clock::now();
+		for (uint32_t f = 0; f < frames; f++) {
+			model.updateAnimation(0, std::fmod(f / 60.0f, duration));
+		}
+		const double singleTime = elapsed(start) / frames;
+		float error = worldMatrixError(model);
+
+		// Blending with a weight of zero for the second clip has to give the same result as playing the first one
+		std::vector<vkglTF::AnimationState> states(2);
+		states[0].index = 0;
+		states[1].index = 1;
+		states[0].time = states[1].time = 0.5f;
+		states[0].weight = 1.0f;
+		states[1].weight = 0.0f;
+		model.updateAnimation(0, 0.5f);
+		std::vector<glm::vec3> translations;
+		std::vector<glm::quat> rotations;
+		for (vkglTF::Node *node : model.linearNodes) {
+			translations.push_back(node->translation);
+			rotations.push_back(node->rotation);
+		}
+		model.updateAnimations(states);
+		float blendError = 0.0f;
+		for (size_t n = 0; n < model.linearNodes.size(); n++) {
+			const vkglTF::Node *node = model.linearNodes[n];
+			for (uint32_t i = 0; i < 3; i++) {
+				blendError = std::max(blendError, std::fabs(node->translation[i] - translations[n][i]));
+			}
+			for (uint32_t i = 0; i < 4; i++) {
+				blendError = std::max(blendError, std::fabs(node->rotation[i] - rotations[n][i]));
+			}
+		}
+
+		// Two weighted clips, crossfading from the first to the second one
+		start = std::chrono::high_resolution_clock::now();
+		for (uint32_t f = 0; f < frames; f++) {
+			const float t = f / 60.0f;
+			states[0].time = std::fmod(t, duration);
+			states[1].time = std::fmod(t, model.animations[1].end);
+			states[1].weight = static_cast<float>(f) / frames;
+			states[0].weight = 1.0f - states[1].weight;
+			model.updateAnimations(states);
+		}
+		const double blendTime = elapsed(start) / frames;
+		error = std::max(error, worldMatrixError(model));
+
+		// A single node near the root changes, only its subtree is recalculated
+		start = std::chrono::high_resolution_clock::now();
+		for (uint32_t f = 0; f < frames; f++) {
+			model.linearNodes[1]->translation.x = f * 0.001f;
+			model.linearNodes[1]->setDirty();
+			model.updateTransforms();
+		}
+		const double partialTime = elapsed(start) / frames;
+		error = std::max(error, worldMatrixError(model));
+
+		printf("depth %4u: one clip %7.3f ms, two blended clips %7.3f ms, one subtree %7.3f ms, max error %g, blend error %g\n", depth, singleTime, blendTime, partialTime, error, blendError);
+		if (error > MAX_ERROR_PER_LEVEL * depth) {
+			std::cerr << "FAILED: cached world matrices differ from the parent chain by " << error << std::endl;
+			passed = false;
+		}
+		if (blendError > MAX_BLEND_ERROR) {
+			std::cerr << "FAILED: blending with a zero weight for the second clip differs from the first clip by " << blendError << std::endl;
+			passed = false;
+		}
+	}
+	return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
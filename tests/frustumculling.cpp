@@ -0,0 +1,147 @@
+/*
+* Frustum culling benchmark
+*
+* Culls a large set of random spheres and axis aligned bounding boxes with every instruction set supported by the CPU,
+* reports the time per pass compared to the scalar path and checks that all paths match the per object checks
+*
+* Copyright (C) by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license (MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <iostream>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include "frustum.hpp"
+
+/** @brief Objects stored as structure of arrays, as expected by the batch culling functions */
+struct Objects {
+	std::vector<float> x, y, z, radius;
+	std::vector<float> minX, minY, minZ, maxX, maxY, maxZ;
+};
+
+static void generateObjects(Objects &objects, size_t count)
+{
+	std::mt19937 rng(42);
+	// The volume is larger than the frustum, so some objects are culled, some intersect the planes and some are inside
+	std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+	std::uniform_real_distribution<float> extent(0.1f, 4.0f);
+	objects.x.resize(count);
+	objects.y.resize(count);
+	objects.z.resize(count);
+	objects.radius.resize(count);
+	objects.minX.resize(count);
+	objects.minY.resize(count);
+	objects.minZ.resize(count);
+	objects.maxX.resize(count);
+	objects.maxY.resize(count);
+	objects.maxZ.resize(count);
+	for (size_t i = 0; i < count; i++) {
+		objects.x[i] = position(rng);
+		objects.y[i] = position(rng);
+		objects.z[i] = position(rng);
+		objects.radius[i] = extent(rng);
+		objects.minX[i] = objects.x[i] - extent(rng);
+		objects.minY[i] = objects.y[i] - extent(rng);
+		objects.minZ[i] = objects.z[i] - extent(rng);
+		objects.maxX[i] = objects.x[i] + extent(rng);
+		objects.maxY[i] = objects.y[i] + extent(rng);
+		objects.maxZ[i] = objects.z[i] + extent(rng);
+	}
+}
+
+static const char *pathName(vks::Frustum::SimdPath path)
+{
+	switch (path) {
+	case vks::Frustum::SimdPath::AVX2:
+		return "AVX2";
+	case vks::Frustum::SimdPath::SSE:
+		return "SSE";
+	default:
+		return "scalar";
+	}
+}
+
+int main(const int argc, const char *argv[])
+{
+	size_t objectCount = 1000000;
+	uint32_t iterations = 20;
+	for (int i = 1; i < argc - 1; i++) {
+		if (strcmp(argv[i], "--objects") == 0) {
+			objectCount = static_cast<size_t>(atoll(argv[i + 1]));
+		}
+		if (strcmp(argv[i], "--iterations") == 0) {
+			iterations = std::max(static_cast<uint32_t>(atoi(argv[i + 1])), 1u);
+		}
+	}
+
+	Objects objects;
+	generateObjects(objects, objectCount);
+
+	vks::Frustum frustum;
+	const glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 128.0f);
+	const glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 0.0f, -64.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	frustum.update(projection * view);
+
+	// Reference results of the per object checks
+	std::vector<bool> sphereReference(objectCount), aabbReference(objectCount);
+	size_t visibleSpheres = 0, visibleAABBs = 0;
+	for (size_t i = 0; i < objectCount; i++) {
+		sphereReference[i] = frustum.checkSphere(glm::vec3(objects.x[i], objects.y[i], objects.z[i]), objects.radius[i]);
+		aabbReference[i] = frustum.checkAABB(glm::vec3(objects.minX[i], objects.minY[i], objects.minZ[i]), glm::vec3(objects.maxX[i], objects.maxY[i], objects.maxZ[i]));
+		visibleSpheres += sphereReference[i] ? 1 : 0;
+		visibleAABBs += aabbReference[i] ? 1 : 0;
+	}
+	std::cout << objectCount << " objects, " << iterations << " iterations, " << visibleSpheres << " visible spheres, " << visibleAABBs << " visible boxes" << std::endl;
+	std::cout << "Supported instruction set: " << pathName(frustum.supportedSimdPath()) << std::endl;
+
+	std::vector<uint32_t> visibilityMask(vks::Frustum::visibilityMaskSize(objectCount));
+	const vks::Frustum::SimdPath paths[] = { vks::Frustum::SimdPath::Scalar, vks::Frustum::SimdPath::SSE, vks::Frustum::SimdPath::AVX2 };
+	double scalarSphereTime = 0.0, scalarAABBTime = 0.0;
+	bool passed = true;
+	for (vks::Frustum::SimdPath path : paths) {
+		if (static_cast<int>(path) > static_cast<int>(frustum.supportedSimdPath())) {
+			std::cout << pathName(path) << ": not supported by the CPU, skipped" << std::endl;
+			continue;
+		}
+		frustum.simdPath = path;
+
+		auto start = std::chrono::high_resolution_clock::now();
+		for (uint32_t i = 0; i < iterations; i++) {
+			frustum.cullSpheres(objects.x.data(), objects.y.data(), objects.z.data(), objects.radius.data(), objectCount, visibilityMask.data());
+		}
+		const double sphereTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count() / iterations;
+		size_t sphereMismatches = 0;
+		for (size_t i = 0; i < objectCount; i++) {
+			sphereMismatches += (vks::Frustum::isVisible(visibilityMask.data(), i) != sphereReference[i]) ? 1 : 0;
+		}
+
+		start = std::chrono::high_resolution_clock::now();
+		for (uint32_t i = 0; i < iterations; i++) {
+			frustum.cullAABBs(objects.minX.data(), objects.minY.data(), objects.minZ.data(), objects.maxX.data(), objects.maxY.data(), objects.maxZ.data(), objectCount, visibilityMask.data());
+		}
+		const double aabbTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count() / iterations;
+		size_t aabbMismatches = 0;
+		for (size_t i = 0; i < objectCount; i++) {
+			aabbMismatches += (vks::Frustum::isVisible(visibilityMask.data(), i) != aabbReference[i]) ? 1 : 0;
+		}
+
+		if (path == vks::Frustum::SimdPath::Scalar) {
+			scalarSphereTime = sphereTime;
+			scalarAABBTime = aabbTime;
+		}
+		printf("%-6s: spheres %8.3f ms (%5.2fx), boxes %8.3f ms (%5.2fx)\n", pathName(path), sphereTime, scalarSphereTime / sphereTime, aabbTime, scalarAABBTime / aabbTime);
+		if ((sphereMismatches > 0) || (aabbMismatches > 0)) {
+			std::cerr << "FAILED: " << pathName(path) << " differs from the per object checks for " << sphereMismatches << " spheres and " << aabbMismatches << " boxes" << std::endl;
+			passed = false;
+		}
+	}
+	return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
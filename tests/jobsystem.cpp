@@ -0,0 +1,107 @@
+/*
+* Job system test
+*
+* Checks that every job runs exactly once and that the thread indices stay valid with several job systems on the same threads,
+* e.g. a model's skinning pool created by a thread that already owns the frame's job system, or a job system created inside a job
+*
+* Copyright (C) by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license (MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include <atomic>
+#include <iostream>
+
+#include "jobsystem.hpp"
+#include "testing.hpp"
+
+/** @brief Runs a parallel loop and counts the indices that were not visited exactly once or ran with an invalid thread index */
+static uint32_t runLoop(vks::JobSystem &jobSystem, size_t count)
+{
+	std::vector<std::atomic<uint32_t>> visits(count);
+	for (auto &visit : visits) {
+		visit.store(0);
+	}
+	std::atomic<uint32_t> errors(0);
+	jobSystem.parallelFor(count, [&](size_t i) {
+		visits[i].fetch_add(1);
+		if (jobSystem.currentThreadIndex() >= jobSystem.threadCount()) {
+			errors.fetch_add(1);
+		}
+	}, 1);
+	for (auto &visit : visits) {
+		if (visit.load() != 1) {
+			errors.fetch_add(1);
+		}
+	}
+	return errors.load();
+}
+
+static bool testSingle()
+{
+	vks::JobSystem jobSystem(4);
+	TEST_CHECK(jobSystem.currentThreadIndex() == 0, "the creating thread must have index 0");
+	for (uint32_t i = 0; i < 100; i++) {
+		TEST_CHECK(runLoop(jobSystem, 1000) == 0, "jobs must run once with valid thread indices");
+	}
+	return true;
+}
+
+/** @brief A second job system created and destroyed on the thread of the first one must not change the first one's thread indices */
+static bool testSameThread()
+{
+	vks::JobSystem first(4);
+	{
+		vks::JobSystem second(3);
+		TEST_CHECK((first.currentThreadIndex() == 0) && (second.currentThreadIndex() == 0), "the creating thread must have index 0 in both job systems");
+		for (uint32_t i = 0; i < 100; i++) {
+			TEST_CHECK(runLoop(first, 1000) == 0, "the first job system must keep working while the second one exists");
+			TEST_CHECK(runLoop(second, 1000) == 0, "the second job system must work next to the first one");
+		}
+	}
+	TEST_CHECK(first.currentThreadIndex() == 0, "the creating thread must keep its index after the second job system has been destroyed");
+	TEST_CHECK(runLoop(first, 1000) == 0, "the first job system must keep working after the second one has been destroyed");
+	return true;
+}
+
+/** @brief Job systems created inside jobs, so the worker threads of one job system own others */
+static bool testNested()
+{
+	vks::JobSystem outer(4);
+	std::atomic<uint32_t> errors(0);
+	for (uint32_t i = 0; i < 20; i++) {
+		outer.parallelFor(8, [&](size_t) {
+			const uint32_t outerIndex = outer.currentThreadIndex();
+			{
+				vks::JobSystem inner(2);
+				errors.fetch_add(runLoop(inner, 100));
+			}
+			if (outer.currentThreadIndex() != outerIndex) {
+				errors.fetch_add(1);
+			}
+		}, 1);
+	}
+	TEST_CHECK(errors.load() == 0, "job systems created in jobs must not change the thread indices of the outer job system");
+	return true;
+}
+
+int main()
+{
+	std::cout << "Single job system" << std::endl;
+	if (!testSingle()) {
+		return EXIT_FAILURE;
+	}
+	std::cout << "Two job systems on the same thread" << std::endl;
+	if (!testSameThread()) {
+		return EXIT_FAILURE;
+	}
+	std::cout << "Job systems created in jobs" << std::endl;
+	if (!testNested()) {
+		return EXIT_FAILURE;
+	}
+	std::cout << "All tests passed" << std::endl;
+	return EXIT_SUCCESS;
+}
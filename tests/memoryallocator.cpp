@@ -0,0 +1,265 @@
+/*
+* Memory allocator stress test
+*
+* Runs a long random sequence of allocations and frees against the block metadata and the device's memory allocator
+* and checks alignment, overlaps, the contents of host visible ranges and that all memory is returned afterwards
+* Runs on any Vulkan implementation, including software ones like lavapipe
+*
+* Copyright (C) by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license (MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <map>
+#include <random>
+#include <iostream>
+#include <algorithm>
+
+#include <vulkan/vulkan.h>
+#include "VulkanTools.h"
+#include "VulkanDevice.hpp"
+#include "VulkanBuffer.hpp"
+#include "VulkanMemoryAllocator.hpp"
+#include "testing.hpp"
+
+struct Range {
+	VkDeviceSize offset;
+	VkDeviceSize size;
+};
+
+static bool overlaps(const Range &a, const Range &b)
+{
+	return (a.offset < b.offset + b.size) && (b.offset < a.offset + a.size);
+}
+
+/** @brief Random allocations and frees against a single block's metadata, without a device */
+static bool testBlockMetadata(vks::BlockMetadata &metadata, VkDeviceSize blockSize, bool freeInOrder, uint32_t iterations)
+{
+	std::mt19937 rng(42);
+	std::map<uint32_t, Range> live;
+	std::vector<uint32_t> order;
+	for (uint32_t i = 0; i < iterations; i++) {
+		const bool allocate = live.empty() || (rng() % 3 != 0);
+		if (allocate && live.size() < 512) {
+			const VkDeviceSize size = 1 + rng() % (1u << (rng() % 20));
+			const VkDeviceSize alignment = 1ull << (rng() % 12);
+			Range range;
+			const uint32_t handle = metadata.allocate(size, alignment, &range.offset);
+			if (handle == vks::BlockMetadata::INVALID_HANDLE) {
+				continue;
+			}
+			range.size = size;
+			TEST_CHECK(range.offset % alignment == 0, "offset " << range.offset << " is not aligned to " << alignment);
+			TEST_CHECK(range.offset + size <= blockSize, "range exceeds the block");
+			TEST_CHECK(live.find(handle) == live.end(), "handle " << handle << " handed out twice");
+			for (auto &other : live) {
+				TEST_CHECK(!overlaps(range, other.second), "range [" << range.offset << ", " << range.offset + size << ") overlaps a live range");
+			}
+			live[handle] = range;
+			order.push_back(handle);
+		} else if (!live.empty()) {
+			// The linear strategy only reclaims memory once the block is empty, so the order of frees doesn't matter for correctness
+			size_t index = freeInOrder ? 0 : rng() % order.size();
+			metadata.free(order[index]);
+			live.erase(order[index]);
+			order.erase(order.begin() + index);
+		}
+	}
+	for (auto handle : order) {
+		metadata.free(handle);
+	}
+	TEST_CHECK(metadata.allocationCount() == 0, "allocations left after freeing all of them");
+	TEST_CHECK(metadata.usedSize() == 0, "used size is not zero after freeing all allocations");
+	TEST_CHECK(metadata.largestFreeRange() == blockSize, "free ranges have not been merged back into a single one");
+	return true;
+}
+
+/** @brief Random allocations and frees of synthetic requirements through the device's allocator, including dedicated allocations */
+static bool testAllocator(vks::VulkanDevice *device, vks::AllocationStrategy strategy, uint32_t iterations)
+{
+	vks::MemoryAllocator &allocator = device->memoryAllocator;
+	// Start with no blocks, so all of them are created with the strategy under test
+	TEST_CHECK(allocator.getStatistics().allocationCount == 0, "allocator has live allocations before the test");
+	allocator.destroy();
+	allocator.create(device->physicalDevice, device->logicalDevice);
+	allocator.strategy = strategy;
+	const vks::MemoryAllocator::Statistics start = allocator.getStatistics();
+
+	const uint32_t deviceLocalType = device->getMemoryType(~0u, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	const uint32_t hostVisibleType = device->getMemoryType(~0u, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+
+	// Only the start of large allocations is filled with the pattern to keep the test fast
+	const VkDeviceSize patternSize = 64 * 1024;
+	struct LiveAllocation {
+		vks::Allocation allocation;
+		/** @brief Number of bytes filled with the pattern, allocations may be larger than requested */
+		VkDeviceSize patternBytes;
+		uint8_t pattern;
+	};
+	std::mt19937 rng(7);
+	std::vector<LiveAllocation> live;
+	for (uint32_t i = 0; i < iterations; i++) {
+		const bool allocate = live.empty() || (rng() % 3 != 0);
+		if (allocate && live.size() < 1024) {
+			VkMemoryRequirements memReqs{};
+			// Mostly small resources, with the occasional one that is large enough for a dedicated allocation
+			memReqs.size = (rng() % 512 == 0) ? allocator.preferredBlockSize / 2 + 4096 : 1 + rng() % (1u << (rng() % 18));
+			memReqs.alignment = 1ull << (rng() % 10);
+			memReqs.memoryTypeBits = ~0u;
+			const bool hostVisible = (rng() % 2 == 0);
+			const vks::ResourceType resourceType = (rng() % 4 == 0) ? vks::ResourceType::Optimal : vks::ResourceType::Linear;
+			LiveAllocation entry;
+			entry.pattern = static_cast<uint8_t>(rng());
+			entry.patternBytes = std::min(memReqs.size, patternSize);
+			VK_CHECK_RESULT(allocator.allocate(memReqs, hostVisible ? hostVisibleType : deviceLocalType, resourceType, &entry.allocation));
+			const vks::Allocation &allocation = entry.allocation;
+			TEST_CHECK(allocation.valid(), "allocation is not valid");
+			TEST_CHECK(allocation.offset % memReqs.alignment == 0, "offset " << allocation.offset << " is not aligned to " << memReqs.alignment);
+			TEST_CHECK(allocation.size >= memReqs.size, "allocation is smaller than requested");
+			const Range range = { allocation.offset, allocation.size };
+			for (auto &other : live) {
+				if (other.allocation.memory == allocation.memory) {
+					TEST_CHECK(!overlaps(range, { other.allocation.offset, other.allocation.size }), "allocation overlaps a live allocation of the same memory object");
+				}
+			}
+			if (hostVisible) {
+				TEST_CHECK(allocation.mapped != nullptr, "host visible allocation is not mapped");
+				memset(allocation.mapped, entry.pattern, static_cast<size_t>(entry.patternBytes));
+			}
+			live.push_back(entry);
+		} else if (!live.empty()) {
+			const size_t index = rng() % live.size();
+			vks::Allocation &allocation = live[index].allocation;
+			if (allocation.mapped) {
+				// Overlapping ranges would have overwritten the pattern
+				const uint8_t *data = static_cast<const uint8_t*>(allocation.mapped);
+				for (VkDeviceSize j = 0; j < live[index].patternBytes; j += 61) {
+					TEST_CHECK(data[j] == live[index].pattern, "contents of a host visible allocation have been overwritten");
+				}
+			}
+			allocator.free(allocation);
+			TEST_CHECK(!allocation.valid(), "allocation is still valid after freeing it");
+			live.erase(live.begin() + index);
+		}
+	}
+	for (auto &entry : live) {
+		allocator.free(entry.allocation);
+	}
+	const vks::MemoryAllocator::Statistics stats = allocator.getStatistics();
+	const uint64_t allocations = stats.totalAllocations - start.totalAllocations;
+	const uint32_t deviceMemoryAllocations = stats.deviceMemoryAllocations - start.deviceMemoryAllocations;
+	std::cout << "  " << allocations << " allocations in " << deviceMemoryAllocations << " device memory allocations, peak used " << (stats.peakUsedBytes >> 10) << " KB of " << (stats.peakReservedBytes >> 10) << " KB reserved" << std::endl;
+	TEST_CHECK(stats.allocationCount == 0, stats.allocationCount << " allocations left after freeing all of them");
+	TEST_CHECK(stats.usedBytes == 0, stats.usedBytes << " bytes still used after freeing all allocations");
+	TEST_CHECK(deviceMemoryAllocations < allocations / 4, "sub-allocation did not reduce the number of device memory allocations");
+	return true;
+}
+
+/** @brief Buffers created through both createBuffer overloads must be sub-allocated and contain the passed data */
+static bool testBuffers(vks::VulkanDevice *device)
+{
+	const uint32_t allocationsBefore = device->memoryAllocator.getStatistics().deviceMemoryAllocations;
+	std::vector<uint32_t> data(1024);
+	for (size_t i = 0; i < data.size(); i++) {
+		data[i] = static_cast<uint32_t>(i * 2654435761u);
+	}
+	const VkDeviceSize size = data.size() * sizeof(uint32_t);
+
+	std::vector<vks::Buffer> buffers(16);
+	for (auto &buffer : buffers) {
+		VK_CHECK_RESULT(device->createBuffer(VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &buffer, size, data.data()));
+		TEST_CHECK(buffer.allocation.valid(), "vks::Buffer has not been sub-allocated");
+	}
+	std::vector<VkBuffer> handles(16);
+	std::vector<vks::Allocation> allocations(16);
+	for (size_t i = 0; i < handles.size(); i++) {
+		VK_CHECK_RESULT(device->createBuffer(VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, size, &handles[i], &allocations[i], data.data()));
+		TEST_CHECK(allocations[i].valid(), "buffer has not been sub-allocated");
+		TEST_CHECK(memcmp(allocations[i].mapped, data.data(), static_cast<size_t>(size)) == 0, "buffer does not contain the passed data");
+	}
+	const uint32_t allocationsAfter = device->memoryAllocator.getStatistics().deviceMemoryAllocations;
+	std::cout << "  32 buffers created with " << (allocationsAfter - allocationsBefore) << " device memory allocations" << std::endl;
+	TEST_CHECK(allocationsAfter - allocationsBefore < 32, "buffers have not been placed in shared memory blocks");
+
+	for (auto &buffer : buffers) {
+		TEST_CHECK(memcmp(buffer.allocation.mapped, data.data(), static_cast<size_t>(size)) == 0, "vks::Buffer does not contain the passed data");
+		buffer.destroy();
+	}
+	for (size_t i = 0; i < handles.size(); i++) {
+		vkDestroyBuffer(device->logicalDevice, handles[i], nullptr);
+		device->memoryAllocator.free(allocations[i]);
+	}
+	TEST_CHECK(device->memoryAllocator.getStatistics().allocationCount == 0, "buffer allocations left after destroying all buffers");
+	return true;
+}
+
+int main(const int argc, const char *argv[])
+{
+	uint32_t iterations = 100000;
+	for (int i = 1; i < argc - 1; i++) {
+		if (strcmp(argv[i], "--iterations") == 0) {
+			iterations = static_cast<uint32_t>(atoi(argv[i + 1]));
+		}
+	}
+
+	const VkDeviceSize blockSize = 64ull * 1024 * 1024;
+	{
+		std::cout << "TLSF block metadata" << std::endl;
+		vks::TLSFBlockMetadata metadata(blockSize);
+		if (!testBlockMetadata(metadata, blockSize, false, iterations)) {
+			return EXIT_FAILURE;
+		}
+	}
+	{
+		std::cout << "Linear block metadata" << std::endl;
+		vks::LinearBlockMetadata metadata(blockSize);
+		if (!testBlockMetadata(metadata, blockSize, true, iterations)) {
+			return EXIT_FAILURE;
+		}
+	}
+
+	VkApplicationInfo appInfo = {};
+	appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+	appInfo.pApplicationName = "memoryallocator";
+	appInfo.pEngineName = "memoryallocator";
+	appInfo.apiVersion = VK_API_VERSION_1_0;
+	VkInstanceCreateInfo instanceCreateInfo = {};
+	instanceCreateInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+	instanceCreateInfo.pApplicationInfo = &appInfo;
+	VkInstance instance;
+	if (vkCreateInstance(&instanceCreateInfo, nullptr, &instance) != VK_SUCCESS) {
+		std::cout << "Could not create a Vulkan instance, skipping the device tests" << std::endl;
+		return TEST_SKIPPED;
+	}
+	uint32_t deviceCount = 0;
+	vkEnumeratePhysicalDevices(instance, &deviceCount, nullptr);
+	if (deviceCount == 0) {
+		std::cout << "No Vulkan device found, skipping the device tests" << std::endl;
+		vkDestroyInstance(instance, nullptr);
+		return TEST_SKIPPED;
+	}
+	std::vector<VkPhysicalDevice> physicalDevices(deviceCount);
+	VK_CHECK_RESULT(vkEnumeratePhysicalDevices(instance, &deviceCount, physicalDevices.data()));
+
+	bool passed = true;
+	{
+		vks::VulkanDevice device(physicalDevices[0]);
+		std::cout << "Device " << device.properties.deviceName << std::endl;
+		VK_CHECK_RESULT(device.createLogicalDevice({}, {}, nullptr, false, VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_TRANSFER_BIT));
+		std::cout << "TLSF allocator" << std::endl;
+		passed = passed && testAllocator(&device, vks::AllocationStrategy::TLSF, iterations);
+		std::cout << "Linear allocator" << std::endl;
+		passed = passed && testAllocator(&device, vks::AllocationStrategy::Linear, iterations);
+		device.memoryAllocator.strategy = vks::AllocationStrategy::TLSF;
+		std::cout << "Buffers" << std::endl;
+		passed = passed && testBuffers(&device);
+	}
+	vkDestroyInstance(instance, nullptr);
+
+	std::cout << (passed ? "All tests passed" : "Tests failed") << std::endl;
+	return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,167 @@
+/*
+* Host skinning test
+*
+* Skins random vertices with vkglTF::VertexSkinning using every instruction set supported by the CPU, reports the time per
+* pass compared to the scalar path and checks the skinned positions and normals against the formula of the skinning shaders
+*
+* Copyright (C) by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license (MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include "VulkanglTFModel.hpp"
+
+// Maximum difference between the skinned and the reference vertices, relative to the magnitude of the reference values
+static const float MAX_ERROR = 1e-4f;
+
+/** @brief Random joint matrices with rotation, non-uniform scale and translation, some of them mirrored like joints of a mirrored limb */
+static void generateJoints(std::vector<glm::mat4> &joints, uint32_t count, std::mt19937 &rng)
+{
+	std::uniform_real_distribution<float> angle(-3.14f, 3.14f);
+	std::uniform_real_distribution<float> axis(-1.0f, 1.0f);
+	std::uniform_real_distribution<float> scale(0.5f, 2.0f);
+	joints.resize(count);
+	for (uint32_t i = 0; i < count; i++) {
+		glm::mat4 m = glm::translate(glm::mat4(1.0f), glm::vec3(axis(rng), axis(rng), axis(rng)) * 4.0f);
+		m = glm::rotate(m, angle(rng), glm::normalize(glm::vec3(axis(rng), axis(rng), axis(rng)) + glm::vec3(0.0f, 0.0f, 0.01f)));
+		m = glm::scale(m, glm::vec3(scale(rng), scale(rng), (i % 5 == 0) ? -scale(rng) : scale(rng)));
+		joints[i] = m;
+	}
+}
+
+/** @brief Random vertices influenced by up to four joints with normalized weights */
+static void generateVertices(std::vector<vkglTF::Vertex> &vertices, size_t count, uint32_t jointCount, std::mt19937 &rng)
+{
+	std::uniform_real_distribution<float> position(-1.0f, 1.0f);
+	std::uniform_real_distribution<float> weight(0.0f, 1.0f);
+	std::uniform_int_distribution<uint32_t> joint(0, jointCount - 1);
+	vertices.resize(count);
+	for (size_t i = 0; i < count; i++) {
+		vkglTF::Vertex &vertex = vertices[i];
+		vertex.pos = glm::vec3(position(rng), position(rng), position(rng));
+		vertex.normal = glm::normalize(glm::vec3(position(rng), position(rng), position(rng)) + glm::vec3(0.0f, 0.01f, 0.0f));
+		vertex.uv = glm::vec2(0.0f);
+		vertex.color = glm::vec4(1.0f);
+		vertex.joint0 = glm::vec4(static_cast<float>(joint(rng)), static_cast<float>(joint(rng)), static_cast<float>(joint(rng)), static_cast<float>(joint(rng)));
+		// Vertices with fewer influences have zero weights for the remaining joints
+		vertex.weight0 = glm::vec4(weight(rng), (i % 4 > 0) ? weight(rng) : 0.0f, (i % 4 > 1) ? weight(rng) : 0.0f, (i % 4 > 2) ? weight(rng) : 0.0f);
+		vertex.weight0 /= vertex.weight0.x + vertex.weight0.y + vertex.weight0.z + vertex.weight0.w;
+	}
+}
+
+/** @brief Skinned vertex as calculated by the skinning shaders (see gltfskinning/skinning.comp) */
+static void skinReference(const vkglTF::Vertex &source, const std::vector<glm::mat4> &joints, glm::vec3 &pos, glm::vec3 &normal)
+{
+	const glm::mat4 skinMat =
+		source.weight0.x * joints[static_cast<int>(source.joint0.x)] +
+		source.weight0.y * joints[static_cast<int>(source.joint0.y)] +
+		source.weight0.z * joints[static_cast<int>(source.joint0.z)] +
+		source.weight0.w * joints[static_cast<int>(source.joint0.w)];
+	pos = glm::vec3(skinMat * glm::vec4(source.pos, 1.0f));
+	normal = glm::normalize(glm::transpose(glm::inverse(glm::mat3(skinMat))) * source.normal);
+}
+
+static float vectorError(const glm::vec3 &value, const glm::vec3 &reference)
+{
+	float error = 0.0f;
+	for (uint32_t i = 0; i < 3; i++) {
+		error = std::max(error, std::fabs(value[i] - reference[i]) / std::max(std::fabs(reference[i]), 1.0f));
+	}
+	return error;
+}
+
+static const char *pathName(vks::simd::Path path)
+{
+	switch (path) {
+	case vks::simd::Path::AVX2:
+		return "AVX2";
+	case vks::simd::Path::SSE:
+		return "SSE";
+	default:
+		return "scalar";
+	}
+}
+
+int main(const int argc, const char *argv[])
+{
+	size_t vertexCount = 1000000;
+	uint32_t jointCount = 64;
+	uint32_t iterations = 10;
+	for (int i = 1; i < argc - 1; i++) {
+		if (strcmp(argv[i], "--vertices") == 0) {
+			vertexCount = std::max(static_cast<size_t>(atoll(argv[i + 1])), static_cast<size_t>(1));
+		}
+		if (strcmp(argv[i], "--joints") == 0) {
+			jointCount = std::max(static_cast<uint32_t>(atoi(argv[i + 1])), 1u);
+		}
+		if (strcmp(argv[i], "--iterations") == 0) {
+			iterations = std::max(static_cast<uint32_t>(atoi(argv[i + 1])), 1u);
+		}
+	}
+
+	std::mt19937 rng(42);
+	std::vector<glm::mat4> joints;
+	std::vector<vkglTF::Vertex> source;
+	generateJoints(joints, jointCount, rng);
+	generateVertices(source, vertexCount, jointCount, rng);
+	std::vector<glm::vec3> referencePositions(vertexCount), referenceNormals(vertexCount);
+	for (size_t i = 0; i < vertexCount; i++) {
+		skinReference(source[i], joints, referencePositions[i], referenceNormals[i]);
+	}
+	std::cout << vertexCount << " vertices, " << jointCount << " joints, " << iterations << " iterations" << std::endl;
+	std::cout << "Supported instruction set: " << pathName(vks::simd::supportedPath()) << std::endl;
+
+	// A vertex without any influence (e.g. a broken export) is collapsed to the origin and gets a zero normal instead of NaNs
+	vkglTF::Vertex unweighted = source[0];
+	unweighted.weight0 = glm::vec4(0.0f);
+
+	std::vector<vkglTF::Vertex> target(vertexCount);
+	const vks::simd::Path paths[] = { vks::simd::Path::Scalar, vks::simd::Path::SSE, vks::simd::Path::AVX2 };
+	double scalarTime = 0.0;
+	bool passed = true;
+	for (vks::simd::Path path : paths) {
+		if (static_cast<int>(path) > static_cast<int>(vks::simd::supportedPath())) {
+			std::cout << pathName(path) << ": not supported by the CPU, skipped" << std::endl;
+			continue;
+		}
+		auto start = std::chrono::high_resolution_clock::now();
+		for (uint32_t i = 0; i < iterations; i++) {
+			vkglTF::VertexSkinning::skin(source.data(), target.data(), vertexCount, joints.data(), path);
+		}
+		const double time = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count() / iterations;
+		if (path == vks::simd::Path::Scalar) {
+			scalarTime = time;
+		}
+
+		float positionError = 0.0f, normalError = 0.0f;
+		for (size_t i = 0; i < vertexCount; i++) {
+			positionError = std::max(positionError, vectorError(target[i].pos, referencePositions[i]));
+			normalError = std::max(normalError, vectorError(target[i].normal, referenceNormals[i]));
+		}
+		printf("%-6s: %8.3f ms (%5.2fx), max position error %g, max normal error %g\n", pathName(path), time, scalarTime / time, positionError, normalError);
+		if ((positionError > MAX_ERROR) || (normalError > MAX_ERROR)) {
+			std::cerr << "FAILED: skinned vertices of the " << pathName(path) << " path differ from the reference" << std::endl;
+			passed = false;
+		}
+
+		vkglTF::Vertex skinned;
+		vkglTF::VertexSkinning::skin(&unweighted, &skinned, 1, joints.data(), path);
+		if ((skinned.pos != glm::vec3(0.0f)) || (skinned.normal != glm::vec3(0.0f))) {
+			std::cerr << "FAILED: a vertex without weights is not collapsed to the origin with a zero normal by the " << pathName(path) << " path" << std::endl;
+			passed = false;
+		}
+	}
+	return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,23 @@
+/*
+* Helpers shared by the tests and benchmarks
+*
+* Copyright (C) by Sascha Willems - www.saschawillems.de
+*
+* This code is licensed under the MIT license (MIT) (http://opensource.org/licenses/MIT)
+*/
+
+#pragma once
+
+#include <iostream>
+
+// Returned if no Vulkan device is available, registered as the skip code of the tests (see CMakeLists.txt)
+#define TEST_SKIPPED 77
+
+/** @brief Prints the message with the location of the failed check and returns false from the calling test function */
+#define TEST_CHECK(condition, message) \
+	do { \
+		if (!(condition)) { \
+			std::cerr << "FAILED: " << message << " (" << __FILE__ << ":" << __LINE__ << ")" << std::endl; \
+			return false; \
+		} \
+	} while (0)